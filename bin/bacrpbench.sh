@@ -0,0 +1,65 @@
+#!/bin/bash
+# Measures the ReadProperty requests per second that bacserv answers
+# with each number of BACnet/IP worker threads (Linux).
+
+PROG=`basename $0`
+DIR=`dirname $0`
+DEVICE=1234
+SECONDS_EACH=10
+SOCKETS=64
+
+usage()
+{
+ echo "usage: $PROG [OPTIONS] <<IP address>> [ <<workers>> ... ]
+
+    Starts bacserv with BACNET_BIP_WORKERS set to each of the worker
+    counts in turn [default: 0 1 2 4 8], and loads it with bacrpbench
+    at the given unicast IP address of the local interface.
+
+    -d ID         Device instance of bacserv [default: $DEVICE]
+    -s SECONDS    Seconds to measure each worker count [default: $SECONDS_EACH]
+    -n SOCKETS    Client sockets of bacrpbench [default: $SOCKETS]
+    -h            Display this help
+"
+}
+
+while getopts ":d:s:n:h" opt; do
+    case $opt in
+        d  ) DEVICE=$OPTARG
+            ;;
+        s  ) SECONDS_EACH=$OPTARG
+            ;;
+        n  ) SOCKETS=$OPTARG
+            ;;
+        h  ) usage
+            exit 1
+            ;;
+        \? ) usage
+            exit 1
+    esac
+done
+shift $(($OPTIND -1))
+
+if [ $# -eq 0 ] || [ "$1" = "" ] ; then
+	usage
+	exit
+fi
+ADDRESS=$1
+shift
+WORKERS="$*"
+if [ "$WORKERS" = "" ] ; then
+	WORKERS="0 1 2 4 8"
+fi
+
+echo "CPUs: `nproc`"
+echo "workers  RP/s"
+for COUNT in $WORKERS ; do
+	BACNET_BIP_WORKERS=$COUNT $DIR/bacserv $DEVICE > /dev/null 2>&1 &
+	SERVER=$!
+	sleep 1
+	RATE=`$DIR/bacrpbench $DEVICE $ADDRESS --seconds $SECONDS_EACH \
+		--sockets $SOCKETS | sed -n 's/.*rate=\([0-9]*\).*/\1/p'`
+	kill $SERVER
+	wait $SERVER 2>/dev/null
+	printf "%7s  %s\n" $COUNT $RATE
+done
@@ -268,11 +268,11 @@ int main(
                     (Target_Device_Object_Instance,
                     Communication_Timeout_Minutes, Communication_State,
                     Communication_Password);
-            } else if (tsm_invoke_id_free(invoke_id))
+            } else if (tsm_peer_invoke_id_free(&Target_Address, invoke_id))
                 break;
-            else if (tsm_invoke_id_failed(invoke_id)) {
+            else if (tsm_peer_invoke_id_failed(&Target_Address, invoke_id)) {
                 fprintf(stderr, "\rError: TSM Timeout!\n");
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(&Target_Address, invoke_id);
                 /* try again or abort? */
                 break;
             }
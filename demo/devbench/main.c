@@ -0,0 +1,185 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+
+/* command line tool that measures how long the Device object takes
+   to read a property of each type of object, without the network */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "bacdef.h"
+#include "bacenum.h"
+#include "bactext.h"
+#include "rp.h"
+#include "device.h"
+#include "version.h"
+/* some demo stuff needed */
+#include "filename.h"
+
+/** @file devbench/main.c  Device_Read_Property() microbenchmark.
+ *
+ * The objects of the server demo are created, and a property of the
+ * first object of each type is read many times through
+ * Device_Read_Property(), which finds the functions of the object type
+ * and calls its Read_Property.  The time per read shows the cost of
+ * that dispatch, and whether it depends on the type of the object.
+ */
+
+static uint8_t Read_Buffer[MAX_APDU];
+
+static uint64_t devbench_nanoseconds(
+    void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+/* reads the property of the object many times; returns the nanoseconds
+   per read, or a negative value if the object can not be read */
+static double devbench_read(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    unsigned long count)
+{
+    BACNET_READ_PROPERTY_DATA rpdata;
+    unsigned long i = 0;
+    uint64_t start = 0;
+    uint64_t elapsed = 0;
+
+    rpdata.object_type = object_type;
+    rpdata.object_instance = object_instance;
+    rpdata.object_property = object_property;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    rpdata.application_data = &Read_Buffer[0];
+    rpdata.application_data_len = sizeof(Read_Buffer);
+    if (Device_Read_Property(&rpdata) < 0) {
+        return -1.0;
+    }
+    start = devbench_nanoseconds();
+    for (i = 0; i < count; i++) {
+        (void) Device_Read_Property(&rpdata);
+    }
+    elapsed = devbench_nanoseconds() - start;
+
+    return (double) elapsed / (double) count;
+}
+
+static void print_usage(
+    const char *filename)
+{
+    printf("Usage: %s [--count N][--property P][--version][--help]\n",
+        filename);
+}
+
+static void print_help(
+    const char *filename)
+{
+    printf("Read a property of the first object of each type in the\n"
+        "server demo many times, and print the time of each read.\n"
+        "\n"
+        "--count N\n"
+        "Reads of each object.  Default is 5000000.\n"
+        "--property P\n"
+        "Property to read.  Default is 81, the Out_Of_Service.  Types\n"
+        "of object that do not have it are skipped.\n"
+        "\nExample:\n"
+        "%s --count 1000000\n", filename);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    BACNET_PROPERTY_ID object_property = PROP_OUT_OF_SERVICE;
+    unsigned long count = 5000000;
+    bool type_done[MAX_BACNET_OBJECT_TYPE] = { false };
+    const char *filename = NULL;
+    unsigned object_count = 0;
+    unsigned i = 0;
+    int argi = 0;
+    int object_type = 0;
+    uint32_t object_instance = 0;
+    double nanoseconds = 0.0;
+
+    filename = filename_remove_path(argv[0]);
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--help") == 0) {
+            print_usage(filename);
+            print_help(filename);
+            return 0;
+        } else if (strcmp(argv[argi], "--version") == 0) {
+            printf("%s %s\n", filename, BACNET_VERSION_TEXT);
+            printf("Copyright (C) 2018 by Steve Karg and others.\n"
+                "This is free software; see the source for copying conditions.\n"
+                "There is NO warranty; not even for MERCHANTABILITY or\n"
+                "FITNESS FOR A PARTICULAR PURPOSE.\n");
+            return 0;
+        } else if ((strcmp(argv[argi], "--count") == 0) &&
+            (++argi < argc)) {
+            count = strtoul(argv[argi], NULL, 0);
+        } else if ((strcmp(argv[argi], "--property") == 0) &&
+            (++argi < argc)) {
+            object_property = (BACNET_PROPERTY_ID) strtoul(argv[argi], NULL,
+                0);
+        } else {
+            print_usage(filename);
+            return 1;
+        }
+    }
+    if (count == 0) {
+        count = 1;
+    }
+    Device_Init(NULL);
+    printf("%-32s %12s\n", "object type", "ns per read");
+    object_count = Device_Object_List_Count();
+    for (i = 1; i <= object_count; i++) {
+        if (!Device_Object_List_Identifier(i, &object_type,
+                &object_instance)) {
+            continue;
+        }
+        if ((object_type >= MAX_BACNET_OBJECT_TYPE) ||
+            type_done[object_type]) {
+            continue;
+        }
+        type_done[object_type] = true;
+        nanoseconds =
+            devbench_read((BACNET_OBJECT_TYPE) object_type, object_instance,
+            object_property, count);
+        if (nanoseconds >= 0.0) {
+            printf("%-32s %12.1f\n", bactext_object_type_name(object_type),
+                nanoseconds);
+        }
+    }
+
+    return 0;
+}
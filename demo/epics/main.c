@@ -1606,14 +1606,16 @@ int main(
                     myState =
                         ProcessRPMData(Read_Property_Multiple_Data.rpm_data,
                         myState);
-                    if (tsm_invoke_id_free(Request_Invoke_ID)) {
+                    if (tsm_peer_invoke_id_free(&Target_Address,
+                        Request_Invoke_ID)) {
                         Request_Invoke_ID = 0;
                     } else {
                         assert(false);  /* How can this be? */
                         Request_Invoke_ID = 0;
                     }
                     elapsed_seconds = 0;
-                } else if (tsm_invoke_id_free(Request_Invoke_ID)) {
+                } else if (tsm_peer_invoke_id_free(&Target_Address,
+                    Request_Invoke_ID)) {
                     elapsed_seconds = 0;
                     Request_Invoke_ID = 0;
                     if (myState == GET_HEADING_RESPONSE)
@@ -1642,9 +1644,10 @@ int main(
                         myState = GET_ALL_REQUEST;      /* Let's try again */
                     else
                         myState = GET_PROPERTY_REQUEST;
-                } else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+                } else if (tsm_peer_invoke_id_failed(&Target_Address,
+                    Request_Invoke_ID)) {
                     fprintf(stderr, "\rError: TSM Timeout!\n");
-                    tsm_free_invoke_id(Request_Invoke_ID);
+                    tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                     Request_Invoke_ID = 0;
                     elapsed_seconds = 0;
                     if (myState == GET_HEADING_RESPONSE)
@@ -1700,7 +1703,8 @@ int main(
                         Read_Property_Multiple_Data.rpm_data->object_instance,
                         Read_Property_Multiple_Data.rpm_data->
                         listOfProperties);
-                    if (tsm_invoke_id_free(Request_Invoke_ID)) {
+                    if (tsm_peer_invoke_id_free(&Target_Address,
+                        Request_Invoke_ID)) {
                         Request_Invoke_ID = 0;
                     } else {
                         assert(false);  /* How can this be? */
@@ -1719,7 +1723,8 @@ int main(
                         Property_List_Index++;
                     }
                     myState = GET_PROPERTY_REQUEST;     /* Go fetch next Property */
-                } else if (tsm_invoke_id_free(Request_Invoke_ID)) {
+                } else if (tsm_peer_invoke_id_free(&Target_Address,
+                    Request_Invoke_ID)) {
                     Request_Invoke_ID = 0;
                     elapsed_seconds = 0;
                     myState = GET_PROPERTY_REQUEST;
@@ -1754,9 +1759,10 @@ int main(
                             }
                         }
                     }
-                } else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+                } else if (tsm_peer_invoke_id_failed(&Target_Address,
+                    Request_Invoke_ID)) {
                     fprintf(stderr, "\rError: TSM Timeout!\n");
-                    tsm_free_invoke_id(Request_Invoke_ID);
+                    tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                     elapsed_seconds = 0;
                     Request_Invoke_ID = 0;
                     myState = 3;        /* Let's try again, same Property */
@@ -0,0 +1,1973 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include "config.h"
+#include "txbuf.h"
+#include "bacdef.h"
+#include "bacdcode.h"
+#include "bacaddr.h"
+#include "address.h"
+#include "apdu.h"
+#include "npdu.h"
+#include "abort.h"
+#include "reject.h"
+#include "tsm.h"
+#include "cov.h"
+#include "rp.h"
+#include "datalink.h"
+#include "fnv.h"
+#include "minheap.h"
+/* some demo stuff needed */
+#include "handlers.h"
+#include "client.h"
+#include "cov_client.h"
+
+/** @file cov_client.c  Keeps COV subscriptions to the points of other
+ *  devices.
+ *
+ * Each point is a monitored object of a device, with a callback for its
+ * values.  The manager subscribes to the points, a few requests at a
+ * time so that the TSM is never used up, and renews each subscription
+ * before its lifetime runs out.  Renewals come due at a different part
+ * of the lifetime for each point, so that points subscribed together
+ * are not renewed together.  Notifications are matched to their point
+ * through a hash of the device and object.  Points of devices that do
+ * not know SubscribeCOV, and of objects that do not support COV, have
+ * their Present_Value read instead, every poll interval, and the
+ * callback is called when it changes.
+ */
+
+#ifndef MAX_COV_PROPERTIES
+#define MAX_COV_PROPERTIES 2
+#endif
+/* the points and devices start out with room for COV_CLIENT_POINTS and
+   COV_CLIENT_DEVICES, and double in size when full up to the _DYNAMIC
+   limits */
+#ifndef COV_CLIENT_POINTS
+#define COV_CLIENT_POINTS 256
+#endif
+#ifndef COV_CLIENT_POINTS_DYNAMIC
+#define COV_CLIENT_POINTS_DYNAMIC 65536
+#endif
+#ifndef COV_CLIENT_DEVICES
+#define COV_CLIENT_DEVICES 16
+#endif
+#ifndef COV_CLIENT_DEVICES_DYNAMIC
+#define COV_CLIENT_DEVICES_DYNAMIC 4096
+#endif
+/* seconds before a failed request is tried again */
+#ifndef COV_CLIENT_RETRY_SECONDS
+#define COV_CLIENT_RETRY_SECONDS 10
+#endif
+/* default seconds between reads of a polled point */
+#ifndef COV_CLIENT_POLL_SECONDS
+#define COV_CLIENT_POLL_SECONDS 30
+#endif
+
+/* marks the end of a chain of point or device indexes */
+#define COV_CLIENT_NO_INDEX UINT_MAX
+
+/* the request a point has outstanding */
+typedef enum {
+    COV_CLIENT_REQUEST_NONE,
+    COV_CLIENT_REQUEST_SUBSCRIBE,
+    COV_CLIENT_REQUEST_CANCEL,
+    COV_CLIENT_REQUEST_READ
+} COV_CLIENT_REQUEST;
+
+typedef struct cov_client_point_flags {
+    bool valid:1;
+    bool confirmed:1;   /* issueConfirmedNotifications */
+    bool subscribed:1;  /* the subscription has been acknowledged */
+    bool polling:1;     /* the object does not support COV */
+    bool cancel:1;      /* free once the subscription is cancelled */
+    bool queued:1;      /* on the send queue */
+    bool value_valid:1; /* value_hash holds the value last polled */
+} COV_CLIENT_POINT_FLAGS;
+
+typedef struct cov_client_point {
+    COV_CLIENT_POINT_FLAGS flag;
+    uint8_t request;    /* COV_CLIENT_REQUEST, while invoke_id is used */
+    uint8_t invoke_id;
+    unsigned device;
+    BACNET_OBJECT_ID object;
+    uint32_t lifetime;
+    cov_client_notify_function callback;
+    void *context;
+    /* position in COV_Client_Timer_Heap, or MIN_HEAP_NO_POSITION */
+    unsigned timer_position;
+    /* next point in the same hash bucket, or on the free list */
+    unsigned next;
+    /* next point with a request outstanding with the same invoke ID */
+    unsigned invoke_next;
+    /* hash of the Present_Value last polled */
+    uint32_t value_hash;
+} COV_CLIENT_POINT;
+
+typedef struct cov_client_device {
+    /* number of points of the device, 0 if the entry is free */
+    unsigned refcount;
+    /* next device in the same hash bucket, or on the free list */
+    unsigned next;
+    uint32_t device_id;
+    /* the device rejected SubscribeCOV, so all of its points are polled */
+    bool polling;
+    /* a Who-Is has been sent to bind, at COV_Client_Clock whois_time */
+    bool whois_sent;
+    uint32_t whois_time;
+} COV_CLIENT_DEVICE;
+
+static COV_CLIENT_POINT *COV_Client_Points;
+static unsigned COV_Client_Point_Size;
+static unsigned COV_Client_Point_Free = COV_CLIENT_NO_INDEX;
+static unsigned *COV_Client_Point_Hash;
+static unsigned COV_Client_Point_Hash_Size;
+static COV_CLIENT_DEVICE *COV_Client_Devices;
+static unsigned COV_Client_Device_Size;
+static unsigned COV_Client_Device_Free = COV_CLIENT_NO_INDEX;
+static unsigned *COV_Client_Device_Hash;
+static unsigned COV_Client_Device_Hash_Size;
+/* points needing a request, oldest first; a point is queued at most once */
+static unsigned *COV_Client_Queue;
+static unsigned COV_Client_Queue_Head;
+static unsigned COV_Client_Queue_Count;
+/* points with a request outstanding, chained by invoke ID */
+static unsigned COV_Client_Invoke[256];
+static unsigned COV_Client_Outstanding;
+/* points waiting for a renewal, poll or retry, soonest first */
+static void cov_client_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position);
+static MIN_HEAP COV_Client_Timer_Heap = {
+    NULL, 0, 0, cov_client_timer_moved, NULL
+};
+/* seconds counted by cov_client_timer_seconds() */
+static uint32_t COV_Client_Clock;
+static uint32_t COV_Client_Process_Identifier;
+static uint32_t COV_Client_Poll_Seconds = COV_CLIENT_POLL_SECONDS;
+/* requests outstanding at once; zero leaves half of the TSM free */
+static unsigned COV_Client_Requests_Max;
+/* the handlers set before cov_client_init(), which are passed the
+   replies that are not to requests of the COV client */
+static confirmed_simple_ack_function COV_Client_Subscribe_Ack_Next;
+static error_function COV_Client_Subscribe_Error_Next;
+static confirmed_ack_function COV_Client_Read_Property_Ack_Next;
+static error_function COV_Client_Read_Property_Error_Next;
+static abort_function COV_Client_Abort_Next;
+static reject_function COV_Client_Reject_Next;
+static void cov_client_subscribe_error_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code);
+static void cov_client_read_property_error_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code);
+
+static unsigned cov_client_hash_size(
+    unsigned size)
+{
+    unsigned hash_size = 1;
+
+    while (hash_size < size) {
+        hash_size *= 2;
+    }
+
+    return hash_size;
+}
+
+static uint32_t cov_client_point_key(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    uint32_t key = FNV_HASH_INIT;
+
+    key = FNV_Hash_Unsigned32(device_id, key);
+    key =
+        FNV_Hash_Unsigned32(((uint32_t) object_type << 22) | object_instance,
+        key);
+
+    return key;
+}
+
+static unsigned cov_client_point_bucket(
+    unsigned index)
+{
+    COV_CLIENT_POINT *point = &COV_Client_Points[index];
+
+    return (unsigned) (cov_client_point_key(COV_Client_Devices[point->
+                device].device_id,
+            (BACNET_OBJECT_TYPE) point->object.type,
+            point->object.instance) & (COV_Client_Point_Hash_Size - 1));
+}
+
+static unsigned cov_client_device_bucket(
+    uint32_t device_id)
+{
+    uint32_t key = device_id;
+
+    key ^= key >> 16;
+    key *= 0x45d9f3bUL;
+    key ^= key >> 16;
+
+    return (unsigned) (key & (COV_Client_Device_Hash_Size - 1));
+}
+
+/* doubles the device pool, rehashing the devices in use;
+   returns false if the pool is at its limit or memory is short */
+static bool cov_client_devices_grow(
+    void)
+{
+    COV_CLIENT_DEVICE *devices = NULL;
+    unsigned *hash = NULL;
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    unsigned bucket = 0;
+    unsigned i = 0;
+
+    if (COV_Client_Device_Size) {
+        size = COV_Client_Device_Size * 2;
+    } else {
+        size = COV_CLIENT_DEVICES;
+    }
+    if (size > COV_CLIENT_DEVICES_DYNAMIC) {
+        size = COV_CLIENT_DEVICES_DYNAMIC;
+    }
+    if (size <= COV_Client_Device_Size) {
+        return false;
+    }
+    devices = realloc(COV_Client_Devices, size * sizeof(COV_CLIENT_DEVICE));
+    if (!devices) {
+        return false;
+    }
+    COV_Client_Devices = devices;
+    hash_size = cov_client_hash_size(size);
+    if (hash_size != COV_Client_Device_Hash_Size) {
+        hash = realloc(COV_Client_Device_Hash, hash_size * sizeof(unsigned));
+        if (!hash) {
+            return false;
+        }
+        COV_Client_Device_Hash = hash;
+        COV_Client_Device_Hash_Size = hash_size;
+        for (i = 0; i < COV_Client_Device_Hash_Size; i++) {
+            COV_Client_Device_Hash[i] = COV_CLIENT_NO_INDEX;
+        }
+        for (i = 0; i < COV_Client_Device_Size; i++) {
+            if (COV_Client_Devices[i].refcount) {
+                bucket =
+                    cov_client_device_bucket(COV_Client_Devices[i].device_id);
+                COV_Client_Devices[i].next = COV_Client_Device_Hash[bucket];
+                COV_Client_Device_Hash[bucket] = i;
+            }
+        }
+    }
+    /* lowest index first on the free list */
+    for (i = size; i > COV_Client_Device_Size; i--) {
+        memset(&COV_Client_Devices[i - 1], 0, sizeof(COV_CLIENT_DEVICE));
+        COV_Client_Devices[i - 1].next = COV_Client_Device_Free;
+        COV_Client_Device_Free = i - 1;
+    }
+    COV_Client_Device_Size = size;
+
+    return true;
+}
+
+static unsigned cov_client_device_find(
+    uint32_t device_id)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+
+    if (COV_Client_Device_Hash_Size) {
+        index = COV_Client_Device_Hash[cov_client_device_bucket(device_id)];
+    }
+    while (index != COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Devices[index].device_id == device_id) {
+            break;
+        }
+        index = COV_Client_Devices[index].next;
+    }
+
+    return index;
+}
+
+/* adds a reference to the device, adding the device if it is new;
+   returns COV_CLIENT_NO_INDEX if there is no room */
+static unsigned cov_client_device_add(
+    uint32_t device_id)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+    unsigned bucket = 0;
+
+    index = cov_client_device_find(device_id);
+    if (index != COV_CLIENT_NO_INDEX) {
+        COV_Client_Devices[index].refcount++;
+        return index;
+    }
+    if (COV_Client_Device_Free == COV_CLIENT_NO_INDEX) {
+        (void) cov_client_devices_grow();
+    }
+    index = COV_Client_Device_Free;
+    if (index != COV_CLIENT_NO_INDEX) {
+        COV_Client_Device_Free = COV_Client_Devices[index].next;
+        memset(&COV_Client_Devices[index], 0, sizeof(COV_CLIENT_DEVICE));
+        COV_Client_Devices[index].device_id = device_id;
+        COV_Client_Devices[index].refcount = 1;
+        bucket = cov_client_device_bucket(device_id);
+        COV_Client_Devices[index].next = COV_Client_Device_Hash[bucket];
+        COV_Client_Device_Hash[bucket] = index;
+    }
+
+    return index;
+}
+
+static void cov_client_device_release(
+    unsigned index)
+{
+    unsigned *link = NULL;
+
+    if ((index < COV_Client_Device_Size) &&
+        COV_Client_Devices[index].refcount) {
+        COV_Client_Devices[index].refcount--;
+        if (COV_Client_Devices[index].refcount == 0) {
+            link =
+                &COV_Client_Device_Hash[cov_client_device_bucket
+                (COV_Client_Devices[index].device_id)];
+            while (*link != COV_CLIENT_NO_INDEX) {
+                if (*link == index) {
+                    *link = COV_Client_Devices[index].next;
+                    break;
+                }
+                link = &COV_Client_Devices[*link].next;
+            }
+            COV_Client_Devices[index].next = COV_Client_Device_Free;
+            COV_Client_Device_Free = index;
+        }
+    }
+}
+
+static void cov_client_point_link(
+    unsigned index)
+{
+    unsigned bucket = cov_client_point_bucket(index);
+
+    COV_Client_Points[index].next = COV_Client_Point_Hash[bucket];
+    COV_Client_Point_Hash[bucket] = index;
+}
+
+static void cov_client_point_unlink(
+    unsigned index)
+{
+    unsigned *link = &COV_Client_Point_Hash[cov_client_point_bucket(index)];
+
+    while (*link != COV_CLIENT_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Client_Points[index].next;
+            break;
+        }
+        link = &COV_Client_Points[*link].next;
+    }
+}
+
+/* doubles the point pool along with the structures indexed by it;
+   returns false if the pool is at its limit or memory is short */
+static bool cov_client_points_grow(
+    void)
+{
+    COV_CLIENT_POINT *points = NULL;
+    unsigned *queue = NULL;
+    unsigned *hash = NULL;
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    unsigned i = 0;
+
+    if (COV_Client_Point_Size) {
+        size = COV_Client_Point_Size * 2;
+    } else {
+        size = COV_CLIENT_POINTS;
+    }
+    if (size > COV_CLIENT_POINTS_DYNAMIC) {
+        size = COV_CLIENT_POINTS_DYNAMIC;
+    }
+    if (size <= COV_Client_Point_Size) {
+        return false;
+    }
+    points = realloc(COV_Client_Points, size * sizeof(COV_CLIENT_POINT));
+    if (!points) {
+        return false;
+    }
+    COV_Client_Points = points;
+    if (!Min_Heap_Reserve(&COV_Client_Timer_Heap, size)) {
+        return false;
+    }
+    /* the send queue is a ring, so unwrap it into the new one */
+    queue = malloc(size * sizeof(unsigned));
+    if (!queue) {
+        return false;
+    }
+    for (i = 0; i < COV_Client_Queue_Count; i++) {
+        queue[i] =
+            COV_Client_Queue[(COV_Client_Queue_Head +
+                i) % COV_Client_Point_Size];
+    }
+    free(COV_Client_Queue);
+    COV_Client_Queue = queue;
+    COV_Client_Queue_Head = 0;
+    hash_size = cov_client_hash_size(size);
+    if (hash_size != COV_Client_Point_Hash_Size) {
+        hash = realloc(COV_Client_Point_Hash, hash_size * sizeof(unsigned));
+        if (!hash) {
+            return false;
+        }
+        COV_Client_Point_Hash = hash;
+        COV_Client_Point_Hash_Size = hash_size;
+        for (i = 0; i < COV_Client_Point_Hash_Size; i++) {
+            COV_Client_Point_Hash[i] = COV_CLIENT_NO_INDEX;
+        }
+        for (i = 0; i < COV_Client_Point_Size; i++) {
+            if (COV_Client_Points[i].flag.valid &&
+                !COV_Client_Points[i].flag.cancel) {
+                cov_client_point_link(i);
+            }
+        }
+    }
+    /* lowest index first on the free list */
+    for (i = size; i > COV_Client_Point_Size; i--) {
+        memset(&COV_Client_Points[i - 1], 0, sizeof(COV_CLIENT_POINT));
+        COV_Client_Points[i - 1].timer_position = MIN_HEAP_NO_POSITION;
+        COV_Client_Points[i - 1].invoke_next = COV_CLIENT_NO_INDEX;
+        COV_Client_Points[i - 1].next = COV_Client_Point_Free;
+        COV_Client_Point_Free = i - 1;
+    }
+    COV_Client_Point_Size = size;
+
+    return true;
+}
+
+/* the point of the device and object, if subscribed */
+static unsigned cov_client_point_find(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+    COV_CLIENT_POINT *point = NULL;
+
+    if (COV_Client_Point_Hash_Size) {
+        index =
+            COV_Client_Point_Hash[cov_client_point_key(device_id, object_type,
+                object_instance) & (COV_Client_Point_Hash_Size - 1)];
+    }
+    while (index != COV_CLIENT_NO_INDEX) {
+        point = &COV_Client_Points[index];
+        if ((point->object.type == object_type) &&
+            (point->object.instance == object_instance) &&
+            (COV_Client_Devices[point->device].device_id == device_id)) {
+            break;
+        }
+        index = point->next;
+    }
+
+    return index;
+}
+
+static void cov_client_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position)
+{
+    (void) context;
+    COV_Client_Points[index].timer_position = position;
+}
+
+static void cov_client_timer_stop(
+    unsigned index)
+{
+    (void) Min_Heap_Remove(&COV_Client_Timer_Heap,
+        COV_Client_Points[index].timer_position);
+}
+
+/* the point needs a request again in the given number of seconds */
+static void cov_client_timer_start(
+    unsigned index,
+    uint32_t seconds)
+{
+    cov_client_timer_stop(index);
+    /* cannot fail, since the heap has room for every point */
+    (void) Min_Heap_Insert(&COV_Client_Timer_Heap, index,
+        COV_Client_Clock + seconds);
+}
+
+/* seconds until a subscription of the point is renewed: somewhere in
+   the middle half of its lifetime, at a place set by the point, so
+   that the points subscribed in one go are renewed over a spread of
+   time rather than all at once.  A lifetime too short to have a
+   quarter is still renewed a second early, so that the renewal is
+   queued a tick before the subscription runs out; zero renews it at
+   once. */
+static uint32_t cov_client_renewal_seconds(
+    unsigned index)
+{
+    COV_CLIENT_POINT *point = &COV_Client_Points[index];
+    uint32_t quarter = point->lifetime / 4;
+    uint32_t early = 1;
+
+    if (quarter) {
+        early = quarter +
+            cov_client_point_key(COV_Client_Devices[point->device].device_id,
+            (BACNET_OBJECT_TYPE) point->object.type,
+            point->object.instance) % quarter;
+    }
+    if (early >= point->lifetime) {
+        return 0;
+    }
+
+    return point->lifetime - early;
+}
+
+static void cov_client_enqueue(
+    unsigned index)
+{
+    if (!COV_Client_Points[index].flag.queued) {
+        COV_Client_Queue[(COV_Client_Queue_Head +
+                COV_Client_Queue_Count) % COV_Client_Point_Size] = index;
+        COV_Client_Queue_Count++;
+        COV_Client_Points[index].flag.queued = true;
+    }
+}
+
+static unsigned cov_client_dequeue(
+    void)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+
+    if (COV_Client_Queue_Count) {
+        index = COV_Client_Queue[COV_Client_Queue_Head];
+        COV_Client_Queue_Head =
+            (COV_Client_Queue_Head + 1) % COV_Client_Point_Size;
+        COV_Client_Queue_Count--;
+        COV_Client_Points[index].flag.queued = false;
+    }
+
+    return index;
+}
+
+static void cov_client_invoke_link(
+    unsigned index,
+    uint8_t invoke_id,
+    COV_CLIENT_REQUEST request)
+{
+    COV_Client_Points[index].invoke_id = invoke_id;
+    COV_Client_Points[index].request = (uint8_t) request;
+    COV_Client_Points[index].invoke_next = COV_Client_Invoke[invoke_id];
+    COV_Client_Invoke[invoke_id] = index;
+    COV_Client_Outstanding++;
+}
+
+static void cov_client_invoke_unlink(
+    unsigned index)
+{
+    unsigned *link = NULL;
+
+    if (COV_Client_Points[index].request == COV_CLIENT_REQUEST_NONE) {
+        return;
+    }
+    link = &COV_Client_Invoke[COV_Client_Points[index].invoke_id];
+    while (*link != COV_CLIENT_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Client_Points[index].invoke_next;
+            break;
+        }
+        link = &COV_Client_Points[*link].invoke_next;
+    }
+    COV_Client_Points[index].invoke_next = COV_CLIENT_NO_INDEX;
+    COV_Client_Points[index].invoke_id = 0;
+    COV_Client_Points[index].request = COV_CLIENT_REQUEST_NONE;
+    COV_Client_Outstanding--;
+}
+
+/* the point with the request the reply is for, which is no longer
+   outstanding, or COV_CLIENT_NO_INDEX if it is not one of ours;
+   the kind of request is given in request, if not NULL */
+static unsigned cov_client_reply_point(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t * request)
+{
+    unsigned index = COV_Client_Invoke[invoke_id];
+    uint32_t device_id = 0;
+
+    if ((index == COV_CLIENT_NO_INDEX) ||
+        !address_get_device_id(src, &device_id)) {
+        return COV_CLIENT_NO_INDEX;
+    }
+    while (index != COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Devices[COV_Client_Points[index].device].device_id ==
+            device_id) {
+            if (request) {
+                *request = COV_Client_Points[index].request;
+            }
+            cov_client_invoke_unlink(index);
+            break;
+        }
+        index = COV_Client_Points[index].invoke_next;
+    }
+
+    return index;
+}
+
+/* returns the slot to the free list; a slot still on the send queue
+   is skipped by cov_client_task() since it is no longer valid, and is
+   not reused until it has left the queue */
+static void cov_client_point_free(
+    unsigned index)
+{
+    COV_CLIENT_POINT *point = &COV_Client_Points[index];
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+
+    if (point->request != COV_CLIENT_REQUEST_NONE) {
+        if (address_get_by_device(COV_Client_Devices[point->device].
+                device_id, &max_apdu, &dest)) {
+            tsm_free_peer_invoke_id(&dest, point->invoke_id);
+        }
+        cov_client_invoke_unlink(index);
+    }
+    cov_client_timer_stop(index);
+    if (!point->flag.cancel) {
+        cov_client_point_unlink(index);
+    }
+    cov_client_device_release(point->device);
+    point->flag.valid = false;
+    point->callback = NULL;
+    if (!point->flag.queued) {
+        point->next = COV_Client_Point_Free;
+        COV_Client_Point_Free = index;
+    }
+}
+
+/* the device does not know SubscribeCOV, or the object does not
+   support COV, so the point is polled from now on */
+static void cov_client_polling_start(
+    unsigned index)
+{
+    COV_Client_Points[index].flag.polling = true;
+    COV_Client_Points[index].flag.subscribed = false;
+    cov_client_timer_stop(index);
+    cov_client_enqueue(index);
+}
+
+/* the request failed, so try it again later */
+static void cov_client_retry(
+    unsigned index)
+{
+    cov_client_timer_start(index, COV_CLIENT_RETRY_SECONDS);
+}
+
+/** Sets up the COV client, forgetting all of the points.
+ * @ingroup DSCOV
+ * The handlers for the replies to its requests and for COV notifications
+ * are set with apdu_set_...().  The SubscribeCOV and ReadProperty reply
+ * handlers, and the Abort and Reject handlers, that were set before are
+ * kept, and are passed the replies to requests the COV client did not
+ * send, so the application should set its own handlers first.
+ *
+ * @param process_identifier [in] subscriberProcessIdentifier of all of
+ *  the subscriptions
+ */
+void cov_client_init(
+    uint32_t process_identifier)
+{
+    confirmed_simple_ack_function simple_ack_handler = NULL;
+    confirmed_ack_function ack_handler = NULL;
+    error_function error_handler = NULL;
+    abort_function abort_handler = NULL;
+    reject_function reject_handler = NULL;
+    unsigned i = 0;
+
+    free(COV_Client_Points);
+    COV_Client_Points = NULL;
+    COV_Client_Point_Size = 0;
+    COV_Client_Point_Free = COV_CLIENT_NO_INDEX;
+    free(COV_Client_Point_Hash);
+    COV_Client_Point_Hash = NULL;
+    COV_Client_Point_Hash_Size = 0;
+    free(COV_Client_Devices);
+    COV_Client_Devices = NULL;
+    COV_Client_Device_Size = 0;
+    COV_Client_Device_Free = COV_CLIENT_NO_INDEX;
+    free(COV_Client_Device_Hash);
+    COV_Client_Device_Hash = NULL;
+    COV_Client_Device_Hash_Size = 0;
+    free(COV_Client_Queue);
+    COV_Client_Queue = NULL;
+    COV_Client_Queue_Head = 0;
+    COV_Client_Queue_Count = 0;
+    Min_Heap_Cleanup(&COV_Client_Timer_Heap);
+    for (i = 0; i < 256; i++) {
+        COV_Client_Invoke[i] = COV_CLIENT_NO_INDEX;
+    }
+    COV_Client_Outstanding = 0;
+    COV_Client_Process_Identifier = process_identifier;
+    (void) cov_client_points_grow();
+    (void) cov_client_devices_grow();
+    apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_COV_NOTIFICATION,
+        cov_client_ucov_notification_handler);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_COV_NOTIFICATION,
+        cov_client_ccov_notification_handler);
+    /* keep the handlers set before, unless they are our own from an
+       earlier call */
+    simple_ack_handler =
+        apdu_get_confirmed_simple_ack_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV);
+    if (simple_ack_handler != cov_client_subscribe_ack_handler) {
+        COV_Client_Subscribe_Ack_Next = simple_ack_handler;
+    }
+    error_handler = apdu_get_error_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV);
+    if (error_handler != cov_client_subscribe_error_handler) {
+        COV_Client_Subscribe_Error_Next = error_handler;
+    }
+    ack_handler =
+        apdu_get_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROPERTY);
+    if (ack_handler != cov_client_read_property_ack_handler) {
+        COV_Client_Read_Property_Ack_Next = ack_handler;
+    }
+    error_handler = apdu_get_error_handler(SERVICE_CONFIRMED_READ_PROPERTY);
+    if (error_handler != cov_client_read_property_error_handler) {
+        COV_Client_Read_Property_Error_Next = error_handler;
+    }
+    abort_handler = apdu_get_abort_handler();
+    if (abort_handler != cov_client_abort_handler) {
+        COV_Client_Abort_Next = abort_handler;
+    }
+    reject_handler = apdu_get_reject_handler();
+    if (reject_handler != cov_client_reject_handler) {
+        COV_Client_Reject_Next = reject_handler;
+    }
+    apdu_set_confirmed_simple_ack_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
+        cov_client_subscribe_ack_handler);
+    apdu_set_error_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
+        cov_client_subscribe_error_handler);
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROPERTY,
+        cov_client_read_property_ack_handler);
+    apdu_set_error_handler(SERVICE_CONFIRMED_READ_PROPERTY,
+        cov_client_read_property_error_handler);
+    apdu_set_abort_handler(cov_client_abort_handler);
+    apdu_set_reject_handler(cov_client_reject_handler);
+}
+
+/** Adds a point, which is subscribed to by cov_client_task().
+ * @ingroup DSCOV
+ * Subscribing to a point again changes its subscription.
+ *
+ * @param device_id [in] device of the monitored object
+ * @param object_type [in] type of the monitored object
+ * @param object_instance [in] instance of the monitored object
+ * @param confirmed [in] true for confirmed notifications
+ * @param lifetime [in] seconds the subscription lasts between renewals,
+ *  or zero for an indefinite subscription, which is never renewed
+ * @param callback [in] called with the values notified or polled
+ * @param context [in] passed to the callback
+ * @return true if the point was added, false if there is no room
+ */
+bool cov_client_subscribe(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    bool confirmed,
+    uint32_t lifetime,
+    cov_client_notify_function callback,
+    void *context)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+    unsigned device = COV_CLIENT_NO_INDEX;
+    COV_CLIENT_POINT *point = NULL;
+
+    if (!COV_Client_Point_Size || !COV_Client_Device_Size) {
+        return false;
+    }
+    index = cov_client_point_find(device_id, object_type, object_instance);
+    if (index == COV_CLIENT_NO_INDEX) {
+        device = cov_client_device_add(device_id);
+        if (device == COV_CLIENT_NO_INDEX) {
+            return false;
+        }
+        if (COV_Client_Point_Free == COV_CLIENT_NO_INDEX) {
+            (void) cov_client_points_grow();
+        }
+        index = COV_Client_Point_Free;
+        if (index == COV_CLIENT_NO_INDEX) {
+            cov_client_device_release(device);
+            return false;
+        }
+        COV_Client_Point_Free = COV_Client_Points[index].next;
+        point = &COV_Client_Points[index];
+        memset(&point->flag, 0, sizeof(point->flag));
+        point->flag.valid = true;
+        point->request = COV_CLIENT_REQUEST_NONE;
+        point->invoke_id = 0;
+        point->invoke_next = COV_CLIENT_NO_INDEX;
+        point->timer_position = MIN_HEAP_NO_POSITION;
+        point->device = device;
+        point->object.type = object_type;
+        point->object.instance = object_instance;
+        cov_client_point_link(index);
+    }
+    point = &COV_Client_Points[index];
+    point->flag.confirmed = confirmed;
+    point->lifetime = lifetime;
+    point->callback = callback;
+    point->context = context;
+    cov_client_timer_stop(index);
+    cov_client_enqueue(index);
+
+    return true;
+}
+
+/** Removes a point, cancelling its subscription.
+ * @ingroup DSCOV
+ *
+ * @param device_id [in] device of the monitored object
+ * @param object_type [in] type of the monitored object
+ * @param object_instance [in] instance of the monitored object
+ * @return true if the point was found
+ */
+bool cov_client_unsubscribe(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+    COV_CLIENT_POINT *point = NULL;
+
+    index = cov_client_point_find(device_id, object_type, object_instance);
+    if (index == COV_CLIENT_NO_INDEX) {
+        return false;
+    }
+    point = &COV_Client_Points[index];
+    if (point->flag.subscribed) {
+        /* out of the way of a new subscription to the same point,
+           and freed once the cancellation has been sent */
+        cov_client_point_unlink(index);
+        point->flag.cancel = true;
+        point->callback = NULL;
+        cov_client_timer_stop(index);
+        cov_client_enqueue(index);
+    } else {
+        cov_client_point_free(index);
+    }
+
+    return true;
+}
+
+/** Tells whether the points of a device are polled.
+ * @ingroup DSCOV
+ *
+ * @param device_id [in] the device
+ * @return true if the device has rejected SubscribeCOV
+ */
+bool cov_client_device_polled(
+    uint32_t device_id)
+{
+    unsigned index = cov_client_device_find(device_id);
+
+    return ((index != COV_CLIENT_NO_INDEX) &&
+        COV_Client_Devices[index].polling);
+}
+
+/** Sets the time between reads of the points that are polled.
+ * @ingroup DSCOV
+ *
+ * @param seconds [in] the poll interval
+ */
+void cov_client_poll_interval_set(
+    uint32_t seconds)
+{
+    if (seconds) {
+        COV_Client_Poll_Seconds = seconds;
+    }
+}
+
+/** Sets the number of requests the COV client may have outstanding.
+ * @ingroup DSCOV
+ *
+ * @param count [in] the number of requests, or zero to use half of
+ *  the TSM transactions, leaving the rest for the application
+ */
+void cov_client_requests_max_set(
+    unsigned count)
+{
+    COV_Client_Requests_Max = count;
+}
+
+/** Counts time for the renewals and polls of the points.
+ * @ingroup DSCOV
+ * The points are kept in order of when they need a request next, so
+ * only the ones that are due are visited, and queued for
+ * cov_client_task().
+ *
+ * @param elapsed_seconds [in] seconds since the last call
+ */
+void cov_client_timer_seconds(
+    uint32_t elapsed_seconds)
+{
+    unsigned index = 0;
+    uint32_t due = 0;
+
+    COV_Client_Clock += elapsed_seconds;
+    while (Min_Heap_Peek(&COV_Client_Timer_Heap, &index, &due)) {
+        if ((int32_t) (due - COV_Client_Clock) > 0) {
+            break;
+        }
+        cov_client_timer_stop(index);
+        cov_client_enqueue(index);
+    }
+}
+
+/* finishes the requests that were freed in the TSM without a reply
+   coming to our handlers, which is a timeout or a reply taken by
+   another handler */
+static void cov_client_outstanding_task(
+    void)
+{
+    unsigned invoke_id = 0;
+    unsigned index = 0;
+    unsigned next = 0;
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    bool done = false;
+
+    for (invoke_id = 1; invoke_id < 256; invoke_id++) {
+        index = COV_Client_Invoke[invoke_id];
+        while (index != COV_CLIENT_NO_INDEX) {
+            next = COV_Client_Points[index].invoke_next;
+            done = true;
+            if (address_get_by_device(COV_Client_Devices[COV_Client_Points
+                        [index].device].device_id, &max_apdu, &dest)) {
+                if (tsm_peer_invoke_id_failed(&dest, (uint8_t) invoke_id)) {
+                    tsm_free_peer_invoke_id(&dest, (uint8_t) invoke_id);
+                } else if (!tsm_peer_invoke_id_free(&dest,
+                        (uint8_t) invoke_id)) {
+                    done = false;
+                }
+            }
+            if (done) {
+                cov_client_invoke_unlink(index);
+                if (COV_Client_Points[index].flag.cancel) {
+                    cov_client_point_free(index);
+                } else {
+                    cov_client_retry(index);
+                }
+            }
+            index = next;
+        }
+    }
+}
+
+/* sends the request the point needs; returns false if it could not be
+   sent now, and should be tried again */
+static bool cov_client_request(
+    unsigned index)
+{
+    COV_CLIENT_POINT *point = &COV_Client_Points[index];
+    COV_CLIENT_DEVICE *device = &COV_Client_Devices[point->device];
+    BACNET_SUBSCRIBE_COV_DATA cov_data;
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    uint8_t invoke_id = 0;
+    COV_CLIENT_REQUEST request = COV_CLIENT_REQUEST_SUBSCRIBE;
+
+    if (!address_get_by_device(device->device_id, &max_apdu, &dest)) {
+        /* bind to the device, asking for it once per retry period */
+        if (!device->whois_sent ||
+            ((COV_Client_Clock - device->whois_time) >=
+                COV_CLIENT_RETRY_SECONDS)) {
+            (void) address_bind_request(device->device_id, &max_apdu, &dest);
+            Send_WhoIs(device->device_id, device->device_id);
+            device->whois_sent = true;
+            device->whois_time = COV_Client_Clock;
+        }
+        cov_client_retry(index);
+        return true;
+    }
+    if (point->flag.cancel) {
+        request = COV_CLIENT_REQUEST_CANCEL;
+    } else if (point->flag.polling || device->polling) {
+        request = COV_CLIENT_REQUEST_READ;
+    }
+    if (request == COV_CLIENT_REQUEST_READ) {
+        invoke_id =
+            Send_Read_Property_Request(device->device_id,
+            (BACNET_OBJECT_TYPE) point->object.type, point->object.instance,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL);
+    } else {
+        memset(&cov_data, 0, sizeof(cov_data));
+        cov_data.subscriberProcessIdentifier = COV_Client_Process_Identifier;
+        cov_data.monitoredObjectIdentifier.type = point->object.type;
+        cov_data.monitoredObjectIdentifier.instance = point->object.instance;
+        cov_data.cancellationRequest = point->flag.cancel;
+        cov_data.issueConfirmedNotifications = point->flag.confirmed;
+        cov_data.lifetime = point->lifetime;
+        invoke_id = Send_COV_Subscribe(device->device_id, &cov_data);
+    }
+    if (!invoke_id) {
+        return false;
+    }
+    cov_client_invoke_link(index, invoke_id, request);
+
+    return true;
+}
+
+/** Sends the requests of the points that need one.
+ * @ingroup DSCOV
+ * Subscriptions, renewals, cancellations and polls are sent oldest
+ * first, only while fewer than the maximum number of requests are
+ * outstanding and the TSM has a transaction free, so a large number
+ * of points is subscribed to at the pace the network replies.
+ * Call it from the main loop, along with tsm_timer_milliseconds().
+ */
+void cov_client_task(
+    void)
+{
+    unsigned index = 0;
+    unsigned count = 0;
+    unsigned requests_max = COV_Client_Requests_Max;
+
+    if (COV_Client_Outstanding) {
+        cov_client_outstanding_task();
+    }
+    if (!requests_max) {
+        requests_max = MAX_TSM_TRANSACTIONS / 2;
+        if (!requests_max) {
+            requests_max = 1;
+        }
+    }
+    /* look at each queued point at most once */
+    count = COV_Client_Queue_Count;
+    while (count && (COV_Client_Outstanding < requests_max) &&
+        tsm_transaction_available()) {
+        count--;
+        index = cov_client_dequeue();
+        if (!COV_Client_Points[index].flag.valid) {
+            /* removed since it was queued */
+            COV_Client_Points[index].next = COV_Client_Point_Free;
+            COV_Client_Point_Free = index;
+            continue;
+        }
+        if (COV_Client_Points[index].request != COV_CLIENT_REQUEST_NONE) {
+            /* changed while a request is outstanding - after it */
+            cov_client_enqueue(index);
+            continue;
+        }
+        if (!cov_client_request(index)) {
+            /* no invoke ID free for the device - try again later */
+            cov_client_enqueue(index);
+            break;
+        }
+    }
+}
+
+/* calls the callback of the point with the values of the object */
+static void cov_client_dispatch(
+    uint32_t device_id,
+    BACNET_OBJECT_ID * object_id,
+    uint32_t subscriber_process_identifier,
+    BACNET_PROPERTY_VALUE * values)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+
+    if (subscriber_process_identifier != COV_Client_Process_Identifier) {
+        return;
+    }
+    index =
+        cov_client_point_find(device_id,
+        (BACNET_OBJECT_TYPE) object_id->type, object_id->instance);
+    if ((index != COV_CLIENT_NO_INDEX) &&
+        COV_Client_Points[index].callback) {
+        COV_Client_Points[index].callback(device_id, object_id, values,
+            COV_Client_Points[index].context);
+    }
+}
+
+/** Handler for an Unconfirmed COV Notification to the COV client.
+ * @ingroup DSCOV
+ * Calls the callback of the point that was notified.
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param context [in] Source address of the message and the reply buffers
+ */
+void cov_client_ucov_notification_handler(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_REQUEST_CONTEXT * context)
+{
+    BACNET_COV_DATA cov_data;
+    BACNET_PROPERTY_VALUE property_value[MAX_COV_PROPERTIES];
+    int len = 0;
+
+    (void) context;
+    bacapp_property_value_list_init(&property_value[0], MAX_COV_PROPERTIES);
+    cov_data.listOfValues = &property_value[0];
+    len =
+        cov_notify_decode_service_request(service_request, service_len,
+        &cov_data);
+    if (len > 0) {
+        cov_client_dispatch(cov_data.initiatingDeviceIdentifier,
+            &cov_data.monitoredObjectIdentifier,
+            cov_data.subscriberProcessIdentifier, cov_data.listOfValues);
+    }
+}
+
+/** Handler for a Confirmed COV Notification to the COV client.
+ * @ingroup DSCOV
+ * Calls the callback of the point that was notified, and replies with
+ * a Simple Ack, or an Abort if the notification could not be decoded.
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param context [in] Source address of the message and the reply buffers
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void cov_client_ccov_notification_handler(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_COV_DATA cov_data;
+    BACNET_PROPERTY_VALUE property_value[MAX_COV_PROPERTIES];
+    BACNET_ADDRESS my_address;
+    int len = 0;
+    int pdu_len = 0;
+    int bytes_sent = 0;
+
+    bacapp_property_value_list_init(&property_value[0], MAX_COV_PROPERTIES);
+    cov_data.listOfValues = &property_value[0];
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len =
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
+        &npdu_data);
+    if (service_data->segmented_message) {
+        len =
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
+            service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
+            true);
+    } else {
+        len =
+            cov_notify_decode_service_request(service_request, service_len,
+            &cov_data);
+        if (len > 0) {
+            len =
+                encode_simple_ack(&context->tx_buffer[pdu_len],
+                service_data->invoke_id, SERVICE_CONFIRMED_COV_NOTIFICATION);
+            cov_client_dispatch(cov_data.initiatingDeviceIdentifier,
+                &cov_data.monitoredObjectIdentifier,
+                cov_data.subscriberProcessIdentifier, cov_data.listOfValues);
+        } else {
+            len =
+                abort_encode_apdu(&context->tx_buffer[pdu_len],
+                service_data->invoke_id, ABORT_REASON_OTHER, true);
+        }
+    }
+    pdu_len += len;
+    bytes_sent =
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+        pdu_len);
+#if PRINT_ENABLED
+    if (bytes_sent <= 0) {
+        fprintf(stderr, "COV Client: Failed to send PDU (%s)!\n",
+            strerror(errno));
+    }
+#else
+    (void) bytes_sent;
+#endif
+}
+
+/** Handler for the Simple Ack of a SubscribeCOV of the COV client.
+ * @ingroup DSCOV
+ * A subscription with a lifetime is set to be renewed, and a cancelled
+ * point is freed.  The ack of a request the COV client did not send is
+ * passed to the handler set before cov_client_init().
+ *
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param invoke_id [in] the invokeID from the acknowledged message
+ */
+void cov_client_subscribe_ack_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id)
+{
+    unsigned index = cov_client_reply_point(src, invoke_id, NULL);
+    uint32_t seconds = 0;
+
+    if (index == COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Subscribe_Ack_Next) {
+            COV_Client_Subscribe_Ack_Next(src, invoke_id);
+        }
+        return;
+    }
+    if (COV_Client_Points[index].flag.cancel) {
+        cov_client_point_free(index);
+        return;
+    }
+    COV_Client_Points[index].flag.subscribed = true;
+    if (COV_Client_Points[index].lifetime) {
+        seconds = cov_client_renewal_seconds(index);
+        if (seconds) {
+            cov_client_timer_start(index, seconds);
+        } else {
+            cov_client_enqueue(index);
+        }
+    }
+}
+
+/** Handler for the ReadProperty Ack of a poll of the COV client.
+ * @ingroup DSCOV
+ * Calls the callback of the point when its Present_Value has changed.
+ * The ack of a request the COV client did not send is passed to the
+ * handler set before cov_client_init().
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_ACK_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void cov_client_read_property_ack_handler(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
+{
+    BACNET_READ_PROPERTY_DATA rp_data;
+    BACNET_PROPERTY_VALUE property_value;
+    COV_CLIENT_POINT *point = NULL;
+    unsigned index = 0;
+    uint32_t hash = 0;
+    int len = 0;
+
+    index = cov_client_reply_point(src, service_data->invoke_id, NULL);
+    if (index == COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Read_Property_Ack_Next) {
+            COV_Client_Read_Property_Ack_Next(service_request, service_len,
+                src, service_data);
+        }
+        return;
+    }
+    point = &COV_Client_Points[index];
+    len = rp_ack_decode_service_request(service_request, service_len, &rp_data);
+    if ((len > 0) &&
+        (bacapp_decode_application_data(rp_data.application_data,
+                (unsigned) rp_data.application_data_len,
+                &property_value.value) > 0)) {
+        hash =
+            FNV_Hash(rp_data.application_data,
+            (size_t) rp_data.application_data_len, FNV_HASH_INIT);
+        if (!point->flag.value_valid || (point->value_hash != hash)) {
+            point->flag.value_valid = true;
+            point->value_hash = hash;
+            property_value.propertyIdentifier = PROP_PRESENT_VALUE;
+            property_value.propertyArrayIndex = BACNET_ARRAY_ALL;
+            property_value.priority = BACNET_NO_PRIORITY;
+            property_value.value.next = NULL;
+            property_value.next = NULL;
+            if (point->callback) {
+                point->callback(COV_Client_Devices[point->device].device_id,
+                    &point->object, &property_value, point->context);
+            }
+        }
+    }
+    cov_client_timer_start(index, COV_Client_Poll_Seconds);
+}
+
+/* handles an Error reply; returns false if the request was not one
+   of ours */
+static bool cov_client_error(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CODE error_code)
+{
+    unsigned index = COV_CLIENT_NO_INDEX;
+    uint8_t request = COV_CLIENT_REQUEST_NONE;
+
+    index = cov_client_reply_point(src, invoke_id, &request);
+    if (index == COV_CLIENT_NO_INDEX) {
+        return false;
+    }
+    if (COV_Client_Points[index].flag.cancel) {
+        cov_client_point_free(index);
+    } else if (request == COV_CLIENT_REQUEST_READ) {
+        cov_client_timer_start(index, COV_Client_Poll_Seconds);
+    } else if ((error_code == ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED)
+        || (error_code == ERROR_CODE_SERVICE_REQUEST_DENIED)) {
+        cov_client_polling_start(index);
+    } else {
+        cov_client_retry(index);
+    }
+
+    return true;
+}
+
+/** Handler for an Error reply to a request of the COV client.
+ * @ingroup DSCOV
+ * A point whose object does not support COV is polled from then on.
+ * An Error to a request the COV client did not send is ignored, so an
+ * application with error handlers of its own can call on to this one.
+ *
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param invoke_id [in] the invokeID from the message in error
+ * @param error_class [in] the error class
+ * @param error_code [in] the error code
+ */
+void cov_client_error_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    (void) error_class;
+    (void) cov_client_error(src, invoke_id, error_code);
+}
+
+/* the Error handlers set by cov_client_init(), which pass on the errors
+   that are not ours */
+static void cov_client_subscribe_error_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    if (!cov_client_error(src, invoke_id, error_code) &&
+        COV_Client_Subscribe_Error_Next) {
+        COV_Client_Subscribe_Error_Next(src, invoke_id, error_class,
+            error_code);
+    }
+}
+
+static void cov_client_read_property_error_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    if (!cov_client_error(src, invoke_id, error_code) &&
+        COV_Client_Read_Property_Error_Next) {
+        COV_Client_Read_Property_Error_Next(src, invoke_id, error_class,
+            error_code);
+    }
+}
+
+/** Handler for an Abort reply to a request of the COV client.
+ * @ingroup DSCOV
+ * The request is tried again later.  The Abort of a request the COV
+ * client did not send is passed to the handler set before
+ * cov_client_init().
+ *
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param invoke_id [in] the invokeID from the aborted message
+ * @param abort_reason [in] the reason for the message abort
+ * @param server [in] true if the abort came from the server
+ */
+void cov_client_abort_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t abort_reason,
+    bool server)
+{
+    unsigned index = cov_client_reply_point(src, invoke_id, NULL);
+
+    if (index == COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Abort_Next) {
+            COV_Client_Abort_Next(src, invoke_id, abort_reason, server);
+        }
+        return;
+    }
+    if (COV_Client_Points[index].flag.cancel) {
+        cov_client_point_free(index);
+    } else {
+        cov_client_retry(index);
+    }
+}
+
+/** Handler for a Reject reply to a request of the COV client.
+ * @ingroup DSCOV
+ * A device that does not know SubscribeCOV has all of its points polled
+ * from then on.  The Reject of a request the COV client did not send is
+ * passed to the handler set before cov_client_init().
+ *
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param invoke_id [in] the invokeID from the rejected message
+ * @param reject_reason [in] the reason for the rejection
+ */
+void cov_client_reject_handler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t reject_reason)
+{
+    unsigned index = cov_client_reply_point(src, invoke_id, NULL);
+
+    if (index == COV_CLIENT_NO_INDEX) {
+        if (COV_Client_Reject_Next) {
+            COV_Client_Reject_Next(src, invoke_id, reject_reason);
+        }
+        return;
+    }
+    if (COV_Client_Points[index].flag.cancel) {
+        cov_client_point_free(index);
+    } else if (reject_reason == REJECT_REASON_UNRECOGNIZED_SERVICE) {
+        COV_Client_Devices[COV_Client_Points[index].device].polling = true;
+        cov_client_polling_start(index);
+    } else {
+        cov_client_retry(index);
+    }
+}
+
+#ifdef TEST
+#include <assert.h>
+#include "ctest.h"
+
+/* the rest of the stack, as far as the COV client needs it: every
+   device is bound, at a one octet MAC address of its device ID, and
+   the requests sent are counted and kept for the tests */
+static unsigned Test_Request_Count;
+static COV_CLIENT_REQUEST Test_Request;
+static BACNET_SUBSCRIBE_COV_DATA Test_Subscribe_Data;
+static uint8_t Test_Invoke_ID;
+static bool Test_Invoke_Failed;
+static unsigned Test_Abort_Count;
+static unsigned Test_Notify_Count;
+
+static void testAbortHandler(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t abort_reason,
+    bool server)
+{
+    (void) src;
+    (void) invoke_id;
+    (void) abort_reason;
+    (void) server;
+    Test_Abort_Count++;
+}
+
+static void testNotify(
+    uint32_t device_id,
+    BACNET_OBJECT_ID * object_id,
+    BACNET_PROPERTY_VALUE * values,
+    void *context)
+{
+    (void) device_id;
+    (void) object_id;
+    (void) values;
+    (void) context;
+    Test_Notify_Count++;
+}
+
+static void testAddress(
+    uint32_t device_id,
+    BACNET_ADDRESS * dest)
+{
+    memset(dest, 0, sizeof(BACNET_ADDRESS));
+    dest->mac_len = 1;
+    dest->mac[0] = (uint8_t) device_id;
+}
+
+static uint8_t testInvokeID(
+    void)
+{
+    Test_Invoke_ID++;
+    if (Test_Invoke_ID == 0) {
+        Test_Invoke_ID = 1;
+    }
+    Test_Request_Count++;
+
+    return Test_Invoke_ID;
+}
+
+bool address_get_by_device(
+    uint32_t device_id,
+    unsigned *max_apdu,
+    BACNET_ADDRESS * src)
+{
+    *max_apdu = MAX_APDU;
+    testAddress(device_id, src);
+
+    return true;
+}
+
+bool address_get_device_id(
+    BACNET_ADDRESS * src,
+    uint32_t * device_id)
+{
+    *device_id = src->mac[0];
+
+    return true;
+}
+
+bool address_bind_request(
+    uint32_t device_id,
+    unsigned *max_apdu,
+    BACNET_ADDRESS * src)
+{
+    return address_get_by_device(device_id, max_apdu, src);
+}
+
+void Send_WhoIs(
+    int32_t low_limit,
+    int32_t high_limit)
+{
+    (void) low_limit;
+    (void) high_limit;
+}
+
+uint8_t Send_COV_Subscribe(
+    uint32_t device_id,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    (void) device_id;
+    Test_Subscribe_Data = *cov_data;
+    if (cov_data->cancellationRequest) {
+        Test_Request = COV_CLIENT_REQUEST_CANCEL;
+    } else {
+        Test_Request = COV_CLIENT_REQUEST_SUBSCRIBE;
+    }
+
+    return testInvokeID();
+}
+
+uint8_t Send_Read_Property_Request(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    (void) device_id;
+    (void) object_type;
+    (void) object_instance;
+    (void) object_property;
+    (void) array_index;
+    Test_Request = COV_CLIENT_REQUEST_READ;
+
+    return testInvokeID();
+}
+
+bool tsm_transaction_available(
+    void)
+{
+    return true;
+}
+
+void tsm_free_peer_invoke_id(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    (void) src;
+    (void) invokeID;
+}
+
+bool tsm_peer_invoke_id_free(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID)
+{
+    (void) dest;
+    (void) invokeID;
+
+    return false;
+}
+
+bool tsm_peer_invoke_id_failed(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID)
+{
+    (void) dest;
+    (void) invokeID;
+
+    return Test_Invoke_Failed;
+}
+
+void datalink_get_my_address(
+    BACNET_ADDRESS * my_address)
+{
+    testAddress(0, my_address);
+}
+
+int datalink_send_pdu(
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * npdu_data,
+    uint8_t * pdu,
+    unsigned pdu_len)
+{
+    (void) dest;
+    (void) npdu_data;
+    (void) pdu;
+
+    return (int) pdu_len;
+}
+
+void apdu_set_confirmed_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    confirmed_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_unconfirmed_handler(
+    BACNET_UNCONFIRMED_SERVICE service_choice,
+    unconfirmed_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_confirmed_simple_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    confirmed_simple_ack_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    confirmed_ack_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    error_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_abort_handler(
+    abort_function pFunction)
+{
+    (void) pFunction;
+}
+
+void apdu_set_reject_handler(
+    reject_function pFunction)
+{
+    (void) pFunction;
+}
+
+confirmed_simple_ack_function apdu_get_confirmed_simple_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    (void) service_choice;
+
+    return NULL;
+}
+
+confirmed_ack_function apdu_get_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    (void) service_choice;
+
+    return NULL;
+}
+
+error_function apdu_get_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    (void) service_choice;
+
+    return NULL;
+}
+
+abort_function apdu_get_abort_handler(
+    void)
+{
+    return testAbortHandler;
+}
+
+reject_function apdu_get_reject_handler(
+    void)
+{
+    return NULL;
+}
+
+static void testSetup(
+    void)
+{
+    Test_Request_Count = 0;
+    Test_Request = COV_CLIENT_REQUEST_NONE;
+    Test_Invoke_ID = 0;
+    Test_Invoke_Failed = false;
+    Test_Abort_Count = 0;
+    Test_Notify_Count = 0;
+    cov_client_init(42);
+}
+
+/* seconds counted, a second at a time, until the COV client sends a
+   request, or limit if it sends none */
+static uint32_t testSecondsToRequest(
+    uint32_t limit)
+{
+    unsigned count = Test_Request_Count;
+    uint32_t seconds = 0;
+
+    while (seconds < limit) {
+        cov_client_timer_seconds(1);
+        seconds++;
+        cov_client_task();
+        if (Test_Request_Count != count) {
+            break;
+        }
+    }
+
+    return seconds;
+}
+
+static void testAck(
+    uint32_t device_id)
+{
+    BACNET_ADDRESS src;
+
+    testAddress(device_id, &src);
+    cov_client_subscribe_ack_handler(&src, Test_Invoke_ID);
+}
+
+void testCOVClientRenewal(
+    Test * pTest)
+{
+    uint32_t seconds = 0;
+    bool status = false;
+
+    testSetup();
+    status =
+        cov_client_subscribe(10, OBJECT_ANALOG_INPUT, 1, false, 120,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request_Count == 1);
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_SUBSCRIBE);
+    ct_test(pTest, Test_Subscribe_Data.subscriberProcessIdentifier == 42);
+    ct_test(pTest, Test_Subscribe_Data.lifetime == 120);
+    /* nothing more is sent until the ack */
+    ct_test(pTest, testSecondsToRequest(200) == 200);
+    testAck(10);
+    /* renewed in the middle half of the lifetime */
+    seconds = testSecondsToRequest(200);
+    ct_test(pTest, seconds >= 60);
+    ct_test(pTest, seconds <= 90);
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_SUBSCRIBE);
+    ct_test(pTest, Test_Subscribe_Data.lifetime == 120);
+    testAck(10);
+    ct_test(pTest, testSecondsToRequest(200) == seconds);
+    testAck(10);
+    /* a lifetime too short to have a quarter is renewed a tick early */
+    status =
+        cov_client_subscribe(10, OBJECT_ANALOG_INPUT, 1, false, 3,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Subscribe_Data.lifetime == 3);
+    testAck(10);
+    ct_test(pTest, testSecondsToRequest(10) == 2);
+    testAck(10);
+    ct_test(pTest, testSecondsToRequest(10) == 2);
+    /* and a lifetime of a second at once */
+    status =
+        cov_client_subscribe(10, OBJECT_ANALOG_INPUT, 1, false, 1,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    testAck(10);
+    seconds = Test_Request_Count;
+    cov_client_task();
+    ct_test(pTest, Test_Request_Count == (seconds + 1));
+}
+
+void testCOVClientExpiry(
+    Test * pTest)
+{
+    BACNET_ADDRESS src;
+    bool status = false;
+
+    testSetup();
+    /* an indefinite subscription is never renewed */
+    status =
+        cov_client_subscribe(11, OBJECT_BINARY_INPUT, 2, true, 0,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request_Count == 1);
+    ct_test(pTest, Test_Subscribe_Data.issueConfirmedNotifications);
+    testAck(11);
+    ct_test(pTest, testSecondsToRequest(100000) == 100000);
+    /* a request that times out in the TSM is tried again later */
+    status =
+        cov_client_subscribe(11, OBJECT_BINARY_INPUT, 3, false, 60,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request_Count == 2);
+    Test_Invoke_Failed = true;
+    cov_client_task();
+    Test_Invoke_Failed = false;
+    ct_test(pTest, Test_Request_Count == 2);
+    ct_test(pTest,
+        testSecondsToRequest(100) == COV_CLIENT_RETRY_SECONDS);
+    ct_test(pTest, Test_Subscribe_Data.monitoredObjectIdentifier.instance ==
+        3);
+    /* as is one that is aborted, while an Abort of a request the COV
+       client did not send goes to the handler set before */
+    testAddress(11, &src);
+    cov_client_abort_handler(&src, (uint8_t) (Test_Invoke_ID + 1), 0, true);
+    ct_test(pTest, Test_Abort_Count == 1);
+    cov_client_abort_handler(&src, Test_Invoke_ID, 0, true);
+    ct_test(pTest, Test_Abort_Count == 1);
+    ct_test(pTest,
+        testSecondsToRequest(100) == COV_CLIENT_RETRY_SECONDS);
+}
+
+void testCOVClientResubscribe(
+    Test * pTest)
+{
+    BACNET_OBJECT_ID object_id;
+    BACNET_ADDRESS src;
+    bool status = false;
+
+    testSetup();
+    status =
+        cov_client_subscribe(12, OBJECT_ANALOG_VALUE, 4, false, 300,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    testAck(12);
+    object_id.type = OBJECT_ANALOG_VALUE;
+    object_id.instance = 4;
+    cov_client_dispatch(12, &object_id, 42, NULL);
+    ct_test(pTest, Test_Notify_Count == 1);
+    /* other subscribers' notifications are not ours */
+    cov_client_dispatch(12, &object_id, 43, NULL);
+    ct_test(pTest, Test_Notify_Count == 1);
+    /* subscribing again changes the subscription at once */
+    status =
+        cov_client_subscribe(12, OBJECT_ANALOG_VALUE, 4, true, 600,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request_Count == 2);
+    ct_test(pTest, Test_Subscribe_Data.lifetime == 600);
+    ct_test(pTest, Test_Subscribe_Data.issueConfirmedNotifications);
+    testAck(12);
+    /* unsubscribing cancels it, and notifications stop */
+    status = cov_client_unsubscribe(12, OBJECT_ANALOG_VALUE, 4);
+    ct_test(pTest, status);
+    cov_client_dispatch(12, &object_id, 42, NULL);
+    ct_test(pTest, Test_Notify_Count == 1);
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_CANCEL);
+    /* and the point may be subscribed to again before the cancellation
+       has been acknowledged */
+    status =
+        cov_client_subscribe(12, OBJECT_ANALOG_VALUE, 4, false, 300,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    testAck(12);
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_SUBSCRIBE);
+    ct_test(pTest, !Test_Subscribe_Data.cancellationRequest);
+    testAck(12);
+    cov_client_dispatch(12, &object_id, 42, NULL);
+    ct_test(pTest, Test_Notify_Count == 2);
+    /* an object that does not support COV is polled instead */
+    status =
+        cov_client_subscribe(12, OBJECT_ANALOG_VALUE, 5, false, 300,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    testAddress(12, &src);
+    cov_client_error_handler(&src, Test_Invoke_ID, ERROR_CLASS_SERVICES,
+        ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED);
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_READ);
+    ct_test(pTest, !cov_client_device_polled(12));
+    /* and a device that does not know SubscribeCOV has all of its new
+       points polled */
+    status =
+        cov_client_subscribe(13, OBJECT_ANALOG_VALUE, 6, false, 300,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_SUBSCRIBE);
+    testAddress(13, &src);
+    cov_client_reject_handler(&src, Test_Invoke_ID,
+        REJECT_REASON_UNRECOGNIZED_SERVICE);
+    ct_test(pTest, cov_client_device_polled(13));
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_READ);
+    status =
+        cov_client_subscribe(13, OBJECT_ANALOG_VALUE, 7, false, 300,
+        testNotify, NULL);
+    ct_test(pTest, status);
+    cov_client_task();
+    ct_test(pTest, Test_Request == COV_CLIENT_REQUEST_READ);
+}
+
+#ifdef TEST_COV_CLIENT
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet COV Client", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testCOVClientRenewal);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVClientExpiry);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVClientResubscribe);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_COV_CLIENT */
+#endif /* TEST */
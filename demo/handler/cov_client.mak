@@ -0,0 +1,49 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../../src
+TEST_DIR = ../../test
+INCLUDES = -I../../include -I$(TEST_DIR) -I. -I../object
+DEFINES = -DBIG_ENDIAN=0 -DBACDL_ALL -DTEST -DBACAPP_ALL -DTEST_COV_CLIENT
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = cov_client.c \
+	$(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/datetime.c \
+	$(SRC_DIR)/bacapp.c \
+	$(SRC_DIR)/bacdevobjpropref.c \
+	$(SRC_DIR)/lighting.c \
+	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/memcopy.c \
+	$(SRC_DIR)/bactext.c \
+	$(SRC_DIR)/abort.c \
+	$(SRC_DIR)/cov.c \
+	$(SRC_DIR)/rp.c \
+	$(SRC_DIR)/npdu.c \
+	$(SRC_DIR)/fnv.c \
+	$(SRC_DIR)/minheap.c \
+	$(TEST_DIR)/ctest.c
+
+TARGET = cov_client
+
+all: ${TARGET}
+
+OBJS = ${SRCS:.c=.o}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf core ${TARGET} $(OBJS)
+
+include: .depend
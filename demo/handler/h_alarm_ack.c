@@ -68,14 +68,14 @@ void handler_alarm_ack_set(
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_alarm_ack(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -91,12 +91,12 @@ void handler_alarm_ack(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -114,7 +114,7 @@ void handler_alarm_ack(
     if (len < 0) {
         /* bad decoding - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "Alarm Ack: Bad Encoding.  Sending Abort!\n");
@@ -137,7 +137,7 @@ void handler_alarm_ack(
 	if (!Device_Valid_Object_Id(data.eventObjectIdentifier.type, data.eventObjectIdentifier.instance))
 	{
 		len =
-			bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+			bacerror_encode_apdu(&context->tx_buffer[pdu_len],
 				service_data->invoke_id,
 				SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM, ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
 	}
@@ -149,7 +149,7 @@ void handler_alarm_ack(
         switch (ack_result) {
             case 1:
                 len =
-                    encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                    encode_simple_ack(&context->tx_buffer[pdu_len],
                     service_data->invoke_id,
                     SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM);
 #if PRINT_ENABLED
@@ -159,7 +159,7 @@ void handler_alarm_ack(
 
             case -1:
                 len =
-                    bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id,
                     SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM, ERROR_CLASS_OBJECT,
                     error_code);
@@ -171,7 +171,7 @@ void handler_alarm_ack(
 
             default:
                 len =
-                    abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    abort_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
                 fprintf(stderr, "Alarm Acknowledge: abort other!\n");
@@ -180,7 +180,7 @@ void handler_alarm_ack(
         }
     } else {
         len =
-            bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            bacerror_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ACKNOWLEDGE_ALARM,
             ERROR_CLASS_OBJECT, ERROR_CODE_NO_ALARM_CONFIGURED);
 #if PRINT_ENABLED
@@ -193,7 +193,7 @@ void handler_alarm_ack(
   AA_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
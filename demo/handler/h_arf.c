@@ -99,7 +99,7 @@ shall be TRUE, otherwise FALSE.
 void handler_atomic_read_file(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_ATOMIC_READ_FILE_DATA data;
@@ -119,11 +119,11 @@ void handler_atomic_read_file(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -135,7 +135,7 @@ void handler_atomic_read_file(
     /* bad decoding - send an abort */
     if (len < 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "Bad Encoding. Sending Abort!\n");
@@ -155,11 +155,11 @@ void handler_atomic_read_file(
 					data.type.stream.requestedOctetCount);
 #endif
 				len =
-					arf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+					arf_ack_encode_apdu(&context->tx_buffer[pdu_len],
 					service_data->invoke_id, &data);
             } else {
                 len =
-                    abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    abort_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id,
                     ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -181,7 +181,7 @@ void handler_atomic_read_file(
                     data.type.record.RecordCount);
 #endif
                 len =
-                    arf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    arf_ack_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, &data);
             } else {
                 error = true;
@@ -203,14 +203,14 @@ void handler_atomic_read_file(
     }
     if (error) {
         len =
-            bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            bacerror_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ATOMIC_READ_FILE,
             error_class, error_code);
     }
   ARF_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -79,7 +79,7 @@ standard.
 void handler_atomic_write_file(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_ATOMIC_WRITE_FILE_DATA data;
@@ -99,11 +99,11 @@ void handler_atomic_write_file(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -115,7 +115,7 @@ void handler_atomic_write_file(
     /* bad decoding - send an abort */
     if (len < 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "Bad Encoding. Sending Abort!\n");
@@ -133,7 +133,7 @@ void handler_atomic_write_file(
                     (int)octetstring_length(&data.fileData[0]));
 #endif
                 len =
-                    awf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    awf_ack_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, &data);
             } else {
                 error = true;
@@ -148,7 +148,7 @@ void handler_atomic_write_file(
                     data.type.record.returnedRecordCount);
 #endif
                 len =
-                    awf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    awf_ack_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, &data);
             } else {
                 error = true;
@@ -170,14 +170,14 @@ void handler_atomic_write_file(
     }
     if (error) {
         len =
-            bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            bacerror_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_ATOMIC_WRITE_FILE,
             error_class, error_code);
     }
   AWF_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -55,14 +55,14 @@
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_ccov_notification(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_NPDU_DATA npdu_data;
@@ -82,14 +82,14 @@ void handler_ccov_notification(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
 #if PRINT_ENABLED
     fprintf(stderr, "CCOV: Received Notification!\n");
 #endif
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -132,7 +132,7 @@ void handler_ccov_notification(
     /* bad decoding or something we didn't understand - send an abort */
     if (len <= 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "CCOV: Bad Encoding. Sending Abort!\n");
@@ -140,7 +140,7 @@ void handler_ccov_notification(
         goto CCOV_ABORT;
     } else {
         len =
-            encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+            encode_simple_ack(&context->tx_buffer[pdu_len],
             service_data->invoke_id, SERVICE_CONFIRMED_COV_NOTIFICATION);
 #if PRINT_ENABLED
         fprintf(stderr, "CCOV: Sending Simple Ack!\n");
@@ -149,7 +149,7 @@ void handler_ccov_notification(
   CCOV_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -24,8 +24,10 @@
 *********************************************************************/
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 #include "config.h"
 #include "txbuf.h"
@@ -40,6 +42,9 @@
 #include "cov.h"
 #include "tsm.h"
 #include "dcc.h"
+#include "address.h"
+#include "fnv.h"
+#include "minheap.h"
 #if PRINT_ENABLED
 #include "bactext.h"
 #endif
@@ -54,7 +59,10 @@
 /** @file h_cov.c  Handles Change of Value (COV) services. */
 
 typedef struct BACnet_COV_Address {
-    bool valid:1;
+    /* number of subscriptions using the address, 0 if the entry is free */
+    unsigned refcount;
+    /* next address in the same hash bucket, or on the free list */
+    unsigned next;
     BACNET_ADDRESS dest;
 } BACNET_COV_ADDRESS;
 
@@ -64,41 +72,249 @@ typedef struct BACnet_COV_Subscription_Flags {
     bool valid:1;
     bool issueConfirmedNotifications:1; /* optional */
     bool send_requested:1;
+    bool queued:1;      /* on the send queue */
+    bool awaiting_confirmation:1;       /* on the confirmation list */
+    bool property:1;    /* SubscribeCOVProperty of monitoredProperty */
+    bool covIncrementPresent:1; /* optional */
+    bool last_valid:1;  /* a value of the property has been sent */
+    bool last_numeric:1;        /* last_value holds the value sent */
+    bool group:1;       /* SubscribeCOVPropertyMultiple context */
+    bool member:1;      /* a property of a SubscribeCOVPropertyMultiple */
+    bool in_batch:1;    /* in the notification being sent by the group */
+    bool polled:1;      /* on the list of polled properties */
 } BACNET_COV_SUBSCRIPTION_FLAGS;
 
 typedef struct BACnet_COV_Subscription {
     BACNET_COV_SUBSCRIPTION_FLAGS flag;
-    uint8_t dest_index;
+    unsigned dest_index;
     uint8_t invokeID;   /* for confirmed COV */
     uint32_t subscriberProcessIdentifier;
     uint32_t lifetime;  /* optional */
+    /* COV_Clock value when a definite lifetime runs out */
+    uint32_t expires;
+    /* position in COV_Timer_Heap, or MIN_HEAP_NO_POSITION */
+    unsigned timer_position;
     BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* next subscription in the same monitored object hash bucket,
+       or on the free list */
+    unsigned object_next;
+    /* next subscription awaiting a confirmation */
+    unsigned confirm_next;
+    /* next SubscribeCOVProperty subscription whose property is polled */
+    unsigned property_next;
+    /* for SubscribeCOVProperty only */
+    BACNET_PROPERTY_REFERENCE monitoredProperty;
+    float covIncrement; /* optional */
+    /* the value last sent, to detect changes of the property: numeric
+       values are compared against the increment, others by a hash of
+       their encoding */
+    double last_value;
+    uint32_t last_hash;
+    /* SubscribeCOVPropertyMultiple: the context is a group, which holds
+       the subscriber, lifetime and notifications, and each of its
+       monitored properties is a member of the group */
+    unsigned group;     /* group of a member */
+    unsigned group_next;        /* next group */
+    unsigned members;   /* first member of a group */
+    unsigned member_next;       /* next member of the same group */
+    /* seconds a group waits for more changes before notifying */
+    uint32_t maxNotificationDelay;
+    /* COV_Clock value when a waiting group notifies */
+    uint32_t due;
 } BACNET_COV_SUBSCRIPTION;
 
+/* the subscriptions and addresses start out with room for
+   MAX_COV_SUBCRIPTIONS and MAX_COV_ADDRESSES entries, and double
+   in size when full up to the _DYNAMIC limits */
 #ifndef MAX_COV_SUBCRIPTIONS
 #define MAX_COV_SUBCRIPTIONS 128
 #endif
-static BACNET_COV_SUBSCRIPTION COV_Subscriptions[MAX_COV_SUBCRIPTIONS];
+#ifndef MAX_COV_SUBSCRIPTIONS_DYNAMIC
+#define MAX_COV_SUBSCRIPTIONS_DYNAMIC 8192
+#endif
 #ifndef MAX_COV_ADDRESSES
 #define MAX_COV_ADDRESSES 16
 #endif
-static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
+#ifndef MAX_COV_ADDRESSES_DYNAMIC
+#define MAX_COV_ADDRESSES_DYNAMIC 1024
+#endif
+/* room to decode a SubscribeCOVPropertyMultiple request */
+#ifndef MAX_COV_MULTIPLE_OBJECTS
+#define MAX_COV_MULTIPLE_OBJECTS 16
+#endif
+#ifndef MAX_COV_MULTIPLE_REFERENCES
+#define MAX_COV_MULTIPLE_REFERENCES 64
+#endif
+/* number of notifications handler_cov_task() sends per call */
+#ifndef MAX_COV_NOTIFICATIONS_PER_TASK
+#define MAX_COV_NOTIFICATIONS_PER_TASK 1
+#endif
+
+/* marks the end of a chain of COV_Subscriptions or COV_Addresses indexes */
+#define COV_NO_INDEX UINT_MAX
+static BACNET_COV_SUBSCRIPTION *COV_Subscriptions;
+static unsigned COV_Subscription_Size;
+static unsigned COV_Subscription_Free = COV_NO_INDEX;
+static BACNET_COV_ADDRESS *COV_Addresses;
+static unsigned COV_Address_Size;
+static unsigned COV_Address_Free = COV_NO_INDEX;
+/* addresses in use, chained by hash of the address */
+static unsigned *COV_Address_Hash;
+static unsigned COV_Address_Hash_Size;
+/* valid subscriptions chained by monitored object */
+static unsigned *COV_Object_Hash;
+static unsigned COV_Object_Hash_Size;
+/* subscriptions with a notification to send, oldest first;
+   a subscription is queued at most once */
+static unsigned *COV_Send_Queue;
+static unsigned COV_Send_Head;
+static unsigned COV_Send_Count;
+/* subscriptions with a confirmed notification outstanding */
+static unsigned COV_Confirm_Head = COV_NO_INDEX;
+/* SubscribeCOVProperty subscriptions, checked for changes each second */
+static unsigned COV_Property_Head = COV_NO_INDEX;
+/* SubscribeCOVPropertyMultiple contexts */
+static unsigned COV_Group_Head = COV_NO_INDEX;
+/* subscriptions with a definite lifetime, soonest to expire first */
+static void cov_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position);
+static MIN_HEAP COV_Timer_Heap = { NULL, 0, 0, cov_timer_moved, NULL };
+/* seconds counted by handler_cov_timer_seconds() */
+static uint32_t COV_Clock;
+/* a queued notification may be sendable now, rather than waiting for
+   its group deadline or for the TSM */
+static bool COV_Send_Ready;
+/* COV_Clock value of the earliest deadline of the queued notifications */
+static uint32_t COV_Send_Due;
+static bool COV_Send_Due_Valid;
+/* the pools have been allocated */
+static bool COV_Index_Ready;
+/* the listOfValues last encoded, which is sent to each subscriber of
+   the object until the object changes again */
+static struct cov_value_cache {
+    bool valid;
+    BACNET_OBJECT_ID object;
+    unsigned length;
+    uint8_t values[MAX_APDU];
+} COV_Value_Cache;
+/* the value of a monitored property, as read from the object */
+struct cov_property_sample {
+    bool numeric;
+    double value;
+    uint32_t hash;
+    int length;
+    uint8_t data[MAX_APDU];
+};
+static struct cov_property_sample COV_Property_Sample;
+static uint8_t COV_Property_Values[MAX_APDU];
+/* the listOfCOVNotifications of a group, one entry per changed object */
+static uint8_t COV_Group_Entries[MAX_APDU];
+
+static unsigned cov_hash_size(
+    unsigned size)
+{
+    unsigned hash_size = 1;
+
+    while (hash_size < size) {
+        hash_size *= 2;
+    }
+
+    return hash_size;
+}
+
+static unsigned cov_address_bucket(
+    BACNET_ADDRESS * dest)
+{
+    return (unsigned) (FNV_Hash_Address(dest, FNV_HASH_INIT) &
+        (COV_Address_Hash_Size - 1));
+}
+
+static unsigned cov_object_bucket(
+    BACNET_OBJECT_ID * object_id)
+{
+    uint32_t key = ((uint32_t) object_id->type << 22) | object_id->instance;
+
+    key ^= key >> 16;
+    key *= 0x45d9f3bUL;
+    key ^= key >> 16;
+
+    return (unsigned) (key & (COV_Object_Hash_Size - 1));
+}
+
+/* doubles the address pool, rehashing the addresses in use;
+   returns false if the pool is at its limit or memory is short */
+static bool cov_addresses_grow(
+    void)
+{
+    BACNET_COV_ADDRESS *addresses = NULL;
+    unsigned *hash = NULL;
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    unsigned i = 0;
+
+    if (COV_Address_Size) {
+        size = COV_Address_Size * 2;
+    } else {
+        size = MAX_COV_ADDRESSES;
+    }
+    if (size > MAX_COV_ADDRESSES_DYNAMIC) {
+        size = MAX_COV_ADDRESSES_DYNAMIC;
+    }
+    if (size <= COV_Address_Size) {
+        return false;
+    }
+    addresses = realloc(COV_Addresses, size * sizeof(BACNET_COV_ADDRESS));
+    if (!addresses) {
+        return false;
+    }
+    COV_Addresses = addresses;
+    hash_size = cov_hash_size(size);
+    if (hash_size != COV_Address_Hash_Size) {
+        hash = realloc(COV_Address_Hash, hash_size * sizeof(unsigned));
+        if (!hash) {
+            return false;
+        }
+        COV_Address_Hash = hash;
+        COV_Address_Hash_Size = hash_size;
+        for (i = 0; i < COV_Address_Hash_Size; i++) {
+            COV_Address_Hash[i] = COV_NO_INDEX;
+        }
+        for (i = 0; i < COV_Address_Size; i++) {
+            if (COV_Addresses[i].refcount) {
+                hash = &COV_Address_Hash[cov_address_bucket(&COV_Addresses
+                        [i].dest)];
+                COV_Addresses[i].next = *hash;
+                *hash = i;
+            }
+        }
+    }
+    /* lowest index first on the free list */
+    for (i = size; i > COV_Address_Size; i--) {
+        COV_Addresses[i - 1].refcount = 0;
+        COV_Addresses[i - 1].next = COV_Address_Free;
+        COV_Address_Free = i - 1;
+    }
+    COV_Address_Size = size;
+
+    return true;
+}
 
 /**
 * Gets the address from the list of COV addresses
 *
 * @param  index - offset into COV address list where address is stored
-* @param  dest - address to be filled when found
 *
-* @return true if valid address, false if not valid or not found
+* @return the address, or NULL if not valid or not found
 */
 static BACNET_ADDRESS *cov_address_get(
-    int index)
+    unsigned index)
 {
     BACNET_ADDRESS *cov_dest = NULL;
 
-    if (index < MAX_COV_ADDRESSES) {
-        if (COV_Addresses[index].valid) {
+    if (index < COV_Address_Size) {
+        if (COV_Addresses[index].refcount) {
             cov_dest = &COV_Addresses[index].dest;
         }
     }
@@ -107,79 +323,513 @@ static BACNET_ADDRESS *cov_address_get(
 }
 
 /**
- * Removes the address from the list of COV addresses, if it is not
- * used by other COV subscriptions
- */
-static void cov_address_remove_unused(
-    void)
+* Drops a reference to the address, freeing it when it is no longer
+* used by any COV subscription
+*
+* @param  index - offset into COV address list where address is stored
+*/
+static void cov_address_release(
+    unsigned index)
 {
-    unsigned index = 0;
-    unsigned cov_index = 0;
-    bool found = false;
+    unsigned *link = NULL;
 
-    for (cov_index = 0; cov_index < MAX_COV_ADDRESSES; cov_index++) {
-        if (COV_Addresses[cov_index].valid) {
-            found = false;
-            for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-                if ((COV_Subscriptions[index].flag.valid) &&
-                    (COV_Subscriptions[index].dest_index == cov_index)) {
-                    found = true;
+    if ((index < COV_Address_Size) && COV_Addresses[index].refcount) {
+        COV_Addresses[index].refcount--;
+        if (COV_Addresses[index].refcount == 0) {
+            link =
+                &COV_Address_Hash[cov_address_bucket(&COV_Addresses[index].
+                    dest)];
+            while (*link != COV_NO_INDEX) {
+                if (*link == index) {
+                    *link = COV_Addresses[index].next;
                     break;
                 }
+                link = &COV_Addresses[*link].next;
             }
-            if (!found) {
-                COV_Addresses[cov_index].valid = false;
-            }
+            COV_Addresses[index].next = COV_Address_Free;
+            COV_Address_Free = index;
         }
     }
 }
 
 /**
-* Adds the address to the list of COV addresses
+* Adds a reference to the address in the list of COV addresses
 *
 * @param  dest - address to be added if there is room in the list
 *
-* @return index number 0..N, or -1 if unable to add
+* @return index number 0..N, or COV_NO_INDEX if unable to add
 */
-static int cov_address_add(
+static unsigned cov_address_add(
     BACNET_ADDRESS * dest)
 {
-    int index = -1;
-    unsigned i = 0;
-    bool found = false;
-    bool valid = false;
-    BACNET_ADDRESS *cov_dest = NULL;
+    unsigned index = COV_NO_INDEX;
+    unsigned bucket = 0;
 
     if (dest) {
-        for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-            valid = COV_Addresses[i].valid;
-            if (valid) {
-                cov_dest = &COV_Addresses[i].dest;
-                found = bacnet_address_same(dest, cov_dest);
-                if (found) {
-                    index = i;
-                    break;
-                }
+        index = COV_Address_Hash[cov_address_bucket(dest)];
+        while (index != COV_NO_INDEX) {
+            if (bacnet_address_same(dest, &COV_Addresses[index].dest)) {
+                COV_Addresses[index].refcount++;
+                return index;
             }
+            index = COV_Addresses[index].next;
         }
-        if (!found) {
-            /* find a free place to add a new address */
-            for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-                valid = COV_Addresses[i].valid;
-                if (!valid) {
-                    index = i;
-                    cov_dest = &COV_Addresses[i].dest;
-                    bacnet_address_copy(cov_dest, dest);
-                    COV_Addresses[i].valid = true;
-                    break;
-                }
+        if (COV_Address_Free == COV_NO_INDEX) {
+            (void) cov_addresses_grow();
+        }
+        index = COV_Address_Free;
+        if (index != COV_NO_INDEX) {
+            COV_Address_Free = COV_Addresses[index].next;
+            bacnet_address_copy(&COV_Addresses[index].dest, dest);
+            COV_Addresses[index].refcount = 1;
+            bucket = cov_address_bucket(dest);
+            COV_Addresses[index].next = COV_Address_Hash[bucket];
+            COV_Address_Hash[bucket] = index;
+        }
+    }
+
+    return index;
+}
+
+static void cov_object_link(
+    unsigned index)
+{
+    unsigned bucket = 0;
+
+    bucket =
+        cov_object_bucket(&COV_Subscriptions[index].monitoredObjectIdentifier);
+    COV_Subscriptions[index].object_next = COV_Object_Hash[bucket];
+    COV_Object_Hash[bucket] = index;
+}
+
+static void cov_object_unlink(
+    unsigned index)
+{
+    unsigned *link = NULL;
+
+    link =
+        &COV_Object_Hash[cov_object_bucket(&COV_Subscriptions[index].
+            monitoredObjectIdentifier)];
+    while (*link != COV_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Subscriptions[index].object_next;
+            break;
+        }
+        link = &COV_Subscriptions[*link].object_next;
+    }
+}
+
+/* doubles the subscription pool along with the structures indexed by it;
+   returns false if the pool is at its limit or memory is short */
+static bool cov_subscriptions_grow(
+    void)
+{
+    BACNET_COV_SUBSCRIPTION *list = NULL;
+    unsigned *queue = NULL;
+    unsigned *hash = NULL;
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    unsigned i = 0;
+
+    if (COV_Subscription_Size) {
+        size = COV_Subscription_Size * 2;
+    } else {
+        size = MAX_COV_SUBCRIPTIONS;
+    }
+    if (size > MAX_COV_SUBSCRIPTIONS_DYNAMIC) {
+        size = MAX_COV_SUBSCRIPTIONS_DYNAMIC;
+    }
+    if (size <= COV_Subscription_Size) {
+        return false;
+    }
+    list = realloc(COV_Subscriptions, size * sizeof(BACNET_COV_SUBSCRIPTION));
+    if (!list) {
+        return false;
+    }
+    COV_Subscriptions = list;
+    if (!Min_Heap_Reserve(&COV_Timer_Heap, size)) {
+        return false;
+    }
+    /* the send queue is a ring, so unwrap it into the new one */
+    queue = malloc(size * sizeof(unsigned));
+    if (!queue) {
+        return false;
+    }
+    for (i = 0; i < COV_Send_Count; i++) {
+        queue[i] =
+            COV_Send_Queue[(COV_Send_Head + i) % COV_Subscription_Size];
+    }
+    free(COV_Send_Queue);
+    COV_Send_Queue = queue;
+    COV_Send_Head = 0;
+    hash_size = cov_hash_size(size);
+    if (hash_size != COV_Object_Hash_Size) {
+        hash = realloc(COV_Object_Hash, hash_size * sizeof(unsigned));
+        if (!hash) {
+            return false;
+        }
+        COV_Object_Hash = hash;
+        COV_Object_Hash_Size = hash_size;
+        for (i = 0; i < COV_Object_Hash_Size; i++) {
+            COV_Object_Hash[i] = COV_NO_INDEX;
+        }
+        for (i = 0; i < COV_Subscription_Size; i++) {
+            if (COV_Subscriptions[i].flag.valid) {
+                cov_object_link(i);
+            }
+        }
+    }
+    /* lowest index first on the free list */
+    for (i = size; i > COV_Subscription_Size; i--) {
+        memset(&COV_Subscriptions[i - 1], 0, sizeof(BACNET_COV_SUBSCRIPTION));
+        COV_Subscriptions[i - 1].dest_index = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].timer_position = MIN_HEAP_NO_POSITION;
+        COV_Subscriptions[i - 1].confirm_next = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].property_next = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].group = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].group_next = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].members = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].member_next = COV_NO_INDEX;
+        COV_Subscriptions[i - 1].object_next = COV_Subscription_Free;
+        COV_Subscription_Free = i - 1;
+    }
+    COV_Subscription_Size = size;
+
+    return true;
+}
+
+/* sets up the pools once, since handler_cov_init() is optional;
+   returns false if they could not be allocated */
+static bool cov_index_init(
+    void)
+{
+    if (!COV_Index_Ready) {
+        if (!COV_Subscription_Size) {
+            (void) cov_subscriptions_grow();
+        }
+        if (!COV_Address_Size) {
+            (void) cov_addresses_grow();
+        }
+        COV_Index_Ready = (COV_Subscription_Size && COV_Address_Size);
+    }
+
+    return COV_Index_Ready;
+}
+
+/* takes a slot from the free list, growing the pool if it is empty;
+   returns COV_NO_INDEX if there is no room */
+static unsigned cov_subscription_alloc(
+    void)
+{
+    unsigned index = COV_NO_INDEX;
+
+    if (COV_Subscription_Free == COV_NO_INDEX) {
+        (void) cov_subscriptions_grow();
+    }
+    index = COV_Subscription_Free;
+    if (index != COV_NO_INDEX) {
+        COV_Subscription_Free = COV_Subscriptions[index].object_next;
+    }
+
+    return index;
+}
+
+/* makes sure the free list has at least count slots, growing the pool
+   as needed, so that a request can be applied without running out of
+   room part of the way through; returns false if there is no room */
+static bool cov_subscriptions_reserve(
+    unsigned count)
+{
+    unsigned index = COV_Subscription_Free;
+    unsigned free_count = 0;
+
+    while (free_count < count) {
+        if (index == COV_NO_INDEX) {
+            if (!cov_subscriptions_grow()) {
+                return false;
             }
+            /* the new slots are at the front of the free list */
+            index = COV_Subscription_Free;
+            free_count = 0;
+        } else {
+            free_count++;
+            index = COV_Subscriptions[index].object_next;
+        }
+    }
+
+    return true;
+}
+
+static void cov_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position)
+{
+    (void) context;
+    COV_Subscriptions[index].timer_position = position;
+}
+
+/* removes the lifetime timer of the subscription, if running */
+static void cov_timer_stop(
+    unsigned index)
+{
+    (void) Min_Heap_Remove(&COV_Timer_Heap,
+        COV_Subscriptions[index].timer_position);
+}
+
+/* (re)starts the lifetime timer of the subscription;
+   a lifetime of zero is indefinite and has no timer */
+static void cov_timer_start(
+    unsigned index,
+    uint32_t lifetime)
+{
+    cov_timer_stop(index);
+    COV_Subscriptions[index].lifetime = lifetime;
+    if (lifetime) {
+        COV_Subscriptions[index].expires = COV_Clock + lifetime;
+        /* cannot fail, since the heap has room for every subscription */
+        (void) Min_Heap_Insert(&COV_Timer_Heap, index,
+            COV_Subscriptions[index].expires);
+    }
+}
+
+/* seconds left of a definite lifetime, or zero if indefinite */
+static uint32_t cov_time_remaining(
+    BACNET_COV_SUBSCRIPTION * cov_subscription)
+{
+    int32_t remaining = 0;
+
+    if (cov_subscription->lifetime) {
+        remaining = (int32_t) (cov_subscription->expires - COV_Clock);
+        if (remaining < 0) {
+            remaining = 0;
+        }
+    }
+
+    return (uint32_t) remaining;
+}
+
+/* queues the subscription for a notification, unless already queued;
+   a member is notified by its group, which waits for other changes
+   for up to its maxNotificationDelay */
+static void cov_send_enqueue(
+    unsigned index)
+{
+    if (COV_Subscriptions[index].flag.member) {
+        COV_Subscriptions[index].flag.send_requested = true;
+        index = COV_Subscriptions[index].group;
+        if (!COV_Subscriptions[index].flag.send_requested) {
+            COV_Subscriptions[index].due =
+                COV_Clock + COV_Subscriptions[index].maxNotificationDelay;
         }
     }
+    COV_Subscriptions[index].flag.send_requested = true;
+    COV_Send_Ready = true;
+    if (!COV_Subscriptions[index].flag.queued) {
+        COV_Send_Queue[(COV_Send_Head +
+                COV_Send_Count) % COV_Subscription_Size] = index;
+        COV_Send_Count++;
+        COV_Subscriptions[index].flag.queued = true;
+    }
+}
+
+static unsigned cov_send_dequeue(
+    void)
+{
+    unsigned index = COV_NO_INDEX;
+
+    if (COV_Send_Count) {
+        index = COV_Send_Queue[COV_Send_Head];
+        COV_Send_Head = (COV_Send_Head + 1) % COV_Subscription_Size;
+        COV_Send_Count--;
+        COV_Subscriptions[index].flag.queued = false;
+    }
 
     return index;
 }
 
+static void cov_confirm_unlink(
+    unsigned index)
+{
+    unsigned *link = &COV_Confirm_Head;
+
+    if (COV_Subscriptions[index].flag.awaiting_confirmation) {
+        while (*link != COV_NO_INDEX) {
+            if (*link == index) {
+                *link = COV_Subscriptions[index].confirm_next;
+                break;
+            }
+            link = &COV_Subscriptions[*link].confirm_next;
+        }
+        COV_Subscriptions[index].flag.awaiting_confirmation = false;
+    }
+}
+
+/* releases any confirmed notification still outstanding */
+static void cov_invoke_id_release(
+    unsigned index)
+{
+    BACNET_ADDRESS *dest = NULL;
+
+    if (COV_Subscriptions[index].invokeID) {
+        dest = cov_address_get(COV_Subscriptions[index].dest_index);
+        if (dest) {
+            tsm_free_peer_invoke_id(dest, COV_Subscriptions[index].invokeID);
+        }
+        COV_Subscriptions[index].invokeID = 0;
+    }
+    cov_confirm_unlink(index);
+}
+
+/* true if the object reports changes of the property through
+   handler_cov_object_changed(): the properties of the COV value list,
+   of the objects that have one.  The object only reports a change of
+   its value once it has moved by its own COV increment, so a finer
+   increment has to be polled. */
+static bool cov_property_hooked(
+    unsigned index)
+{
+    BACNET_READ_PROPERTY_DATA rpdata;
+    BACNET_APPLICATION_DATA_VALUE value;
+    int len = 0;
+
+    rpdata.object_type = (BACNET_OBJECT_TYPE)
+        COV_Subscriptions[index].monitoredObjectIdentifier.type;
+    rpdata.object_instance =
+        COV_Subscriptions[index].monitoredObjectIdentifier.instance;
+    if (COV_Subscriptions[index].monitoredProperty.propertyArrayIndex !=
+        BACNET_ARRAY_ALL) {
+        return false;
+    }
+    switch (COV_Subscriptions[index].monitoredProperty.propertyIdentifier) {
+        case PROP_PRESENT_VALUE:
+            break;
+        case PROP_STATUS_FLAGS:
+            return Device_Value_List_Supported(rpdata.object_type);
+        default:
+            return false;
+    }
+    if (!Device_Value_List_Supported(rpdata.object_type)) {
+        return false;
+    }
+    if (COV_Subscriptions[index].flag.covIncrementPresent) {
+        rpdata.object_property = PROP_COV_INCREMENT;
+        rpdata.array_index = BACNET_ARRAY_ALL;
+        rpdata.application_data = &COV_Property_Sample.data[0];
+        rpdata.application_data_len = sizeof(COV_Property_Sample.data);
+        len = Device_Read_Property(&rpdata);
+        if ((len > 0) &&
+            (bacapp_decode_application_data(rpdata.application_data,
+                    (unsigned) len, &value) == len) &&
+            (value.tag == BACNET_APPLICATION_TAG_REAL) &&
+            (COV_Subscriptions[index].covIncrement < value.type.Real)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* puts a SubscribeCOVProperty subscription on the list polled by
+   handler_cov_timer_seconds(), unless its object reports the changes */
+static void cov_property_link(
+    unsigned index)
+{
+    if (!COV_Subscriptions[index].flag.polled &&
+        !cov_property_hooked(index)) {
+        COV_Subscriptions[index].flag.polled = true;
+        COV_Subscriptions[index].property_next = COV_Property_Head;
+        COV_Property_Head = index;
+    }
+}
+
+static void cov_property_unlink(
+    unsigned index)
+{
+    unsigned *link = &COV_Property_Head;
+
+    if (!COV_Subscriptions[index].flag.polled) {
+        return;
+    }
+    COV_Subscriptions[index].flag.polled = false;
+    while (*link != COV_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Subscriptions[index].property_next;
+            break;
+        }
+        link = &COV_Subscriptions[*link].property_next;
+    }
+    COV_Subscriptions[index].property_next = COV_NO_INDEX;
+}
+
+static void cov_group_unlink(
+    unsigned index)
+{
+    unsigned *link = &COV_Group_Head;
+
+    while (*link != COV_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Subscriptions[index].group_next;
+            break;
+        }
+        link = &COV_Subscriptions[*link].group_next;
+    }
+    COV_Subscriptions[index].group_next = COV_NO_INDEX;
+}
+
+static void cov_member_unlink(
+    unsigned index)
+{
+    unsigned *link = &COV_Subscriptions[COV_Subscriptions[index].group].members;
+
+    while (*link != COV_NO_INDEX) {
+        if (*link == index) {
+            *link = COV_Subscriptions[index].member_next;
+            break;
+        }
+        link = &COV_Subscriptions[*link].member_next;
+    }
+    COV_Subscriptions[index].member_next = COV_NO_INDEX;
+    COV_Subscriptions[index].group = COV_NO_INDEX;
+}
+
+/* returns the slot to the free list; a slot still on the send queue
+   is skipped by handler_cov_fsm() since it is no longer valid, and is
+   not reused until it has left the queue.  Removing a group removes
+   its members. */
+static void cov_subscription_remove(
+    unsigned index)
+{
+    cov_invoke_id_release(index);
+    cov_timer_stop(index);
+    if (COV_Subscriptions[index].flag.group) {
+        while (COV_Subscriptions[index].members != COV_NO_INDEX) {
+            cov_subscription_remove(COV_Subscriptions[index].members);
+        }
+        cov_group_unlink(index);
+    } else {
+        cov_object_unlink(index);
+    }
+    if (COV_Subscriptions[index].flag.member) {
+        cov_member_unlink(index);
+    }
+    if (COV_Subscriptions[index].flag.property) {
+        cov_property_unlink(index);
+    }
+    COV_Subscriptions[index].flag.valid = false;
+    COV_Subscriptions[index].flag.send_requested = false;
+    COV_Subscriptions[index].flag.group = false;
+    COV_Subscriptions[index].flag.member = false;
+    COV_Subscriptions[index].flag.in_batch = false;
+    cov_address_release(COV_Subscriptions[index].dest_index);
+    COV_Subscriptions[index].dest_index = COV_NO_INDEX;
+    COV_Subscriptions[index].lifetime = 0;
+    if (!COV_Subscriptions[index].flag.queued) {
+        COV_Subscriptions[index].object_next = COV_Subscription_Free;
+        COV_Subscription_Free = index;
+    }
+}
+
 /*
 BACnetCOVSubscription ::= SEQUENCE {
 Recipient [0] BACnetRecipientProcess,
@@ -273,9 +923,25 @@ static int cov_encode_subscription(
         cov_subscription->monitoredObjectIdentifier.instance);
     apdu_len += len;
     /* propertyIdentifier [1] */
-    /* FIXME: we are monitoring 2 properties! How to encode? */
-    len = encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
-    apdu_len += len;
+    if (cov_subscription->flag.property) {
+        len =
+            encode_context_enumerated(&apdu[apdu_len], 1,
+            cov_subscription->monitoredProperty.propertyIdentifier);
+        apdu_len += len;
+        /* propertyArrayIndex [2] */
+        if (cov_subscription->monitoredProperty.propertyArrayIndex !=
+            BACNET_ARRAY_ALL) {
+            len =
+                encode_context_unsigned(&apdu[apdu_len], 2,
+                cov_subscription->monitoredProperty.propertyArrayIndex);
+            apdu_len += len;
+        }
+    } else {
+        /* FIXME: we are monitoring 2 properties! How to encode? */
+        len =
+            encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
+        apdu_len += len;
+    }
     /* MonitoredPropertyReference [1] - closing */
     len = encode_closing_tag(&apdu[apdu_len], 1);
     apdu_len += len;
@@ -287,8 +953,15 @@ static int cov_encode_subscription(
     /* TimeRemaining [3] Unsigned, */
     len =
         encode_context_unsigned(&apdu[apdu_len], 3,
-        cov_subscription->lifetime);
+        cov_time_remaining(cov_subscription));
     apdu_len += len;
+    /* COVIncrement [4] REAL OPTIONAL */
+    if (cov_subscription->flag.covIncrementPresent) {
+        len =
+            encode_context_real(&apdu[apdu_len], 4,
+            cov_subscription->covIncrement);
+        apdu_len += len;
+    }
 
     return apdu_len;
 }
@@ -313,8 +986,11 @@ int handler_cov_encode_subscriptions(
     unsigned index = 0;
 
     if (apdu) {
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
+        for (index = 0; index < COV_Subscription_Size; index++) {
+            /* SubscribeCOVPropertyMultiple contexts are not listed */
+            if (COV_Subscriptions[index].flag.valid &&
+                !COV_Subscriptions[index].flag.group &&
+                !COV_Subscriptions[index].flag.member) {
                 len =
                     cov_encode_subscription(&apdu[apdu_len],
                     max_apdu - apdu_len, &COV_Subscriptions[index]);
@@ -336,34 +1012,85 @@ int handler_cov_encode_subscriptions(
 void handler_cov_init(
     void)
 {
-    unsigned index = 0;
+    free(COV_Subscriptions);
+    COV_Subscriptions = NULL;
+    COV_Subscription_Size = 0;
+    COV_Subscription_Free = COV_NO_INDEX;
+    free(COV_Addresses);
+    COV_Addresses = NULL;
+    COV_Address_Size = 0;
+    COV_Address_Free = COV_NO_INDEX;
+    free(COV_Address_Hash);
+    COV_Address_Hash = NULL;
+    COV_Address_Hash_Size = 0;
+    free(COV_Object_Hash);
+    COV_Object_Hash = NULL;
+    COV_Object_Hash_Size = 0;
+    free(COV_Send_Queue);
+    COV_Send_Queue = NULL;
+    COV_Send_Head = 0;
+    COV_Send_Count = 0;
+    COV_Confirm_Head = COV_NO_INDEX;
+    COV_Property_Head = COV_NO_INDEX;
+    COV_Group_Head = COV_NO_INDEX;
+    Min_Heap_Cleanup(&COV_Timer_Heap);
+    COV_Value_Cache.valid = false;
+    COV_Index_Ready = false;
+    (void) cov_index_init();
+}
 
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        COV_Subscriptions[index].flag.valid = false;
-        COV_Subscriptions[index].dest_index = -1;
-        COV_Subscriptions[index].subscriberProcessIdentifier = 0;
-        COV_Subscriptions[index].monitoredObjectIdentifier.type =
-            OBJECT_ANALOG_INPUT;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance = 0;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications = false;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = 0;
-        COV_Subscriptions[index].flag.send_requested = false;
+/* true if the subscription is the context of the request: the same
+   service, and for SubscribeCOVProperty the same property */
+static bool cov_subscription_same_property(
+    unsigned index,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data,
+    bool property)
+{
+    if (COV_Subscriptions[index].flag.member) {
+        return false;
+    }
+    if (COV_Subscriptions[index].flag.property != property) {
+        return false;
     }
-    for (index = 0; index < MAX_COV_ADDRESSES; index++) {
-        COV_Addresses[index].valid = false;
+    if (!property) {
+        return true;
     }
+
+    return ((COV_Subscriptions[index].monitoredProperty.propertyIdentifier ==
+            cov_data->monitoredProperty.propertyIdentifier) &&
+        (COV_Subscriptions[index].monitoredProperty.propertyArrayIndex ==
+            cov_data->monitoredProperty.propertyArrayIndex));
+}
+
+/* sets the property and increment of a SubscribeCOVProperty subscription,
+   so that the current value is sent, and polls the property if its
+   object does not report the changes */
+static void cov_subscription_property_set(
+    unsigned index,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    COV_Subscriptions[index].monitoredProperty.propertyIdentifier =
+        cov_data->monitoredProperty.propertyIdentifier;
+    COV_Subscriptions[index].monitoredProperty.propertyArrayIndex =
+        cov_data->monitoredProperty.propertyArrayIndex;
+    COV_Subscriptions[index].flag.covIncrementPresent =
+        cov_data->covIncrementPresent;
+    COV_Subscriptions[index].covIncrement = cov_data->covIncrement;
+    COV_Subscriptions[index].flag.last_valid = false;
+    /* a new increment may change whether the property is polled */
+    cov_property_unlink(index);
+    cov_property_link(index);
 }
 
 static bool cov_list_subscribe(
     BACNET_ADDRESS * src,
     BACNET_SUBSCRIBE_COV_DATA * cov_data,
+    bool property,
     BACNET_ERROR_CLASS * error_class,
     BACNET_ERROR_CODE * error_code)
 {
     bool existing_entry = false;
-    int index;
-    int first_invalid_index = -1;
+    unsigned index;
     bool found = true;
     bool address_match = false;
     BACNET_ADDRESS *dest = NULL;
@@ -372,51 +1099,61 @@ static bool cov_list_subscribe(
     /* unable to cancel subscription - other? */
 
     /* existing? - match Object ID and Process ID and address */
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        if (COV_Subscriptions[index].flag.valid) {
-            dest = cov_address_get(COV_Subscriptions[index].dest_index);
-            if (dest) {
-                address_match = bacnet_address_same(src, dest);
+    index =
+        COV_Object_Hash[cov_object_bucket(&cov_data->
+            monitoredObjectIdentifier)];
+    while (index != COV_NO_INDEX) {
+        dest = cov_address_get(COV_Subscriptions[index].dest_index);
+        if (dest) {
+            address_match = bacnet_address_same(src, dest);
+        } else {
+            /* skip address matching - we don't have an address */
+            address_match = true;
+        }
+        if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
+                cov_data->monitoredObjectIdentifier.type) &&
+            (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
+                cov_data->monitoredObjectIdentifier.instance) &&
+            (COV_Subscriptions[index].subscriberProcessIdentifier ==
+                cov_data->subscriberProcessIdentifier) && address_match &&
+            cov_subscription_same_property(index, cov_data, property)) {
+            existing_entry = true;
+            if (cov_data->cancellationRequest) {
+                cov_subscription_remove(index);
             } else {
-                /* skip address matching - we don't have an address */
-                address_match = true;
-            }
-            if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
-                    cov_data->monitoredObjectIdentifier.type) &&
-                (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
-                    cov_data->monitoredObjectIdentifier.instance) &&
-                (COV_Subscriptions[index].subscriberProcessIdentifier ==
-                    cov_data->subscriberProcessIdentifier) && address_match) {
-                existing_entry = true;
-                if (cov_data->cancellationRequest) {
-                    COV_Subscriptions[index].flag.valid = false;
-                    COV_Subscriptions[index].dest_index = -1;
-                    cov_address_remove_unused();
-                } else {
-                    COV_Subscriptions[index].dest_index = cov_address_add(src);
-                    COV_Subscriptions[index].flag.issueConfirmedNotifications =
-                        cov_data->issueConfirmedNotifications;
-                    COV_Subscriptions[index].lifetime = cov_data->lifetime;
-                    COV_Subscriptions[index].flag.send_requested = true;
+                cov_invoke_id_release(index);
+                if (!dest) {
+                    COV_Subscriptions[index].dest_index =
+                        cov_address_add(src);
                 }
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
+                COV_Subscriptions[index].flag.issueConfirmedNotifications =
+                    cov_data->issueConfirmedNotifications;
+                if (property) {
+                    cov_subscription_property_set(index, cov_data);
                 }
-                break;
+                cov_timer_start(index, cov_data->lifetime);
+                cov_send_enqueue(index);
             }
-        } else {
-            if (first_invalid_index < 0) {
-                first_invalid_index = index;
+            break;
+        }
+        index = COV_Subscriptions[index].object_next;
+    }
+    index = COV_NO_INDEX;
+    if (!existing_entry && !cov_data->cancellationRequest) {
+        index = cov_subscription_alloc();
+        if (index != COV_NO_INDEX) {
+            COV_Subscriptions[index].dest_index = cov_address_add(src);
+            if (COV_Subscriptions[index].dest_index == COV_NO_INDEX) {
+                /* no room for the address - give the slot back */
+                COV_Subscriptions[index].object_next = COV_Subscription_Free;
+                COV_Subscription_Free = index;
+                index = COV_NO_INDEX;
             }
         }
     }
-    if (!existing_entry && (first_invalid_index >= 0) &&
-        (!cov_data->cancellationRequest)) {
-        index = first_invalid_index;
+    if (!existing_entry && (index != COV_NO_INDEX)) {
         found = true;
         COV_Subscriptions[index].flag.valid = true;
-        COV_Subscriptions[index].dest_index = cov_address_add(src);
         COV_Subscriptions[index].monitoredObjectIdentifier.type =
             cov_data->monitoredObjectIdentifier.type;
         COV_Subscriptions[index].monitoredObjectIdentifier.instance =
@@ -426,10 +1163,15 @@ static bool cov_list_subscribe(
         COV_Subscriptions[index].flag.issueConfirmedNotifications =
             cov_data->issueConfirmedNotifications;
         COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = cov_data->lifetime;
-        COV_Subscriptions[index].flag.send_requested = true;
+        COV_Subscriptions[index].flag.property = property;
+        if (property) {
+            cov_subscription_property_set(index, cov_data);
+        }
+        cov_timer_start(index, cov_data->lifetime);
+        cov_object_link(index);
+        cov_send_enqueue(index);
     } else if (!existing_entry) {
-        if (first_invalid_index < 0) {
+        if (!cov_data->cancellationRequest) {
             /* Out of resources */
             *error_class = ERROR_CLASS_RESOURCES;
             *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
@@ -447,18 +1189,288 @@ static bool cov_list_subscribe(
     return found;
 }
 
-static bool cov_send_request(
-    BACNET_COV_SUBSCRIPTION * cov_subscription,
-    BACNET_PROPERTY_VALUE * value_list)
+/* encodes the values of the object into the cache, unless they are
+   already there, clearing the COV flag of the object */
+static bool cov_value_cache_load(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
 {
+    BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
+    bool status = false;
     int len = 0;
-    int pdu_len = 0;
-    BACNET_NPDU_DATA npdu_data;
-    BACNET_ADDRESS my_address;
-    int bytes_sent = 0;
-    uint8_t invoke_id = 0;
-    bool status = false;        /* return value */
+
+    if (COV_Value_Cache.valid &&
+        (COV_Value_Cache.object.type == object_type) &&
+        (COV_Value_Cache.object.instance == object_instance)) {
+        return true;
+    }
+    COV_Value_Cache.valid = false;
+    /* clear the COV flag now that the change is being reported */
+    Device_COV_Clear(object_type, object_instance);
+    /* configure the linked list for the two properties */
+    bacapp_property_value_list_init(&value_list[0], MAX_COV_PROPERTIES);
+    status =
+        Device_Encode_Value_List(object_type, object_instance,
+        &value_list[0]);
+    if (status) {
+        len =
+            cov_notify_encode_values(&COV_Value_Cache.values[0],
+            sizeof(COV_Value_Cache.values), &value_list[0]);
+        if (len > 0) {
+            COV_Value_Cache.object.type = object_type;
+            COV_Value_Cache.object.instance = object_instance;
+            COV_Value_Cache.length = (unsigned) len;
+            COV_Value_Cache.valid = true;
+        } else {
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+/* reads the monitored property of a SubscribeCOVProperty subscription */
+static bool cov_property_sample_read(
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    struct cov_property_sample *sample)
+{
+    BACNET_READ_PROPERTY_DATA rpdata;
+    BACNET_APPLICATION_DATA_VALUE value;
+    int len = 0;
+
+    rpdata.object_type = (BACNET_OBJECT_TYPE)
+        cov_subscription->monitoredObjectIdentifier.type;
+    rpdata.object_instance =
+        cov_subscription->monitoredObjectIdentifier.instance;
+    rpdata.object_property =
+        cov_subscription->monitoredProperty.propertyIdentifier;
+    rpdata.array_index =
+        cov_subscription->monitoredProperty.propertyArrayIndex;
+    rpdata.application_data = &sample->data[0];
+    rpdata.application_data_len = sizeof(sample->data);
+    len = Device_Read_Property(&rpdata);
+    if (len < 0) {
+        return false;
+    }
+    sample->length = len;
+    sample->hash = FNV_Hash(&sample->data[0], (size_t) len, FNV_HASH_INIT);
+    sample->numeric = false;
+    sample->value = 0.0;
+    if (bacapp_decode_application_data(&sample->data[0], (unsigned) len,
+            &value) == len) {
+        switch (value.tag) {
+#if defined (BACAPP_UNSIGNED)
+            case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+                sample->numeric = true;
+                sample->value = value.type.Unsigned_Int;
+                break;
+#endif
+#if defined (BACAPP_SIGNED)
+            case BACNET_APPLICATION_TAG_SIGNED_INT:
+                sample->numeric = true;
+                sample->value = value.type.Signed_Int;
+                break;
+#endif
+#if defined (BACAPP_REAL)
+            case BACNET_APPLICATION_TAG_REAL:
+                sample->numeric = true;
+                sample->value = value.type.Real;
+                break;
+#endif
+#if defined (BACAPP_DOUBLE)
+            case BACNET_APPLICATION_TAG_DOUBLE:
+                sample->numeric = true;
+                sample->value = value.type.Double;
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+/* true if the sample should be reported: numeric values once they have
+   moved by the COV increment, others on any change of their encoding */
+static bool cov_property_sample_changed(
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    struct cov_property_sample *sample)
+{
+    double delta = 0.0;
+
+    if (!cov_subscription->flag.last_valid) {
+        return true;
+    }
+    if (cov_subscription->flag.covIncrementPresent && sample->numeric &&
+        cov_subscription->flag.last_numeric) {
+        delta = sample->value - cov_subscription->last_value;
+        if (delta < 0.0) {
+            delta = -delta;
+        }
+        return (delta >= cov_subscription->covIncrement);
+    }
+
+    return (sample->hash != cov_subscription->last_hash);
+}
+
+static void cov_property_sample_sent(
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    struct cov_property_sample *sample)
+{
+    cov_subscription->flag.last_valid = true;
+    cov_subscription->flag.last_numeric = sample->numeric;
+    cov_subscription->last_value = sample->value;
+    cov_subscription->last_hash = sample->hash;
+}
+
+/* queues a SubscribeCOVProperty subscription if its property changed */
+static void cov_property_check(
+    unsigned index)
+{
+    if (COV_Subscriptions[index].flag.send_requested) {
+        return;
+    }
+    if (cov_property_sample_read(&COV_Subscriptions[index],
+            &COV_Property_Sample) &&
+        cov_property_sample_changed(&COV_Subscriptions[index],
+            &COV_Property_Sample)) {
+#if PRINT_ENABLED
+        fprintf(stderr, "COVtask: Marking property...\n");
+#endif
+        cov_send_enqueue(index);
+    }
+}
+
+/* encodes the monitored property as an entry of a listOfValues */
+static int cov_property_value_encode(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    struct cov_property_sample *sample)
+{
+    int apdu_len = 0;
+
+    /* tags and the property identifier and array index fit in 14 */
+    if ((unsigned) sample->length + 14 > max_apdu_len) {
+        return -1;
+    }
+    /* tag 0 - propertyIdentifier */
+    apdu_len +=
+        encode_context_enumerated(&apdu[apdu_len], 0,
+        cov_subscription->monitoredProperty.propertyIdentifier);
+    /* tag 1 - propertyArrayIndex OPTIONAL */
+    if (cov_subscription->monitoredProperty.propertyArrayIndex !=
+        BACNET_ARRAY_ALL) {
+        apdu_len +=
+            encode_context_unsigned(&apdu[apdu_len], 1,
+            cov_subscription->monitoredProperty.propertyArrayIndex);
+    }
+    /* tag 2 - value, as encoded by the object */
+    apdu_len += encode_opening_tag(&apdu[apdu_len], 2);
+    memcpy(&apdu[apdu_len], &sample->data[0], (size_t) sample->length);
+    apdu_len += sample->length;
+    apdu_len += encode_closing_tag(&apdu[apdu_len], 2);
+
+    return apdu_len;
+}
+
+/* encodes the listOfValues of a SubscribeCOVProperty notification,
+   which holds just the monitored property */
+static int cov_property_values_encode(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    struct cov_property_sample *sample)
+{
+    int len = 0;
+
+    if (max_apdu_len < 2) {
+        return -1;
+    }
+    /* tag 4 - listOfValues */
+    len =
+        cov_property_value_encode(&apdu[1], max_apdu_len - 2,
+        cov_subscription, sample);
+    if (len < 0) {
+        return len;
+    }
+    (void) encode_opening_tag(&apdu[0], 4);
+    (void) encode_closing_tag(&apdu[1 + len], 4);
+
+    return len + 2;
+}
+
+/* encodes the APDU of a notification with the values already encoded:
+   a group sends a COVNotificationMultiple, the others a COVNotification,
+   confirmed when given an invoke ID */
+static int cov_notify_encode(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    uint8_t * values,
+    unsigned values_len)
+{
     BACNET_COV_DATA cov_data;
+    BACNET_COV_MULTIPLE_DATA cov_multiple_data;
+    int len = 0;
+
+    if (cov_subscription->flag.group) {
+        cov_multiple_data.subscriberProcessIdentifier =
+            cov_subscription->subscriberProcessIdentifier;
+        cov_multiple_data.initiatingDeviceIdentifier =
+            Device_Object_Instance_Number();
+        cov_multiple_data.timeRemaining =
+            cov_time_remaining(cov_subscription);
+        cov_multiple_data.timestampPresent = false;
+        cov_multiple_data.listOfCOVNotifications = NULL;
+        if (invoke_id) {
+            len =
+                ccov_notify_multiple_encode_apdu_notifications(apdu,
+                max_apdu_len, invoke_id, &cov_multiple_data, values,
+                values_len);
+        } else {
+            len =
+                ucov_notify_multiple_encode_apdu_notifications(apdu,
+                max_apdu_len, &cov_multiple_data, values, values_len);
+        }
+    } else {
+        cov_data.subscriberProcessIdentifier =
+            cov_subscription->subscriberProcessIdentifier;
+        cov_data.initiatingDeviceIdentifier = Device_Object_Instance_Number();
+        cov_data.monitoredObjectIdentifier.type =
+            cov_subscription->monitoredObjectIdentifier.type;
+        cov_data.monitoredObjectIdentifier.instance =
+            cov_subscription->monitoredObjectIdentifier.instance;
+        cov_data.timeRemaining = cov_time_remaining(cov_subscription);
+        cov_data.listOfValues = NULL;
+        if (invoke_id) {
+            len =
+                ccov_notify_encode_apdu_values(apdu, max_apdu_len, invoke_id,
+                &cov_data, values, values_len);
+        } else {
+            len =
+                ucov_notify_encode_apdu_values(apdu, max_apdu_len, &cov_data,
+                values, values_len);
+        }
+    }
+
+    return len;
+}
+
+static bool cov_send_request(
+    BACNET_COV_SUBSCRIPTION * cov_subscription,
+    uint8_t * values,
+    unsigned values_len)
+{
+    int len = 0;
+    int pdu_len = 0;
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+    int bytes_sent = 0;
+    uint8_t invoke_id = 0;
+    bool status = false;        /* return value */
     BACNET_ADDRESS *dest = NULL;
 
     if (!dcc_communication_enabled()) {
@@ -482,31 +1494,26 @@ static bool cov_send_request(
     pdu_len =
         npdu_encode_pdu(&Handler_Transmit_Buffer[0], dest, &my_address,
         &npdu_data);
-    /* load the COV data structure for outgoing message */
-    cov_data.subscriberProcessIdentifier =
-        cov_subscription->subscriberProcessIdentifier;
-    cov_data.initiatingDeviceIdentifier = Device_Object_Instance_Number();
-    cov_data.monitoredObjectIdentifier.type =
-        cov_subscription->monitoredObjectIdentifier.type;
-    cov_data.monitoredObjectIdentifier.instance =
-        cov_subscription->monitoredObjectIdentifier.instance;
-    cov_data.timeRemaining = cov_subscription->lifetime;
-    cov_data.listOfValues = value_list;
     if (cov_subscription->flag.issueConfirmedNotifications) {
         npdu_data.data_expecting_reply = true;
-        invoke_id = tsm_next_free_invokeID();
+        invoke_id = tsm_next_free_peer_invokeID(dest);
         if (invoke_id) {
             cov_subscription->invokeID = invoke_id;
-            len =
-                ccov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-                sizeof(Handler_Transmit_Buffer) - pdu_len, invoke_id, &cov_data);
         } else {
             goto COV_FAILED;
         }
-    } else {
-        len =
-            ucov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-            sizeof(Handler_Transmit_Buffer) - pdu_len, &cov_data);
+    }
+    /* the values were encoded once for all of the subscribers */
+    len =
+        cov_notify_encode(&Handler_Transmit_Buffer[pdu_len],
+        sizeof(Handler_Transmit_Buffer) - pdu_len, invoke_id,
+        cov_subscription, values, values_len);
+    if (len <= 0) {
+        if (invoke_id) {
+            tsm_free_peer_invoke_id(dest, invoke_id);
+            cov_subscription->invokeID = 0;
+        }
+        goto COV_FAILED;
     }
     pdu_len += len;
     if (cov_subscription->flag.issueConfirmedNotifications) {
@@ -528,66 +1535,169 @@ static bool cov_send_request(
     return status;
 }
 
-static void cov_lifetime_expiration_handler(
+/* room for the entries of a group notification in the largest APDU
+   that the subscriber accepts, if it is in the address cache */
+static unsigned cov_group_entries_max(
+    unsigned index)
+{
+    BACNET_ADDRESS *dest = NULL;
+    BACNET_ADDRESS peer_address;
+    uint32_t device_id = 0;
+    unsigned max_apdu = MAX_APDU;
+    unsigned peer_max_apdu = 0;
+
+    dest = cov_address_get(COV_Subscriptions[index].dest_index);
+    if (dest && address_get_device_id(dest, &device_id) &&
+        address_get_by_device(device_id, &peer_max_apdu, &peer_address) &&
+        peer_max_apdu && (peer_max_apdu < max_apdu)) {
+        max_apdu = peer_max_apdu;
+    }
+    /* the APDU header, service parameters and tags 4 fit in 24 */
+    if (max_apdu <= 24) {
+        return 0;
+    }
+    max_apdu -= 24;
+    if (max_apdu > sizeof(COV_Group_Entries)) {
+        max_apdu = sizeof(COV_Group_Entries);
+    }
+
+    return max_apdu;
+}
+
+/* encodes the changed members of a group as entries of the
+   listOfCOVNotifications, as many as fit, with the members of the
+   same object sharing an entry; the members encoded are marked
+   in_batch, and the others stay requested for the next notification */
+static int cov_group_entries_encode(
     unsigned index,
-    uint32_t elapsed_seconds,
-    uint32_t lifetime_seconds)
-{
-    if (index < MAX_COV_SUBCRIPTIONS) {
-        /* handle lifetime expiration */
-        if (lifetime_seconds >= elapsed_seconds) {
-            COV_Subscriptions[index].lifetime -= elapsed_seconds;
-#if 0
-            fprintf(stderr, "COVtimer: subscription[%d].lifetime=%lu\n", index,
-                (unsigned long) COV_Subscriptions[index].lifetime);
-#endif
+    uint8_t * apdu,
+    unsigned max_apdu_len)
+{
+    BACNET_COV_SUBSCRIPTION *member = NULL;
+    BACNET_COV_SUBSCRIPTION *last = NULL;
+    unsigned member_index = 0;
+    unsigned apdu_len = 0;
+    unsigned entry_len = 0;
+    bool same_object = false;
+    int len = 0;
+
+    member_index = COV_Subscriptions[index].members;
+    while (member_index != COV_NO_INDEX) {
+        member = &COV_Subscriptions[member_index];
+        member_index = member->member_next;
+        if (!member->flag.send_requested) {
+            continue;
+        }
+        len = -1;
+        if (cov_property_sample_read(member, &COV_Property_Sample)) {
+            len =
+                cov_property_value_encode(&COV_Property_Values[0],
+                sizeof(COV_Property_Values), member, &COV_Property_Sample);
+        }
+        same_object = last &&
+            (last->monitoredObjectIdentifier.type ==
+            member->monitoredObjectIdentifier.type) &&
+            (last->monitoredObjectIdentifier.instance ==
+            member->monitoredObjectIdentifier.instance);
+        /* a new entry adds the object identifier and the tags 1 */
+        entry_len = (unsigned) len;
+        if (!same_object) {
+            entry_len += 7;
+        }
+        if ((len > 0) && ((apdu_len + entry_len) > max_apdu_len)) {
+            if (apdu_len) {
+                break;
+            }
+            /* too big to ever be sent */
+            len = -1;
+        }
+        if (len <= 0) {
+            member->flag.send_requested = false;
+            continue;
+        }
+        if (same_object) {
+            /* reopen the listOfValues of the entry */
+            apdu_len--;
         } else {
-            COV_Subscriptions[index].lifetime = 0;
+            /* tag 0 - monitoredObjectIdentifier */
+            apdu_len +=
+                encode_context_object_id(&apdu[apdu_len], 0,
+                (int) member->monitoredObjectIdentifier.type,
+                member->monitoredObjectIdentifier.instance);
+            /* tag 1 - listOfValues */
+            apdu_len += encode_opening_tag(&apdu[apdu_len], 1);
         }
-        if (COV_Subscriptions[index].lifetime == 0) {
-            /* expire the subscription */
-#if PRINT_ENABLED
-            fprintf(stderr, "COVtimer: PID=%u ",
-                COV_Subscriptions[index].subscriberProcessIdentifier);
-            fprintf(stderr, "%s %u ",
-                bactext_object_type_name(COV_Subscriptions[index].
-                    monitoredObjectIdentifier.type),
-                COV_Subscriptions[index].monitoredObjectIdentifier.instance);
-            fprintf(stderr, "time remaining=%u seconds ",
-                COV_Subscriptions[index].lifetime);
-            fprintf(stderr, "\n");
-#endif
-            COV_Subscriptions[index].flag.valid = false;
-            COV_Subscriptions[index].dest_index = -1;
-            cov_address_remove_unused();
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
+        memcpy(&apdu[apdu_len], &COV_Property_Values[0], (size_t) len);
+        apdu_len += len;
+        apdu_len += encode_closing_tag(&apdu[apdu_len], 1);
+        cov_property_sample_sent(member, &COV_Property_Sample);
+        member->flag.send_requested = false;
+        member->flag.in_batch = true;
+        last = member;
+    }
+
+    return (int) apdu_len;
+}
+
+/* sends the changes of a group's members in one notification;
+   returns true if there are no more changes waiting */
+static bool cov_group_send(
+    unsigned index)
+{
+    unsigned member_index = 0;
+    bool status = false;
+    bool pending = false;
+    int len = 0;
+
+    len =
+        cov_group_entries_encode(index, &COV_Group_Entries[0],
+        cov_group_entries_max(index));
+    if (len > 0) {
+        status =
+            cov_send_request(&COV_Subscriptions[index], &COV_Group_Entries[0],
+            (unsigned) len);
+    }
+    member_index = COV_Subscriptions[index].members;
+    while (member_index != COV_NO_INDEX) {
+        if (COV_Subscriptions[member_index].flag.in_batch) {
+            COV_Subscriptions[member_index].flag.in_batch = false;
+            if (!status) {
+                /* try again later */
+                COV_Subscriptions[member_index].flag.send_requested = true;
             }
         }
+        if (COV_Subscriptions[member_index].flag.send_requested) {
+            pending = true;
+        }
+        member_index = COV_Subscriptions[member_index].member_next;
     }
+
+    return !pending;
 }
 
-/** Handler to check the list of subscribed objects for any that have changed
- *  and so need to have notifications sent.
+static void cov_lifetime_expiration_handler(
+    unsigned index)
+{
+    /* expire the subscription */
+#if PRINT_ENABLED
+    fprintf(stderr, "COVtimer: PID=%u ",
+        COV_Subscriptions[index].subscriberProcessIdentifier);
+    fprintf(stderr, "%s %u ",
+        bactext_object_type_name(COV_Subscriptions[index].
+            monitoredObjectIdentifier.type),
+        COV_Subscriptions[index].monitoredObjectIdentifier.instance);
+    fprintf(stderr, "time remaining=%u seconds ",
+        cov_time_remaining(&COV_Subscriptions[index]));
+    fprintf(stderr, "\n");
+#endif
+    cov_subscription_remove(index);
+}
+
+/** Handler to expire the subscriptions whose lifetime has run out.
  * @ingroup DSCOV
  * This handler will be invoked by the main program every second or so.
- * This example only handles Binary Inputs, but can be easily extended to
- * support other types.
- * For each subscribed object,
- *  - See if the subscription has timed out
- *    - Remove it if it has timed out.
- *  - See if the subscribed object instance has changed
- *    (eg, check with Binary_Input_Change_Of_Value() )
- *  - If changed,
- *    - Clear the COV (eg, Binary_Input_Change_Of_Value_Clear() )
- *    - Send the notice with cov_send_request()
- *      - Will be confirmed or unconfirmed, as per the subscription.
- *
- * @note worst case tasking: MS/TP with the ability to send only
- *        one notification per task cycle.
+ * The subscriptions with a definite lifetime are kept in order of expiry,
+ * so only the ones that have timed out are visited, and removed.
  *
  * @param elapsed_seconds [in] How many seconds have elapsed since last called.
  */
@@ -595,157 +1705,345 @@ void handler_cov_timer_seconds(
     uint32_t elapsed_seconds)
 {
     unsigned index = 0;
-    uint32_t lifetime_seconds = 0;
+    uint32_t expires = 0;
 
+    if (!cov_index_init()) {
+        return;
+    }
     if (elapsed_seconds) {
-        /* handle the subscription timeouts */
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-            if (COV_Subscriptions[index].flag.valid) {
-                lifetime_seconds = COV_Subscriptions[index].lifetime;
-                if (lifetime_seconds) {
-                    /* only expire COV with definite lifetimes */
-                    cov_lifetime_expiration_handler(index, elapsed_seconds,
-                        lifetime_seconds);
-                }
+        /* values held for a slow subscriber are only good for a while */
+        COV_Value_Cache.valid = false;
+        COV_Clock += elapsed_seconds;
+        /* only the subscriptions with definite lifetimes are timed,
+           and only the ones that have run out are visited */
+        while (Min_Heap_Peek(&COV_Timer_Heap, &index, &expires)) {
+            if ((int32_t) (expires - COV_Clock) > 0) {
+                break;
             }
+            cov_lifetime_expiration_handler(index);
+        }
+        /* properties that the objects do not report changes of can change
+           at any time, so those SubscribeCOVProperty are checked each
+           second; the others are checked by handler_cov_object_changed() */
+        index = COV_Property_Head;
+        while (index != COV_NO_INDEX) {
+            cov_property_check(index);
+            index = COV_Subscriptions[index].property_next;
         }
     }
 }
 
-bool handler_cov_fsm(
-    void)
+/** Queue notifications for the subscriptions to an object that has changed.
+ * @ingroup DSCOV
+ * Objects that support COV call this when they set their COV flag (see
+ * Device_COV()), so that only the subscriptions of changed objects are
+ * visited.  The notifications are sent by handler_cov_task(), with the
+ * values the object has at that time.
+ *
+ * @param object_type [in] The type of the object that changed.
+ * @param object_instance [in] The instance of the object that changed.
+ */
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
 {
-    static int index = 0;
-    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
-    uint32_t object_instance = 0;
-    bool status = false;
-    bool send = false;
-    BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
-    /* states for transmitting */
-    static enum {
-        COV_STATE_IDLE = 0,
-        COV_STATE_MARK,
-        COV_STATE_CLEAR,
-        COV_STATE_FREE,
-        COV_STATE_SEND
-    } cov_task_state = COV_STATE_IDLE;
-
-    switch (cov_task_state) {
-        case COV_STATE_IDLE:
-            index = 0;
-            cov_task_state = COV_STATE_MARK;
-            break;
-        case COV_STATE_MARK:
-            /* mark any subscriptions where the value has changed */
-            if (COV_Subscriptions[index].flag.valid) {
-                object_type = (BACNET_OBJECT_TYPE)
-                    COV_Subscriptions[index].monitoredObjectIdentifier.type;
-                object_instance =
-                    COV_Subscriptions[index].
-                    monitoredObjectIdentifier.instance;
-                status = Device_COV(object_type, object_instance);
-                if (status) {
-                    COV_Subscriptions[index].flag.send_requested = true;
+    BACNET_OBJECT_ID object_id;
+    unsigned index = 0;
+
+    if (!cov_index_init()) {
+        return;
+    }
+    if (COV_Value_Cache.valid &&
+        (COV_Value_Cache.object.type == object_type) &&
+        (COV_Value_Cache.object.instance == object_instance)) {
+        COV_Value_Cache.valid = false;
+    }
+    object_id.type = object_type;
+    object_id.instance = object_instance;
+    index = COV_Object_Hash[cov_object_bucket(&object_id)];
+    while (index != COV_NO_INDEX) {
+        if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
+                object_type) &&
+            (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
+                object_instance)) {
+            if (COV_Subscriptions[index].flag.property) {
+                cov_property_check(index);
+            } else {
 #if PRINT_ENABLED
-                    fprintf(stderr, "COVtask: Marking...\n");
+                fprintf(stderr, "COVtask: Marking...\n");
 #endif
-                }
+                cov_send_enqueue(index);
             }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_CLEAR;
+        }
+        index = COV_Subscriptions[index].object_next;
+    }
+}
+
+/** Remove the subscriptions to an object that has been deleted.
+ * @ingroup DSCOV
+ * Device_Delete_Object() calls this, so that no notifications are sent
+ * for the deleted object, and a new object created with the same
+ * instance does not inherit its subscriptions.  A
+ * SubscribeCOVPropertyMultiple context left with no properties to
+ * monitor is removed as well.
+ *
+ * @param object_type [in] The type of the object that was deleted.
+ * @param object_instance [in] The instance of the object that was deleted.
+ */
+void handler_cov_object_deleted(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    BACNET_OBJECT_ID object_id;
+    unsigned index = 0;
+    unsigned next = 0;
+    unsigned group = 0;
+
+    if (!cov_index_init()) {
+        return;
+    }
+    if (COV_Value_Cache.valid &&
+        (COV_Value_Cache.object.type == object_type) &&
+        (COV_Value_Cache.object.instance == object_instance)) {
+        COV_Value_Cache.valid = false;
+    }
+    object_id.type = object_type;
+    object_id.instance = object_instance;
+    index = COV_Object_Hash[cov_object_bucket(&object_id)];
+    while (index != COV_NO_INDEX) {
+        /* removing the slot reuses its link for the free list */
+        next = COV_Subscriptions[index].object_next;
+        if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
+                object_type) &&
+            (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
+                object_instance)) {
+            group = COV_NO_INDEX;
+            if (COV_Subscriptions[index].flag.member) {
+                group = COV_Subscriptions[index].group;
             }
-            break;
-        case COV_STATE_CLEAR:
-            /* clear the COV flag after checking all subscriptions */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
-                object_type = (BACNET_OBJECT_TYPE)
-                    COV_Subscriptions[index].monitoredObjectIdentifier.type;
-                object_instance =
-                    COV_Subscriptions[index].
-                    monitoredObjectIdentifier.instance;
-                Device_COV_Clear(object_type, object_instance);
+            cov_subscription_remove(index);
+            if ((group != COV_NO_INDEX) &&
+                (COV_Subscriptions[group].members == COV_NO_INDEX)) {
+                cov_subscription_remove(group);
             }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_FREE;
+        }
+        index = next;
+    }
+}
+
+/* notes a COV_Clock deadline of a queued notification, keeping the
+   earliest */
+static void cov_send_due(
+    uint32_t due)
+{
+    if (!COV_Send_Due_Valid || ((int32_t) (due - COV_Send_Due) < 0)) {
+        COV_Send_Due = due;
+        COV_Send_Due_Valid = true;
+    }
+}
+
+/* confirmed notification house keeping */
+static void cov_confirm_task(
+    void)
+{
+    unsigned *link = &COV_Confirm_Head;
+    unsigned index = 0;
+    BACNET_ADDRESS *dest = NULL;
+    bool done = false;
+
+    while (*link != COV_NO_INDEX) {
+        index = *link;
+        done = true;
+        dest = cov_address_get(COV_Subscriptions[index].dest_index);
+        if (dest && COV_Subscriptions[index].invokeID) {
+            if (tsm_peer_invoke_id_free(dest,
+                    COV_Subscriptions[index].invokeID)) {
+                COV_Subscriptions[index].invokeID = 0;
+            } else if (tsm_peer_invoke_id_failed(dest,
+                    COV_Subscriptions[index].invokeID)) {
+                tsm_free_peer_invoke_id(dest,
+                    COV_Subscriptions[index].invokeID);
+                COV_Subscriptions[index].invokeID = 0;
+            } else {
+                done = false;
             }
-            break;
-        case COV_STATE_FREE:
-            /* confirmed notification house keeping */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.issueConfirmedNotifications) &&
-                (COV_Subscriptions[index].invokeID)) {
-                if (tsm_invoke_id_free(COV_Subscriptions[index].invokeID)) {
-                    COV_Subscriptions[index].invokeID = 0;
-                } else
-                    if (tsm_invoke_id_failed(COV_Subscriptions
-                        [index].invokeID)) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
+        }
+        if (done) {
+            *link = COV_Subscriptions[index].confirm_next;
+            COV_Subscriptions[index].flag.awaiting_confirmation = false;
+            COV_Subscriptions[index].invokeID = 0;
+        } else {
+            link = &COV_Subscriptions[index].confirm_next;
+        }
+    }
+}
+
+/** Handler to send the queued COV notifications.
+ * @ingroup DSCOV
+ * Subscriptions are queued by handler_cov_object_changed() and when they
+ * are made, so the work done here follows the rate of change rather than
+ * the number of subscriptions.  For each queued subscription,
+ *  - Clear the COV flag of the object (eg, Binary_Input_Change_Of_Value_Clear() )
+ *  - Send the notice with cov_send_request()
+ *    - Will be confirmed or unconfirmed, as per the subscription.
+ *  - Leave it queued if it can not be sent yet, such as while a
+ *    confirmed notification to the same subscriber is outstanding.
+ * A SubscribeCOVPropertyMultiple context is queued by the changes of its
+ * properties, and once its maxNotificationDelay has passed sends them
+ * all in one notification, or as many as fit in the APDU.
+ *
+ * @note worst case tasking: MS/TP with the ability to send only
+ *        one notification per task cycle, which is the default for
+ *        MAX_COV_NOTIFICATIONS_PER_TASK.
+ *
+ * @return true if there are no notifications waiting to be sent
+ */
+bool handler_cov_fsm(
+    void)
+{
+    unsigned index = 0;
+    unsigned count = 0;
+    unsigned sent = 0;
+    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
+    uint32_t object_instance = 0;
+    bool status = false;
+    bool send = false;
+    int len = 0;
+
+    if (!cov_index_init()) {
+        return true;
+    }
+    if (COV_Confirm_Head != COV_NO_INDEX) {
+        cov_confirm_task();
+    }
+    COV_Send_Due_Valid = false;
+    /* look at each queued subscription at most once */
+    count = COV_Send_Count;
+    while (count && (sent < MAX_COV_NOTIFICATIONS_PER_TASK)) {
+        count--;
+        index = cov_send_dequeue();
+        if (!COV_Subscriptions[index].flag.valid) {
+            /* cancelled or expired since it was queued */
+            COV_Subscriptions[index].object_next = COV_Subscription_Free;
+            COV_Subscription_Free = index;
+            continue;
+        }
+        if (!COV_Subscriptions[index].flag.send_requested) {
+            continue;
+        }
+        send = true;
+        if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
+            if (COV_Subscriptions[index].invokeID != 0) {
+                /* already sending */
+                send = false;
             }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_SEND;
+            if (!tsm_transaction_available()) {
+                /* no transactions available - can't send now */
+                send = false;
             }
-            break;
-        case COV_STATE_SEND:
-            /* send any COVs that are requested */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
-                send = true;
-                if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                    if (COV_Subscriptions[index].invokeID != 0) {
-                        /* already sending */
-                        send = false;
-                    }
-                    if (!tsm_transaction_available()) {
-                        /* no transactions available - can't send now */
-                        send = false;
-                    }
-                }
-                if (send) {
-                    object_type = (BACNET_OBJECT_TYPE)
-                        COV_Subscriptions[index].
-                        monitoredObjectIdentifier.type;
-                    object_instance =
-                        COV_Subscriptions[index].
-                        monitoredObjectIdentifier.instance;
+        }
+        if (COV_Subscriptions[index].flag.group &&
+            ((int32_t) (COV_Subscriptions[index].due - COV_Clock) > 0)) {
+            /* waiting for other changes to send with this one */
+            cov_send_due(COV_Subscriptions[index].due);
+            send = false;
+        }
+        if (!send) {
+            cov_send_enqueue(index);
+            continue;
+        }
+        object_type = (BACNET_OBJECT_TYPE)
+            COV_Subscriptions[index].monitoredObjectIdentifier.type;
+        object_instance =
+            COV_Subscriptions[index].monitoredObjectIdentifier.instance;
 #if PRINT_ENABLED
-                    fprintf(stderr, "COVtask: Sending...\n");
+        fprintf(stderr, "COVtask: Sending...\n");
 #endif
-                    /* configure the linked list for the two properties */
-                    bacapp_property_value_list_init(&value_list[0],
-                        MAX_COV_PROPERTIES);
-                    status = Device_Encode_Value_List(object_type,
-                        object_instance, &value_list[0]);
-                    if (status) {
-                        status =
-                            cov_send_request(&COV_Subscriptions[index],
-                            &value_list[0]);
-                    }
-                    if (status) {
-                        COV_Subscriptions[index].flag.send_requested = false;
-                    }
-                }
+        if (COV_Subscriptions[index].flag.group) {
+            status = cov_group_send(index);
+        } else if (COV_Subscriptions[index].flag.property) {
+            status =
+                cov_property_sample_read(&COV_Subscriptions[index],
+                &COV_Property_Sample);
+            if (status) {
+                len =
+                    cov_property_values_encode(&COV_Property_Values[0],
+                    sizeof(COV_Property_Values), &COV_Subscriptions[index],
+                    &COV_Property_Sample);
+                status = (len > 0);
             }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_IDLE;
+            if (status) {
+                status =
+                    cov_send_request(&COV_Subscriptions[index],
+                    &COV_Property_Values[0], (unsigned) len);
             }
-            break;
-        default:
-            index = 0;
-            cov_task_state = COV_STATE_IDLE;
-            break;
+            if (status) {
+                cov_property_sample_sent(&COV_Subscriptions[index],
+                    &COV_Property_Sample);
+            }
+        } else {
+            status = cov_value_cache_load(object_type, object_instance);
+            if (status) {
+                status =
+                    cov_send_request(&COV_Subscriptions[index],
+                    &COV_Value_Cache.values[0], COV_Value_Cache.length);
+            }
+        }
+        sent++;
+        if (COV_Subscriptions[index].invokeID &&
+            !COV_Subscriptions[index].flag.awaiting_confirmation) {
+            COV_Subscriptions[index].confirm_next = COV_Confirm_Head;
+            COV_Confirm_Head = index;
+            COV_Subscriptions[index].flag.awaiting_confirmation = true;
+        }
+        if (status) {
+            COV_Subscriptions[index].flag.send_requested = false;
+        } else {
+            /* try again later */
+            cov_send_due(COV_Clock + 1);
+            cov_send_enqueue(index);
+        }
     }
-    return (cov_task_state == COV_STATE_IDLE);
+    /* the rest wait for a deadline, or for the TSM; unless this pass
+       stopped at its limit with some of the queue still to look at */
+    COV_Send_Ready = (count > 0);
+
+    if (COV_Send_Count == 0) {
+        /* the next change is encoded afresh */
+        COV_Value_Cache.valid = false;
+    }
+
+    return (COV_Send_Count == 0);
+}
+
+/** Gets the time until handler_cov_fsm() next has a notification that
+ * it may send, so that a task which sleeps knows when to call it.
+ * @ingroup DSCOV
+ * Notifications that wait for a free transaction, or for the
+ * confirmation of the one before, are not counted: they can only be
+ * sent once a reply arrives or tsm_timer_next() runs out.
+ *
+ * @param milliseconds [out] time until the notification is due, zero
+ *  if it is due now.  Deadlines are counted in the seconds of
+ *  handler_cov_timer_seconds(), so this may be up to a second early.
+ * @return true if a notification is due, or will be
+ */
+bool handler_cov_fsm_next(
+    uint32_t * milliseconds)
+{
+    int32_t remaining = 0;
+
+    if (COV_Send_Ready) {
+        *milliseconds = 0;
+        return true;
+    }
+    if (!COV_Send_Due_Valid) {
+        return false;
+    }
+    remaining = (int32_t) (COV_Send_Due - COV_Clock);
+    *milliseconds = (remaining > 0) ? ((uint32_t) remaining * 1000) : 0;
+
+    return true;
 }
 
 void handler_cov_task(
@@ -764,6 +2062,11 @@ static bool cov_subscribe(
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
 
+    if (!cov_index_init()) {
+        *error_class = ERROR_CLASS_RESOURCES;
+        *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+        return false;
+    }
     object_type =
         (BACNET_OBJECT_TYPE) cov_data->monitoredObjectIdentifier.type;
     object_instance = cov_data->monitoredObjectIdentifier.instance;
@@ -772,7 +2075,8 @@ static bool cov_subscribe(
         status = Device_Value_List_Supported(object_type);
         if (status) {
             status =
-                cov_list_subscribe(src, cov_data, error_class, error_code);
+                cov_list_subscribe(src, cov_data, false, error_class,
+                error_code);
         } else {
             *error_class = ERROR_CLASS_OBJECT;
             *error_code = ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
@@ -785,30 +2089,366 @@ static bool cov_subscribe(
     return status;
 }
 
-/** Handler for a COV Subscribe Service request.
- * @ingroup DSCOV
- * This handler will be invoked by apdu_handler() if it has been enabled
- * by a call to apdu_set_confirmed_handler().
- * This handler builds a response packet, which is
- * - an Abort if
- *   - the message is segmented
- *   - if decoding fails
- * - an ACK, if cov_subscribe() succeeds
- * - an Error if cov_subscribe() fails
- *
- * @param service_request [in] The contents of the service request.
- * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
- * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
- *                          decoded from the APDU header of this message.
- */
-void handler_cov_subscribe(
+/* checks that the property of a SubscribeCOVProperty request can be
+   monitored, and uses the COV increment of the object if none is given.
+   A cancellation is found by its subscription alone, so that it
+   succeeds even once the object is gone. */
+static bool cov_property_validate(
+    BACNET_SUBSCRIBE_COV_DATA * cov_data,
+    BACNET_ERROR_CLASS * error_class,
+    BACNET_ERROR_CODE * error_code)
+{
+    BACNET_READ_PROPERTY_DATA rpdata;
+    BACNET_APPLICATION_DATA_VALUE value;
+    int len = 0;
+
+    if (cov_data->cancellationRequest) {
+        return true;
+    }
+    rpdata.object_type = (BACNET_OBJECT_TYPE)
+        cov_data->monitoredObjectIdentifier.type;
+    rpdata.object_instance = cov_data->monitoredObjectIdentifier.instance;
+    if (!Device_Valid_Object_Id(rpdata.object_type, rpdata.object_instance)) {
+        *error_class = ERROR_CLASS_OBJECT;
+        *error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return false;
+    }
+    rpdata.application_data = &COV_Property_Sample.data[0];
+    rpdata.application_data_len = sizeof(COV_Property_Sample.data);
+    /* the property must be readable to be monitored */
+    rpdata.object_property = cov_data->monitoredProperty.propertyIdentifier;
+    rpdata.array_index = cov_data->monitoredProperty.propertyArrayIndex;
+    if (Device_Read_Property(&rpdata) < 0) {
+        *error_class = rpdata.error_class;
+        *error_code = rpdata.error_code;
+        return false;
+    }
+    if (!cov_data->covIncrementPresent) {
+        /* without an increment, use the one of the object if any */
+        rpdata.object_property = PROP_COV_INCREMENT;
+        rpdata.array_index = BACNET_ARRAY_ALL;
+        len = Device_Read_Property(&rpdata);
+        if ((len > 0) &&
+            (bacapp_decode_application_data(rpdata.application_data,
+                    (unsigned) len, &value) == len) &&
+            (value.tag == BACNET_APPLICATION_TAG_REAL)) {
+            cov_data->covIncrementPresent = true;
+            cov_data->covIncrement = value.type.Real;
+        }
+    }
+
+    return true;
+}
+
+static bool cov_subscribe_property(
+    BACNET_ADDRESS * src,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data,
+    BACNET_ERROR_CLASS * error_class,
+    BACNET_ERROR_CODE * error_code)
+{
+    if (!cov_index_init()) {
+        *error_class = ERROR_CLASS_RESOURCES;
+        *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+        return false;
+    }
+    if (!cov_property_validate(cov_data, error_class, error_code)) {
+        return false;
+    }
+
+    return cov_list_subscribe(src, cov_data, true, error_class, error_code);
+}
+
+/* finds the SubscribeCOVPropertyMultiple context of the subscriber */
+static unsigned cov_group_find(
+    BACNET_ADDRESS * src,
+    uint32_t subscriberProcessIdentifier)
+{
+    unsigned index = COV_Group_Head;
+    BACNET_ADDRESS *dest = NULL;
+
+    while (index != COV_NO_INDEX) {
+        dest = cov_address_get(COV_Subscriptions[index].dest_index);
+        if ((COV_Subscriptions[index].subscriberProcessIdentifier ==
+                subscriberProcessIdentifier) && dest &&
+            bacnet_address_same(src, dest)) {
+            break;
+        }
+        index = COV_Subscriptions[index].group_next;
+    }
+
+    return index;
+}
+
+/* finds the member of the group monitoring the property of the object */
+static unsigned cov_member_find(
+    unsigned group,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    unsigned index = COV_Subscriptions[group].members;
+
+    while (index != COV_NO_INDEX) {
+        if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
+                cov_data->monitoredObjectIdentifier.type) &&
+            (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
+                cov_data->monitoredObjectIdentifier.instance) &&
+            (COV_Subscriptions[index].monitoredProperty.propertyIdentifier ==
+                cov_data->monitoredProperty.propertyIdentifier) &&
+            (COV_Subscriptions[index].monitoredProperty.propertyArrayIndex ==
+                cov_data->monitoredProperty.propertyArrayIndex)) {
+            break;
+        }
+        index = COV_Subscriptions[index].member_next;
+    }
+
+    return index;
+}
+
+static unsigned cov_group_add(
+    BACNET_ADDRESS * src,
+    uint32_t subscriberProcessIdentifier)
+{
+    unsigned index = COV_NO_INDEX;
+
+    index = cov_subscription_alloc();
+    if (index != COV_NO_INDEX) {
+        COV_Subscriptions[index].dest_index = cov_address_add(src);
+        if (COV_Subscriptions[index].dest_index == COV_NO_INDEX) {
+            /* no room for the address - give the slot back */
+            COV_Subscriptions[index].object_next = COV_Subscription_Free;
+            COV_Subscription_Free = index;
+            return COV_NO_INDEX;
+        }
+        COV_Subscriptions[index].flag.valid = true;
+        COV_Subscriptions[index].flag.group = true;
+        COV_Subscriptions[index].flag.property = false;
+        COV_Subscriptions[index].subscriberProcessIdentifier =
+            subscriberProcessIdentifier;
+        COV_Subscriptions[index].monitoredObjectIdentifier.type =
+            OBJECT_DEVICE;
+        COV_Subscriptions[index].monitoredObjectIdentifier.instance =
+            Device_Object_Instance_Number();
+        COV_Subscriptions[index].invokeID = 0;
+        COV_Subscriptions[index].members = COV_NO_INDEX;
+        COV_Subscriptions[index].group_next = COV_Group_Head;
+        COV_Group_Head = index;
+    }
+
+    return index;
+}
+
+/* adds a member to the end of the group, so that the members of the
+   same object stay together in the notifications */
+static unsigned cov_member_add(
+    unsigned group,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    unsigned index = COV_NO_INDEX;
+    unsigned *link = NULL;
+
+    index = cov_subscription_alloc();
+    if (index != COV_NO_INDEX) {
+        COV_Subscriptions[index].flag.valid = true;
+        COV_Subscriptions[index].flag.property = true;
+        COV_Subscriptions[index].flag.member = true;
+        COV_Subscriptions[index].dest_index = COV_NO_INDEX;
+        COV_Subscriptions[index].invokeID = 0;
+        COV_Subscriptions[index].lifetime = 0;
+        COV_Subscriptions[index].subscriberProcessIdentifier =
+            COV_Subscriptions[group].subscriberProcessIdentifier;
+        COV_Subscriptions[index].monitoredObjectIdentifier.type =
+            cov_data->monitoredObjectIdentifier.type;
+        COV_Subscriptions[index].monitoredObjectIdentifier.instance =
+            cov_data->monitoredObjectIdentifier.instance;
+        COV_Subscriptions[index].group = group;
+        COV_Subscriptions[index].member_next = COV_NO_INDEX;
+        link = &COV_Subscriptions[group].members;
+        while (*link != COV_NO_INDEX) {
+            link = &COV_Subscriptions[*link].member_next;
+        }
+        *link = index;
+        cov_object_link(index);
+        cov_subscription_property_set(index, cov_data);
+    }
+
+    return index;
+}
+
+/* the request for one of the properties of a SubscribeCOVPropertyMultiple */
+static void cov_multiple_reference_data(
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data,
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION * specification,
+    BACNET_COV_REFERENCE * reference,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    cov_data->subscriberProcessIdentifier = data->subscriberProcessIdentifier;
+    cov_data->cancellationRequest = data->cancellationRequest;
+    cov_data->issueConfirmedNotifications =
+        data->issueConfirmedNotifications;
+    cov_data->lifetime = data->lifetime;
+    cov_data->monitoredObjectIdentifier.type =
+        specification->monitoredObjectIdentifier.type;
+    cov_data->monitoredObjectIdentifier.instance =
+        specification->monitoredObjectIdentifier.instance;
+    cov_data->monitoredProperty.propertyIdentifier =
+        reference->monitoredProperty.propertyIdentifier;
+    cov_data->monitoredProperty.propertyArrayIndex =
+        reference->monitoredProperty.propertyArrayIndex;
+    cov_data->covIncrementPresent = reference->covIncrementPresent;
+    cov_data->covIncrement = reference->covIncrement;
+}
+
+/* records the subscription reported in a SubscribeCOVPropertyMultiple-Error */
+static void cov_multiple_failed_set(
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data,
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION * specification,
+    BACNET_COV_REFERENCE * reference)
+{
+    if (specification) {
+        data->failedObjectIdentifier.type =
+            specification->monitoredObjectIdentifier.type;
+        data->failedObjectIdentifier.instance =
+            specification->monitoredObjectIdentifier.instance;
+    }
+    if (reference) {
+        data->failedProperty.propertyIdentifier =
+            reference->monitoredProperty.propertyIdentifier;
+        data->failedProperty.propertyArrayIndex =
+            reference->monitoredProperty.propertyArrayIndex;
+    }
+}
+
+/* subscribes to, or cancels, the properties of a
+   SubscribeCOVPropertyMultiple; all of the properties are checked, and
+   room is made for all of them, before any subscription is changed.
+   On failure, the failed object and property in data name the first
+   subscription that failed (or could not be made room for). */
+static bool cov_subscribe_property_multiple(
+    BACNET_ADDRESS * src,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data,
+    BACNET_ERROR_CLASS * error_class,
+    BACNET_ERROR_CODE * error_code)
+{
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION *specification = NULL;
+    BACNET_COV_REFERENCE *reference = NULL;
+    BACNET_SUBSCRIBE_COV_DATA cov_data;
+    unsigned group = COV_NO_INDEX;
+    unsigned index = COV_NO_INDEX;
+    unsigned needed = 0;
+    bool failed_set = false;
+
+    data->failedObjectIdentifier.type = OBJECT_DEVICE;
+    data->failedObjectIdentifier.instance = BACNET_MAX_INSTANCE;
+    data->failedProperty.propertyIdentifier = PROP_ALL;
+    data->failedProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+    specification = data->listOfCOVSubscriptionSpecifications;
+    if (specification) {
+        cov_multiple_failed_set(data, specification,
+            specification->listOfCOVReferences);
+    }
+    if (!cov_index_init()) {
+        *error_class = ERROR_CLASS_RESOURCES;
+        *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+        return false;
+    }
+    group = cov_group_find(src, data->subscriberProcessIdentifier);
+    if ((group == COV_NO_INDEX) && !data->cancellationRequest) {
+        needed++;
+    }
+    for (specification = data->listOfCOVSubscriptionSpecifications;
+        specification; specification = specification->next) {
+        for (reference = specification->listOfCOVReferences; reference;
+            reference = reference->next) {
+            cov_multiple_reference_data(data, specification, reference,
+                &cov_data);
+            if (!cov_property_validate(&cov_data, error_class, error_code)) {
+                cov_multiple_failed_set(data, specification, reference);
+                return false;
+            }
+            if ((group == COV_NO_INDEX) ||
+                (cov_member_find(group, &cov_data) == COV_NO_INDEX)) {
+                needed++;
+                if (!failed_set) {
+                    /* the first one that would not fit */
+                    cov_multiple_failed_set(data, specification, reference);
+                    failed_set = true;
+                }
+            }
+        }
+    }
+    /* every slot the request takes is reserved up front, so that adding
+       the members below cannot fail part of the way through */
+    if (!data->cancellationRequest && !cov_subscriptions_reserve(needed)) {
+        *error_class = ERROR_CLASS_RESOURCES;
+        *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+        return false;
+    }
+    if (data->cancellationRequest) {
+        /* cancellations without a context succeed, as for SubscribeCOV */
+        if (group == COV_NO_INDEX) {
+            return true;
+        }
+    } else if (group == COV_NO_INDEX) {
+        group = cov_group_add(src, data->subscriberProcessIdentifier);
+        if (group == COV_NO_INDEX) {
+            *error_class = ERROR_CLASS_RESOURCES;
+            *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
+            return false;
+        }
+    } else {
+        cov_invoke_id_release(group);
+    }
+    if (!data->cancellationRequest) {
+        COV_Subscriptions[group].flag.issueConfirmedNotifications =
+            data->issueConfirmedNotifications;
+        COV_Subscriptions[group].maxNotificationDelay =
+            data->maxNotificationDelay;
+        cov_timer_start(group, data->lifetime);
+    }
+    for (specification = data->listOfCOVSubscriptionSpecifications;
+        specification; specification = specification->next) {
+        for (reference = specification->listOfCOVReferences; reference;
+            reference = reference->next) {
+            cov_multiple_reference_data(data, specification, reference,
+                &cov_data);
+            (void) cov_property_validate(&cov_data, error_class, error_code);
+            index = cov_member_find(group, &cov_data);
+            if (data->cancellationRequest) {
+                if (index != COV_NO_INDEX) {
+                    cov_subscription_remove(index);
+                }
+                continue;
+            }
+            if (index == COV_NO_INDEX) {
+                index = cov_member_add(group, &cov_data);
+            } else {
+                cov_subscription_property_set(index, &cov_data);
+            }
+            cov_send_enqueue(index);
+        }
+    }
+    if (COV_Subscriptions[group].members == COV_NO_INDEX) {
+        cov_subscription_remove(group);
+    }
+
+    return true;
+}
+
+
+/* decodes a SubscribeCOV, SubscribeCOVProperty or
+   SubscribeCOVPropertyMultiple request, subscribes, and sends the reply */
+static void cov_subscribe_service(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
-    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data,
+    BACNET_CONFIRMED_SERVICE service_choice)
 {
     BACNET_SUBSCRIBE_COV_DATA cov_data;
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA cov_multiple_data;
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION
+        specifications[MAX_COV_MULTIPLE_OBJECTS];
+    BACNET_COV_REFERENCE references[MAX_COV_MULTIPLE_REFERENCES];
+    unsigned i = 0;
     int len = 0;
     int pdu_len = 0;
     int npdu_len = 0;
@@ -819,13 +2459,14 @@ void handler_cov_subscribe(
     BACNET_ADDRESS my_address;
     bool error = false;
 
+    memset(&cov_data, 0, sizeof(cov_data));
     /* initialize a common abort code */
     cov_data.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     npdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
@@ -836,9 +2477,40 @@ void handler_cov_subscribe(
         error = true;
         goto COV_ABORT;
     }
-    len =
-        cov_subscribe_decode_service_request(service_request, service_len,
-        &cov_data);
+    if (service_choice == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE) {
+        /* the references of all of the objects are decoded into one list */
+        for (i = 0; i < MAX_COV_MULTIPLE_OBJECTS; i++) {
+            specifications[i].listOfCOVReferences = NULL;
+            specifications[i].next = &specifications[i + 1];
+        }
+        specifications[MAX_COV_MULTIPLE_OBJECTS - 1].next = NULL;
+        for (i = 0; i < MAX_COV_MULTIPLE_REFERENCES; i++) {
+            references[i].next = &references[i + 1];
+        }
+        references[MAX_COV_MULTIPLE_REFERENCES - 1].next = NULL;
+        specifications[0].listOfCOVReferences = &references[0];
+        cov_multiple_data.listOfCOVSubscriptionSpecifications =
+            &specifications[0];
+        len =
+            cov_subscribe_property_multiple_decode_service_request
+            (service_request, service_len, &cov_multiple_data);
+        if (len == BACNET_STATUS_ERROR) {
+            len = BACNET_STATUS_REJECT;
+            cov_multiple_data.error_code =
+                ERROR_CODE_REJECT_MISSING_REQUIRED_PARAMETER;
+        }
+        if (len < 0) {
+            cov_data.error_code = cov_multiple_data.error_code;
+        }
+    } else if (service_choice == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY) {
+        len =
+            cov_subscribe_property_decode_service_request(service_request,
+            service_len, &cov_data);
+    } else {
+        len =
+            cov_subscribe_decode_service_request(service_request,
+            service_len, &cov_data);
+    }
 #if PRINT_ENABLED
     if (len <= 0)
         fprintf(stderr, "SubscribeCOV: Unable to decode Request!\n");
@@ -849,13 +2521,23 @@ void handler_cov_subscribe(
     }
     cov_data.error_class = ERROR_CLASS_OBJECT;
     cov_data.error_code = ERROR_CODE_UNKNOWN_OBJECT;
-    success =
-        cov_subscribe(src, &cov_data, &cov_data.error_class,
-        &cov_data.error_code);
+    if (service_choice == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE) {
+        success =
+            cov_subscribe_property_multiple(context->src, &cov_multiple_data,
+            &cov_data.error_class, &cov_data.error_code);
+    } else if (service_choice == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY) {
+        success =
+            cov_subscribe_property(context->src, &cov_data,
+            &cov_data.error_class, &cov_data.error_code);
+    } else {
+        success =
+            cov_subscribe(context->src, &cov_data, &cov_data.error_class,
+            &cov_data.error_code);
+    }
     if (success) {
         apdu_len =
-            encode_simple_ack(&Handler_Transmit_Buffer[npdu_len],
-            service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV);
+            encode_simple_ack(&context->tx_buffer[npdu_len],
+            service_data->invoke_id, service_choice);
 #if PRINT_ENABLED
         fprintf(stderr, "SubscribeCOV: Sending Simple Ack!\n");
 #endif
@@ -870,23 +2552,36 @@ void handler_cov_subscribe(
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
             apdu_len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                abort_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(cov_data.error_code), true);
 #if PRINT_ENABLED
             fprintf(stderr, "SubscribeCOV: Sending Abort!\n");
+#endif
+        } else if ((len == BACNET_STATUS_ERROR) &&
+            (service_choice ==
+                SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE)) {
+            /* Clause 13.16: the error names the first failed subscription */
+            cov_multiple_data.error_class = cov_data.error_class;
+            cov_multiple_data.error_code = cov_data.error_code;
+            apdu_len =
+                cov_subscribe_property_multiple_error_encode(&context->
+                tx_buffer[npdu_len], service_data->invoke_id,
+                &cov_multiple_data);
+#if PRINT_ENABLED
+            fprintf(stderr, "SubscribeCOV: Sending Error!\n");
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
-                service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV,
+                bacerror_encode_apdu(&context->tx_buffer[npdu_len],
+                service_data->invoke_id, service_choice,
                 cov_data.error_class, cov_data.error_code);
 #if PRINT_ENABLED
             fprintf(stderr, "SubscribeCOV: Sending Error!\n");
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
             apdu_len =
-                reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                reject_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(cov_data.error_code));
 #if PRINT_ENABLED
@@ -896,7 +2591,7 @@ void handler_cov_subscribe(
     }
     pdu_len = npdu_len + apdu_len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
@@ -908,3 +2603,80 @@ void handler_cov_subscribe(
 
     return;
 }
+
+/** Handler for a COV Subscribe Service request.
+ * @ingroup DSCOV
+ * This handler will be invoked by apdu_handler() if it has been enabled
+ * by a call to apdu_set_confirmed_handler().
+ * This handler builds a response packet, which is
+ * - an Abort if
+ *   - the message is segmented
+ *   - if decoding fails
+ * - an ACK, if cov_subscribe() succeeds
+ * - an Error if cov_subscribe() fails
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param context [in] Source address of the message and the reply buffers
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    cov_subscribe_service(service_request, service_len, context, service_data,
+        SERVICE_CONFIRMED_SUBSCRIBE_COV);
+}
+
+/** Handler for a COV Subscribe Property Service request.
+ * @ingroup DSCOV
+ * Like handler_cov_subscribe(), but the subscription is to a single
+ * property, which may be any readable property of the object.  Changes
+ * are found by comparing the property with the value last sent, using
+ * the COV increment of the request, or of the object if none was given,
+ * and the notifications carry just that property.
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param context [in] Source address of the message and the reply buffers
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe_property(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    cov_subscribe_service(service_request, service_len, context, service_data,
+        SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY);
+}
+
+/** Handler for a COV Subscribe Property Multiple Service request.
+ * @ingroup DSCOV
+ * Like handler_cov_subscribe_property(), for a list of properties of a
+ * list of objects.  The changes of all of the properties are sent to the
+ * subscriber together, in a COVNotificationMultiple of as many objects
+ * as fit in its max APDU, after waiting up to the maxNotificationDelay
+ * of the request for other changes to join the first.
+ * Errors are sent as a simple Error rather than a
+ * SubscribeCOVPropertyMultiple-Error, so the property at fault is not named.
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param context [in] Source address of the message and the reply buffers
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe_property_multiple(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    cov_subscribe_service(service_request, service_len, context, service_data,
+        SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE);
+}
@@ -90,14 +90,14 @@ char *handler_dcc_password(void)
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_device_communication_control(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     uint16_t timeDuration = 0;
@@ -112,14 +112,14 @@ void handler_device_communication_control(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
 #if PRINT_ENABLED
     fprintf(stderr, "DeviceCommunicationControl!\n");
 #endif
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -143,7 +143,7 @@ void handler_device_communication_control(
     /* bad decoding or something we didn't understand - send an abort */
     if (len < 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr,
@@ -154,7 +154,7 @@ void handler_device_communication_control(
     }
     if (state >= MAX_BACNET_COMMUNICATION_ENABLE_DISABLE) {
         len =
-            reject_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            reject_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, REJECT_REASON_UNDEFINED_ENUMERATION);
 #if PRINT_ENABLED
         fprintf(stderr,
@@ -167,14 +167,14 @@ void handler_device_communication_control(
         len =
             Routed_Device_Service_Approval
             (SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL, (int) state,
-            &Handler_Transmit_Buffer[pdu_len], service_data->invoke_id);
+            &context->tx_buffer[pdu_len], service_data->invoke_id);
         if (len > 0)
             goto DCC_ABORT;
 #endif
 
         if (characterstring_ansi_same(&password, My_Password)) {
             len =
-                encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                encode_simple_ack(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL);
 #if PRINT_ENABLED
@@ -184,7 +184,7 @@ void handler_device_communication_control(
             dcc_set_status_duration(state, timeDuration);
         } else {
             len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL,
                 ERROR_CLASS_SECURITY, ERROR_CODE_PASSWORD_FAILURE);
@@ -198,7 +198,7 @@ void handler_device_communication_control(
   DCC_ABORT:
     pdu_len += len;
     len =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
     if (len <= 0) {
 #if PRINT_ENABLED
@@ -34,6 +34,7 @@
 #include "bacerror.h"
 #include "apdu.h"
 #include "npdu.h"
+#include "tsm.h"
 #include "abort.h"
 #include "handlers.h"
 
@@ -53,7 +54,7 @@ void handler_get_alarm_summary_set(
 void handler_get_alarm_summary(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -63,9 +64,12 @@ void handler_get_alarm_summary(
     int alarm_value = 0;
     unsigned i = 0;
     unsigned j = 0;
+    unsigned index = 0;
     bool error = false;
+    unsigned max_apdu = 0;
     BACNET_ADDRESS my_address;
     BACNET_NPDU_DATA npdu_data;
+    BACNET_OBJECT_ID next_id;
     BACNET_GET_ALARM_SUMMARY_DATA getalarm_data;
 
 
@@ -74,36 +78,51 @@ void handler_get_alarm_summary(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         apdu_len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
         fprintf(stderr,
             "GetAlarmSummary: Segmented message. Sending Abort!\n");
 #endif
+        error = true;
         goto GET_ALARM_SUMMARY_ABORT;
     }
+    /* the reply is limited by the client, segmented if it accepts it */
+    max_apdu = tsm_complex_ack_max(service_data);
 
     /* init header */
     apdu_len =
-        get_alarm_summary_ack_encode_apdu_init(&Handler_Transmit_Buffer
+        get_alarm_summary_ack_encode_apdu_init(&context->tx_buffer
         [pdu_len], service_data->invoke_id);
 
 
     for (i = 0; i < MAX_BACNET_OBJECT_TYPE; i++) {
         if (Get_Alarm_Summary[i]) {
+            next_id.type = (BACNET_OBJECT_TYPE) i;
+            next_id.instance = 0;
             for (j = 0; j < 0xffff; j++) {
-                alarm_value = Get_Alarm_Summary[i] (j, &getalarm_data);
+                if (handler_event_index_valid((BACNET_OBJECT_TYPE) i)) {
+                    /* only the objects with events are in the index */
+                    if (!handler_event_index_next(&next_id, &index) ||
+                        (next_id.type != i)) {
+                        break;
+                    }
+                    next_id.instance++;
+                } else {
+                    index = j;
+                }
+                alarm_value = Get_Alarm_Summary[i] (index, &getalarm_data);
                 if (alarm_value > 0) {
                     len =
                         get_alarm_summary_ack_encode_apdu_data
-                        (&Handler_Transmit_Buffer[pdu_len + apdu_len],
-                        service_data->max_resp - apdu_len, &getalarm_data);
+                        (&context->tx_buffer[pdu_len + apdu_len],
+                        max_apdu - apdu_len, &getalarm_data);
                     if (len <= 0) {
                         error = true;
                         goto GET_ALARM_SUMMARY_ERROR;
@@ -126,7 +145,7 @@ void handler_get_alarm_summary(
         if (len == BACNET_STATUS_ABORT) {
             /* BACnet APDU too small to fit data, so proper response is Abort */
             apdu_len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                abort_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -135,7 +154,7 @@ void handler_get_alarm_summary(
 #endif
         } else {
             apdu_len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_GET_ALARM_SUMMARY,
                 ERROR_CLASS_PROPERTY, ERROR_CODE_OTHER);
 #if PRINT_ENABLED
@@ -146,10 +165,17 @@ void handler_get_alarm_summary(
 
 
   GET_ALARM_SUMMARY_ABORT:
-    pdu_len += apdu_len;
-    bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
-        pdu_len);
+    if (error) {
+        pdu_len += apdu_len;
+        bytes_sent =
+            datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+            pdu_len);
+    } else {
+        /* segmented if it does not fit in one APDU */
+        bytes_sent =
+            tsm_send_complex_ack(context->src, &npdu_data, service_data,
+            &context->tx_buffer[0], pdu_len, apdu_len);
+    }
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
         /*fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno)); */
@@ -34,14 +34,21 @@
 #include "bacerror.h"
 #include "apdu.h"
 #include "npdu.h"
+#include "tsm.h"
 #include "abort.h"
 #include "event.h"
 #include "getevent.h"
 #include "handlers.h"
+#include "keylist.h"
 
 /** @file h_getevent.c  Handles Get Event Information request. */
 
 static get_event_info_function Get_Event_Info[MAX_BACNET_OBJECT_TYPE];
+/* object types whose objects keep the event index up to date */
+static get_event_index_function Get_Event_Index[MAX_BACNET_OBJECT_TYPE];
+/* objects with an active event or unacknowledged transitions, keyed by
+   object type and instance so that they are visited in order */
+static OS_Keylist Event_Index;
 
 
 /** print eventState
@@ -77,15 +84,153 @@ void handler_get_event_information_set(
     }
 }
 
+/** Declare that objects of a type keep the event index up to date.
+ * @ingroup ALMEVNT
+ * GetEventInformation and GetAlarmSummary then visit only the objects of
+ * this type that are in the index, instead of asking each one in turn.
+ *
+ * @param object_type [in] The type of the objects.
+ * @param pFunction [in] Gives the index, as used by the functions set for
+ *  the services, of an object instance of this type.
+ */
+void handler_event_index_set(
+    BACNET_OBJECT_TYPE object_type,
+    get_event_index_function pFunction)
+{
+    if (object_type < MAX_BACNET_OBJECT_TYPE) {
+        Get_Event_Index[object_type] = pFunction;
+    }
+}
+
+/** Add an object to, or remove it from, the event index.
+ * @ingroup ALMEVNT
+ * Objects call this whenever their Event_State or Acked_Transitions
+ * change, and when they are deleted.
+ *
+ * @param object_type [in] The type of the object.
+ * @param object_instance [in] The instance of the object.
+ * @param active [in] True if the Event_State is not NORMAL, or any
+ *  transition is not acknowledged.
+ */
+void handler_event_index_update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    bool active)
+{
+    KEY key = KEY_ENCODE(object_type, object_instance);
+
+    if (!Event_Index) {
+        if (!active) {
+            return;
+        }
+        Event_Index = Keylist_Create();
+        if (!Event_Index) {
+            return;
+        }
+    }
+    if (Keylist_Index(Event_Index, key) < 0) {
+        if (active) {
+            (void) Keylist_Data_Add(Event_Index, key, NULL);
+        }
+    } else if (!active) {
+        (void) Keylist_Data_Delete(Event_Index, key);
+    }
+}
+
+/** Find the first object in the event index at or after an object.
+ * @ingroup ALMEVNT
+ *
+ * @param object_id [in,out] The object to start at, which is replaced
+ *  with the object found.
+ * @param index [out] The index of the object found, as used by the
+ *  functions set for the services.
+ * @return True if an object was found.
+ */
+bool handler_event_index_next(
+    BACNET_OBJECT_ID * object_id,
+    unsigned *index)
+{
+    KEY key = 0;
+    int position = 0;
+    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
+
+    if (!Event_Index) {
+        return false;
+    }
+    position =
+        Keylist_Index_Nearest(Event_Index, KEY_ENCODE(object_id->type,
+            object_id->instance));
+    while (position < Keylist_Count(Event_Index)) {
+        key = Keylist_Key(Event_Index, position);
+        object_type = (BACNET_OBJECT_TYPE) KEY_DECODE_TYPE(key);
+        if ((object_type < MAX_BACNET_OBJECT_TYPE) &&
+            Get_Event_Index[object_type]) {
+            object_id->type = object_type;
+            object_id->instance = KEY_DECODE_ID(key);
+            *index = Get_Event_Index[object_type] (object_id->instance);
+            return true;
+        }
+        position++;
+    }
+
+    return false;
+}
+
+/** Tells if objects of a type keep the event index up to date.
+ * @ingroup ALMEVNT
+ *
+ * @param object_type [in] The type of the objects.
+ * @return True if handler_event_index_set() was called for the type.
+ */
+bool handler_event_index_valid(
+    BACNET_OBJECT_TYPE object_type)
+{
+    return (object_type < MAX_BACNET_OBJECT_TYPE) &&
+        (Get_Event_Index[object_type] != NULL);
+}
+
+/* encodes one event information, and tells if there is room for more;
+   returns the length, or zero if the reply is full, or a negative
+   status if the reply cannot hold even one */
+static int getevent_encode_object(
+    uint8_t * apdu,
+    int apdu_len,
+    int apdu_size,
+    int max_apdu,
+    BACNET_GET_EVENT_INFORMATION_DATA * getevent_data)
+{
+    int len = 0;
+
+    getevent_data->next = NULL;
+    len =
+        getevent_ack_encode_apdu_data(apdu, apdu_size, getevent_data);
+    if (len <= 0) {
+        return BACNET_STATUS_ERROR;
+    }
+    if ((apdu_len + len) >= max_apdu - 2) {
+        /* Device must be able to fit minimum
+           one event information.
+           Length of one event informations needs
+           more than 50 octets. */
+        if (max_apdu < 128) {
+            return BACNET_STATUS_ABORT;
+        }
+        return 0;
+    }
+
+    return len;
+}
+
 void handler_get_event_information(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
     int pdu_len = 0;
     int apdu_len = 0;
+    int max_apdu = 0;
     BACNET_NPDU_DATA npdu_data;
     bool error = false;
     bool more_events = false;
@@ -94,7 +239,11 @@ void handler_get_event_information(
     BACNET_ERROR_CODE error_code = ERROR_CODE_UNKNOWN_OBJECT;
     BACNET_ADDRESS my_address;
     BACNET_OBJECT_ID object_id;
+    BACNET_OBJECT_ID next_id;
     unsigned i = 0, j = 0;      /* counter */
+    unsigned index = 0;
+    unsigned start_type = 0;
+    uint32_t start_instance = 0;
     BACNET_GET_EVENT_INFORMATION_DATA getevent_data;
     int valid_event = 0;
 
@@ -105,18 +254,19 @@ void handler_get_event_information(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
         fprintf(stderr,
             "GetEventInformation: " "Segmented message. Sending Abort!\n");
 #endif
+        error = true;
         goto GET_EVENT_ABORT;
     }
 
@@ -126,78 +276,81 @@ void handler_get_event_information(
     if (len < 0) {
         /* bad decoding - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr,
             "GetEventInformation: Bad Encoding.  Sending Abort!\n");
 #endif
+        error = true;
         goto GET_EVENT_ABORT;
     }
+    /* the reply is limited by the client, segmented if it accepts it */
+    max_apdu = (int) tsm_complex_ack_max(service_data);
     len =
-        getevent_ack_encode_apdu_init(&Handler_Transmit_Buffer[pdu_len],
-        sizeof(Handler_Transmit_Buffer) - pdu_len, service_data->invoke_id);
+        getevent_ack_encode_apdu_init(&context->tx_buffer[pdu_len],
+        context->tx_buffer_size - pdu_len, service_data->invoke_id);
     if (len <= 0) {
         error = true;
         goto GET_EVENT_ERROR;
     }
     pdu_len += len;
     apdu_len = len;
-    for (i = 0; i < MAX_BACNET_OBJECT_TYPE; i++) {
-        if (Get_Event_Info[i]) {
-            for (j = 0; j < 0xffff; j++) {
-                valid_event = Get_Event_Info[i] (j, &getevent_data);
-                if (valid_event > 0) {
-                    /* encode GetEvent_data only when type of object_id has max value */
-                    if (object_id.type != MAX_BACNET_OBJECT_TYPE) {
-                        if ((object_id.type ==
-                                getevent_data.objectIdentifier.type) &&
-                            (object_id.instance ==
-                                getevent_data.objectIdentifier.instance)) {
-                            /* found 'Last Received Object Identifier'
-                               so should set type of object_id to max value */
-                            object_id.type = MAX_BACNET_OBJECT_TYPE;
-                        }
-                        continue;
-                    }
-
-                    getevent_data.next = NULL;
-                    len =
-                        getevent_ack_encode_apdu_data(&Handler_Transmit_Buffer
-                        [pdu_len], sizeof(Handler_Transmit_Buffer) - pdu_len,
-                        &getevent_data);
-                    if (len <= 0) {
-                        error = true;
-                        goto GET_EVENT_ERROR;
-                    }
-                    apdu_len += len;
-                    if ((apdu_len >= service_data->max_resp - 2)  ||
-                        (apdu_len >= MAX_APDU - 2)) {
-                        /* Device must be able to fit minimum
-                           one event information.
-                           Length of one event informations needs
-                           more than 50 octets. */
-                        if ((service_data->max_resp < 128) ||
-                            (MAX_APDU < 128)) {
-                            len = BACNET_STATUS_ABORT;
-                            error = true;
-                            goto GET_EVENT_ERROR;
-                        } else {
-                            more_events = true;
-                        }
-                        break;
-                    } else {
-                        pdu_len += len;
-                    }
-                } else if (valid_event < 0) {
+    /* resume after 'Last Received Object Identifier', if given */
+    if (object_id.type < MAX_BACNET_OBJECT_TYPE) {
+        start_type = object_id.type;
+        start_instance = object_id.instance + 1;
+        if (object_id.instance >= BACNET_MAX_INSTANCE) {
+            start_type++;
+            start_instance = 0;
+        }
+    }
+    for (i = start_type; (i < MAX_BACNET_OBJECT_TYPE) && !more_events; i++) {
+        if (!Get_Event_Info[i]) {
+            continue;
+        }
+        if (i != start_type) {
+            start_instance = 0;
+        }
+        next_id.type = (BACNET_OBJECT_TYPE) i;
+        next_id.instance = start_instance;
+        for (j = 0; j < 0xffff; j++) {
+            if (handler_event_index_valid((BACNET_OBJECT_TYPE) i)) {
+                /* only the objects with events are in the index */
+                if (!handler_event_index_next(&next_id, &index) ||
+                    (next_id.type != i)) {
                     break;
                 }
+                next_id.instance++;
+            } else {
+                index = j;
+            }
+            valid_event = Get_Event_Info[i] (index, &getevent_data);
+            if (valid_event < 0) {
+                break;
             }
+            if ((valid_event == 0) ||
+                (getevent_data.objectIdentifier.instance < start_instance)) {
+                continue;
+            }
+            len =
+                getevent_encode_object(&context->tx_buffer[pdu_len],
+                apdu_len, context->tx_buffer_size - pdu_len, max_apdu,
+                &getevent_data);
+            if (len < 0) {
+                error = true;
+                goto GET_EVENT_ERROR;
+            } else if (len == 0) {
+                more_events = true;
+                break;
+            }
+            pdu_len += len;
+            apdu_len += len;
         }
     }
     len =
-        getevent_ack_encode_apdu_end(&Handler_Transmit_Buffer[pdu_len],
-        sizeof(Handler_Transmit_Buffer) - pdu_len, more_events);
+        getevent_ack_encode_apdu_end(&context->tx_buffer[pdu_len],
+        context->tx_buffer_size - pdu_len, more_events);
     if (len <= 0) {
         error = true;
         goto GET_EVENT_ERROR;
@@ -208,13 +361,13 @@ void handler_get_event_information(
   GET_EVENT_ERROR:
     if (error) {
         pdu_len =
-            npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+            npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
             &npdu_data);
 
         if (len == -2) {
             /* BACnet APDU too small to fit data, so proper response is Abort */
             len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                abort_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -223,7 +376,7 @@ void handler_get_event_information(
 #endif
         } else {
             len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_READ_PROPERTY,
                 error_class, error_code);
 #if PRINT_ENABLED
@@ -232,10 +385,17 @@ void handler_get_event_information(
         }
     }
   GET_EVENT_ABORT:
-    pdu_len += len;
-    bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
-        pdu_len);
+    if (error) {
+        pdu_len += len;
+        bytes_sent =
+            datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+            pdu_len);
+    } else {
+        /* segmented if it does not fit in one APDU */
+        bytes_sent =
+            tsm_send_complex_ack(context->src, &npdu_data, service_data,
+            &context->tx_buffer[0], pdu_len - apdu_len, apdu_len + len);
+    }
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
@@ -40,12 +40,12 @@
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_i_am_add(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     uint32_t device_id = 0;
@@ -63,10 +63,11 @@ void handler_i_am_add(
     if (len != -1) {
 #if PRINT_ENABLED
         fprintf(stderr, " from %lu, MAC = %d.%d.%d.%d.%d.%d\n",
-            (unsigned long) device_id, src->mac[0], src->mac[1], src->mac[2],
-            src->mac[3], src->mac[4], src->mac[5]);
+            (unsigned long) device_id, context->src->mac[0],
+            context->src->mac[1], context->src->mac[2], context->src->mac[3],
+            context->src->mac[4], context->src->mac[5]);
 #endif
-        address_add(device_id, max_apdu, src);
+        address_add(device_id, max_apdu, context->src);
     } else {
 #if PRINT_ENABLED
         fprintf(stderr, ", but unable to decode it.\n");
@@ -82,12 +83,12 @@ void handler_i_am_add(
  *
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_i_am_bind(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     uint32_t device_id = 0;
@@ -101,7 +102,7 @@ void handler_i_am_bind(
         &segmentation, &vendor_id);
     if (len > 0) {
         /* only add address if requested to bind */
-        address_add_binding(device_id, max_apdu, src);
+        address_add_binding(device_id, max_apdu, context->src);
     }
 
     return;
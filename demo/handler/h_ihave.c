@@ -39,18 +39,18 @@
  * @ingroup DMDOB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_i_have(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     BACNET_I_HAVE_DATA data;
 
     (void) service_len;
-    (void) src;
+    (void) context;
     len = ihave_decode_service_request(service_request, service_len, &data);
     if (len != -1) {
 #if PRINT_ENABLED
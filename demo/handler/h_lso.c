@@ -43,7 +43,7 @@
 void handler_lso(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_LSO_DATA data;
@@ -57,12 +57,12 @@ void handler_lso(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -79,7 +79,7 @@ void handler_lso(
     if (len < 0) {
         /* bad decoding - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "LSO: Bad Encoding.  Sending Abort!\n");
@@ -98,7 +98,7 @@ void handler_lso(
 #endif
 
     len =
-        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+        encode_simple_ack(&context->tx_buffer[pdu_len],
         service_data->invoke_id, SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION);
 #if PRINT_ENABLED
     fprintf(stderr, "Life Safety Operation: " "Sending Simple Ack!\n");
@@ -107,7 +107,7 @@ void handler_lso(
   LSO_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
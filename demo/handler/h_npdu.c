@@ -71,6 +71,7 @@ void npdu_handler(
     int apdu_offset = 0;
     BACNET_ADDRESS dest = { 0 };
     BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_REQUEST_CONTEXT context;
 
     /* only handle the version that we know how to handle */
     if (pdu[0] == BACNET_PROTOCOL_VERSION) {
@@ -92,7 +93,8 @@ void npdu_handler(
                     /* ConfirmedBroadcastReceived */
                     /* then enter IDLE - ignore the PDU */
                 } else {
-                    apdu_handler(src, &pdu[apdu_offset],
+                    handler_context_init(&context, src);
+                    apdu_handler(&context, &pdu[apdu_offset],
                         (uint16_t) (pdu_len - apdu_offset));
                 }
             } else {
@@ -50,10 +50,10 @@
 
 DATABLOCK MyData[MYMAXBLOCK];
 
-uint8_t IOBufferPT[MAX_APDU];   /* Buffer for building response in  */
-
+/* the response is built in buffer, which must hold MAX_APDU octets */
 static void ProcessPT(
-    BACNET_PRIVATE_TRANSFER_DATA * data)
+    BACNET_PRIVATE_TRANSFER_DATA * data,
+    uint8_t * buffer)
 {
     int iLen;   /* Index to current location in data */
     char cBlockNumber;
@@ -96,24 +96,24 @@ static void ProcessPT(
             iLen = 0;
 
             /* Signal success */
-            iLen += encode_application_unsigned(&IOBufferPT[iLen], MY_ERR_OK);
+            iLen += encode_application_unsigned(&buffer[iLen], MY_ERR_OK);
             /* Followed by the block number */
             iLen +=
-                encode_application_unsigned(&IOBufferPT[iLen], cBlockNumber);
+                encode_application_unsigned(&buffer[iLen], cBlockNumber);
             /* And Then the block contents */
             iLen +=
-                encode_application_unsigned(&IOBufferPT[iLen],
+                encode_application_unsigned(&buffer[iLen],
                 MyData[(int8_t) cBlockNumber].cMyByte1);
             iLen +=
-                encode_application_unsigned(&IOBufferPT[iLen],
+                encode_application_unsigned(&buffer[iLen],
                 MyData[(int8_t) cBlockNumber].cMyByte2);
             iLen +=
-                encode_application_real(&IOBufferPT[iLen],
+                encode_application_real(&buffer[iLen],
                 MyData[(int8_t) cBlockNumber].fMyReal);
             characterstring_init_ansi(&bsTemp,
                 (char *) MyData[(int8_t) cBlockNumber].sMyString);
             iLen +=
-                encode_application_character_string(&IOBufferPT[iLen],
+                encode_application_character_string(&buffer[iLen],
                 &bsTemp);
         } else {
             /* Write operation */
@@ -178,14 +178,14 @@ static void ProcessPT(
             /* Make sure it is nul terminated */
             MyData[(int8_t) cBlockNumber].sMyString[MY_MAX_STR] = '\0';
             /* Signal success */
-            iLen = encode_application_unsigned(&IOBufferPT[0], MY_ERR_OK);
+            iLen = encode_application_unsigned(&buffer[0], MY_ERR_OK);
         }
     } else {
         /* Signal bad index */
-        iLen = encode_application_unsigned(&IOBufferPT[0], MY_ERR_BAD_INDEX);
+        iLen = encode_application_unsigned(&buffer[0], MY_ERR_BAD_INDEX);
     }
     data->serviceParametersLen = iLen;
-    data->serviceParameters = IOBufferPT;
+    data->serviceParameters = buffer;
 }
 
 /*
@@ -202,7 +202,7 @@ static void ProcessPT(
 void handler_conf_private_trans(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_PRIVATE_TRANSFER_DATA data;
@@ -231,12 +231,12 @@ void handler_conf_private_trans(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
 
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -250,7 +250,7 @@ void handler_conf_private_trans(
     /* bad decoding - send an abort */
     if (len < 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "CPT: Bad Encoding. Sending Abort!\n");
@@ -268,7 +268,7 @@ void handler_conf_private_trans(
         (data.serviceNumber <= MY_SVC_WRITE)) {
         /* We only try to understand our own IDs and service numbers */
         /* Will either return a result block or an app level status block */
-        ProcessPT(&data);
+        ProcessPT(&data, context->scratch);
         if (data.serviceParametersLen == 0) {
             /* No respopnse means fatal error */
             error = true;
@@ -279,7 +279,7 @@ void handler_conf_private_trans(
 #endif
         }
         len =
-            ptransfer_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            ptransfer_ack_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, &data);
     } else {    /* Not our vendor ID or bad service parameter */
 
@@ -293,13 +293,13 @@ void handler_conf_private_trans(
 
     if (error) {
         len =
-            ptransfer_error_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            ptransfer_error_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, error_class, error_code, &data);
     }
   CPT_ABORT:
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 
 #if PRINT_ENABLED
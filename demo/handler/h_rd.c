@@ -59,14 +59,14 @@
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_reinitialize_device(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_REINITIALIZE_DEVICE_DATA rd_data;
@@ -79,14 +79,14 @@ void handler_reinitialize_device(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
 #if PRINT_ENABLED
     fprintf(stderr, "ReinitializeDevice!\n");
 #endif
     if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
@@ -111,7 +111,7 @@ void handler_reinitialize_device(
     /* bad decoding or something we didn't understand - send an abort */
     if (len < 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr,
@@ -122,7 +122,7 @@ void handler_reinitialize_device(
     /* check the data from the request */
     if (rd_data.state >= BACNET_REINIT_MAX) {
         len =
-            reject_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            reject_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, REJECT_REASON_UNDEFINED_ENUMERATION);
 #if PRINT_ENABLED
         fprintf(stderr,
@@ -134,14 +134,14 @@ void handler_reinitialize_device(
         len =
             Routed_Device_Service_Approval
             (SERVICE_CONFIRMED_REINITIALIZE_DEVICE, (int) rd_data.state,
-            &Handler_Transmit_Buffer[pdu_len], service_data->invoke_id);
+            &context->tx_buffer[pdu_len], service_data->invoke_id);
         if (len > 0)
             goto RD_ABORT;
 #endif
 
         if (Device_Reinitialize(&rd_data)) {
             len =
-                encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                encode_simple_ack(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 SERVICE_CONFIRMED_REINITIALIZE_DEVICE);
 #if PRINT_ENABLED
@@ -149,7 +149,7 @@ void handler_reinitialize_device(
 #endif
         } else {
             len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_REINITIALIZE_DEVICE,
                 rd_data.error_class, rd_data.error_code);
 #if PRINT_ENABLED
@@ -160,7 +160,7 @@ void handler_reinitialize_device(
   RD_ABORT:
     pdu_len += len;
     len =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
     if (len <= 0) {
 #if PRINT_ENABLED
@@ -200,6 +200,7 @@ static void routed_apdu_handler(
 {
     int cursor = 0;     /* Starting hint */
     bool bGotOne = false;
+    BACNET_REQUEST_CONTEXT context;
 
     if (!Routed_Device_Is_Valid_Network(dest->net, DNET_list)) {
         /* We don't know how to reach this one.
@@ -225,8 +226,9 @@ static void routed_apdu_handler(
         return;
     }
 
+    handler_context_init(&context, src);
     while (Routed_Device_GetNext(dest, DNET_list, &cursor)) {
-        apdu_handler(src, apdu, apdu_len);
+        apdu_handler(&context, apdu, apdu_len);
         bGotOne = true;
         if (cursor < 0) /* If no more matches, */
             break;      /* We don't need to keep looking */
@@ -35,6 +35,7 @@
 #include "bacdevobjpropref.h"
 #include "apdu.h"
 #include "npdu.h"
+#include "tsm.h"
 #include "abort.h"
 #include "reject.h"
 #include "rp.h"
@@ -53,21 +54,21 @@
  * - an Abort if
  *   - the message is segmented
  *   - if decoding fails
- *   - if the response would be too large
+ *   - if the response would be too large, even when segmented
  * - the result from Device_Read_Property(), if it succeeds
  * - an Error if Device_Read_Property() fails
  *   or there isn't enough room in the APDU to fit the data.
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_read_property(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_READ_PROPERTY_DATA rpdata;
@@ -86,7 +87,7 @@ void handler_read_property(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     npdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
@@ -117,20 +118,20 @@ void handler_read_property(
     }
 
     apdu_len =
-        rp_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
+        rp_ack_encode_apdu_init(&context->tx_buffer[npdu_len],
         service_data->invoke_id, &rpdata);
     /* configure our storage */
-    rpdata.application_data = &Handler_Transmit_Buffer[npdu_len + apdu_len];
+    rpdata.application_data = &context->tx_buffer[npdu_len + apdu_len];
     rpdata.application_data_len =
-        sizeof(Handler_Transmit_Buffer) - (npdu_len + apdu_len);
+        context->tx_buffer_size - (npdu_len + apdu_len);
     len = Device_Read_Property(&rpdata);
     if (len >= 0) {
         apdu_len += len;
         len =
-            rp_ack_encode_apdu_object_property_end(&Handler_Transmit_Buffer
+            rp_ack_encode_apdu_object_property_end(&context->tx_buffer
             [npdu_len + apdu_len]);
         apdu_len += len;
-        if (apdu_len > service_data->max_resp) {
+        if (apdu_len > (int) tsm_complex_ack_max(service_data)) {
             /* too big for the sender - send an abort
              * Setting of error code needed here as read property processing may
              * have overriden the default set at start */
@@ -164,7 +165,7 @@ void handler_read_property(
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
             apdu_len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                abort_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(rpdata.error_code), true);
 #if PRINT_ENABLED
@@ -172,7 +173,7 @@ void handler_read_property(
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_READ_PROPERTY,
                 rpdata.error_class, rpdata.error_code);
 #if PRINT_ENABLED
@@ -180,7 +181,7 @@ void handler_read_property(
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
             apdu_len =
-                reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                reject_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(rpdata.error_code));
 #if PRINT_ENABLED
@@ -189,10 +190,17 @@ void handler_read_property(
         }
     }
 
-    pdu_len = npdu_len + apdu_len;
-    bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
-        pdu_len);
+    if (error) {
+        pdu_len = npdu_len + apdu_len;
+        bytes_sent =
+            datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+            pdu_len);
+    } else {
+        /* segmented if it does not fit in one APDU */
+        bytes_sent =
+            tsm_send_complex_ack(context->src, &npdu_data, service_data,
+            &context->tx_buffer[0], npdu_len, apdu_len);
+    }
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
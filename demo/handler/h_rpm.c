@@ -36,6 +36,7 @@
 #include "bacdcode.h"
 #include "apdu.h"
 #include "npdu.h"
+#include "tsm.h"
 #include "abort.h"
 #include "reject.h"
 #include "bacerror.h"
@@ -46,8 +47,6 @@
 
 /** @file h_rpm.c  Handles Read Property Multiple requests. */
 
-static uint8_t Temp_Buf[MAX_APDU] = { 0 };
-
 static BACNET_PROPERTY_ID RPM_Object_Property(
     struct special_property_list_t *pPropertyList,
     BACNET_PROPERTY_ID special_property,
@@ -102,8 +101,10 @@ static unsigned RPM_Object_Property_Count(
 }
 
 /** Encode the RPM property returning the length of the encoding,
-   or 0 if there is no room to fit the encoding.  */
+   or 0 if there is no room to fit the encoding.  The value is read
+   into the scratch space of the request context first. */
 static int RPM_Encode_Property(
+    BACNET_REQUEST_CONTEXT * context,
     uint8_t * apdu,
     uint16_t offset,
     uint16_t max_apdu,
@@ -115,9 +116,10 @@ static int RPM_Encode_Property(
     BACNET_READ_PROPERTY_DATA rpdata;
 
     len =
-        rpm_ack_encode_apdu_object_property(&Temp_Buf[0],
+        rpm_ack_encode_apdu_object_property(&context->scratch[0],
         rpmdata->object_property, rpmdata->array_index);
-    copy_len = memcopy(&apdu[0], &Temp_Buf[0], offset, len, max_apdu);
+    copy_len =
+        memcopy(&apdu[0], &context->scratch[0], offset, len, max_apdu);
     if (copy_len == 0) {
         rpmdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
         return BACNET_STATUS_ABORT;
@@ -130,8 +132,8 @@ static int RPM_Encode_Property(
     rpdata.object_instance = rpmdata->object_instance;
     rpdata.object_property = rpmdata->object_property;
     rpdata.array_index = rpmdata->array_index;
-    rpdata.application_data = &Temp_Buf[0];
-    rpdata.application_data_len = sizeof(Temp_Buf);
+    rpdata.application_data = &context->scratch[0];
+    rpdata.application_data_len = context->scratch_size;
     len = Device_Read_Property(&rpdata);
     if (len < 0) {
         if ((len == BACNET_STATUS_ABORT) || (len == BACNET_STATUS_REJECT)) {
@@ -141,10 +143,11 @@ static int RPM_Encode_Property(
         }
         /* error was returned - encode that for the response */
         len =
-            rpm_ack_encode_apdu_object_property_error(&Temp_Buf[0],
+            rpm_ack_encode_apdu_object_property_error(&context->scratch[0],
             rpdata.error_class, rpdata.error_code);
         copy_len =
-            memcopy(&apdu[0], &Temp_Buf[0], offset + apdu_len, len, max_apdu);
+            memcopy(&apdu[0], &context->scratch[0], offset + apdu_len, len,
+            max_apdu);
 
         if (copy_len == 0) {
             rpmdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -154,7 +157,7 @@ static int RPM_Encode_Property(
         /* enough room to fit the property value and tags */
         len =
             rpm_ack_encode_apdu_object_property_value(&apdu[offset + apdu_len],
-            &Temp_Buf[0], len);
+            &context->scratch[0], len);
     } else {
         /* not enough room - abort! */
         rpmdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -173,21 +176,21 @@ static int RPM_Encode_Property(
  * - an Abort if
  *   - the message is segmented
  *   - if decoding fails
- *   - if the response would be too large
+ *   - if the response would be too large, even when segmented
  * - the result from each included read request, if it succeeds
  * - an Error if processing fails for all, or individual errors if only some fail,
  *   or there isn't enough room in the APDU to fit the data.
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_read_property_multiple(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -201,14 +204,15 @@ void handler_read_property_multiple(
     int apdu_len = 0;
     int npdu_len = 0;
     int error = 0;
+    uint16_t max_apdu = 0;
 
     /* jps_debug - see if we are utilizing all the buffer */
-    /* memset(&Handler_Transmit_Buffer[0], 0xff, sizeof(Handler_Transmit_Buffer)); */
+    /* memset(&context->tx_buffer[0], 0xff, context->tx_buffer_size); */
     /* encode the NPDU portion of the packet */
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     npdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         rpmdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -218,10 +222,16 @@ void handler_read_property_multiple(
 #endif
         goto RPM_FAILURE;
     }
+    /* the reply is limited by the client, segmented if it accepts it */
+    max_apdu = (uint16_t) tsm_complex_ack_max(service_data);
+    /* and by the room left in the transmit buffer of the request */
+    if (max_apdu > (context->tx_buffer_size - npdu_len)) {
+        max_apdu = (uint16_t) (context->tx_buffer_size - npdu_len);
+    }
     /* decode apdu request & encode apdu reply
        encode complex ack, invoke id, service choice */
     apdu_len =
-        rpm_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
+        rpm_ack_encode_apdu_init(&context->tx_buffer[npdu_len],
         service_data->invoke_id);
     for (;;) {
         /* Start by looking for an object ID */
@@ -247,10 +257,10 @@ void handler_read_property_multiple(
         }
 
         /* Stick this object id into the reply - if it will fit */
-        len = rpm_ack_encode_apdu_object_begin(&Temp_Buf[0], &rpmdata);
+        len = rpm_ack_encode_apdu_object_begin(&context->scratch[0], &rpmdata);
         copy_len =
-            memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0], apdu_len,
-            len, MAX_APDU);
+            memcopy(&context->tx_buffer[npdu_len], &context->scratch[0],
+            apdu_len, len, max_apdu);
         if (copy_len == 0) {
 #if PRINT_ENABLED
             fprintf(stderr, "RPM: Response too big!\r\n");
@@ -289,11 +299,12 @@ void handler_read_property_multiple(
                     /*  No array index options for this special property.
                        Encode error for this object property response */
                     len =
-                        rpm_ack_encode_apdu_object_property(&Temp_Buf[0],
-                        rpmdata.object_property, rpmdata.array_index);
+                        rpm_ack_encode_apdu_object_property
+                        (&context->scratch[0], rpmdata.object_property,
+                        rpmdata.array_index);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&context->tx_buffer[npdu_len],
+                        &context->scratch[0], apdu_len, len, max_apdu);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr,
@@ -306,12 +317,12 @@ void handler_read_property_multiple(
                     }
                     apdu_len += len;
                     len =
-                        rpm_ack_encode_apdu_object_property_error(&Temp_Buf[0],
-                        ERROR_CLASS_PROPERTY,
+                        rpm_ack_encode_apdu_object_property_error
+                        (&context->scratch[0], ERROR_CLASS_PROPERTY,
                         ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&context->tx_buffer[npdu_len],
+                        &context->scratch[0], apdu_len, len, max_apdu);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr, "RPM: Too full to encode error!\r\n");
@@ -342,9 +353,9 @@ void handler_read_property_multiple(
                                 RPM_Object_Property(&property_list,
                                 special_object_property, index);
                             len =
-                                RPM_Encode_Property(&Handler_Transmit_Buffer
-                                [npdu_len], (uint16_t) apdu_len, MAX_APDU,
-                                &rpmdata);
+                                RPM_Encode_Property(context,
+                                &context->tx_buffer[npdu_len],
+                                (uint16_t) apdu_len, max_apdu, &rpmdata);
                             if (len > 0) {
                                 apdu_len += len;
                             } else {
@@ -361,8 +372,8 @@ void handler_read_property_multiple(
             } else {
                 /* handle an individual property */
                 len =
-                    RPM_Encode_Property(&Handler_Transmit_Buffer[npdu_len],
-                    (uint16_t) apdu_len, MAX_APDU, &rpmdata);
+                    RPM_Encode_Property(context, &context->tx_buffer[npdu_len],
+                    (uint16_t) apdu_len, max_apdu, &rpmdata);
                 if (len > 0) {
                     apdu_len += len;
                 } else {
@@ -377,10 +388,10 @@ void handler_read_property_multiple(
             if (decode_is_closing_tag_number(&service_request[decode_len], 1)) {
                 /* Reached end of property list so cap the result list */
                 decode_len++;
-                len = rpm_ack_encode_apdu_object_end(&Temp_Buf[0]);
+                len = rpm_ack_encode_apdu_object_end(&context->scratch[0]);
                 copy_len =
-                    memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0],
-                    apdu_len, len, MAX_APDU);
+                    memcopy(&context->tx_buffer[npdu_len], &context->scratch[0],
+                    apdu_len, len, max_apdu);
                 if (copy_len == 0) {
 #if PRINT_ENABLED
                     fprintf(stderr, "RPM: Too full to encode object end!\r\n");
@@ -401,7 +412,7 @@ void handler_read_property_multiple(
         }
     }
 
-    if (apdu_len > service_data->max_resp) {
+    if (apdu_len > max_apdu) {
         /* too big for the sender - send an abort */
         rpmdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
         error = BACNET_STATUS_ABORT;
@@ -415,7 +426,7 @@ void handler_read_property_multiple(
     if (error) {
         if (error == BACNET_STATUS_ABORT) {
             apdu_len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                abort_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(rpmdata.error_code), true);
 #if PRINT_ENABLED
@@ -423,7 +434,7 @@ void handler_read_property_multiple(
 #endif
         } else if (error == BACNET_STATUS_ERROR) {
             apdu_len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
                 rpmdata.error_class, rpmdata.error_code);
 #if PRINT_ENABLED
@@ -431,7 +442,7 @@ void handler_read_property_multiple(
 #endif
         } else if (error == BACNET_STATUS_REJECT) {
             apdu_len =
-                reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                reject_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(rpmdata.error_code));
 #if PRINT_ENABLED
@@ -440,10 +451,17 @@ void handler_read_property_multiple(
         }
     }
 
-    pdu_len = apdu_len + npdu_len;
-    bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
-        pdu_len);
+    if (error) {
+        pdu_len = apdu_len + npdu_len;
+        bytes_sent =
+            datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+            pdu_len);
+    } else {
+        /* segmented if it does not fit in one APDU */
+        bytes_sent =
+            tsm_send_complex_ack(context->src, &npdu_data, service_data,
+            &context->tx_buffer[0], npdu_len, apdu_len);
+    }
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
         fprintf(stderr, "RPM: Failed to send PDU (%s)!\n", strerror(errno));
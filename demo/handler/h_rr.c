@@ -34,6 +34,7 @@
 #include "bacerror.h"
 #include "apdu.h"
 #include "npdu.h"
+#include "tsm.h"
 #include "abort.h"
 #include "readrange.h"
 #include "device.h"
@@ -41,8 +42,6 @@
 
 /** @file h_rr.c  Handles Read Range requests. */
 
-static uint8_t Temp_Buf[MAX_APDU] = { 0 };
-
 /* Encodes the property APDU and returns the length,
    or sets the error, and returns -1 */
 static int Encode_RR_payload(
@@ -90,7 +89,7 @@ static int Encode_RR_payload(
 void handler_read_range(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_READ_RANGE_DATA data;
@@ -100,6 +99,7 @@ void handler_read_range(
     bool error = false;
     int bytes_sent = 0;
     BACNET_ADDRESS my_address;
+    unsigned max_apdu = 0;
 
     data.error_class = ERROR_CLASS_OBJECT;
     data.error_code = ERROR_CODE_UNKNOWN_OBJECT;
@@ -107,17 +107,18 @@ void handler_read_range(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
 #if PRINT_ENABLED
         fprintf(stderr, "RR: Segmented message.  Sending Abort!\n");
 #endif
+        error = true;
         goto RR_ABORT;
     }
     memset(&data, 0, sizeof(data));     /* start with blank canvas */
@@ -129,35 +130,44 @@ void handler_read_range(
     if (len < 0) {
         /* bad decoding - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
 #if PRINT_ENABLED
         fprintf(stderr, "RR: Bad Encoding.  Sending Abort!\n");
 #endif
+        error = true;
         goto RR_ABORT;
     }
+    /* the object handlers fit the items into MAX_APDU less the overhead,
+       so move the overhead by what the client takes, segmented or not */
+    max_apdu = tsm_complex_ack_max(service_data);
+    data.Overhead += MAX_APDU - (int) max_apdu;
 
     /* assume that there is an error */
     error = true;
-    len = Encode_RR_payload(&Temp_Buf[0], &data);
+    len = Encode_RR_payload(&context->scratch[0], &data);
     if (len >= 0) {
         /* encode the APDU portion of the packet */
-        data.application_data = &Temp_Buf[0];
+        data.application_data = &context->scratch[0];
         data.application_data_len = len;
         /* FIXME: probably need a length limitation sent with encode */
         len =
-            rr_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            rr_ack_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, &data);
+        if (len <= (int) max_apdu) {
 #if PRINT_ENABLED
-        fprintf(stderr, "RR: Sending Ack!\n");
+            fprintf(stderr, "RR: Sending Ack!\n");
 #endif
-        error = false;
+            error = false;
+        } else {
+            len = -2;
+        }
     }
     if (error) {
         if (len == -2) {
             /* BACnet APDU too small to fit data, so proper response is Abort */
             len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                abort_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id,
                 ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
 #if PRINT_ENABLED
@@ -165,7 +175,7 @@ void handler_read_range(
 #endif
         } else {
             len =
-                bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                 service_data->invoke_id, SERVICE_CONFIRMED_READ_RANGE,
                 data.error_class, data.error_code);
 #if PRINT_ENABLED
@@ -174,10 +184,17 @@ void handler_read_range(
         }
     }
   RR_ABORT:
-    pdu_len += len;
-    bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
-        pdu_len);
+    if (error) {
+        pdu_len += len;
+        bytes_sent =
+            datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+            pdu_len);
+    } else {
+        /* segmented if it does not fit in one APDU */
+        bytes_sent =
+            tsm_send_complex_ack(context->src, &npdu_data, service_data,
+            &context->tx_buffer[0], pdu_len, len);
+    }
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
         fprintf(stderr, "Failed to send PDU (%s)!\n", strerror(errno));
@@ -69,13 +69,13 @@ static void show_bacnet_date_time(
 void handler_timesync(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     BACNET_DATE bdate = {0};
     BACNET_TIME btime = {0};
 
-    (void) src;
+    (void) context;
     (void) service_len;
     len =
         timesync_decode_service_request(service_request, service_len, &bdate,
@@ -99,13 +99,13 @@ void handler_timesync(
 void handler_timesync_utc(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     BACNET_DATE bdate;
     BACNET_TIME btime;
 
-    (void) src;
+    (void) context;
     (void) service_len;
     len =
         timesync_decode_service_request(service_request, service_len, &bdate,
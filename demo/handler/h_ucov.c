@@ -55,20 +55,20 @@
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message (unused)
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_ucov_notification(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     BACNET_COV_DATA cov_data;
     BACNET_PROPERTY_VALUE property_value[MAX_COV_PROPERTIES];
     BACNET_PROPERTY_VALUE *pProperty_value = NULL;
     int len = 0;
 
-    /* src not needed for this application */
-    src = src;
+    /* context->src not needed for this application */
+    context->src = context->src;
     /* create linked list to store data if more
        than one property value is expected */
     bacapp_property_value_list_init(&property_value[0], MAX_COV_PROPERTIES);
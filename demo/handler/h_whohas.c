@@ -41,9 +41,11 @@
 /** Local function which responds with either the requested object name
  *  or object ID, if the Device has a match.
  *  @param data [in] The decoded who-has payload from the request.
+ *  @param buffer [in] The buffer to send the I-Have from.
  */
 static void match_name_or_object(
-    BACNET_WHO_HAS_DATA * data)
+    BACNET_WHO_HAS_DATA * data,
+    uint8_t * buffer)
 {
     int object_type = 0;
     uint32_t object_instance = 0;
@@ -58,7 +60,7 @@ static void match_name_or_object(
             Device_Valid_Object_Name(&data->object.name, &object_type,
             &object_instance);
         if (found) {
-            Send_I_Have(Device_Object_Instance_Number(),
+            Send_I_Have_Buffer(buffer, Device_Object_Instance_Number(),
                 (BACNET_OBJECT_TYPE) object_type, object_instance,
                 &data->object.name);
         }
@@ -69,7 +71,7 @@ static void match_name_or_object(
             object.identifier.type, data->object.identifier.instance,
             &object_name);
         if (found) {
-            Send_I_Have(Device_Object_Instance_Number(),
+            Send_I_Have_Buffer(buffer, Device_Object_Instance_Number(),
                 (BACNET_OBJECT_TYPE) data->object.identifier.type,
                 data->object.identifier.instance, &object_name);
         }
@@ -84,18 +86,17 @@ static void match_name_or_object(
  * @ingroup DMDOB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_has(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     BACNET_WHO_HAS_DATA data;
     bool directed_to_me = false;
 
-    (void) src;
     len = whohas_decode_service_request(service_request, service_len, &data);
     if (len > 0) {
         if ((data.low_limit == -1) || (data.high_limit == -1))
@@ -104,7 +105,7 @@ void handler_who_has(
             && (Device_Object_Instance_Number() <= (uint32_t) data.high_limit))
             directed_to_me = true;
         if (directed_to_me) {
-            match_name_or_object(&data);
+            match_name_or_object(&data, context->tx_buffer);
         }
     }
 }
@@ -122,12 +123,12 @@ void handler_who_has(
  * @ingroup DMDOB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source (ignored).
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_has_for_routing(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     BACNET_WHO_HAS_DATA data;
@@ -136,7 +137,6 @@ void handler_who_has_for_routing(
     int my_list[2] = { 0, -1 }; /* Not really used, so dummy values */
     BACNET_ADDRESS bcast_net;
 
-    (void) src;
     len = whohas_decode_service_request(service_request, service_len, &data);
     if (len > 0) {
         /* Go through all devices, starting with the root gateway Device */
@@ -147,7 +147,7 @@ void handler_who_has_for_routing(
             if ((data.low_limit == -1) || (data.high_limit == -1) ||
                 ((dev_instance >= data.low_limit) &&
                     (dev_instance <= data.high_limit)))
-                match_name_or_object(&data);
+                match_name_or_object(&data, context->tx_buffer);
         }
     }
 }
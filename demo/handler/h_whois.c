@@ -45,28 +45,27 @@
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source (ignored).
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_is(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     int32_t low_limit = 0;
     int32_t high_limit = 0;
 
-    (void) src;
     len =
         whois_decode_service_request(service_request, service_len, &low_limit,
         &high_limit);
     if (len == 0) {
-        Send_I_Am(&Handler_Transmit_Buffer[0]);
+        Send_I_Am(&context->tx_buffer[0]);
     } else if (len != BACNET_STATUS_ERROR) {
         /* is my device id within the limits? */
         if ((Device_Object_Instance_Number() >= (uint32_t) low_limit) &&
                 (Device_Object_Instance_Number() <= (uint32_t) high_limit)) {
-            Send_I_Am(&Handler_Transmit_Buffer[0]);
+            Send_I_Am(&context->tx_buffer[0]);
         }
     }
 
@@ -77,13 +76,12 @@ void handler_who_is(
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source that the
- *                 response will be sent back to.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_is_unicast(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     int32_t low_limit = 0;
@@ -94,12 +92,12 @@ void handler_who_is_unicast(
         &high_limit);
     /* If no limits, then always respond */
     if (len == 0) {
-        Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
+        Send_I_Am_Unicast(&context->tx_buffer[0], context->src);
     } else if (len != BACNET_STATUS_ERROR) {
         /* is my device id within the limits? */
         if ((Device_Object_Instance_Number() >= (uint32_t) low_limit) &&
                 (Device_Object_Instance_Number() <= (uint32_t) high_limit)) {
-            Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
+            Send_I_Am_Unicast(&context->tx_buffer[0], context->src);
         }
     }
 
@@ -118,14 +116,14 @@ void handler_who_is_unicast(
  *
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] Source address of the message and the reply buffers
  * @param is_unicast [in] True if should send unicast response(s)
  * 			back to the src, else False if should broadcast response(s).
  */
 static void check_who_is_for_routing(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     bool is_unicast)
 {
     int len = 0;
@@ -153,9 +151,9 @@ static void check_who_is_for_routing(
         if ((len == 0) || ((dev_instance >= low_limit) &&
                 (dev_instance <= high_limit))) {
             if (is_unicast)
-                Send_I_Am_Unicast(&Handler_Transmit_Buffer[0], src);
+                Send_I_Am_Unicast(&context->tx_buffer[0], context->src);
             else
-                Send_I_Am(&Handler_Transmit_Buffer[0]);
+                Send_I_Am(&context->tx_buffer[0]);
         }
     }
 
@@ -171,14 +169,14 @@ static void check_who_is_for_routing(
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source (ignored).
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_is_bcast_for_routing(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
-    check_who_is_for_routing(service_request, service_len, src, false);
+    check_who_is_for_routing(service_request, service_len, context, false);
 }
 
 
@@ -190,14 +188,13 @@ void handler_who_is_bcast_for_routing(
  * @ingroup DMDDB
  * @param service_request [in] The received message to be handled.
  * @param service_len [in] Length of the service_request message.
- * @param src [in] The BACNET_ADDRESS of the message's source that the
- *                 response will be sent back to.
+ * @param context [in] Source address of the message and the reply buffers
  */
 void handler_who_is_unicast_for_routing(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
-    check_who_is_for_routing(service_request, service_len, src, true);
+    check_who_is_for_routing(service_request, service_len, context, true);
 }
 #endif /* BAC_ROUTING */
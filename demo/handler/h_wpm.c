@@ -58,14 +58,14 @@
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
- * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param context [in] Source address of the message and the reply buffers
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
  */
 void handler_write_property_multiple(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -161,14 +161,14 @@ void handler_write_property_multiple(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     npdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     apdu_len = 0;
     /* handle any errors */
     if (error) {
         if (len == BACNET_STATUS_ABORT) {
             apdu_len =
-                abort_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                abort_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 abort_convert_error_code(wp_data.error_code), true);
 #if PRINT_ENABLED
@@ -176,14 +176,14 @@ void handler_write_property_multiple(
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len =
-                wpm_error_ack_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                wpm_error_ack_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id, &wp_data);
 #if PRINT_ENABLED
             fprintf(stderr, "WPM: Sending Error!\n");
 #endif
         } else if (len == BACNET_STATUS_REJECT) {
             apdu_len =
-                reject_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
+                reject_encode_apdu(&context->tx_buffer[npdu_len],
                 service_data->invoke_id,
                 reject_convert_error_code(wp_data.error_code));
 #if PRINT_ENABLED
@@ -192,7 +192,7 @@ void handler_write_property_multiple(
         }
     } else {
         apdu_len =
-            wpm_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
+            wpm_ack_encode_apdu_init(&context->tx_buffer[npdu_len],
             service_data->invoke_id);
 #if PRINT_ENABLED
         fprintf(stderr, "WPM: Sending Ack!\n");
@@ -201,7 +201,7 @@ void handler_write_property_multiple(
 
     pdu_len = npdu_len + apdu_len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -70,7 +70,7 @@ uint8_t Send_Atomic_Read_File_Stream(
     status = address_get_by_device(device_id, &max_apdu, &dest);
     /* is there a tsm available? */
     if (status)
-        invoke_id = tsm_next_free_invokeID();
+        invoke_id = tsm_next_free_peer_invokeID(&dest);
     if (invoke_id) {
         /* load the data for the encoding */
         data.object_type = OBJECT_FILE;
@@ -106,7 +106,7 @@ uint8_t Send_Atomic_Read_File_Stream(
                     strerror(errno));
 #endif
         } else {
-            tsm_free_invoke_id(invoke_id);
+            tsm_free_peer_invoke_id(&dest, invoke_id);
             invoke_id = 0;
 #if PRINT_ENABLED
             fprintf(stderr,
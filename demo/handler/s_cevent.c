@@ -39,42 +39,38 @@
 
 /** @file s_cevent.c  Send a ConfirmedEventNotification Request. */
 
-/** Sends an Confirmed Alarm/Event Notification.
+/** Sends an Confirmed Alarm/Event Notification to an address.
  * @ingroup EVNOTFCN
  *
- * @param device_id [in] ID of the destination device
+ * @param dest [in] BACnet address of the destination device
+ * @param max_apdu [in] Maximum APDU accepted by the destination device
  * @param data [in] The information about the Event to be sent.
  * @return invoke id of outgoing message, or 0 if communication is disabled,
  *         or no tsm slot is available.
  */
-uint8_t Send_CEvent_Notify(
-    uint32_t device_id,
+uint8_t Send_CEvent_Notify_Address(
+    BACNET_ADDRESS * dest,
+    unsigned max_apdu,
     BACNET_EVENT_NOTIFICATION_DATA * data)
 {
     int len = 0;
     int pdu_len = 0;
     int bytes_sent = 0;
     BACNET_NPDU_DATA npdu_data;
-    BACNET_ADDRESS dest;
     BACNET_ADDRESS my_address;
-    unsigned max_apdu = 0;
-    bool status = false;
     uint8_t invoke_id = 0;
 
     if (!dcc_communication_enabled())
         return 0;
 
-    /* is the device bound? */
-    status = address_get_by_device(device_id, &max_apdu, &dest);
     /* is there a tsm available? */
-    if (status)
-        invoke_id = tsm_next_free_invokeID();
+    invoke_id = tsm_next_free_peer_invokeID(dest);
     if (invoke_id) {
         /* encode the NPDU portion of the packet */
         datalink_get_my_address(&my_address);
         npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
         pdu_len =
-            npdu_encode_pdu(&Handler_Transmit_Buffer[0], &dest, &my_address,
+            npdu_encode_pdu(&Handler_Transmit_Buffer[0], dest, &my_address,
             &npdu_data);
         /* encode the APDU portion of the packet */
         len =
@@ -87,10 +83,10 @@ uint8_t Send_CEvent_Notify(
            we have a way to check for that and update the
            max_apdu in the address binding table. */
         if ((unsigned) pdu_len < max_apdu) {
-            tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest,
+            tsm_set_confirmed_unsegmented_transaction(invoke_id, dest,
                 &npdu_data, &Handler_Transmit_Buffer[0], (uint16_t) pdu_len);
             bytes_sent =
-                datalink_send_pdu(&dest, &npdu_data,
+                datalink_send_pdu(dest, &npdu_data,
                 &Handler_Transmit_Buffer[0], pdu_len);
 #if PRINT_ENABLED
             if (bytes_sent <= 0) {
@@ -100,7 +96,7 @@ uint8_t Send_CEvent_Notify(
             }
 #endif
         } else {
-            tsm_free_invoke_id(invoke_id);
+            tsm_free_peer_invoke_id(dest, invoke_id);
             invoke_id = 0;
 #if PRINT_ENABLED
             fprintf(stderr,
@@ -112,3 +108,27 @@ uint8_t Send_CEvent_Notify(
 
     return invoke_id;
 }
+
+/** Sends an Confirmed Alarm/Event Notification.
+ * @ingroup EVNOTFCN
+ *
+ * @param device_id [in] ID of the destination device
+ * @param data [in] The information about the Event to be sent.
+ * @return invoke id of outgoing message, or 0 if communication is disabled,
+ *         or no tsm slot is available.
+ */
+uint8_t Send_CEvent_Notify(
+    uint32_t device_id,
+    BACNET_EVENT_NOTIFICATION_DATA * data)
+{
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    uint8_t invoke_id = 0;
+
+    /* is the device bound? */
+    if (address_get_by_device(device_id, &max_apdu, &dest)) {
+        invoke_id = Send_CEvent_Notify_Address(&dest, max_apdu, data);
+    }
+
+    return invoke_id;
+}
@@ -69,7 +69,7 @@ uint8_t Send_Get_Event_Information_Address(
 #endif
 
     /* is there a tsm available? */
-    invoke_id = tsm_next_free_invokeID();
+    invoke_id = tsm_next_free_peer_invokeID(dest);
     if (invoke_id) {
         datalink_get_my_address(&my_address);
         /* encode the NPDU portion of the packet */
@@ -96,7 +96,7 @@ uint8_t Send_Get_Event_Information_Address(
                     strerror(errno));
 #endif
         } else {
-            tsm_free_invoke_id(invoke_id);
+            tsm_free_peer_invoke_id(dest, invoke_id);
             invoke_id = 0;
 #if PRINT_ENABLED
             fprintf(stderr,
@@ -45,15 +45,18 @@
 
 /** @file s_ihave.c  Send an I-Have (property) message. */
 
-/** Broadcast an I Have message.
+/** Broadcast an I Have message, encoded in the given buffer.
  * @ingroup DMDOB
  *
+ * @param buffer [in] The buffer to use for building and sending the message,
+ *                    which holds at least MAX_PDU octets.
  * @param device_id [in] My device ID.
  * @param object_type [in] The BACNET_OBJECT_TYPE that I Have.
  * @param object_instance [in] The Object ID that I Have.
  * @param object_name [in] The Name of the Object I Have.
  */
-void Send_I_Have(
+void Send_I_Have_Buffer(
+    uint8_t * buffer,
     uint32_t device_id,
     BACNET_OBJECT_TYPE object_type,
     uint32_t object_instance,
@@ -76,7 +79,7 @@ void Send_I_Have(
     /* encode the NPDU portion of the packet */
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], &dest, &my_address,
+        npdu_encode_pdu(&buffer[0], &dest, &my_address,
         &npdu_data);
 
     /* encode the APDU portion of the packet */
@@ -85,11 +88,11 @@ void Send_I_Have(
     data.object_id.type = object_type;
     data.object_id.instance = object_instance;
     characterstring_copy(&data.object_name, object_name);
-    len = ihave_encode_apdu(&Handler_Transmit_Buffer[pdu_len], &data);
+    len = ihave_encode_apdu(&buffer[pdu_len], &data);
     pdu_len += len;
     /* send the data */
     bytes_sent =
-        datalink_send_pdu(&dest, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(&dest, &npdu_data, &buffer[0],
         pdu_len);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
@@ -98,3 +101,21 @@ void Send_I_Have(
 #endif
     }
 }
+
+/** Broadcast an I Have message.
+ * @ingroup DMDOB
+ *
+ * @param device_id [in] My device ID.
+ * @param object_type [in] The BACNET_OBJECT_TYPE that I Have.
+ * @param object_instance [in] The Object ID that I Have.
+ * @param object_name [in] The Name of the Object I Have.
+ */
+void Send_I_Have(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_CHARACTER_STRING * object_name)
+{
+    Send_I_Have_Buffer(&Handler_Transmit_Buffer[0], device_id, object_type,
+        object_instance, object_name);
+}
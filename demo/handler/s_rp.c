@@ -82,7 +82,7 @@ uint8_t Send_Read_Property_Request_Address(
         return 0;
     }
     /* is there a tsm available? */
-    invoke_id = tsm_next_free_invokeID();
+    invoke_id = tsm_next_free_peer_invokeID(dest);
     if (invoke_id) {
         /* encode the NPDU portion of the packet */
         datalink_get_my_address(&my_address);
@@ -117,7 +117,7 @@ uint8_t Send_Read_Property_Request_Address(
 #endif
             }
         } else {
-            tsm_free_invoke_id(invoke_id);
+            tsm_free_peer_invoke_id(dest, invoke_id);
             invoke_id = 0;
 #if PRINT_ENABLED
             fprintf(stderr,
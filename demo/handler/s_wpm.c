@@ -81,7 +81,7 @@ uint8_t Send_Write_Property_Multiple_Request(
     status = address_get_by_device(device_id, &max_apdu, &dest);
     /* is there a tsm available? */
     if (status) {
-        invoke_id = tsm_next_free_invokeID();
+        invoke_id = tsm_next_free_peer_invokeID(&dest);
     }
     if (invoke_id) {
         /* encode the NPDU portion of the packet */
@@ -113,7 +113,7 @@ uint8_t Send_Write_Property_Multiple_Request(
             }
 #endif
         } else {
-            tsm_free_invoke_id(invoke_id);
+            tsm_free_peer_invoke_id(&dest, invoke_id);
             invoke_id = 0;
 #if PRINT_ENABLED
             fprintf(stderr,
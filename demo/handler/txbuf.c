@@ -26,7 +26,37 @@
 #include <stdint.h>
 #include "config.h"
 #include "datalink.h"
+#include "txbuf.h"
+#include "handlers.h"
 
 /** @file txbuf.c  Declare the global Transmit Buffer for handler functions. */
 
-uint8_t Handler_Transmit_Buffer[MAX_PDU] = { 0 };
+BACNET_THREAD_LOCAL uint8_t Handler_Transmit_Buffer[MAX_PDU_SEGMENTED] = { 0 };
+#if MAX_HANDLER_SCRATCH
+BACNET_THREAD_LOCAL uint8_t Handler_Scratch_Buffer[MAX_HANDLER_SCRATCH] =
+    { 0 };
+#endif
+
+/** Sets up a request context to reply from the transmit and scratch
+ * buffers of the calling thread.  A caller that processes more than one
+ * request at a time in a thread gives each its own buffers instead.
+ * @ingroup MISCHNDLR
+ *
+ * @param context [out] The request context to set up.
+ * @param src [in] The BACNET_ADDRESS of the source of the request.
+ */
+void handler_context_init(
+    BACNET_REQUEST_CONTEXT * context,
+    BACNET_ADDRESS * src)
+{
+    context->src = src;
+    context->tx_buffer = &Handler_Transmit_Buffer[0];
+    context->tx_buffer_size = sizeof(Handler_Transmit_Buffer);
+#if MAX_HANDLER_SCRATCH
+    context->scratch = &Handler_Scratch_Buffer[0];
+    context->scratch_size = sizeof(Handler_Scratch_Buffer);
+#else
+    context->scratch = NULL;
+    context->scratch_size = 0;
+#endif
+}
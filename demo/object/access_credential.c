@@ -155,7 +155,7 @@ bool Access_Credential_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
 
     if (object_instance < MAX_ACCESS_CREDENTIALS) {
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "bacdef.h"
 #include "bacdcode.h"
@@ -37,17 +38,33 @@
 #include "config.h"     /* the custom stuff */
 #include "device.h"
 #include "handlers.h"
+#include "objstore.h"
 #include "proplist.h"
 #include "timestamp.h"
 #include "ai.h"
 
-
+/* number of demo objects created by Analog_Input_Init() */
 #ifndef MAX_ANALOG_INPUTS
 #define MAX_ANALOG_INPUTS 4
 #endif
 
+#if defined(INTRINSIC_REPORTING)
+/* takes a deleted object out of the event index */
+static void Analog_Input_Free(
+    uint32_t object_instance,
+    void *data)
+{
+    (void) data;
+    handler_event_index_update(OBJECT_ANALOG_INPUT, object_instance, false);
+}
+#define ANALOG_INPUT_FREE Analog_Input_Free
+#else
+#define ANALOG_INPUT_FREE NULL
+#endif
 
-ANALOG_INPUT_DESCR AI_Descr[MAX_ANALOG_INPUTS];
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(ANALOG_INPUT_DESCR), ANALOG_INPUT_FREE);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Properties_Required[] = {
@@ -104,123 +121,220 @@ void Analog_Input_Property_Lists(
 }
 
 
-void Analog_Input_Init(
+/**
+ * Determines if a given Analog Input instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool Analog_Input_Valid_Instance(
+    uint32_t object_instance)
+{
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
+
+/**
+ * Determines the number of Analog Input objects
+ *
+ * @return  Number of Analog Input objects
+ */
+unsigned Analog_Input_Count(
     void)
 {
-    unsigned i;
+    return Object_Store_Count(&Objects);
+}
+
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Analog Input objects where N is Analog_Input_Count().
+ *
+ * @param  index - 0..N where N is Analog_Input_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t Analog_Input_Index_To_Instance(
+    unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
+}
+
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Analog Input objects where N is Analog_Input_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Analog_Input_Count()
+ * if not valid.
+ */
+unsigned Analog_Input_Instance_To_Index(
+    uint32_t object_instance)
+{
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
+}
+
+/**
+ * Creates a Analog Input object with default values
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Analog_Input_Create(
+    uint32_t object_instance)
+{
+    ANALOG_INPUT_DESCR *pObject;
 #if defined(INTRINSIC_REPORTING)
     unsigned j;
 #endif
 
-    for (i = 0; i < MAX_ANALOG_INPUTS; i++) {
-        AI_Descr[i].Present_Value = 0.0f;
-        AI_Descr[i].Out_Of_Service = false;
-        AI_Descr[i].Units = UNITS_PERCENT;
-        AI_Descr[i].Reliability = RELIABILITY_NO_FAULT_DETECTED;
-        AI_Descr[i].Prior_Value = 0.0f;
-        AI_Descr[i].COV_Increment = 1.0f;
-        AI_Descr[i].Changed = false;
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
+        return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    pObject->Present_Value = 0.0f;
+    pObject->Out_Of_Service = false;
+    pObject->Units = UNITS_PERCENT;
+    pObject->Reliability = RELIABILITY_NO_FAULT_DETECTED;
+    pObject->Prior_Value = 0.0f;
+    pObject->COV_Increment = 1.0f;
+    pObject->Changed = false;
 #if defined(INTRINSIC_REPORTING)
-        AI_Descr[i].Event_State = EVENT_STATE_NORMAL;
-        /* notification class not connected */
-        AI_Descr[i].Notification_Class = BACNET_MAX_INSTANCE;
-        /* initialize Event time stamps using wildcards
-           and set Acked_transitions */
-        for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
-            datetime_wildcard_set(&AI_Descr[i].Event_Time_Stamps[j]);
-            AI_Descr[i].Acked_Transitions[j].bIsAcked = true;
-        }
-
-        /* Set handler for GetEventInformation function */
-        handler_get_event_information_set(OBJECT_ANALOG_INPUT,
-            Analog_Input_Event_Information);
-        /* Set handler for AcknowledgeAlarm function */
-        handler_alarm_ack_set(OBJECT_ANALOG_INPUT, Analog_Input_Alarm_Ack);
-        /* Set handler for GetAlarmSummary Service */
-        handler_get_alarm_summary_set(OBJECT_ANALOG_INPUT,
-            Analog_Input_Alarm_Summary);
+    pObject->Event_State = EVENT_STATE_NORMAL;
+    /* notification class not connected */
+    pObject->Notification_Class = BACNET_MAX_INSTANCE;
+    /* initialize Event time stamps using wildcards
+       and set Acked_transitions */
+    for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
+        datetime_wildcard_set(&pObject->Event_Time_Stamps[j]);
+        pObject->Acked_Transitions[j].bIsAcked = true;
+    }
 #endif
+
+    Device_Object_Name_Index_Update(OBJECT_ANALOG_INPUT, object_instance);
+
+    return true;
+}
+
+#if defined(INTRINSIC_REPORTING)
+/* keeps the object in the event index while it has an active event
+   or unacknowledged transitions */
+static void Analog_Input_Event_Index_Update(
+    uint32_t object_instance,
+    ANALOG_INPUT_DESCR * pObject)
+{
+    bool active = false;
+    unsigned j;
+
+    active = (pObject->Event_State != EVENT_STATE_NORMAL);
+    for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
+        if (!pObject->Acked_Transitions[j].bIsAcked) {
+            active = true;
+        }
     }
+    handler_event_index_update(OBJECT_ANALOG_INPUT, object_instance, active);
 }
+#endif
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
-bool Analog_Input_Valid_Instance(
+/**
+ * Deletes a Analog Input object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Analog_Input_Delete(
     uint32_t object_instance)
 {
-    unsigned int index;
+    bool status = false;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS)
-        return true;
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_ANALOG_INPUT, object_instance);
+    }
 
-    return false;
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned Analog_Input_Count(
+/**
+ * Deletes all the Analog Input objects and their data
+ */
+void Analog_Input_Cleanup(
     void)
 {
-    return MAX_ANALOG_INPUTS;
+    Object_Store_Cleanup(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t Analog_Input_Index_To_Instance(
-    unsigned index)
-{
-    return index;
-}
-
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned Analog_Input_Instance_To_Index(
-    uint32_t object_instance)
+/**
+ * Initializes the Analog Input objects
+ */
+void Analog_Input_Init(
+    void)
 {
-    unsigned index = MAX_ANALOG_INPUTS;
+    unsigned i;
 
-    if (object_instance < MAX_ANALOG_INPUTS)
-        index = object_instance;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_ANALOG_INPUTS; i++) {
+            Analog_Input_Create(i);
+        }
+#if defined(INTRINSIC_REPORTING)
+        /* Set handler for GetEventInformation function */
+        handler_get_event_information_set(OBJECT_ANALOG_INPUT,
+            Analog_Input_Event_Information);
+        /* Set handler for AcknowledgeAlarm function */
+        handler_alarm_ack_set(OBJECT_ANALOG_INPUT, Analog_Input_Alarm_Ack);
+        /* Set handler for GetAlarmSummary Service */
+        handler_get_alarm_summary_set(OBJECT_ANALOG_INPUT,
+            Analog_Input_Alarm_Summary);
+        /* Objects keep the event index up to date */
+        handler_event_index_set(OBJECT_ANALOG_INPUT,
+            Analog_Input_Instance_To_Index);
+#endif
+    }
 
-    return index;
+    return;
 }
 
+
 float Analog_Input_Present_Value(
     uint32_t object_instance)
 {
     float value = 0.0;
-    unsigned int index;
+    ANALOG_INPUT_DESCR *pObject;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        value = AI_Descr[index].Present_Value;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Present_Value;
     }
 
     return value;
 }
 
-static void Analog_Input_COV_Detect(unsigned int index,
+static void Analog_Input_COV_Detect(uint32_t object_instance,
+    ANALOG_INPUT_DESCR *pObject,
     float value)
 {
     float prior_value = 0.0;
     float cov_increment = 0.0;
     float cov_delta = 0.0;
 
-    if (index < MAX_ANALOG_INPUTS) {
-        prior_value = AI_Descr[index].Prior_Value;
-        cov_increment = AI_Descr[index].COV_Increment;
+    if (pObject) {
+        prior_value = pObject->Prior_Value;
+        cov_increment = pObject->COV_Increment;
         if (prior_value > value) {
             cov_delta = prior_value - value;
         } else {
             cov_delta = value - prior_value;
         }
         if (cov_delta >= cov_increment) {
-            AI_Descr[index].Changed = true;
-            AI_Descr[index].Prior_Value = value;
+            pObject->Changed = true;
+            pObject->Prior_Value = value;
+            handler_cov_object_changed(OBJECT_ANALOG_INPUT, object_instance);
         }
     }
 }
@@ -229,12 +343,18 @@ void Analog_Input_Present_Value_Set(
     uint32_t object_instance,
     float value)
 {
-    unsigned int index = 0;
+    ANALOG_INPUT_DESCR *pObject;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        Analog_Input_COV_Detect(index, value);
-        AI_Descr[index].Present_Value = value;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        Analog_Input_COV_Detect(object_instance, pObject, value);
+#if defined(INTRINSIC_REPORTING)
+        if (pObject->Present_Value != value) {
+            Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_INPUT,
+                object_instance);
+        }
+#endif
+        pObject->Present_Value = value;
     }
 }
 
@@ -242,13 +362,14 @@ bool Analog_Input_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
-    unsigned int index;
+    char text_string[32] = "";
+    ANALOG_INPUT_DESCR *pObject;
     bool status = false;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        sprintf(text_string, "ANALOG INPUT %lu", (unsigned long) index);
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        sprintf(text_string, "ANALOG INPUT %lu",
+            (unsigned long) object_instance);
         status = characterstring_init_ansi(object_name, text_string);
     }
 
@@ -258,12 +379,12 @@ bool Analog_Input_Object_Name(
 bool Analog_Input_Change_Of_Value(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
     bool changed = false;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        changed = AI_Descr[index].Changed;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        changed = pObject->Changed;
     }
 
     return changed;
@@ -272,11 +393,11 @@ bool Analog_Input_Change_Of_Value(
 void Analog_Input_Change_Of_Value_Clear(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        AI_Descr[index].Changed = false;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->Changed = false;
     }
 }
 
@@ -336,12 +457,12 @@ bool Analog_Input_Encode_Value_List(
 float Analog_Input_COV_Increment(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
     float value = 0;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        value = AI_Descr[index].COV_Increment;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->COV_Increment;
     }
 
     return value;
@@ -351,24 +472,24 @@ void Analog_Input_COV_Increment_Set(
     uint32_t object_instance,
     float value)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        AI_Descr[index].COV_Increment = value;
-        Analog_Input_COV_Detect(index, AI_Descr[index].Present_Value);
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->COV_Increment = value;
+        Analog_Input_COV_Detect(object_instance, pObject, pObject->Present_Value);
     }
 }
 
 bool Analog_Input_Out_Of_Service(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
     bool value = false;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
-        value = AI_Descr[index].Out_Of_Service;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Out_Of_Service;
     }
 
     return value;
@@ -378,10 +499,10 @@ void Analog_Input_Out_Of_Service_Set(
     uint32_t object_instance,
     bool value)
 {
-    unsigned index = 0;
+    ANALOG_INPUT_DESCR *pObject;
 
-    index = Analog_Input_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_INPUTS) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
 		/* 	BACnet Testing Observed Incident oi00104
 			The Changed flag was not being set when a client wrote to the Out-of-Service bit.
 			Revealed by BACnet Test Client v1.8.16 ( www.bac-test.com/bacnet-test-client-download )
@@ -390,10 +511,11 @@ void Analog_Input_Out_Of_Service_Set(
     		Any discussions can be directed to edward@bac-test.com
     		Please feel free to remove this comment when my changes accepted after suitable time for
     		review by all interested parties. Say 6 months -> September 2016 */
-        if (AI_Descr[index].Out_Of_Service != value) {
-            AI_Descr[index].Changed = true;
+        if (pObject->Out_Of_Service != value) {
+            pObject->Changed = true;
+            handler_cov_object_changed(OBJECT_ANALOG_INPUT, object_instance);
         }
-        AI_Descr[index].Out_Of_Service = value;
+        pObject->Out_Of_Service = value;
     }
 }
 
@@ -406,7 +528,6 @@ int Analog_Input_Read_Property(
     BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     ANALOG_INPUT_DESCR *CurrentAI;
-    unsigned object_index = 0;
 #if defined(INTRINSIC_REPORTING)
     unsigned i = 0;
     int len = 0;
@@ -418,11 +539,12 @@ int Analog_Input_Read_Property(
         return 0;
     }
 
-    object_index = Analog_Input_Instance_To_Index(rpdata->object_instance);
-    if (object_index < MAX_ANALOG_INPUTS)
-        CurrentAI = &AI_Descr[object_index];
-    else
+    CurrentAI = Object_Store_Data(&Objects, rpdata->object_instance);
+    if (!CurrentAI) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return BACNET_STATUS_ERROR;
+    }
 
     apdu = rpdata->application_data;
     switch ((int) rpdata->object_property) {
@@ -655,7 +777,6 @@ bool Analog_Input_Write_Property(
     BACNET_WRITE_PROPERTY_DATA * wp_data)
 {
     bool status = false;        /* return value */
-    unsigned int object_index = 0;
     int len = 0;
     BACNET_APPLICATION_DATA_VALUE value;
     ANALOG_INPUT_DESCR *CurrentAI;
@@ -678,10 +799,10 @@ bool Analog_Input_Write_Property(
         wp_data->error_code = ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY;
         return false;
     }
-    object_index = Analog_Input_Instance_To_Index(wp_data->object_instance);
-    if (object_index < MAX_ANALOG_INPUTS) {
-        CurrentAI = &AI_Descr[object_index];
-    } else {
+    CurrentAI = Object_Store_Data(&Objects, wp_data->object_instance);
+    if (!CurrentAI) {
+        wp_data->error_class = ERROR_CLASS_OBJECT;
+        wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return false;
     }
 
@@ -749,6 +870,8 @@ bool Analog_Input_Write_Property(
             if (status) {
                 CurrentAI->Time_Delay = value.type.Unsigned_Int;
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_INPUT,
+                    wp_data->object_instance);
             }
             break;
 
@@ -869,6 +992,14 @@ bool Analog_Input_Write_Property(
             break;
     }
 
+#if defined(INTRINSIC_REPORTING)
+    if (status) {
+        /* the value, limits and enables all feed the event algorithm */
+        Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_INPUT,
+            wp_data->object_instance);
+    }
+#endif
+
     return status;
 }
 
@@ -880,7 +1011,6 @@ void Analog_Input_Intrinsic_Reporting(
     BACNET_EVENT_NOTIFICATION_DATA event_data;
     BACNET_CHARACTER_STRING msgText;
     ANALOG_INPUT_DESCR *CurrentAI;
-    unsigned int object_index;
     uint8_t FromState = 0;
     uint8_t ToState;
     float ExceededLimit = 0.0f;
@@ -888,10 +1018,8 @@ void Analog_Input_Intrinsic_Reporting(
     bool SendNotify = false;
 
 
-    object_index = Analog_Input_Instance_To_Index(object_instance);
-    if (object_index < MAX_ANALOG_INPUTS)
-        CurrentAI = &AI_Descr[object_index];
-    else
+    CurrentAI = Object_Store_Data(&Objects, object_instance);
+    if (!CurrentAI)
         return;
 
     /* check limits */
@@ -933,10 +1061,10 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_INPUT,
+                            object_instance,
+                            &CurrentAI->Remaining_Time_Delay))
                         CurrentAI->Event_State = EVENT_STATE_HIGH_LIMIT;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
 
@@ -950,14 +1078,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_INPUT,
+                            object_instance,
+                            &CurrentAI->Remaining_Time_Delay))
                         CurrentAI->Event_State = EVENT_STATE_LOW_LIMIT;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_INPUT,
+                    object_instance);
                 break;
 
             case EVENT_STATE_HIGH_LIMIT:
@@ -972,14 +1102,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_INPUT,
+                            object_instance,
+                            &CurrentAI->Remaining_Time_Delay))
                         CurrentAI->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_INPUT,
+                    object_instance);
                 break;
 
             case EVENT_STATE_LOW_LIMIT:
@@ -995,14 +1127,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_INPUT,
+                            object_instance,
+                            &CurrentAI->Remaining_Time_Delay))
                         CurrentAI->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_INPUT,
+                    object_instance);
                 break;
 
             default:
@@ -1015,6 +1149,8 @@ void Analog_Input_Intrinsic_Reporting(
             /* Event_State has changed.
                Need to fill only the basic parameters of this type of event.
                Other parameters will be filled in common function. */
+            /* the next transition has a time delay of its own */
+            CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
 
             switch (ToState) {
                 case EVENT_STATE_HIGH_LIMIT:
@@ -1166,6 +1302,7 @@ void Analog_Input_Intrinsic_Reporting(
                     break;
             }
         }
+        Analog_Input_Event_Index_Update(object_instance, CurrentAI);
     }
 #endif /* defined(INTRINSIC_REPORTING) */
 }
@@ -1176,24 +1313,26 @@ int Analog_Input_Event_Information(
     unsigned index,
     BACNET_GET_EVENT_INFORMATION_DATA * getevent_data)
 {
+    ANALOG_INPUT_DESCR *pObject;
     bool IsNotAckedTransitions;
     bool IsActiveEvent;
     int i;
 
 
     /* check index */
-    if (index < MAX_ANALOG_INPUTS) {
+    pObject = Object_Store_Data_Index(&Objects, index);
+    if (pObject) {
         /* Event_State not equal to NORMAL */
-        IsActiveEvent = (AI_Descr[index].Event_State != EVENT_STATE_NORMAL);
+        IsActiveEvent = (pObject->Event_State != EVENT_STATE_NORMAL);
 
         /* Acked_Transitions property, which has at least one of the bits
            (TO-OFFNORMAL, TO-FAULT, TONORMAL) set to FALSE. */
         IsNotAckedTransitions =
-            (AI_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+            (pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
             bIsAcked ==
-            false) | (AI_Descr[index].Acked_Transitions[TRANSITION_TO_FAULT].
+            false) | (pObject->Acked_Transitions[TRANSITION_TO_FAULT].
             bIsAcked ==
-            false) | (AI_Descr[index].Acked_Transitions[TRANSITION_TO_NORMAL].
+            false) | (pObject->Acked_Transitions[TRANSITION_TO_NORMAL].
             bIsAcked == false);
     } else
         return -1;      /* end of list  */
@@ -1204,40 +1343,40 @@ int Analog_Input_Event_Information(
         getevent_data->objectIdentifier.instance =
             Analog_Input_Index_To_Instance(index);
         /* Event State */
-        getevent_data->eventState = AI_Descr[index].Event_State;
+        getevent_data->eventState = pObject->Event_State;
         /* Acknowledged Transitions */
         bitstring_init(&getevent_data->acknowledgedTransitions);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_OFFNORMAL,
-            AI_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+            pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
             bIsAcked);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_FAULT,
-            AI_Descr[index].Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
+            pObject->Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_NORMAL,
-            AI_Descr[index].Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
+            pObject->Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
         /* Event Time Stamps */
         for (i = 0; i < 3; i++) {
             getevent_data->eventTimeStamps[i].tag = TIME_STAMP_DATETIME;
             getevent_data->eventTimeStamps[i].value.dateTime =
-                AI_Descr[index].Event_Time_Stamps[i];
+                pObject->Event_Time_Stamps[i];
         }
         /* Notify Type */
-        getevent_data->notifyType = AI_Descr[index].Notify_Type;
+        getevent_data->notifyType = pObject->Notify_Type;
         /* Event Enable */
         bitstring_init(&getevent_data->eventEnable);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_OFFNORMAL,
-            (AI_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ? true : false);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_FAULT,
-            (AI_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_FAULT) ? true : false);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_NORMAL,
-            (AI_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_NORMAL) ? true : false);
         /* Event Priorities */
-        Notification_Class_Get_Priorities(AI_Descr[index].Notification_Class,
+        Notification_Class_Get_Priorities(pObject->Notification_Class,
             getevent_data->eventPriorities);
 
         return 1;       /* active event */
@@ -1251,16 +1390,11 @@ int Analog_Input_Alarm_Ack(
     BACNET_ERROR_CODE * error_code)
 {
     ANALOG_INPUT_DESCR *CurrentAI;
-    unsigned int object_index;
-
 
-    object_index =
-        Analog_Input_Instance_To_Index(alarmack_data->eventObjectIdentifier.
-        instance);
-
-    if (object_index < MAX_ANALOG_INPUTS)
-        CurrentAI = &AI_Descr[object_index];
-    else {
+    CurrentAI =
+        Object_Store_Data(&Objects,
+        alarmack_data->eventObjectIdentifier.instance);
+    if (!CurrentAI) {
         *error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return -1;
     }
@@ -1342,6 +1476,10 @@ int Analog_Input_Alarm_Ack(
     }
     CurrentAI->Ack_notify_data.bSendAckNotify = true;
     CurrentAI->Ack_notify_data.EventState = alarmack_data->eventStateAcked;
+    Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_INPUT,
+        alarmack_data->eventObjectIdentifier.instance);
+    Analog_Input_Event_Index_Update(
+        alarmack_data->eventObjectIdentifier.instance, CurrentAI);
 
     return 1;
 }
@@ -1350,32 +1488,34 @@ int Analog_Input_Alarm_Summary(
     unsigned index,
     BACNET_GET_ALARM_SUMMARY_DATA * getalarm_data)
 {
+    ANALOG_INPUT_DESCR *pObject;
 
     /* check index */
-    if (index < MAX_ANALOG_INPUTS) {
+    pObject = Object_Store_Data_Index(&Objects, index);
+    if (pObject) {
         /* Event_State is not equal to NORMAL  and
            Notify_Type property value is ALARM */
-        if ((AI_Descr[index].Event_State != EVENT_STATE_NORMAL) &&
-            (AI_Descr[index].Notify_Type == NOTIFY_ALARM)) {
+        if ((pObject->Event_State != EVENT_STATE_NORMAL) &&
+            (pObject->Notify_Type == NOTIFY_ALARM)) {
             /* Object Identifier */
             getalarm_data->objectIdentifier.type = OBJECT_ANALOG_INPUT;
             getalarm_data->objectIdentifier.instance =
                 Analog_Input_Index_To_Instance(index);
             /* Alarm State */
-            getalarm_data->alarmState = AI_Descr[index].Event_State;
+            getalarm_data->alarmState = pObject->Event_State;
             /* Acknowledged Transitions */
             bitstring_init(&getalarm_data->acknowledgedTransitions);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_OFFNORMAL,
-                AI_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+                pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
                 bIsAcked);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_FAULT,
-                AI_Descr[index].
+                pObject->
                 Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_NORMAL,
-                AI_Descr[index].
+                pObject->
                 Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
 
             return 1;   /* active alarm */
@@ -1392,6 +1532,14 @@ int Analog_Input_Alarm_Summary(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -1414,6 +1562,14 @@ bool WPValidateArgType(
     return (bResult);
 }
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 void testAnalogInput(
     Test * pTest)
 {
@@ -1424,6 +1580,7 @@ void testAnalogInput(
     uint32_t decoded_instance = 0;
     uint16_t decoded_type = 0;
     BACNET_READ_PROPERTY_DATA rpdata;
+    uint32_t i = 0;
 
     Analog_Input_Init();
     rpdata.application_data = &apdu[0];
@@ -1439,6 +1596,24 @@ void testAnalogInput(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* many sparse instances */
+    for (i = 0; i < 100000; i++) {
+        if (!Analog_Input_Create(1000 + (i * 41))) {
+            break;
+        }
+    }
+    ct_test(pTest, i == 100000);
+    ct_test(pTest, Analog_Input_Count() == (MAX_ANALOG_INPUTS + 100000));
+    ct_test(pTest, Analog_Input_Valid_Instance(1000 + (99999 * 41)));
+    ct_test(pTest, !Analog_Input_Valid_Instance(1001));
+    ct_test(pTest,
+        Analog_Input_Index_To_Instance(MAX_ANALOG_INPUTS + 1) == 1041);
+    Analog_Input_Present_Value_Set(1041, 42.0f);
+    ct_test(pTest, Analog_Input_Present_Value(1041) == 42.0f);
+    ct_test(pTest, Analog_Input_Delete(1041));
+    ct_test(pTest, Analog_Input_Count() == (MAX_ANALOG_INPUTS + 99999));
+    Analog_Input_Cleanup();
+    ct_test(pTest, Analog_Input_Count() == 0);
 
     return;
 }
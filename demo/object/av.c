@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "bacdef.h"
@@ -39,14 +40,31 @@
 #include "config.h"     /* the custom stuff */
 #include "device.h"
 #include "handlers.h"
+#include "objstore.h"
 #include "av.h"
 
-
+/* number of demo objects created by Analog_Value_Init() */
 #ifndef MAX_ANALOG_VALUES
 #define MAX_ANALOG_VALUES 4
 #endif
 
-ANALOG_VALUE_DESCR AV_Descr[MAX_ANALOG_VALUES];
+#if defined(INTRINSIC_REPORTING)
+/* takes a deleted object out of the event index */
+static void Analog_Value_Free(
+    uint32_t object_instance,
+    void *data)
+{
+    (void) data;
+    handler_event_index_update(OBJECT_ANALOG_VALUE, object_instance, false);
+}
+#define ANALOG_VALUE_FREE Analog_Value_Free
+#else
+#define ANALOG_VALUE_FREE NULL
+#endif
+
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(ANALOG_VALUE_DESCR), ANALOG_VALUE_FREE);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Analog_Value_Properties_Required[] = {
@@ -98,105 +116,204 @@ void Analog_Value_Property_Lists(
     return;
 }
 
-void Analog_Value_Init(
+/**
+ * Determines if a given Analog Value instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool Analog_Value_Valid_Instance(
+    uint32_t object_instance)
+{
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
+
+/**
+ * Determines the number of Analog Value objects
+ *
+ * @return  Number of Analog Value objects
+ */
+unsigned Analog_Value_Count(
     void)
 {
-	unsigned i;
+    return Object_Store_Count(&Objects);
+}
+
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Analog Value objects where N is Analog_Value_Count().
+ *
+ * @param  index - 0..N where N is Analog_Value_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t Analog_Value_Index_To_Instance(
+    unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
+}
+
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Analog Value objects where N is Analog_Value_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Analog_Value_Count()
+ * if not valid.
+ */
+unsigned Analog_Value_Instance_To_Index(
+    uint32_t object_instance)
+{
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
+}
+
+/**
+ * Creates a Analog Value object with default values
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Analog_Value_Create(
+    uint32_t object_instance)
+{
+    ANALOG_VALUE_DESCR *pObject;
 #if defined(INTRINSIC_REPORTING)
-	unsigned j;
+    unsigned j;
 #endif
 
-    for (i = 0; i < MAX_ANALOG_VALUES; i++) {
-        memset(&AV_Descr[i], 0x00, sizeof(ANALOG_VALUE_DESCR));
-        AV_Descr[i].Present_Value = 0.0;
-        AV_Descr[i].Units = UNITS_NO_UNITS;
-        AV_Descr[i].Prior_Value = 0.0f;
-        AV_Descr[i].COV_Increment = 1.0f;
-        AV_Descr[i].Changed = false;
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
+        return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    pObject->Present_Value = 0.0;
+    pObject->Units = UNITS_NO_UNITS;
+    pObject->Prior_Value = 0.0f;
+    pObject->COV_Increment = 1.0f;
+    pObject->Changed = false;
 #if defined(INTRINSIC_REPORTING)
-        AV_Descr[i].Event_State = EVENT_STATE_NORMAL;
-        /* notification class not connected */
-        AV_Descr[i].Notification_Class = BACNET_MAX_INSTANCE;
-        /* initialize Event time stamps using wildcards
-           and set Acked_transitions */
-        for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
-            datetime_wildcard_set(&AV_Descr[i].Event_Time_Stamps[j]);
-            AV_Descr[i].Acked_Transitions[j].bIsAcked = true;
-        }
-
-        /* Set handler for GetEventInformation function */
-        handler_get_event_information_set(OBJECT_ANALOG_VALUE,
-            Analog_Value_Event_Information);
-        /* Set handler for AcknowledgeAlarm function */
-        handler_alarm_ack_set(OBJECT_ANALOG_VALUE, Analog_Value_Alarm_Ack);
-        /* Set handler for GetAlarmSummary Service */
-        handler_get_alarm_summary_set(OBJECT_ANALOG_VALUE,
-            Analog_Value_Alarm_Summary);
-#endif
+    pObject->Event_State = EVENT_STATE_NORMAL;
+    /* notification class not connected */
+    pObject->Notification_Class = BACNET_MAX_INSTANCE;
+    /* initialize Event time stamps using wildcards
+       and set Acked_transitions */
+    for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
+        datetime_wildcard_set(&pObject->Event_Time_Stamps[j]);
+        pObject->Acked_Transitions[j].bIsAcked = true;
     }
+#endif
+
+    Device_Object_Name_Index_Update(OBJECT_ANALOG_VALUE, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
-bool Analog_Value_Valid_Instance(
-    uint32_t object_instance)
+#if defined(INTRINSIC_REPORTING)
+/* keeps the object in the event index while it has an active event
+   or unacknowledged transitions */
+static void Analog_Value_Event_Index_Update(
+    uint32_t object_instance,
+    ANALOG_VALUE_DESCR * pObject)
 {
-    if (object_instance < MAX_ANALOG_VALUES)
-        return true;
+    bool active = false;
+    unsigned j;
 
-    return false;
+    active = (pObject->Event_State != EVENT_STATE_NORMAL);
+    for (j = 0; j < MAX_BACNET_EVENT_TRANSITION; j++) {
+        if (!pObject->Acked_Transitions[j].bIsAcked) {
+            active = true;
+        }
+    }
+    handler_event_index_update(OBJECT_ANALOG_VALUE, object_instance, active);
 }
+#endif
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned Analog_Value_Count(
-    void)
+/**
+ * Deletes a Analog Value object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Analog_Value_Delete(
+    uint32_t object_instance)
 {
-    return MAX_ANALOG_VALUES;
+    bool status = false;
+
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_ANALOG_VALUE, object_instance);
+    }
+
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t Analog_Value_Index_To_Instance(
-    unsigned index)
+/**
+ * Deletes all the Analog Value objects and their data
+ */
+void Analog_Value_Cleanup(
+    void)
 {
-    return index;
+    Object_Store_Cleanup(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned Analog_Value_Instance_To_Index(
-    uint32_t object_instance)
+/**
+ * Initializes the Analog Value objects
+ */
+void Analog_Value_Init(
+    void)
 {
-    unsigned index = MAX_ANALOG_VALUES;
+    unsigned i;
 
-    if (object_instance < MAX_ANALOG_VALUES)
-        index = object_instance;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_ANALOG_VALUES; i++) {
+            Analog_Value_Create(i);
+        }
+#if defined(INTRINSIC_REPORTING)
+        /* Set handler for GetEventInformation function */
+        handler_get_event_information_set(OBJECT_ANALOG_VALUE,
+            Analog_Value_Event_Information);
+        /* Set handler for AcknowledgeAlarm function */
+        handler_alarm_ack_set(OBJECT_ANALOG_VALUE, Analog_Value_Alarm_Ack);
+        /* Set handler for GetAlarmSummary Service */
+        handler_get_alarm_summary_set(OBJECT_ANALOG_VALUE,
+            Analog_Value_Alarm_Summary);
+        /* Objects keep the event index up to date */
+        handler_event_index_set(OBJECT_ANALOG_VALUE,
+            Analog_Value_Instance_To_Index);
+#endif
+    }
 
-    return index;
+    return;
 }
 
-static void Analog_Value_COV_Detect(unsigned int index,
+
+static void Analog_Value_COV_Detect(uint32_t object_instance,
+    ANALOG_VALUE_DESCR *pObject,
     float value)
 {
     float prior_value = 0.0;
     float cov_increment = 0.0;
     float cov_delta = 0.0;
 
-    if (index < MAX_ANALOG_VALUES) {
-        prior_value = AV_Descr[index].Prior_Value;
-        cov_increment = AV_Descr[index].COV_Increment;
+    if (pObject) {
+        prior_value = pObject->Prior_Value;
+        cov_increment = pObject->COV_Increment;
         if (prior_value > value) {
             cov_delta = prior_value - value;
         } else {
             cov_delta = value - prior_value;
         }
         if (cov_delta >= cov_increment) {
-            AV_Descr[index].Changed = true;
-            AV_Descr[index].Prior_Value = value;
+            pObject->Changed = true;
+            pObject->Prior_Value = value;
+            handler_cov_object_changed(OBJECT_ANALOG_VALUE, object_instance);
         }
     }
 }
@@ -216,13 +333,19 @@ bool Analog_Value_Present_Value_Set(
     float value,
     uint8_t priority)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
     bool status = false;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        Analog_Value_COV_Detect(index, value);
-        AV_Descr[index].Present_Value = value;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        Analog_Value_COV_Detect(object_instance, pObject, value);
+#if defined(INTRINSIC_REPORTING)
+        if (pObject->Present_Value != value) {
+            Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_VALUE,
+                object_instance);
+        }
+#endif
+        pObject->Present_Value = value;
         status = true;
     }
     return status;
@@ -232,11 +355,11 @@ float Analog_Value_Present_Value(
     uint32_t object_instance)
 {
     float value = 0;
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        value = AV_Descr[index].Present_Value;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Present_Value;
     }
 
     return value;
@@ -247,10 +370,10 @@ bool Analog_Value_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
 
-    if (object_instance < MAX_ANALOG_VALUES) {
+    if (Analog_Value_Valid_Instance(object_instance)) {
         sprintf(text_string, "ANALOG VALUE %lu",
             (unsigned long) object_instance);
         status = characterstring_init_ansi(object_name, text_string);
@@ -269,12 +392,12 @@ bool Analog_Value_Object_Name(
  */
 bool Analog_Value_Change_Of_Value(uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
     bool changed = false;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        changed = AV_Descr[index].Changed;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        changed = pObject->Changed;
     }
 
     return changed;
@@ -287,11 +410,11 @@ bool Analog_Value_Change_Of_Value(uint32_t object_instance)
  */
 void Analog_Value_Change_Of_Value_Clear(uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        AV_Descr[index].Changed = false;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->Changed = false;
     }
 }
 
@@ -351,12 +474,12 @@ bool Analog_Value_Encode_Value_List(
 float Analog_Value_COV_Increment(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
     float value = 0;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        value = AV_Descr[index].COV_Increment;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->COV_Increment;
     }
 
     return value;
@@ -366,24 +489,24 @@ void Analog_Value_COV_Increment_Set(
     uint32_t object_instance,
     float value)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        AV_Descr[index].COV_Increment = value;
-        Analog_Value_COV_Detect(index, AV_Descr[index].Present_Value);
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->COV_Increment = value;
+        Analog_Value_COV_Detect(object_instance, pObject, pObject->Present_Value);
     }
 }
 
 bool Analog_Value_Out_Of_Service(
     uint32_t object_instance)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
     bool value = false;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        value = AV_Descr[index].Out_Of_Service;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Out_Of_Service;
     }
 
     return value;
@@ -393,14 +516,15 @@ void Analog_Value_Out_Of_Service_Set(
     uint32_t object_instance,
     bool value)
 {
-    unsigned index = 0;
+    ANALOG_VALUE_DESCR *pObject;
 
-    index = Analog_Value_Instance_To_Index(object_instance);
-    if (index < MAX_ANALOG_VALUES) {
-        if (AV_Descr[index].Out_Of_Service != value) {
-            AV_Descr[index].Changed = true;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        if (pObject->Out_Of_Service != value) {
+            pObject->Changed = true;
+            handler_cov_object_changed(OBJECT_ANALOG_VALUE, object_instance);
         }
-        AV_Descr[index].Out_Of_Service = value;
+        pObject->Out_Of_Service = value;
     }
 }
 
@@ -412,7 +536,6 @@ int Analog_Value_Read_Property(
     BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     float real_value = (float) 1.414;
-    unsigned object_index = 0;
     bool state = false;
     uint8_t *apdu = NULL;
     ANALOG_VALUE_DESCR *CurrentAV;
@@ -428,11 +551,12 @@ int Analog_Value_Read_Property(
 
     apdu = rpdata->application_data;
 
-    object_index = Analog_Value_Instance_To_Index(rpdata->object_instance);
-    if (object_index < MAX_ANALOG_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else
+    CurrentAV = Object_Store_Data(&Objects, rpdata->object_instance);
+    if (!CurrentAV) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return BACNET_STATUS_ERROR;
+    }
 
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
@@ -646,7 +770,6 @@ bool Analog_Value_Write_Property(
     BACNET_WRITE_PROPERTY_DATA * wp_data)
 {
     bool status = false;        /* return value */
-    unsigned int object_index = 0;
     int len = 0;
     BACNET_APPLICATION_DATA_VALUE value;
     ANALOG_VALUE_DESCR *CurrentAV;
@@ -670,11 +793,12 @@ bool Analog_Value_Write_Property(
         wp_data->error_code = ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY;
         return false;
     }
-    object_index = Analog_Value_Instance_To_Index(wp_data->object_instance);
-    if (object_index < MAX_ANALOG_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else
+    CurrentAV = Object_Store_Data(&Objects, wp_data->object_instance);
+    if (!CurrentAV) {
+        wp_data->error_class = ERROR_CLASS_OBJECT;
+        wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return false;
+    }
 
     switch (wp_data->object_property) {
         case PROP_PRESENT_VALUE:
@@ -746,6 +870,8 @@ bool Analog_Value_Write_Property(
             if (status) {
                 CurrentAV->Time_Delay = value.type.Unsigned_Int;
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_VALUE,
+                    wp_data->object_instance);
             }
             break;
 
@@ -864,6 +990,14 @@ bool Analog_Value_Write_Property(
             break;
     }
 
+#if defined(INTRINSIC_REPORTING)
+    if (status) {
+        /* the value, limits and enables all feed the event algorithm */
+        Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_VALUE,
+            wp_data->object_instance);
+    }
+#endif
+
     return status;
 }
 
@@ -875,7 +1009,6 @@ void Analog_Value_Intrinsic_Reporting(
     BACNET_EVENT_NOTIFICATION_DATA event_data;
     BACNET_CHARACTER_STRING msgText;
     ANALOG_VALUE_DESCR *CurrentAV;
-    unsigned int object_index;
     uint8_t FromState = 0;
     uint8_t ToState;
     float ExceededLimit = 0.0f;
@@ -883,10 +1016,8 @@ void Analog_Value_Intrinsic_Reporting(
     bool SendNotify = false;
 
 
-    object_index = Analog_Value_Instance_To_Index(object_instance);
-    if (object_index < MAX_ANALOG_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else
+    CurrentAV = Object_Store_Data(&Objects, object_instance);
+    if (!CurrentAV)
         return;
 
     /* check limits */
@@ -928,10 +1059,10 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_VALUE,
+                            object_instance,
+                            &CurrentAV->Remaining_Time_Delay))
                         CurrentAV->Event_State = EVENT_STATE_HIGH_LIMIT;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
 
@@ -945,14 +1076,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_VALUE,
+                            object_instance,
+                            &CurrentAV->Remaining_Time_Delay))
                         CurrentAV->Event_State = EVENT_STATE_LOW_LIMIT;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_VALUE,
+                    object_instance);
                 break;
 
             case EVENT_STATE_HIGH_LIMIT:
@@ -967,14 +1100,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_VALUE,
+                            object_instance,
+                            &CurrentAV->Remaining_Time_Delay))
                         CurrentAV->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_VALUE,
+                    object_instance);
                 break;
 
             case EVENT_STATE_LOW_LIMIT:
@@ -990,14 +1125,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_Intrinsic_Time_Delay(OBJECT_ANALOG_VALUE,
+                            object_instance,
+                            &CurrentAV->Remaining_Time_Delay))
                         CurrentAV->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                Device_Intrinsic_Time_Delay_Stop(OBJECT_ANALOG_VALUE,
+                    object_instance);
                 break;
 
             default:
@@ -1010,6 +1147,8 @@ void Analog_Value_Intrinsic_Reporting(
             /* Event_State has changed.
                Need to fill only the basic parameters of this type of event.
                Other parameters will be filled in common function. */
+            /* the next transition has a time delay of its own */
+            CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
 
             switch (ToState) {
                 case EVENT_STATE_HIGH_LIMIT:
@@ -1161,6 +1300,7 @@ void Analog_Value_Intrinsic_Reporting(
                     break;
             }
         }
+        Analog_Value_Event_Index_Update(object_instance, CurrentAV);
     }
 #endif /* defined(INTRINSIC_REPORTING) */
 }
@@ -1171,24 +1311,26 @@ int Analog_Value_Event_Information(
     unsigned index,
     BACNET_GET_EVENT_INFORMATION_DATA * getevent_data)
 {
+    ANALOG_VALUE_DESCR *pObject;
     bool IsNotAckedTransitions;
     bool IsActiveEvent;
     int i;
 
 
     /* check index */
-    if (index < MAX_ANALOG_VALUES) {
+    pObject = Object_Store_Data_Index(&Objects, index);
+    if (pObject) {
         /* Event_State not equal to NORMAL */
-        IsActiveEvent = (AV_Descr[index].Event_State != EVENT_STATE_NORMAL);
+        IsActiveEvent = (pObject->Event_State != EVENT_STATE_NORMAL);
 
         /* Acked_Transitions property, which has at least one of the bits
            (TO-OFFNORMAL, TO-FAULT, TONORMAL) set to FALSE. */
         IsNotAckedTransitions =
-            (AV_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+            (pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
             bIsAcked ==
-            false) | (AV_Descr[index].Acked_Transitions[TRANSITION_TO_FAULT].
+            false) | (pObject->Acked_Transitions[TRANSITION_TO_FAULT].
             bIsAcked ==
-            false) | (AV_Descr[index].Acked_Transitions[TRANSITION_TO_NORMAL].
+            false) | (pObject->Acked_Transitions[TRANSITION_TO_NORMAL].
             bIsAcked == false);
     } else
         return -1;      /* end of list  */
@@ -1199,40 +1341,40 @@ int Analog_Value_Event_Information(
         getevent_data->objectIdentifier.instance =
             Analog_Value_Index_To_Instance(index);
         /* Event State */
-        getevent_data->eventState = AV_Descr[index].Event_State;
+        getevent_data->eventState = pObject->Event_State;
         /* Acknowledged Transitions */
         bitstring_init(&getevent_data->acknowledgedTransitions);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_OFFNORMAL,
-            AV_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+            pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
             bIsAcked);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_FAULT,
-            AV_Descr[index].Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
+            pObject->Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
         bitstring_set_bit(&getevent_data->acknowledgedTransitions,
             TRANSITION_TO_NORMAL,
-            AV_Descr[index].Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
+            pObject->Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
         /* Event Time Stamps */
         for (i = 0; i < 3; i++) {
             getevent_data->eventTimeStamps[i].tag = TIME_STAMP_DATETIME;
             getevent_data->eventTimeStamps[i].value.dateTime =
-                AV_Descr[index].Event_Time_Stamps[i];
+                pObject->Event_Time_Stamps[i];
         }
         /* Notify Type */
-        getevent_data->notifyType = AV_Descr[index].Notify_Type;
+        getevent_data->notifyType = pObject->Notify_Type;
         /* Event Enable */
         bitstring_init(&getevent_data->eventEnable);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_OFFNORMAL,
-            (AV_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ? true : false);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_FAULT,
-            (AV_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_FAULT) ? true : false);
         bitstring_set_bit(&getevent_data->eventEnable, TRANSITION_TO_NORMAL,
-            (AV_Descr[index].
+            (pObject->
                 Event_Enable & EVENT_ENABLE_TO_NORMAL) ? true : false);
         /* Event Priorities */
-        Notification_Class_Get_Priorities(AV_Descr[index].Notification_Class,
+        Notification_Class_Get_Priorities(pObject->Notification_Class,
             getevent_data->eventPriorities);
 
         return 1;       /* active event */
@@ -1245,16 +1387,11 @@ int Analog_Value_Alarm_Ack(
     BACNET_ERROR_CODE * error_code)
 {
     ANALOG_VALUE_DESCR *CurrentAV;
-    unsigned int object_index;
-
-
-    object_index =
-        Analog_Value_Instance_To_Index(alarmack_data->eventObjectIdentifier.
-        instance);
 
-    if (object_index < MAX_ANALOG_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else {
+    CurrentAV =
+        Object_Store_Data(&Objects,
+        alarmack_data->eventObjectIdentifier.instance);
+    if (!CurrentAV) {
         *error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return -1;
     }
@@ -1338,6 +1475,10 @@ int Analog_Value_Alarm_Ack(
     /* Need to send AckNotification. */
     CurrentAV->Ack_notify_data.bSendAckNotify = true;
     CurrentAV->Ack_notify_data.EventState = alarmack_data->eventStateAcked;
+    Device_Intrinsic_Reporting_Changed(OBJECT_ANALOG_VALUE,
+        alarmack_data->eventObjectIdentifier.instance);
+    Analog_Value_Event_Index_Update(
+        alarmack_data->eventObjectIdentifier.instance, CurrentAV);
 
     /* Return OK */
     return 1;
@@ -1347,32 +1488,34 @@ int Analog_Value_Alarm_Summary(
     unsigned index,
     BACNET_GET_ALARM_SUMMARY_DATA * getalarm_data)
 {
+    ANALOG_VALUE_DESCR *pObject;
 
     /* check index */
-    if (index < MAX_ANALOG_VALUES) {
+    pObject = Object_Store_Data_Index(&Objects, index);
+    if (pObject) {
         /* Event_State is not equal to NORMAL  and
            Notify_Type property value is ALARM */
-        if ((AV_Descr[index].Event_State != EVENT_STATE_NORMAL) &&
-            (AV_Descr[index].Notify_Type == NOTIFY_ALARM)) {
+        if ((pObject->Event_State != EVENT_STATE_NORMAL) &&
+            (pObject->Notify_Type == NOTIFY_ALARM)) {
             /* Object Identifier */
             getalarm_data->objectIdentifier.type = OBJECT_ANALOG_VALUE;
             getalarm_data->objectIdentifier.instance =
                 Analog_Value_Index_To_Instance(index);
             /* Alarm State */
-            getalarm_data->alarmState = AV_Descr[index].Event_State;
+            getalarm_data->alarmState = pObject->Event_State;
             /* Acknowledged Transitions */
             bitstring_init(&getalarm_data->acknowledgedTransitions);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_OFFNORMAL,
-                AV_Descr[index].Acked_Transitions[TRANSITION_TO_OFFNORMAL].
+                pObject->Acked_Transitions[TRANSITION_TO_OFFNORMAL].
                 bIsAcked);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_FAULT,
-                AV_Descr[index].
+                pObject->
                 Acked_Transitions[TRANSITION_TO_FAULT].bIsAcked);
             bitstring_set_bit(&getalarm_data->acknowledgedTransitions,
                 TRANSITION_TO_NORMAL,
-                AV_Descr[index].
+                pObject->
                 Acked_Transitions[TRANSITION_TO_NORMAL].bIsAcked);
 
             return 1;   /* active alarm */
@@ -1389,6 +1532,14 @@ int Analog_Value_Alarm_Summary(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -1403,6 +1554,14 @@ bool WPValidateArgType(
     return false;
 }
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 void testAnalog_Value(
     Test * pTest)
 {
@@ -1428,6 +1587,15 @@ void testAnalog_Value(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, Analog_Value_Create(77777));
+    ct_test(pTest, Analog_Value_Count() == (MAX_ANALOG_VALUES + 1));
+    ct_test(pTest, Analog_Value_Present_Value_Set(77777, 1.5f, 16));
+    ct_test(pTest, Analog_Value_Present_Value(77777) == 1.5f);
+    ct_test(pTest, Analog_Value_Delete(77777));
+    ct_test(pTest, !Analog_Value_Present_Value_Set(77777, 1.5f, 16));
+    Analog_Value_Cleanup();
+    ct_test(pTest, Analog_Value_Count() == 0);
 
     return;
 }
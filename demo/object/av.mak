@@ -18,6 +18,8 @@ SRCS = av.c \
 	$(SRC_DIR)/bacdevobjpropref.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(TEST_DIR)/ctest.c
 
 TARGET = analog_value
@@ -400,6 +400,7 @@ uint32_t bacfile_instance(
 /* invokeID and file instance in a list or table */
 /* when the request was sent */
 uint32_t bacfile_instance_from_tsm(
+    BACNET_ADDRESS * src,
     uint8_t invokeID)
 {
     BACNET_NPDU_DATA npdu_data = { 0 }; /* dummy for getting npdu length */
@@ -407,7 +408,6 @@ uint32_t bacfile_instance_from_tsm(
     uint8_t service_choice = 0;
     uint8_t *service_request = NULL;
     uint16_t service_request_len = 0;
-    BACNET_ADDRESS dest;        /* where the original packet was destined */
     uint8_t apdu[MAX_PDU] = { 0 };      /* original APDU packet */
     uint16_t apdu_len = 0;      /* original APDU packet length */
     int len = 0;        /* apdu header length */
@@ -416,7 +416,7 @@ uint32_t bacfile_instance_from_tsm(
     bool found = false;
 
     found =
-        tsm_get_transaction_pdu(invokeID, &dest, &npdu_data, &apdu[0],
+        tsm_get_peer_transaction_pdu(src, invokeID, &npdu_data, &apdu[0],
         &apdu_len);
     if (found) {
         if (!npdu_data.network_layer_message && npdu_data.data_expecting_reply
@@ -71,6 +71,7 @@ extern "C" {
     /* invokeID and file instance in a list or table */
     /* when the request was sent */
     uint32_t bacfile_instance_from_tsm(
+        BACNET_ADDRESS * src,
         uint8_t invokeID);
 
     /* handler ACK helper */
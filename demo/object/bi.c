@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "bacenum.h"
@@ -38,19 +39,28 @@
 #include "config.h"     /* the custom stuff */
 #include "bi.h"
 #include "handlers.h"
+#include "device.h"
 
+#include "objstore.h"
+
+/* number of demo objects created by Binary_Input_Init() */
 #ifndef MAX_BINARY_INPUTS
 #define MAX_BINARY_INPUTS 5
 #endif
 
-/* stores the current value */
-static BACNET_BINARY_PV Present_Value[MAX_BINARY_INPUTS];
-/* out of service decouples physical input from Present_Value */
-static bool Out_Of_Service[MAX_BINARY_INPUTS];
-/* Change of Value flag */
-static bool Change_Of_Value[MAX_BINARY_INPUTS];
-/* Polarity of Input */
-static BACNET_POLARITY Polarity[MAX_BINARY_INPUTS];
+struct object_data {
+    /* stores the current value */
+    BACNET_BINARY_PV Present_Value;
+    /* out of service decouples physical input from Present_Value */
+    bool Out_Of_Service;
+    /* Change of Value flag */
+    bool Change_Of_Value;
+    /* Polarity of Input */
+    BACNET_POLARITY Polarity;
+};
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(struct object_data), NULL);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Binary_Input_Properties_Required[] = {
@@ -92,79 +102,145 @@ void Binary_Input_Property_Lists(
     return;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
+/**
+ * Determines if a given Binary Input instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
 bool Binary_Input_Valid_Instance(
     uint32_t object_instance)
 {
-    if (object_instance < MAX_BINARY_INPUTS) {
-        return true;
-    }
-
-    return false;
+    return Object_Store_Valid_Instance(&Objects, object_instance);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
+/**
+ * Determines the number of Binary Input objects
+ *
+ * @return  Number of Binary Input objects
+ */
 unsigned Binary_Input_Count(
     void)
 {
-    return MAX_BINARY_INPUTS;
+    return Object_Store_Count(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Binary Input objects where N is Binary_Input_Count().
+ *
+ * @param  index - 0..N where N is Binary_Input_Count()
+ *
+ * @return  object instance-number for the given index
+ */
 uint32_t Binary_Input_Index_To_Instance(
     unsigned index)
 {
-    return index;
+    return Object_Store_Index_To_Instance(&Objects, index);
 }
 
-void Binary_Input_Init(
-    void)
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Binary Input objects where N is Binary_Input_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Binary_Input_Count()
+ * if not valid.
+ */
+unsigned Binary_Input_Instance_To_Index(
+    uint32_t object_instance)
 {
-    static bool initialized = false;
-    unsigned i;
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
+}
 
-    if (!initialized) {
-        initialized = true;
+/**
+ * Creates a Binary Input object with default values
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Binary_Input_Create(
+    uint32_t object_instance)
+{
+    struct object_data *pObject;
 
-        /* initialize all the values */
-        for (i = 0; i < MAX_BINARY_INPUTS; i++) {
-            Present_Value[i] = BINARY_INACTIVE;
-        }
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
+        return true;
     }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    pObject->Present_Value = BINARY_INACTIVE;
+    pObject->Out_Of_Service = false;
+    pObject->Change_Of_Value = false;
+    pObject->Polarity = POLARITY_NORMAL;
 
-    return;
+    Device_Object_Name_Index_Update(OBJECT_BINARY_INPUT, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned Binary_Input_Instance_To_Index(
+/**
+ * Deletes a Binary Input object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Binary_Input_Delete(
     uint32_t object_instance)
 {
-    unsigned index = MAX_BINARY_INPUTS;
+    bool status = false;
 
-    if (object_instance < MAX_BINARY_INPUTS) {
-        index = object_instance;
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_BINARY_INPUT, object_instance);
     }
 
-    return index;
+    return status;
+}
+
+/**
+ * Deletes all the Binary Input objects and their data
+ */
+void Binary_Input_Cleanup(
+    void)
+{
+    Object_Store_Cleanup(&Objects);
+}
+
+/**
+ * Initializes the Binary Input objects
+ */
+void Binary_Input_Init(
+    void)
+{
+    unsigned i;
+
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_BINARY_INPUTS; i++) {
+            Binary_Input_Create(i);
+        }
+    }
+
+    return;
 }
 
 BACNET_BINARY_PV Binary_Input_Present_Value(
     uint32_t object_instance)
 {
     BACNET_BINARY_PV value = BINARY_INACTIVE;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        value = Present_Value[index];
-        if (Polarity[index] != POLARITY_NORMAL) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Present_Value;
+        if (pObject->Polarity != POLARITY_NORMAL) {
             if (value == BINARY_INACTIVE) {
                 value = BINARY_ACTIVE;
             } else {
@@ -180,11 +256,11 @@ bool Binary_Input_Out_Of_Service(
     uint32_t object_instance)
 {
     bool value = false;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        value = Out_Of_Service[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Out_Of_Service;
     }
 
     return value;
@@ -194,11 +270,11 @@ bool Binary_Input_Change_Of_Value(
     uint32_t object_instance)
 {
     bool status = false;
-    unsigned index;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        status = Change_Of_Value[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        status = pObject->Change_Of_Value;
     }
 
     return status;
@@ -207,11 +283,11 @@ bool Binary_Input_Change_Of_Value(
 void Binary_Input_Change_Of_Value_Clear(
     uint32_t object_instance)
 {
-    unsigned index;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        Change_Of_Value[index] = false;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->Change_Of_Value = false;
     }
 
     return;
@@ -274,22 +350,23 @@ bool Binary_Input_Present_Value_Set(
     uint32_t object_instance,
     BACNET_BINARY_PV value)
 {
-    unsigned index = 0;
     bool status = false;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        if (Polarity[index] != POLARITY_NORMAL) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        if (pObject->Polarity != POLARITY_NORMAL) {
             if (value == BINARY_INACTIVE) {
                 value = BINARY_ACTIVE;
             } else {
                 value = BINARY_INACTIVE;
             }
         }
-        if (Present_Value[index] != value) {
-            Change_Of_Value[index] = true;
+        if (pObject->Present_Value != value) {
+            pObject->Change_Of_Value = true;
+            handler_cov_object_changed(OBJECT_BINARY_INPUT, object_instance);
         }
-        Present_Value[index] = value;
+        pObject->Present_Value = value;
         status = true;
     }
 
@@ -300,14 +377,15 @@ void Binary_Input_Out_Of_Service_Set(
     uint32_t object_instance,
     bool value)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        if (Out_Of_Service[index] != value) {
-            Change_Of_Value[index] = true;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        if (pObject->Out_Of_Service != value) {
+            pObject->Change_Of_Value = true;
+            handler_cov_object_changed(OBJECT_BINARY_INPUT, object_instance);
         }
-        Out_Of_Service[index] = value;
+        pObject->Out_Of_Service = value;
     }
 
     return;
@@ -317,12 +395,12 @@ bool Binary_Input_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         sprintf(text_string, "BINARY INPUT %lu",
             (unsigned long) object_instance);
         status = characterstring_init_ansi(object_name, text_string);
@@ -335,11 +413,11 @@ BACNET_POLARITY Binary_Input_Polarity(
     uint32_t object_instance)
 {
     BACNET_POLARITY polarity = POLARITY_NORMAL;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        polarity = Polarity[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        polarity = pObject->Polarity;
     }
 
     return polarity;
@@ -350,11 +428,11 @@ bool Binary_Input_Polarity_Set(
     BACNET_POLARITY polarity)
 {
     bool status = false;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Input_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_INPUTS) {
-        Polarity[index] = polarity;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->Polarity = polarity;
     }
 
     return status;
@@ -527,6 +605,14 @@ bool Binary_Input_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -541,6 +627,14 @@ bool WPValidateArgType(
     return false;
 }
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 void testBinaryInput(
     Test * pTest)
 {
@@ -566,6 +660,24 @@ void testBinaryInput(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, Binary_Input_Count() == MAX_BINARY_INPUTS);
+    ct_test(pTest, Binary_Input_Create(BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest, Binary_Input_Valid_Instance(BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest, Binary_Input_Count() == (MAX_BINARY_INPUTS + 1));
+    ct_test(pTest,
+        Binary_Input_Index_To_Instance(MAX_BINARY_INPUTS) ==
+        (BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest,
+        Binary_Input_Instance_To_Index(BACNET_MAX_INSTANCE - 1) ==
+        MAX_BINARY_INPUTS);
+    ct_test(pTest, !Binary_Input_Create(BACNET_MAX_INSTANCE));
+    ct_test(pTest, Binary_Input_Delete(BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest, !Binary_Input_Delete(BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest, !Binary_Input_Valid_Instance(BACNET_MAX_INSTANCE - 1));
+    ct_test(pTest, Binary_Input_Count() == MAX_BINARY_INPUTS);
+    Binary_Input_Cleanup();
+    ct_test(pTest, Binary_Input_Count() == 0);
 
     return;
 }
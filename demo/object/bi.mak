@@ -16,6 +16,8 @@ SRCS = bi.c \
 	$(SRC_DIR)/bacdevobjpropref.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(SRC_DIR)/datetime.c \
 	$(SRC_DIR)/lighting.c \
 	$(TEST_DIR)/ctest.c
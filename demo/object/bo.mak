@@ -18,6 +18,8 @@ SRCS = bo.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/lighting.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(TEST_DIR)/ctest.c
 
 TARGET = binary_output
@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "bacenum.h"
@@ -37,7 +38,10 @@
 #include "rp.h"
 #include "bv.h"
 #include "handlers.h"
+#include "device.h"
+#include "objstore.h"
 
+/* number of demo objects created by Binary_Value_Init() */
 #ifndef MAX_BINARY_VALUES
 #define MAX_BINARY_VALUES 10
 #endif
@@ -45,12 +49,16 @@
 /* When all the priorities are level null, the present value returns */
 /* the Relinquish Default value */
 #define RELINQUISH_DEFAULT BINARY_INACTIVE
-/* Here is our Priority Array.*/
-static BACNET_BINARY_PV
-    Binary_Value_Level[MAX_BINARY_VALUES][BACNET_MAX_PRIORITY];
-/* Writable out-of-service allows others to play with our Present Value */
-/* without changing the physical output */
-static bool Out_Of_Service[MAX_BINARY_VALUES];
+struct object_data {
+    /* Here is our Priority Array.*/
+    BACNET_BINARY_PV Priority_Array[BACNET_MAX_PRIORITY];
+    /* Writable out-of-service allows others to play with our Present Value */
+    /* without changing the physical output */
+    bool Out_Of_Service;
+};
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(struct object_data), NULL);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Binary_Value_Properties_Required[] = {
@@ -90,81 +98,148 @@ void Binary_Value_Property_Lists(
     return;
 }
 
-void Binary_Value_Init(
-    void)
+/**
+ * Determines if a given Binary Value instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool Binary_Value_Valid_Instance(
+    uint32_t object_instance)
 {
-    unsigned i, j;
-    static bool initialized = false;
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
 
-    if (!initialized) {
-        initialized = true;
+/**
+ * Determines the number of Binary Value objects
+ *
+ * @return  Number of Binary Value objects
+ */
+unsigned Binary_Value_Count(
+    void)
+{
+    return Object_Store_Count(&Objects);
+}
 
-        /* initialize all the analog output priority arrays to NULL */
-        for (i = 0; i < MAX_BINARY_VALUES; i++) {
-            for (j = 0; j < BACNET_MAX_PRIORITY; j++) {
-                Binary_Value_Level[i][j] = BINARY_NULL;
-            }
-        }
-    }
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Binary Value objects where N is Binary_Value_Count().
+ *
+ * @param  index - 0..N where N is Binary_Value_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t Binary_Value_Index_To_Instance(
+    unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
+}
 
-    return;
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Binary Value objects where N is Binary_Value_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Binary_Value_Count()
+ * if not valid.
+ */
+unsigned Binary_Value_Instance_To_Index(
+    uint32_t object_instance)
+{
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
-bool Binary_Value_Valid_Instance(
+/**
+ * Creates a Binary Value object with an empty priority array
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Binary_Value_Create(
     uint32_t object_instance)
 {
-    if (object_instance < MAX_BINARY_VALUES)
+    struct object_data *pObject;
+    unsigned j;
+
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
         return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    for (j = 0; j < BACNET_MAX_PRIORITY; j++) {
+        pObject->Priority_Array[j] = BINARY_NULL;
+    }
+    pObject->Out_Of_Service = false;
 
-    return false;
+    Device_Object_Name_Index_Update(OBJECT_BINARY_VALUE, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned Binary_Value_Count(
-    void)
+/**
+ * Deletes a Binary Value object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Binary_Value_Delete(
+    uint32_t object_instance)
 {
-    return MAX_BINARY_VALUES;
+    bool status = false;
+
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_BINARY_VALUE, object_instance);
+    }
+
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t Binary_Value_Index_To_Instance(
-    unsigned index)
+/**
+ * Deletes all the Binary Value objects and their data
+ */
+void Binary_Value_Cleanup(
+    void)
 {
-    return index;
+    Object_Store_Cleanup(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned Binary_Value_Instance_To_Index(
-    uint32_t object_instance)
+/**
+ * Initializes the Binary Value objects
+ */
+void Binary_Value_Init(
+    void)
 {
-    unsigned index = MAX_BINARY_VALUES;
+    unsigned i;
 
-    if (object_instance < MAX_BINARY_VALUES)
-        index = object_instance;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_BINARY_VALUES; i++) {
+            Binary_Value_Create(i);
+        }
+    }
 
-    return index;
+    return;
 }
 
 BACNET_BINARY_PV Binary_Value_Present_Value(
     uint32_t object_instance)
 {
     BACNET_BINARY_PV value = RELINQUISH_DEFAULT;
-    unsigned index = 0;
+    struct object_data *pObject;
     unsigned i = 0;
 
-    index = Binary_Value_Instance_To_Index(object_instance);
-    if (index < MAX_BINARY_VALUES) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         for (i = 0; i < BACNET_MAX_PRIORITY; i++) {
-            if (Binary_Value_Level[index][i] != BINARY_NULL) {
-                value = Binary_Value_Level[index][i];
+            if (pObject->Priority_Array[i] != BINARY_NULL) {
+                value = pObject->Priority_Array[i];
                 break;
             }
         }
@@ -178,10 +253,10 @@ bool Binary_Value_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
 
-    if (object_instance < MAX_BINARY_VALUES) {
+    if (Binary_Value_Valid_Instance(object_instance)) {
         sprintf(text_string, "BINARY VALUE %lu",
             (unsigned long) object_instance);
         status = characterstring_init_ansi(object_name, text_string);
@@ -193,12 +268,12 @@ bool Binary_Value_Object_Name(
 bool Binary_Value_Out_Of_Service(
     uint32_t instance)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
     bool oos_flag = false;
 
-    index = Binary_Value_Instance_To_Index(instance);
-    if (index < MAX_BINARY_VALUES) {
-        oos_flag = Out_Of_Service[index];
+    pObject = Object_Store_Data(&Objects, instance);
+    if (pObject) {
+        oos_flag = pObject->Out_Of_Service;
     }
 
     return oos_flag;
@@ -208,11 +283,11 @@ void Binary_Value_Out_Of_Service_Set(
     uint32_t instance,
     bool oos_flag)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Binary_Value_Instance_To_Index(instance);
-    if (index < MAX_BINARY_VALUES) {
-        Out_Of_Service[index] = oos_flag;
+    pObject = Object_Store_Data(&Objects, instance);
+    if (pObject) {
+        pObject->Out_Of_Service = oos_flag;
     }
 }
 
@@ -225,7 +300,7 @@ int Binary_Value_Read_Property(
     BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     BACNET_BINARY_PV present_value = BINARY_INACTIVE;
-    unsigned object_index = 0;
+    struct object_data *pObject;
     unsigned i = 0;
     bool state = false;
     uint8_t *apdu = NULL;
@@ -234,6 +309,12 @@ int Binary_Value_Read_Property(
         (rpdata->application_data_len == 0)) {
         return 0;
     }
+    pObject = Object_Store_Data(&Objects, rpdata->object_instance);
+    if (!pObject) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return BACNET_STATUS_ERROR;
+    }
     apdu = rpdata->application_data;
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
@@ -285,14 +366,12 @@ int Binary_Value_Read_Property(
             /* if no index was specified, then try to encode the entire list */
             /* into one packet. */
             else if (rpdata->array_index == BACNET_ARRAY_ALL) {
-                object_index =
-                    Binary_Value_Instance_To_Index(rpdata->object_instance);
                 for (i = 0; i < BACNET_MAX_PRIORITY; i++) {
                     /* FIXME: check if we have room before adding it to APDU */
-                    if (Binary_Value_Level[object_index][i] == BINARY_NULL)
+                    if (pObject->Priority_Array[i] == BINARY_NULL)
                         len = encode_application_null(&apdu[apdu_len]);
                     else {
-                        present_value = Binary_Value_Level[object_index][i];
+                        present_value = pObject->Priority_Array[i];
                         len =
                             encode_application_enumerated(&apdu[apdu_len],
                             present_value);
@@ -308,15 +387,13 @@ int Binary_Value_Read_Property(
                     }
                 }
             } else {
-                object_index =
-                    Binary_Value_Instance_To_Index(rpdata->object_instance);
                 if (rpdata->array_index <= BACNET_MAX_PRIORITY) {
-                    if (Binary_Value_Level[object_index][rpdata->array_index]
-                        == BINARY_NULL)
+                    if (pObject->Priority_Array[rpdata->array_index - 1] ==
+                        BINARY_NULL)
                         apdu_len = encode_application_null(&apdu[apdu_len]);
                     else {
-                        present_value = Binary_Value_Level[object_index]
-                            [rpdata->array_index];
+                        present_value =
+                            pObject->Priority_Array[rpdata->array_index - 1];
                         apdu_len =
                             encode_application_enumerated(&apdu[apdu_len],
                             present_value);
@@ -354,12 +431,18 @@ bool Binary_Value_Write_Property(
     BACNET_WRITE_PROPERTY_DATA * wp_data)
 {
     bool status = false;        /* return value */
-    unsigned int object_index = 0;
+    struct object_data *pObject;
     unsigned int priority = 0;
     BACNET_BINARY_PV level = BINARY_NULL;
     int len = 0;
     BACNET_APPLICATION_DATA_VALUE value;
 
+    pObject = Object_Store_Data(&Objects, wp_data->object_instance);
+    if (!pObject) {
+        wp_data->error_class = ERROR_CLASS_OBJECT;
+        wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return false;
+    }
     /* decode the some of the request */
     len =
         bacapp_decode_application_data(wp_data->application_data,
@@ -389,11 +472,8 @@ bool Binary_Value_Write_Property(
                     (priority != 6 /* reserved */ ) &&
                     (value.type.Enumerated <= MAX_BINARY_PV)) {
                     level = (BACNET_BINARY_PV) value.type.Enumerated;
-                    object_index =
-                        Binary_Value_Instance_To_Index
-                        (wp_data->object_instance);
                     priority--;
-                    Binary_Value_Level[object_index][priority] = level;
+                    pObject->Priority_Array[priority] = level;
                     /* Note: you could set the physical output here if we
                        are the highest priority.
                        However, if Out of Service is TRUE, then don't set the
@@ -416,13 +496,10 @@ bool Binary_Value_Write_Property(
                     &wp_data->error_class, &wp_data->error_code);
                 if (status) {
                     level = BINARY_NULL;
-                    object_index =
-                        Binary_Value_Instance_To_Index
-                        (wp_data->object_instance);
                     priority = wp_data->priority;
                     if (priority && (priority <= BACNET_MAX_PRIORITY)) {
                         priority--;
-                        Binary_Value_Level[object_index][priority] = level;
+                        pObject->Priority_Array[priority] = level;
                         /* Note: you could set the physical output here to the next
                            highest priority, or to the relinquish default if no
                            priorities are set.
@@ -472,6 +549,14 @@ bool Binary_Value_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -511,6 +596,20 @@ void testBinary_Value(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, Binary_Value_Create(4194302));
+    ct_test(pTest, Binary_Value_Count() == (MAX_BINARY_VALUES + 1));
+    ct_test(pTest,
+        Binary_Value_Index_To_Instance(Binary_Value_Count() - 1) == 4194302);
+    rpdata.object_instance = 4194302;
+    rpdata.object_property = PROP_PRIORITY_ARRAY;
+    rpdata.array_index = BACNET_MAX_PRIORITY;
+    len = Binary_Value_Read_Property(&rpdata);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, Binary_Value_Delete(4194302));
+    ct_test(pTest, !Binary_Value_Valid_Instance(4194302));
+    Binary_Value_Cleanup();
+    ct_test(pTest, Binary_Value_Count() == 0);
 
     return;
 }
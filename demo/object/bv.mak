@@ -17,6 +17,8 @@ SRCS = bv.c \
 	$(SRC_DIR)/bacdevobjpropref.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(SRC_DIR)/lighting.c \
 	$(TEST_DIR)/ctest.c
 
@@ -619,7 +619,7 @@ bool Command_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     unsigned int index;
     bool status = false;
 
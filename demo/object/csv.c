@@ -37,6 +37,7 @@
 #include "wp.h"
 #include "csv.h"
 #include "handlers.h"
+#include "device.h"
 
 /* number of demo objects */
 #ifndef MAX_CHARACTERSTRING_VALUES
@@ -290,6 +291,11 @@ bool CharacterString_Value_Name_Set(
         }
     }
 
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_CHARACTERSTRING_VALUE,
+            object_instance);
+    }
+
     return status;
 }
 
@@ -452,6 +458,14 @@ bool CharacterString_Value_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -28,6 +28,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>     /* for UINT_MAX */
+#include <stdlib.h>     /* for calloc, free */
 #include <string.h>     /* for memmove */
 #include <time.h>       /* for timezone, localtime */
 #include "bacdef.h"
@@ -44,6 +46,9 @@
 #include "handlers.h"
 #include "datalink.h"
 #include "address.h"
+#include "keylist.h"
+#include "fnv.h"
+#include "minheap.h"
 /* os specfic includes */
 #include "timer.h"
 /* include the device object */
@@ -99,6 +104,23 @@ extern bool Routed_Device_Write_Property_Local(
 
 /* may be overridden by outside table */
 static object_functions_t *Object_Table;
+/* direct lookup of the Object_Table entry by object type */
+static struct object_functions *Object_Type_Table[MAX_BACNET_OBJECT_TYPE];
+
+/* Object_Name lookup index.  Each name hash keys a chain of objects
+   whose names have that hash, and each object key refers back to its
+   entry so that a renamed object can be found and moved.  It is built
+   by Device_Init(), and the object name setters and the object Create
+   and Delete functions keep it current, so a name that is not in the
+   index is not in the device.  Lookups only read it. */
+struct object_name_entry {
+    KEY object_key;
+    uint32_t name_hash;
+    struct object_name_entry *next;
+};
+static OS_Keylist Object_Name_Hash_List;
+static OS_Keylist Object_Name_Key_List;
+static bool Object_Name_Index_Valid;
 
 static object_functions_t My_Object_Table[] = {
     {OBJECT_DEVICE,
@@ -115,7 +137,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #if (BACNET_PROTOCOL_REVISION >= 17)
     {OBJECT_NETWORK_PORT,
             Network_Port_Init,
@@ -131,7 +155,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #endif
     {OBJECT_ANALOG_INPUT,
             Analog_Input_Init,
@@ -147,7 +173,9 @@ static object_functions_t My_Object_Table[] = {
             Analog_Input_Encode_Value_List,
             Analog_Input_Change_Of_Value,
             Analog_Input_Change_Of_Value_Clear,
-        Analog_Input_Intrinsic_Reporting},
+            Analog_Input_Intrinsic_Reporting,
+            Analog_Input_Create,
+        Analog_Input_Delete},
     {OBJECT_ANALOG_OUTPUT,
             Analog_Output_Init,
             Analog_Output_Count,
@@ -162,7 +190,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_ANALOG_VALUE,
             Analog_Value_Init,
             Analog_Value_Count,
@@ -177,7 +207,9 @@ static object_functions_t My_Object_Table[] = {
             Analog_Value_Encode_Value_List,
             Analog_Value_Change_Of_Value,
             Analog_Value_Change_Of_Value_Clear,
-        Analog_Value_Intrinsic_Reporting},
+            Analog_Value_Intrinsic_Reporting,
+            Analog_Value_Create,
+        Analog_Value_Delete},
     {OBJECT_BINARY_INPUT,
             Binary_Input_Init,
             Binary_Input_Count,
@@ -192,7 +224,9 @@ static object_functions_t My_Object_Table[] = {
             Binary_Input_Encode_Value_List,
             Binary_Input_Change_Of_Value,
             Binary_Input_Change_Of_Value_Clear,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            Binary_Input_Create,
+        Binary_Input_Delete},
     {OBJECT_BINARY_OUTPUT,
             Binary_Output_Init,
             Binary_Output_Count,
@@ -207,7 +241,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            Binary_Output_Create,
+        Binary_Output_Delete},
     {OBJECT_BINARY_VALUE,
             Binary_Value_Init,
             Binary_Value_Count,
@@ -222,7 +258,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            Binary_Value_Create,
+        Binary_Value_Delete},
     {OBJECT_CHARACTERSTRING_VALUE,
             CharacterString_Value_Init,
             CharacterString_Value_Count,
@@ -237,7 +275,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_COMMAND,
             Command_Init,
             Command_Count,
@@ -252,7 +292,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_INTEGER_VALUE,
             Integer_Value_Init,
             Integer_Value_Count,
@@ -267,7 +309,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #if defined(INTRINSIC_REPORTING)
     {OBJECT_NOTIFICATION_CLASS,
             Notification_Class_Init,
@@ -283,7 +327,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #endif
     {OBJECT_LIFE_SAFETY_POINT,
             Life_Safety_Point_Init,
@@ -299,7 +345,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_LOAD_CONTROL,
             Load_Control_Init,
             Load_Control_Count,
@@ -314,7 +362,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_MULTI_STATE_INPUT,
             Multistate_Input_Init,
             Multistate_Input_Count,
@@ -329,7 +379,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_MULTI_STATE_OUTPUT,
             Multistate_Output_Init,
             Multistate_Output_Count,
@@ -344,7 +396,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            Multistate_Output_Create,
+        Multistate_Output_Delete},
     {OBJECT_MULTI_STATE_VALUE,
             Multistate_Value_Init,
             Multistate_Value_Count,
@@ -359,7 +413,9 @@ static object_functions_t My_Object_Table[] = {
             Multistate_Value_Encode_Value_List,
             Multistate_Value_Change_Of_Value,
             Multistate_Value_Change_Of_Value_Clear,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            Multistate_Value_Create,
+        Multistate_Value_Delete},
     {OBJECT_TRENDLOG,
             Trend_Log_Init,
             Trend_Log_Count,
@@ -374,7 +430,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #if (BACNET_PROTOCOL_REVISION >= 14)
     {OBJECT_LIGHTING_OUTPUT,
             Lighting_Output_Init,
@@ -390,7 +448,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_CHANNEL,
             Channel_Init,
             Channel_Count,
@@ -405,7 +465,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #endif
 #if defined(BACFILE)
     {OBJECT_FILE,
@@ -422,7 +484,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
 #endif
     {OBJECT_OCTETSTRING_VALUE,
             OctetString_Value_Init,
@@ -438,7 +502,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            OctetString_Value_Create,
+        OctetString_Value_Delete},
     {OBJECT_POSITIVE_INTEGER_VALUE,
             PositiveInteger_Value_Init,
             PositiveInteger_Value_Count,
@@ -453,7 +519,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {OBJECT_SCHEDULE,
             Schedule_Init,
             Schedule_Count,
@@ -468,7 +536,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ },
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ },
     {MAX_BACNET_OBJECT_TYPE,
             NULL /* Init */ ,
             NULL /* Count */ ,
@@ -483,7 +553,9 @@ static object_functions_t My_Object_Table[] = {
             NULL /* Value_Lists */ ,
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
-        NULL /* Intrinsic Reporting */ }
+            NULL /* Intrinsic Reporting */ ,
+            NULL /* Create */ ,
+        NULL /* Delete */ }
 };
 
 /** Glue function to let the Device object, when called by a handler,
@@ -496,15 +568,8 @@ static object_functions_t My_Object_Table[] = {
 static struct object_functions *Device_Objects_Find_Functions(
     BACNET_OBJECT_TYPE Object_Type)
 {
-    struct object_functions *pObject = NULL;
-
-    pObject = Object_Table;
-    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
-        /* handle each object type */
-        if (pObject->Object_Type == Object_Type) {
-            return (pObject);
-        }
-        pObject++;
+    if ((unsigned) Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        return Object_Type_Table[Object_Type];
     }
 
     return (NULL);
@@ -620,6 +685,11 @@ static const int Device_Properties_Optional[] = {
     PROP_TIME_SYNCHRONIZATION_INTERVAL,
     PROP_ALIGN_INTERVALS,
     PROP_INTERVAL_OFFSET,
+#endif
+#if (MAX_TSM_TRANSACTIONS) && \
+    ((MAX_SEGMENTS_TRANSMIT > 1) || (MAX_SEGMENTS_ACCEPTED > 1))
+    PROP_MAX_SEGMENTS_ACCEPTED,
+    PROP_APDU_SEGMENT_TIMEOUT,
 #endif
     -1
 };
@@ -661,19 +731,21 @@ static char Description[MAX_DEV_DESC_LEN + 1] = "server";
 /* static uint8_t Protocol_Revision = 4; - constant, not settable */
 /* Protocol_Services_Supported - dynamically generated */
 /* Protocol_Object_Types_Supported - in RP encoding */
-/* Object_List - dynamically generated */
+/* Object_List - cached from the object table, see below */
 /* static BACNET_SEGMENTATION Segmentation_Supported = SEGMENTATION_NONE; */
 /* static uint8_t Max_Segments_Accepted = 0; */
 /* VT_Classes_Supported */
 /* Active_VT_Sessions */
-static BACNET_TIME Local_Time;  /* rely on OS, if there is one */
-static BACNET_DATE Local_Date;  /* rely on OS, if there is one */
+/* read from the OS each time they are used, so that threads
+   reading them at once each have their own copy */
+static BACNET_THREAD_LOCAL BACNET_TIME Local_Time;      /* rely on OS, if there is one */
+static BACNET_THREAD_LOCAL BACNET_DATE Local_Date;      /* rely on OS, if there is one */
 /* NOTE: BACnet UTC Offset is inverse of common practice.
    If your UTC offset is -5hours of GMT,
    then BACnet UTC offset is +5hours.
    BACnet UTC offset is expressed in minutes. */
-static int32_t UTC_Offset = 5 * 60;
-static bool Daylight_Savings_Status = false;    /* rely on OS */
+static BACNET_THREAD_LOCAL int32_t UTC_Offset = 5 * 60;
+static BACNET_THREAD_LOCAL bool Daylight_Savings_Status = false;        /* rely on OS */
 #if defined(BACNET_TIME_MASTER)
 static bool Align_Intervals;
 static uint32_t Interval_Minutes;
@@ -685,6 +757,12 @@ static uint32_t Interval_Offset_Minutes;
 /* Max_Info_Frames - rely on MS/TP subsystem, if there is one */
 /* Device_Address_Binding - required, but relies on binding cache */
 static uint32_t Database_Revision = 0;
+/* Object_List - cached, and rebuilt when the Database_Revision changes */
+static KEY *Object_List;
+static uint32_t Object_List_Count;
+static uint32_t Object_List_Size;
+static uint32_t Object_List_Revision;
+static bool Object_List_Valid;
 /* Configuration_Files */
 /* Last_Restore_Time */
 /* Backup_Failure_Timeout */
@@ -795,11 +873,14 @@ bool Device_Set_Object_Instance_Number(
     uint32_t object_id)
 {
     bool status = true; /* return value */
+    uint32_t old_object_id = Object_Instance_Number;
 
     if (object_id <= BACNET_MAX_INSTANCE) {
         /* Make the change and update the database revision */
         Object_Instance_Number = object_id;
         Device_Inc_Database_Revision();
+        Device_Object_Name_Index_Update(OBJECT_DEVICE, old_object_id);
+        Device_Object_Name_Index_Update(OBJECT_DEVICE, object_id);
     } else
         status = false;
 
@@ -834,6 +915,7 @@ bool Device_Set_Object_Name(
         /* Make the change and update the database revision */
         status = characterstring_copy(&My_Object_Name, object_name);
         Device_Inc_Database_Revision();
+        Device_Object_Name_Index_Update(OBJECT_DEVICE, Object_Instance_Number);
     }
 
     return status;
@@ -1042,7 +1124,12 @@ uint8_t Device_Protocol_Revision(
 BACNET_SEGMENTATION Device_Segmentation_Supported(
     void)
 {
+#if (MAX_TSM_TRANSACTIONS) && (MAX_SEGMENTS_TRANSMIT > 1)
+    /* responses are segmented, requests are not reassembled */
+    return SEGMENTATION_TRANSMIT;
+#else
     return SEGMENTATION_NONE;
+#endif
 }
 
 uint32_t Device_Database_Revision(
@@ -1068,6 +1155,103 @@ void Device_Inc_Database_Revision(
     Database_Revision++;
 }
 
+/* the number of objects in the object table, counted type by type */
+static uint32_t Device_Object_Table_Count(
+    void)
+{
+    struct object_functions *pObject = NULL;
+    uint32_t count = 0;
+
+    pObject = Object_Table;
+    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        if (pObject->Object_Count && pObject->Object_Index_To_Instance) {
+            count += pObject->Object_Count();
+        }
+        pObject++;
+    }
+
+    return count;
+}
+
+/** Rebuild the flattened Object_List from the object table.
+ * Even though we don't keep a single linear array of objects in the
+ * Device, this builds one from the concatenated object type arrays so
+ * that indexed reads of the Object_List don't have to walk the table.
+ * @param count [in] The number of objects in the object table.
+ * @return True if the list was built.
+ */
+static bool Device_Object_List_Rebuild(
+    uint32_t count)
+{
+    struct object_functions *pObject = NULL;
+    uint32_t object_count = 0;
+    uint32_t object_index = 0;
+    uint32_t i = 0;
+    KEY *object_list = NULL;
+
+    Object_List_Valid = false;
+    if (count > Object_List_Size) {
+        object_list = realloc(Object_List, count * sizeof(KEY));
+        if (!object_list) {
+            return false;
+        }
+        Object_List = object_list;
+        Object_List_Size = count;
+    }
+    count = 0;
+    pObject = Object_Table;
+    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        if (pObject->Object_Count && pObject->Object_Index_To_Instance) {
+            object_count = pObject->Object_Count();
+            /* Use the iterator function if available otherwise
+             * the index is the position in the array of this type */
+            if (pObject->Object_Iterator) {
+                object_index = pObject->Object_Iterator(~(unsigned) 0);
+            } else {
+                object_index = 0;
+            }
+            for (i = 0; (i < object_count) && (count < Object_List_Size);
+                i++) {
+                Object_List[count] =
+                    KEY_ENCODE(pObject->Object_Type,
+                    pObject->Object_Index_To_Instance(object_index));
+                count++;
+                if (pObject->Object_Iterator) {
+                    object_index = pObject->Object_Iterator(object_index);
+                } else {
+                    object_index++;
+                }
+            }
+        }
+        pObject++;
+    }
+    Object_List_Count = count;
+    Object_List_Revision = Database_Revision;
+    Object_List_Valid = true;
+
+    return true;
+}
+
+/** Make sure the cached Object_List matches the object table.
+ * The cache is rebuilt when the Database_Revision changes, or when the
+ * object counts change without a revision bump, as they do when objects
+ * are created through the per-type APIs or a routed device is selected.
+ * @param count [out] The number of objects in the object table.
+ * @return True if the cached list may be used, false if it could not be
+ *  allocated and the object table must be walked instead.
+ */
+static bool Device_Object_List_Current(
+    uint32_t * count)
+{
+    *count = Device_Object_Table_Count();
+    if (Object_List_Valid && (Object_List_Revision == Database_Revision) &&
+        (Object_List_Count == *count)) {
+        return true;
+    }
+
+    return Device_Object_List_Rebuild(*count);
+}
+
 /** Get the total count of objects supported by this Device Object.
  * @note Since many network clients depend on the object list
  *       for discovery, it must be consistent!
@@ -1076,25 +1260,54 @@ void Device_Inc_Database_Revision(
 unsigned Device_Object_List_Count(
     void)
 {
-    unsigned count = 0; /* number of objects */
+    uint32_t count = 0;
+
+    (void) Device_Object_List_Current(&count);
+
+    return count;
+}
+
+/* finds the object at this Object_List index by walking the object table,
+   for when the cached list could not be allocated */
+static bool Device_Object_List_Walk(
+    uint32_t object_index,
+    int *object_type,
+    uint32_t * instance)
+{
+    uint32_t count = 0;
+    uint32_t temp_index = 0;
     struct object_functions *pObject = NULL;
 
-    /* initialize the default return values */
     pObject = Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
-        if (pObject->Object_Count) {
-            count += pObject->Object_Count();
+        if (pObject->Object_Count && pObject->Object_Index_To_Instance) {
+            count = pObject->Object_Count();
+            if (object_index < count) {
+                if (pObject->Object_Iterator) {
+                    temp_index = pObject->Object_Iterator(~(unsigned) 0);
+                    while (object_index != 0) {
+                        temp_index = pObject->Object_Iterator(temp_index);
+                        object_index--;
+                    }
+                    object_index = temp_index;
+                }
+                *object_type = pObject->Object_Type;
+                *instance = pObject->Object_Index_To_Instance(object_index);
+                return true;
+            }
+            object_index -= count;
         }
         pObject++;
     }
 
-    return count;
+    return false;
 }
 
 /** Lookup the Object at the given array index in the Device's Object List.
- * Even though we don't keep a single linear array of objects in the Device,
- * this method acts as though we do and works through a virtual, concatenated
- * array of all of our object type arrays.
+ * The list is cached, and rebuilt when the Database_Revision or the
+ * object counts change.  A change that keeps the counts the same, such
+ * as deleting one object and creating another, must increment the
+ * revision.
  *
  * @param array_index [in] The desired array index (1 to N)
  * @param object_type [out] The object's type, if found.
@@ -1108,50 +1321,170 @@ bool Device_Object_List_Identifier(
 {
     bool status = false;
     uint32_t count = 0;
-    uint32_t object_index = 0;
-    uint32_t temp_index = 0;
-    struct object_functions *pObject = NULL;
+    KEY object_key = 0;
 
     /* array index zero is length - so invalid */
     if (array_index == 0) {
         return status;
     }
-    object_index = array_index - 1;
-    /* initialize the default return values */
-    pObject = Object_Table;
-    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
-        if (pObject->Object_Count) {
-            object_index -= count;
-            count = pObject->Object_Count();
-            if (object_index < count) {
-                /* Use the iterator function if available otherwise
-                 * look for the index to instance to get the ID */
-                if (pObject->Object_Iterator) {
-                    /* First find the first object */
-                    temp_index = pObject->Object_Iterator(~(unsigned) 0);
-                    /* Then step through the objects to find the nth */
-                    while (object_index != 0) {
-                        temp_index = pObject->Object_Iterator(temp_index);
-                        object_index--;
-                    }
-                    /* set the object_index up before falling through to next bit */
-                    object_index = temp_index;
-                }
-                if (pObject->Object_Index_To_Instance) {
-                    *object_type = pObject->Object_Type;
-                    *instance =
-                        pObject->Object_Index_To_Instance(object_index);
-                    status = true;
-                    break;
-                }
-            }
+    if (Device_Object_List_Current(&count)) {
+        if (array_index <= Object_List_Count) {
+            object_key = Object_List[array_index - 1];
+            *object_type = KEY_DECODE_TYPE(object_key);
+            *instance = KEY_DECODE_ID(object_key);
+            status = true;
         }
-        pObject++;
+    } else if (array_index <= count) {
+        status = Device_Object_List_Walk(array_index - 1, object_type,
+            instance);
     }
+#ifdef BAC_ROUTING
+    if (status && (*object_type == OBJECT_DEVICE)) {
+        /* the routed Device instance depends on the current device */
+        *instance = Device_Object_Instance_Number();
+    }
+#endif
 
     return status;
 }
 
+/* FNV-1a hash of the object name characters */
+static uint32_t Device_Object_Name_Hash(
+    BACNET_CHARACTER_STRING * object_name)
+{
+    return FNV_Hash((const uint8_t *) characterstring_value(object_name),
+        characterstring_length(object_name), FNV_HASH_INIT);
+}
+
+static void Device_Object_Name_Index_Remove(
+    KEY object_key)
+{
+    struct object_name_entry *entry = NULL;
+    struct object_name_entry *prior = NULL;
+
+    entry = Keylist_Data_Delete(Object_Name_Key_List, object_key);
+    if (!entry) {
+        return;
+    }
+    prior = Keylist_Data(Object_Name_Hash_List, entry->name_hash);
+    if (prior == entry) {
+        (void) Keylist_Data_Delete(Object_Name_Hash_List, entry->name_hash);
+        if (entry->next) {
+            (void) Keylist_Data_Add(Object_Name_Hash_List, entry->name_hash,
+                entry->next);
+        }
+    } else {
+        while (prior && (prior->next != entry)) {
+            prior = prior->next;
+        }
+        if (prior) {
+            prior->next = entry->next;
+        }
+    }
+    free(entry);
+}
+
+static void Device_Object_Name_Index_Add(
+    KEY object_key,
+    BACNET_CHARACTER_STRING * object_name)
+{
+    struct object_name_entry *entry = NULL;
+    struct object_name_entry *head = NULL;
+
+    entry = calloc(1, sizeof(struct object_name_entry));
+    if (!entry) {
+        return;
+    }
+    entry->object_key = object_key;
+    entry->name_hash = Device_Object_Name_Hash(object_name);
+    head = Keylist_Data(Object_Name_Hash_List, entry->name_hash);
+    if (head) {
+        /* same hash - chain it behind the first one */
+        entry->next = head->next;
+        head->next = entry;
+    } else {
+        (void) Keylist_Data_Add(Object_Name_Hash_List, entry->name_hash,
+            entry);
+    }
+    (void) Keylist_Data_Add(Object_Name_Key_List, object_key, entry);
+}
+
+/** Rebuild the Object_Name index from every object in the Device.
+ * Called once the object table is initialized.
+ */
+static void Device_Object_Name_Index_Rebuild(
+    void)
+{
+    struct object_name_entry *entry = NULL;
+    struct object_functions *pObject = NULL;
+    BACNET_CHARACTER_STRING object_name;
+    uint32_t max_objects = 0, i = 0;
+    int type = 0;
+    uint32_t instance = 0;
+
+    if (!Object_Name_Hash_List) {
+        Object_Name_Hash_List = Keylist_Create();
+    }
+    if (!Object_Name_Key_List) {
+        Object_Name_Key_List = Keylist_Create();
+    }
+    while (Keylist_Count(Object_Name_Hash_List) > 0) {
+        (void) Keylist_Data_Pop(Object_Name_Hash_List);
+    }
+    do {
+        entry = Keylist_Data_Pop(Object_Name_Key_List);
+        free(entry);
+    } while (entry);
+    max_objects = Device_Object_List_Count();
+    for (i = 1; i <= max_objects; i++) {
+        if (Device_Object_List_Identifier(i, &type, &instance)) {
+#ifdef BAC_ROUTING
+            if (type == OBJECT_DEVICE) {
+                /* the routed Device is compared directly on lookup */
+                continue;
+            }
+#endif
+            pObject = Device_Objects_Find_Functions(type);
+            if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
+                pObject->Object_Name(instance, &object_name)) {
+                Device_Object_Name_Index_Add(KEY_ENCODE(type, instance),
+                    &object_name);
+            }
+        }
+    }
+    Object_Name_Index_Valid = true;
+}
+
+/** Update the Object_Name index after an object was renamed, created,
+ * deleted or given a new instance number.  Every function that changes
+ * the name of an object, other than during Device_Init(), calls this;
+ * otherwise Device_Valid_Object_Name() does not find the new name.
+ * @param object_type [in] The BACNET_OBJECT_TYPE of the changed Object.
+ * @param object_instance [in] The object instance number of the changed
+ *  Object.  If the object no longer exists, it is removed from the index.
+ */
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    KEY object_key = KEY_ENCODE(object_type, object_instance);
+    BACNET_CHARACTER_STRING object_name;
+
+    if (!Object_Name_Index_Valid) {
+        /* the whole index gets built by Device_Init() */
+        return;
+    }
+#ifdef BAC_ROUTING
+    if (object_type == OBJECT_DEVICE) {
+        return;
+    }
+#endif
+    Device_Object_Name_Index_Remove(object_key);
+    if (Device_Object_Name_Copy(object_type, object_instance, &object_name)) {
+        Device_Object_Name_Index_Add(object_key, &object_name);
+    }
+}
+
 /** Determine if we have an object with the given object_name.
  * If the object_type and object_instance pointers are not null,
  * and the lookup succeeds, they will be given the resulting values.
@@ -1168,34 +1501,64 @@ bool Device_Valid_Object_Name(
     bool found = false;
     int type = 0;
     uint32_t instance;
-    uint32_t max_objects = 0, i = 0;
-    bool check_id = false;
     BACNET_CHARACTER_STRING object_name2;
     struct object_functions *pObject = NULL;
+    struct object_name_entry *entry = NULL;
 
-    max_objects = Device_Object_List_Count();
-    for (i = 1; i <= max_objects; i++) {
-        check_id = Device_Object_List_Identifier(i, &type, &instance);
-        if (check_id) {
-            pObject = Device_Objects_Find_Functions(type);
-            if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
-                (pObject->Object_Name(instance, &object_name2) &&
-                    characterstring_same(object_name1, &object_name2))) {
-                found = true;
-                if (object_type) {
-                    *object_type = type;
-                }
-                if (object_instance) {
-                    *object_instance = instance;
-                }
-                break;
+#ifdef BAC_ROUTING
+    /* the name and instance of the routed Device follow the current
+       device, so it is not in the index */
+    instance = Device_Object_Instance_Number();
+    if (Device_Object_Name_Copy(OBJECT_DEVICE, instance, &object_name2) &&
+        characterstring_same(object_name1, &object_name2)) {
+        if (object_type) {
+            *object_type = OBJECT_DEVICE;
+        }
+        if (object_instance) {
+            *object_instance = instance;
+        }
+        return true;
+    }
+#endif
+    entry =
+        Keylist_Data(Object_Name_Hash_List,
+        Device_Object_Name_Hash(object_name1));
+    while (entry) {
+        /* the hash only narrows the search - compare the actual name */
+        type = KEY_DECODE_TYPE(entry->object_key);
+        instance = KEY_DECODE_ID(entry->object_key);
+        pObject = Device_Objects_Find_Functions(type);
+        if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
+            (pObject->Object_Name(instance, &object_name2) &&
+                characterstring_same(object_name1, &object_name2))) {
+            found = true;
+            if (object_type) {
+                *object_type = type;
             }
+            if (object_instance) {
+                *object_instance = instance;
+            }
+            break;
         }
+        entry = entry->next;
     }
 
     return found;
 }
 
+/** Build the Object_List now if it is out of date, instead of on its
+ * next lookup.  Lookups then only read it and the Object_Name index,
+ * so that several threads may look up objects at once, as long as this
+ * is called after the objects change and before they start.
+ */
+void Device_Objects_Refresh(
+    void)
+{
+    uint32_t count = 0;
+
+    (void) Device_Object_List_Current(&count);
+}
+
 /** Determine if we have an object of this type and instance number.
  * @param object_type [in] The desired BACNET_OBJECT_TYPE
  * @param object_instance [in] The object instance number to be looked up.
@@ -1216,6 +1579,63 @@ bool Device_Valid_Object_Id(
     return status;
 }
 
+/** Create a child object of the given type and instance number, for
+ * object types whose helpers provide Object_Create.
+ * @param object_type [in] The BACNET_OBJECT_TYPE of the new Object.
+ * @param object_instance [in] The object instance number of the new Object.
+ * @return True if the object was created; False if the type does not
+ *  support creation, the instance already exists, or memory ran out.
+ */
+bool Device_Create_Object(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    struct object_functions *pObject = NULL;
+    bool status = false;
+
+    pObject = Device_Objects_Find_Functions(object_type);
+    if ((pObject != NULL) && (pObject->Object_Create != NULL)) {
+        if ((pObject->Object_Valid_Instance != NULL) &&
+            pObject->Object_Valid_Instance(object_instance)) {
+            /* already exists */
+            return false;
+        }
+        status = pObject->Object_Create(object_instance);
+        if (status) {
+            Device_Object_Name_Index_Update(object_type, object_instance);
+            Device_Inc_Database_Revision();
+        }
+    }
+
+    return status;
+}
+
+/** Delete a child object of the given type and instance number, for
+ * object types whose helpers provide Object_Delete.
+ * @param object_type [in] The BACNET_OBJECT_TYPE of the Object.
+ * @param object_instance [in] The object instance number of the Object.
+ * @return True if the object was deleted.
+ */
+bool Device_Delete_Object(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    struct object_functions *pObject = NULL;
+    bool status = false;
+
+    pObject = Device_Objects_Find_Functions(object_type);
+    if ((pObject != NULL) && (pObject->Object_Delete != NULL)) {
+        status = pObject->Object_Delete(object_instance);
+        if (status) {
+            Device_Object_Name_Index_Update(object_type, object_instance);
+            handler_cov_object_deleted(object_type, object_instance);
+            Device_Inc_Database_Revision();
+        }
+    }
+
+    return status;
+}
+
 /** Copy a child object's object_name value, given its ID.
  * @param object_type [in] The BACNET_OBJECT_TYPE of the child Object.
  * @param object_instance [in] The object instance number of the child Object.
@@ -1246,6 +1666,7 @@ static void Update_Current_Time(
     time_t tTemp;
 #else
     struct timeval tv;
+    struct tm tm_buffer;
 #endif
 /*
 struct tm
@@ -1265,7 +1686,7 @@ int    tm_isdst Daylight Savings flag.
     tblock = (struct tm *)localtime(&tTemp);
 #else
     if (gettimeofday(&tv, NULL) == 0) {
-        tblock = (struct tm *)localtime((const time_t *)&tv.tv_sec);
+        tblock = localtime_r((const time_t *)&tv.tv_sec, &tm_buffer);
     }
 #endif
 
@@ -1535,29 +1956,21 @@ int Device_Read_Property_Local(
             /* to return an error if the number of encoded objects exceeds */
             /* your maximum APDU size. */
             else if (rpdata->array_index == BACNET_ARRAY_ALL) {
+                /* one pass over the cached list */
                 for (i = 1; i <= count; i++) {
-                    found =
-                        Device_Object_List_Identifier(i, &object_type,
+                    (void) Device_Object_List_Identifier(i, &object_type,
                         &instance);
-                    if (found) {
-                        len =
-                            encode_application_object_id(&apdu[apdu_len],
-                            object_type, instance);
-                        apdu_len += len;
-                        /* assume next one is the same size as this one */
-                        /* can we all fit into the APDU? Don't check for last entry */
-                        if ((i != count) && (apdu_len + len) >= apdu_max) {
-                            /* Abort response */
-                            rpdata->error_code =
-                                ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
-                            apdu_len = BACNET_STATUS_ABORT;
-                            break;
-                        }
-                    } else {
-                        /* error: internal error? */
-                        rpdata->error_class = ERROR_CLASS_SERVICES;
-                        rpdata->error_code = ERROR_CODE_OTHER;
-                        apdu_len = BACNET_STATUS_ERROR;
+                    len =
+                        encode_application_object_id(&apdu[apdu_len],
+                        object_type, instance);
+                    apdu_len += len;
+                    /* assume next one is the same size as this one */
+                    /* can we all fit into the APDU? Don't check for last entry */
+                    if ((i != count) && (apdu_len + len) >= apdu_max) {
+                        /* Abort response */
+                        rpdata->error_code =
+                            ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+                        apdu_len = BACNET_STATUS_ABORT;
                         break;
                     }
                 }
@@ -1590,6 +2003,19 @@ int Device_Read_Property_Local(
         case PROP_NUMBER_OF_APDU_RETRIES:
             apdu_len = encode_application_unsigned(&apdu[0], apdu_retries());
             break;
+#if (MAX_TSM_TRANSACTIONS) && \
+    ((MAX_SEGMENTS_TRANSMIT > 1) || (MAX_SEGMENTS_ACCEPTED > 1))
+        case PROP_MAX_SEGMENTS_ACCEPTED:
+            /* the segments of a ComplexACK that are reassembled */
+            apdu_len =
+                encode_application_unsigned(&apdu[0], MAX_SEGMENTS_ACCEPTED);
+            break;
+        case PROP_APDU_SEGMENT_TIMEOUT:
+            apdu_len =
+                encode_application_unsigned(&apdu[0],
+                apdu_segment_timeout());
+            break;
+#endif
         case PROP_DEVICE_ADDRESS_BINDING:
             apdu_len = address_list_encode(&apdu[0], apdu_max);
             break;
@@ -1764,6 +2190,22 @@ bool Device_Write_Property_Local(
                 apdu_timeout_set((uint16_t) value.type.Unsigned_Int);
             }
             break;
+#if (MAX_TSM_TRANSACTIONS) && \
+    ((MAX_SEGMENTS_TRANSMIT > 1) || (MAX_SEGMENTS_ACCEPTED > 1))
+        case PROP_APDU_SEGMENT_TIMEOUT:
+            status =
+                WPValidateArgType(&value, BACNET_APPLICATION_TAG_UNSIGNED_INT,
+                &wp_data->error_class, &wp_data->error_code);
+            if (status) {
+                /* FIXME: bounds check? */
+                apdu_segment_timeout_set((uint16_t) value.type.Unsigned_Int);
+            }
+            break;
+        case PROP_MAX_SEGMENTS_ACCEPTED:
+            wp_data->error_class = ERROR_CLASS_PROPERTY;
+            wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+            break;
+#endif
         case PROP_VENDOR_IDENTIFIER:
             status =
                 WPValidateArgType(&value, BACNET_APPLICATION_TAG_UNSIGNED_INT,
@@ -2011,6 +2453,11 @@ bool Device_Write_Property(
 #endif
                 {
                     status = pObject->Object_Write_Property(wp_data);
+                    if (status &&
+                        (wp_data->object_property == PROP_OBJECT_NAME)) {
+                        Device_Object_Name_Index_Update(wp_data->object_type,
+                            wp_data->object_instance);
+                    }
                 }
             } else {
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
@@ -2107,31 +2554,356 @@ void Device_COV_Clear(
 }
 
 #if defined(INTRINSIC_REPORTING)
-void Device_local_reporting(
-    void)
+/* Intrinsic reporting is driven by change.  Objects flag themselves with
+   Device_Intrinsic_Reporting_Changed() when their value, limits or
+   acknowledgments change, and pending time delays are kept in a timer
+   heap, so that only the objects with something to do are evaluated.
+   An entry exists only while its object is flagged or timed. */
+struct reporting_entry {
+    KEY object_key;
+    /* Reporting_Slots index, which names the entry in the timer heap */
+    unsigned slot;
+    /* Reporting_Clock second at which the time delay runs out */
+    uint32_t due;
+    /* position in Reporting_Timer_Heap, or MIN_HEAP_NO_POSITION */
+    unsigned timer_position;
+    bool expired;
+    bool dirty;
+    struct reporting_entry *dirty_next;
+};
+/* the entries by slot; a free slot holds the next free slot instead */
+union reporting_slot {
+    struct reporting_entry *entry;
+    unsigned next_free;
+};
+/* initial number of slots, which doubles as needed */
+#define REPORTING_SLOTS 16
+static OS_Keylist Reporting_List;
+static union reporting_slot *Reporting_Slots;
+static unsigned Reporting_Slot_Size;
+static unsigned Reporting_Slot_Free = UINT_MAX;
+static void Device_Reporting_Timer_Moved(
+    void *context,
+    unsigned slot,
+    unsigned position);
+static MIN_HEAP Reporting_Timer_Heap = {
+    NULL, 0, 0, Device_Reporting_Timer_Moved, NULL
+};
+static struct reporting_entry *Reporting_Dirty_Head;
+static struct reporting_entry *Reporting_Dirty_Tail;
+static uint32_t Reporting_Clock;
+/* every object is evaluated at startup, and again if an entry
+   could not be allocated for an object that changed */
+static bool Reporting_Scan_Requested = true;
+
+/* gives the entry a slot, growing the slots if needed */
+static bool Device_Reporting_Slot_Alloc(
+    struct reporting_entry *entry)
+{
+    union reporting_slot *slots = NULL;
+    unsigned size = 0;
+    unsigned i = 0;
+
+    if (Reporting_Slot_Free == UINT_MAX) {
+        if (Reporting_Slot_Size) {
+            size = Reporting_Slot_Size * 2;
+        } else {
+            size = REPORTING_SLOTS;
+        }
+        slots = realloc(Reporting_Slots, size * sizeof(union reporting_slot));
+        if (!slots) {
+            return false;
+        }
+        Reporting_Slots = slots;
+        for (i = size; i > Reporting_Slot_Size; i--) {
+            Reporting_Slots[i - 1].next_free = Reporting_Slot_Free;
+            Reporting_Slot_Free = i - 1;
+        }
+        Reporting_Slot_Size = size;
+    }
+    entry->slot = Reporting_Slot_Free;
+    Reporting_Slot_Free = Reporting_Slots[entry->slot].next_free;
+    Reporting_Slots[entry->slot].entry = entry;
+
+    return true;
+}
+
+static void Device_Reporting_Slot_Release(
+    struct reporting_entry *entry)
+{
+    Reporting_Slots[entry->slot].next_free = Reporting_Slot_Free;
+    Reporting_Slot_Free = entry->slot;
+}
+
+static struct reporting_entry *Device_Reporting_Entry(
+    KEY object_key,
+    bool create)
+{
+    struct reporting_entry *entry = NULL;
+
+    if (!Reporting_List) {
+        if (!create) {
+            return NULL;
+        }
+        Reporting_List = Keylist_Create();
+        if (!Reporting_List) {
+            return NULL;
+        }
+    }
+    entry = Keylist_Data(Reporting_List, object_key);
+    if (!entry && create) {
+        entry = calloc(1, sizeof(struct reporting_entry));
+        if (entry) {
+            entry->object_key = object_key;
+            entry->timer_position = MIN_HEAP_NO_POSITION;
+            if (!Device_Reporting_Slot_Alloc(entry)) {
+                free(entry);
+                entry = NULL;
+            } else if (Keylist_Data_Add(Reporting_List, object_key,
+                    entry) < 0) {
+                Device_Reporting_Slot_Release(entry);
+                free(entry);
+                entry = NULL;
+            }
+        }
+    }
+
+    return entry;
+}
+
+/* frees the entry once it is neither flagged nor timed */
+static void Device_Reporting_Entry_Release(
+    struct reporting_entry *entry)
+{
+    if (!entry->dirty && !entry->expired &&
+        (entry->timer_position == MIN_HEAP_NO_POSITION)) {
+        Keylist_Data_Delete(Reporting_List, entry->object_key);
+        Device_Reporting_Slot_Release(entry);
+        free(entry);
+    }
+}
+
+static void Device_Reporting_Dirty(
+    struct reporting_entry *entry)
+{
+    if (!entry->dirty) {
+        entry->dirty = true;
+        entry->dirty_next = NULL;
+        if (Reporting_Dirty_Tail) {
+            Reporting_Dirty_Tail->dirty_next = entry;
+        } else {
+            Reporting_Dirty_Head = entry;
+        }
+        Reporting_Dirty_Tail = entry;
+    }
+}
+
+static void Device_Reporting_Timer_Moved(
+    void *context,
+    unsigned slot,
+    unsigned position)
+{
+    (void) context;
+    Reporting_Slots[slot].entry->timer_position = position;
+}
+
+static void Device_Reporting_Timer_Stop(
+    struct reporting_entry *entry)
+{
+    (void) Min_Heap_Remove(&Reporting_Timer_Heap, entry->timer_position);
+}
+
+/* returns false if the heap could not grow to hold the timer */
+static bool Device_Reporting_Timer_Start(
+    struct reporting_entry *entry,
+    uint32_t seconds)
+{
+    entry->due = Reporting_Clock + seconds;
+
+    return Min_Heap_Insert(&Reporting_Timer_Heap, entry->slot, entry->due);
+}
+
+/** Flags an object for intrinsic reporting evaluation.
+ * @ingroup ObjHelpers
+ * Objects that support intrinsic reporting call this when anything that
+ * their event algorithm depends on changes, such as the Present_Value,
+ * the limits, or an acknowledgment waiting to be notified.
+ * @param [in] The object type of the object that changed.
+ * @param [in] The object instance of the object that changed.
+ */
+void Device_Intrinsic_Reporting_Changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    struct reporting_entry *entry;
+
+    entry =
+        Device_Reporting_Entry(KEY_ENCODE(object_type, object_instance),
+        true);
+    if (entry) {
+        Device_Reporting_Dirty(entry);
+    } else {
+        Reporting_Scan_Requested = true;
+    }
+}
+
+/** Runs the time delay of an object whose event condition holds.
+ * @ingroup ObjHelpers
+ * Called by the intrinsic reporting function of the object on each
+ * evaluation.  The first call starts a timer, which evaluates the object
+ * again when the time delay has run out.
+ * @param [in] The object type of the object.
+ * @param [in] The object instance of the object.
+ * @param [in,out] remaining - the seconds left of the time delay, which
+ *  are updated while the timer runs.
+ * @return True once the time delay has run out.
+ */
+bool Device_Intrinsic_Time_Delay(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    uint32_t * remaining)
+{
+    struct reporting_entry *entry;
+    KEY object_key = KEY_ENCODE(object_type, object_instance);
+
+    entry = Device_Reporting_Entry(object_key, false);
+    if (entry) {
+        if (entry->expired) {
+            entry->expired = false;
+            *remaining = 0;
+            Device_Reporting_Entry_Release(entry);
+            return true;
+        }
+        if (entry->timer_position != MIN_HEAP_NO_POSITION) {
+            *remaining = entry->due - Reporting_Clock;
+            return false;
+        }
+    }
+    if (*remaining == 0) {
+        return true;
+    }
+    if (!entry) {
+        entry = Device_Reporting_Entry(object_key, true);
+    }
+    if (entry && Device_Reporting_Timer_Start(entry, *remaining)) {
+        return false;
+    }
+    /* without a timer, count down once per evaluation each second */
+    (*remaining)--;
+    if (entry) {
+        Device_Reporting_Dirty(entry);
+    } else {
+        Reporting_Scan_Requested = true;
+    }
+
+    return false;
+}
+
+/** Stops the time delay of an object whose event condition has cleared.
+ * @ingroup ObjHelpers
+ * @param [in] The object type of the object.
+ * @param [in] The object instance of the object.
+ */
+void Device_Intrinsic_Time_Delay_Stop(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    struct reporting_entry *entry;
+
+    entry =
+        Device_Reporting_Entry(KEY_ENCODE(object_type, object_instance),
+        false);
+    if (entry) {
+        Device_Reporting_Timer_Stop(entry);
+        entry->expired = false;
+        Device_Reporting_Entry_Release(entry);
+    }
+}
+
+static void Device_Reporting_Evaluate(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
 {
     struct object_functions *pObject;
+    struct reporting_entry *entry;
+
+    pObject = Device_Objects_Find_Functions(object_type);
+    if ((pObject != NULL) && pObject->Object_Valid_Instance &&
+        pObject->Object_Valid_Instance(object_instance)) {
+        if (pObject->Object_Intrinsic_Reporting) {
+            pObject->Object_Intrinsic_Reporting(object_instance);
+        }
+    } else {
+        /* the object is gone, and so is its time delay */
+        Device_Intrinsic_Time_Delay_Stop(object_type, object_instance);
+    }
+    /* the object may have left the entry idle, or not looked at
+       an expired time delay because its limits were disabled */
+    entry =
+        Device_Reporting_Entry(KEY_ENCODE(object_type, object_instance),
+        false);
+    if (entry) {
+        entry->expired = false;
+        Device_Reporting_Entry_Release(entry);
+    }
+}
+
+/** Evaluates the intrinsic reporting of the objects that need it.
+ * @ingroup ObjHelpers
+ * Only the objects flagged with Device_Intrinsic_Reporting_Changed(),
+ * and those whose time delay has run out, are evaluated.
+ * @param [in] elapsed_seconds - seconds since the last call.
+ */
+void Device_local_reporting(
+    uint32_t elapsed_seconds)
+{
+    struct reporting_entry *entry;
+    struct reporting_entry *next;
     uint32_t objects_count;
     uint32_t object_instance;
     int object_type;
     uint32_t idx;
+    KEY object_key;
+    unsigned slot;
+    uint32_t due;
 
-    objects_count = Device_Object_List_Count();
-
-    /* loop for all objects */
-    for (idx = 1; idx <= objects_count; idx++) {
-        Device_Object_List_Identifier(idx, &object_type, &object_instance);
-
-        pObject = Device_Objects_Find_Functions(object_type);
-        if (pObject != NULL) {
-            if (pObject->Object_Valid_Instance &&
-                pObject->Object_Valid_Instance(object_instance)) {
-                if (pObject->Object_Intrinsic_Reporting) {
-                    pObject->Object_Intrinsic_Reporting(object_instance);
-                }
+    Reporting_Clock += elapsed_seconds;
+    while (Min_Heap_Peek(&Reporting_Timer_Heap, &slot, &due)) {
+        if ((int32_t) (due - Reporting_Clock) > 0) {
+            break;
+        }
+        entry = Reporting_Slots[slot].entry;
+        Device_Reporting_Timer_Stop(entry);
+        entry->expired = true;
+        Device_Reporting_Dirty(entry);
+    }
+    if (Reporting_Scan_Requested) {
+        Reporting_Scan_Requested = false;
+        objects_count = Device_Object_List_Count();
+        for (idx = 1; idx <= objects_count; idx++) {
+            Device_Object_List_Identifier(idx, &object_type,
+                &object_instance);
+            entry =
+                Device_Reporting_Entry(KEY_ENCODE(object_type,
+                    object_instance), false);
+            if (!entry || !entry->dirty) {
+                Device_Reporting_Evaluate((BACNET_OBJECT_TYPE) object_type,
+                    object_instance);
             }
         }
     }
+    /* objects flagged while these are evaluated wait for the next call */
+    entry = Reporting_Dirty_Head;
+    Reporting_Dirty_Head = NULL;
+    Reporting_Dirty_Tail = NULL;
+    while (entry) {
+        next = entry->dirty_next;
+        entry->dirty = false;
+        object_key = entry->object_key;
+        Device_Reporting_Evaluate((BACNET_OBJECT_TYPE)
+            KEY_DECODE_TYPE(object_key), KEY_DECODE_ID(object_key));
+        entry = next;
+    }
 }
 #endif
 
@@ -2185,12 +2957,27 @@ void Device_Init(
     }
     ucix_cleanup(ctx);
 #endif /* defined(BAC_UCI) */
+#if !defined(_MSC_VER)
+    /* localtime_r() need not set the timezone that UTC_Offset is from */
+    tzset();
+#endif
 
     if (object_table) {
         Object_Table = object_table;
     } else {
         Object_Table = &My_Object_Table[0];
     }
+    memset(Object_Type_Table, 0, sizeof(Object_Type_Table));
+    pObject = Object_Table;
+    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        /* the first entry for a type wins, as with a table scan */
+        if (!Object_Type_Table[pObject->Object_Type]) {
+            Object_Type_Table[pObject->Object_Type] = pObject;
+        }
+        pObject++;
+    }
+    /* the objects created here are indexed all at once, below */
+    Object_Name_Index_Valid = false;
     pObject = Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         if (pObject->Object_Init) {
@@ -2198,6 +2985,8 @@ void Device_Init(
         }
         pObject++;
     }
+    Object_List_Valid = false;
+    Device_Object_Name_Index_Rebuild();
 }
 
 bool DeviceGetRRInfo(
@@ -2272,6 +3061,8 @@ void Routing_Device_Init(
     pDevObject->Object_Name = Routed_Device_Name;
     pDevObject->Object_Read_Property = Routed_Device_Read_Property_Local;
     pDevObject->Object_Write_Property = Routed_Device_Write_Property_Local;
+    Object_List_Valid = false;
+    Device_Object_Name_Index_Rebuild();
 }
 
 #endif /* BAC_ROUTING */
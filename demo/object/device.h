@@ -138,6 +138,24 @@ typedef void (
     *object_intrinsic_reporting_function) (
     uint32_t object_instance);
 
+/** Create an object of this type with the given instance number.
+ * @ingroup ObjHelpers
+ * @param [in] The object instance number of the new object.
+ * @return True if the object instance exists after the call.
+ */
+typedef bool(
+    *object_create_function) (
+    uint32_t object_instance);
+
+/** Delete the object of this type with the given instance number.
+ * @ingroup ObjHelpers
+ * @param [in] The object instance number to be deleted.
+ * @return True if the object instance was found and deleted.
+ */
+typedef bool(
+    *object_delete_function) (
+    uint32_t object_instance);
+
 
 /** Defines the group of object helper functions for any supported Object.
  * @ingroup ObjHelpers
@@ -164,6 +182,8 @@ typedef struct object_functions {
     object_cov_function Object_COV;
     object_cov_clear_function Object_COV_Clear;
     object_intrinsic_reporting_function Object_Intrinsic_Reporting;
+    object_create_function Object_Create;
+    object_delete_function Object_Delete;
 } object_functions_t;
 
 /* String Lengths - excluding any nul terminator */
@@ -360,9 +380,20 @@ extern "C" {
         BACNET_CHARACTER_STRING * object_name,
         int *object_type,
         uint32_t * object_instance);
+    void Device_Object_Name_Index_Update(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    void Device_Objects_Refresh(
+        void);
     bool Device_Valid_Object_Id(
         int object_type,
         uint32_t object_instance);
+    bool Device_Create_Object(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    bool Device_Delete_Object(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
 
     int Device_Read_Property(
         BACNET_READ_PROPERTY_DATA * rpdata);
@@ -380,7 +411,17 @@ extern "C" {
 
 #if defined(INTRINSIC_REPORTING)
     void Device_local_reporting(
-        void);
+        uint32_t elapsed_seconds);
+    void Device_Intrinsic_Reporting_Changed(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    bool Device_Intrinsic_Time_Delay(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        uint32_t * remaining);
+    void Device_Intrinsic_Time_Delay_Stop(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
 #endif
 
 /* Prototypes for Routing functionality in the Device Object.
@@ -27,6 +27,8 @@ SRCS = device.c \
 	$(SRC_DIR)/lighting.c \
 	$(SRC_DIR)/apdu.c \
 	$(SRC_DIR)/address.c \
+	$(SRC_DIR)/fnv.c \
+	$(SRC_DIR)/minheap.c \
 	$(SRC_DIR)/bacaddr.c \
 	$(SRC_DIR)/dcc.c \
 	$(SRC_DIR)/version.c \
@@ -342,6 +342,11 @@ bool Multistate_Input_Name_Set(
         }
     }
 
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_INPUT,
+            object_instance);
+    }
+
     return status;
 }
 
@@ -785,6 +790,14 @@ bool Multistate_Input_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 
 bool Device_Valid_Object_Name(
     BACNET_CHARACTER_STRING * object_name,
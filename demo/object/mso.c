@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "bacenum.h"
@@ -37,7 +38,10 @@
 #include "wp.h"
 #include "mso.h"
 #include "handlers.h"
+#include "device.h"
+#include "objstore.h"
 
+/* number of demo objects created by Multistate_Output_Init() */
 #ifndef MAX_MULTISTATE_OUTPUTS
 #define MAX_MULTISTATE_OUTPUTS 4
 #endif
@@ -50,12 +54,16 @@
 #define MULTISTATE_NULL (255)
 /* how many states? 1 to 254 states, 0 is not allowed */
 #define MULTISTATE_NUMBER_OF_STATES (254)
-/* Here is our Priority Array.*/
-static uint8_t
-    Multistate_Output_Level[MAX_MULTISTATE_OUTPUTS][BACNET_MAX_PRIORITY];
-/* Writable out-of-service allows others to play with our Present Value */
-/* without changing the physical output */
-static bool Out_Of_Service[MAX_MULTISTATE_OUTPUTS];
+struct object_data {
+    /* Here is our Priority Array.*/
+    uint8_t Priority_Array[BACNET_MAX_PRIORITY];
+    /* Writable out-of-service allows others to play with our Present Value */
+    /* without changing the physical output */
+    bool Out_Of_Service;
+};
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(struct object_data), NULL);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Multistate_Output_Properties_Required[] = {
@@ -96,81 +104,149 @@ void Multistate_Output_Property_Lists(
     return;
 }
 
-void Multistate_Output_Init(
-    void)
+/**
+ * Determines if a given Multi-State Output instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool Multistate_Output_Valid_Instance(
+    uint32_t object_instance)
 {
-    unsigned i, j;
-    static bool initialized = false;
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
 
-    if (!initialized) {
-        initialized = true;
+/**
+ * Determines the number of Multi-State Output objects
+ *
+ * @return  Number of Multi-State Output objects
+ */
+unsigned Multistate_Output_Count(
+    void)
+{
+    return Object_Store_Count(&Objects);
+}
 
-        /* initialize all the analog output priority arrays to NULL */
-        for (i = 0; i < MAX_MULTISTATE_OUTPUTS; i++) {
-            for (j = 0; j < BACNET_MAX_PRIORITY; j++) {
-                Multistate_Output_Level[i][j] = MULTISTATE_NULL;
-            }
-        }
-    }
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Multi-State Output objects where N is Multistate_Output_Count().
+ *
+ * @param  index - 0..N where N is Multistate_Output_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t Multistate_Output_Index_To_Instance(
+    unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
+}
 
-    return;
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Multi-State Output objects where N is Multistate_Output_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Multistate_Output_Count()
+ * if not valid.
+ */
+unsigned Multistate_Output_Instance_To_Index(
+    uint32_t object_instance)
+{
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
-bool Multistate_Output_Valid_Instance(
+/**
+ * Creates a Multi-State Output object with an empty priority array
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Multistate_Output_Create(
     uint32_t object_instance)
 {
-    if (object_instance < MAX_MULTISTATE_OUTPUTS)
+    struct object_data *pObject;
+    unsigned j;
+
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
         return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    for (j = 0; j < BACNET_MAX_PRIORITY; j++) {
+        pObject->Priority_Array[j] = MULTISTATE_NULL;
+    }
+    pObject->Out_Of_Service = false;
 
-    return false;
+    Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_OUTPUT, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned Multistate_Output_Count(
-    void)
+/**
+ * Deletes a Multi-State Output object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Multistate_Output_Delete(
+    uint32_t object_instance)
 {
-    return MAX_MULTISTATE_OUTPUTS;
+    bool status = false;
+
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_OUTPUT,
+            object_instance);
+    }
+
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t Multistate_Output_Index_To_Instance(
-    unsigned index)
+/**
+ * Deletes all the Multi-State Output objects and their data
+ */
+void Multistate_Output_Cleanup(
+    void)
 {
-    return index;
+    Object_Store_Cleanup(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned Multistate_Output_Instance_To_Index(
-    uint32_t object_instance)
+/**
+ * Initializes the Multi-State Output objects
+ */
+void Multistate_Output_Init(
+    void)
 {
-    unsigned index = MAX_MULTISTATE_OUTPUTS;
+    unsigned i;
 
-    if (object_instance < MAX_MULTISTATE_OUTPUTS)
-        index = object_instance;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_MULTISTATE_OUTPUTS; i++) {
+            Multistate_Output_Create(i);
+        }
+    }
 
-    return index;
+    return;
 }
 
 uint32_t Multistate_Output_Present_Value(
     uint32_t object_instance)
 {
     uint32_t value = MULTISTATE_RELINQUISH_DEFAULT;
-    unsigned index = 0;
+    struct object_data *pObject;
     unsigned i = 0;
 
-    index = Multistate_Output_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_OUTPUTS) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         for (i = 0; i < BACNET_MAX_PRIORITY; i++) {
-            if (Multistate_Output_Level[index][i] != MULTISTATE_NULL) {
-                value = Multistate_Output_Level[index][i];
+            if (pObject->Priority_Array[i] != MULTISTATE_NULL) {
+                value = pObject->Priority_Array[i];
                 break;
             }
         }
@@ -184,10 +260,10 @@ bool Multistate_Output_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
 
-    if (object_instance < MAX_MULTISTATE_OUTPUTS) {
+    if (Multistate_Output_Valid_Instance(object_instance)) {
         sprintf(text_string, "MULTISTATE OUTPUT %u", object_instance);
         status = characterstring_init_ansi(object_name, text_string);
     }
@@ -198,12 +274,12 @@ bool Multistate_Output_Object_Name(
 bool Multistate_Output_Out_Of_Service(
     uint32_t instance)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
     bool oos_flag = false;
 
-    index = Multistate_Output_Instance_To_Index(instance);
-    if (index < MAX_MULTISTATE_OUTPUTS) {
-        oos_flag = Out_Of_Service[index];
+    pObject = Object_Store_Data(&Objects, instance);
+    if (pObject) {
+        oos_flag = pObject->Out_Of_Service;
     }
 
     return oos_flag;
@@ -213,11 +289,11 @@ void Multistate_Output_Out_Of_Service_Set(
     uint32_t instance,
     bool oos_flag)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Multistate_Output_Instance_To_Index(instance);
-    if (index < MAX_MULTISTATE_OUTPUTS) {
-        Out_Of_Service[index] = oos_flag;
+    pObject = Object_Store_Data(&Objects, instance);
+    if (pObject) {
+        pObject->Out_Of_Service = oos_flag;
     }
 }
 
@@ -230,7 +306,7 @@ int Multistate_Output_Read_Property(
     BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     uint32_t present_value = 0;
-    unsigned object_index = 0;
+    struct object_data *pObject;
     unsigned i = 0;
     bool state = false;
     uint8_t *apdu = NULL;
@@ -239,6 +315,12 @@ int Multistate_Output_Read_Property(
         (rpdata->application_data_len == 0)) {
         return 0;
     }
+    pObject = Object_Store_Data(&Objects, rpdata->object_instance);
+    if (!pObject) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return BACNET_STATUS_ERROR;
+    }
     apdu = rpdata->application_data;
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
@@ -292,17 +374,12 @@ int Multistate_Output_Read_Property(
             /* if no index was specified, then try to encode the entire list */
             /* into one packet. */
             else if (rpdata->array_index == BACNET_ARRAY_ALL) {
-                object_index =
-                    Multistate_Output_Instance_To_Index
-                    (rpdata->object_instance);
                 for (i = 0; i < BACNET_MAX_PRIORITY; i++) {
                     /* FIXME: check if we have room before adding it to APDU */
-                    if (Multistate_Output_Level[object_index][i] ==
-                        MULTISTATE_NULL)
+                    if (pObject->Priority_Array[i] == MULTISTATE_NULL)
                         len = encode_application_null(&apdu[apdu_len]);
                     else {
-                        present_value =
-                            Multistate_Output_Level[object_index][i];
+                        present_value = pObject->Priority_Array[i];
                         len =
                             encode_application_unsigned(&apdu[apdu_len],
                             present_value);
@@ -318,16 +395,13 @@ int Multistate_Output_Read_Property(
                     }
                 }
             } else {
-                object_index =
-                    Multistate_Output_Instance_To_Index
-                    (rpdata->object_instance);
                 if (rpdata->array_index <= BACNET_MAX_PRIORITY) {
-                    if (Multistate_Output_Level[object_index]
-                        [rpdata->array_index - 1] == MULTISTATE_NULL)
+                    if (pObject->Priority_Array[rpdata->array_index - 1] ==
+                        MULTISTATE_NULL)
                         apdu_len = encode_application_null(&apdu[0]);
                     else {
-                        present_value = Multistate_Output_Level[object_index]
-                            [rpdata->array_index - 1];
+                        present_value =
+                            pObject->Priority_Array[rpdata->array_index - 1];
                         apdu_len =
                             encode_application_unsigned(&apdu[0],
                             present_value);
@@ -373,12 +447,18 @@ bool Multistate_Output_Write_Property(
     BACNET_WRITE_PROPERTY_DATA * wp_data)
 {
     bool status = false;        /* return value */
-    unsigned int object_index = 0;
+    struct object_data *pObject;
     unsigned int priority = 0;
     uint32_t level = 0;
     int len = 0;
     BACNET_APPLICATION_DATA_VALUE value;
 
+    pObject = Object_Store_Data(&Objects, wp_data->object_instance);
+    if (!pObject) {
+        wp_data->error_class = ERROR_CLASS_OBJECT;
+        wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return false;
+    }
     /* decode the some of the request */
     len =
         bacapp_decode_application_data(wp_data->application_data,
@@ -410,11 +490,8 @@ bool Multistate_Output_Write_Property(
                     (value.type.Unsigned_Int > 0) &&
                     (value.type.Unsigned_Int <= MULTISTATE_NUMBER_OF_STATES)) {
                     level = value.type.Unsigned_Int;
-                    object_index =
-                        Multistate_Output_Instance_To_Index
-                        (wp_data->object_instance);
                     priority--;
-                    Multistate_Output_Level[object_index][priority] =
+                    pObject->Priority_Array[priority] =
                         (uint8_t) level;
                     /* Note: you could set the physical output here if we
                        are the highest priority.
@@ -438,13 +515,10 @@ bool Multistate_Output_Write_Property(
                     &wp_data->error_class, &wp_data->error_code);
                 if (status) {
                     level = MULTISTATE_NULL;
-                    object_index =
-                        Multistate_Output_Instance_To_Index
-                        (wp_data->object_instance);
                     priority = wp_data->priority;
                     if (priority && (priority <= BACNET_MAX_PRIORITY)) {
                         priority--;
-                        Multistate_Output_Level[object_index][priority] =
+                        pObject->Priority_Array[priority] =
                             (uint8_t) level;
                         /* Note: you could set the physical output here to the next
                            highest priority, or to the relinquish default if no
@@ -496,6 +570,14 @@ bool Multistate_Output_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -535,6 +617,16 @@ void testMultistateOutput(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, Multistate_Output_Create(65535));
+    ct_test(pTest, Multistate_Output_Count() == (MAX_MULTISTATE_OUTPUTS + 1));
+    ct_test(pTest,
+        Multistate_Output_Present_Value(65535) ==
+        MULTISTATE_RELINQUISH_DEFAULT);
+    ct_test(pTest, Multistate_Output_Delete(65535));
+    ct_test(pTest, !Multistate_Output_Valid_Instance(65535));
+    Multistate_Output_Cleanup();
+    ct_test(pTest, Multistate_Output_Count() == 0);
 
     return;
 }
@@ -53,6 +53,12 @@ extern "C" {
         uint32_t object_instance,
         BACNET_CHARACTER_STRING * object_name);
 
+    bool Multistate_Output_Create(
+        uint32_t object_instance);
+    bool Multistate_Output_Delete(
+        uint32_t object_instance);
+    void Multistate_Output_Cleanup(
+        void);
     void Multistate_Output_Init(
         void);
 
@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "bacenum.h"
@@ -37,8 +38,10 @@
 #include "wp.h"
 #include "msv.h"
 #include "handlers.h"
+#include "device.h"
+#include "objstore.h"
 
-/* number of demo objects */
+/* number of demo objects created by Multistate_Value_Init() */
 #ifndef MAX_MULTISTATE_VALUES
 #define MAX_MULTISTATE_VALUES 4
 #endif
@@ -48,18 +51,34 @@
 #define MULTISTATE_NUMBER_OF_STATES (254)
 #endif
 
-/* Here is our Present Value */
-static uint8_t Present_Value[MAX_MULTISTATE_VALUES];
-/* Writable out-of-service allows others to manipulate our Present Value */
-static bool Out_Of_Service[MAX_MULTISTATE_VALUES];
-/* Change of Value flag */
-static bool Change_Of_Value[MAX_MULTISTATE_VALUES];
-/* object name storage */
-static char Object_Name[MAX_MULTISTATE_VALUES][64];
-/* object description storage */
-static char Object_Description[MAX_MULTISTATE_VALUES][64];
-/* object state text storage */
-static char State_Text[MAX_MULTISTATE_VALUES][MULTISTATE_NUMBER_OF_STATES][64];
+struct object_data {
+    /* Here is our Present Value */
+    uint8_t Present_Value;
+    /* Writable out-of-service allows others to manipulate our Present Value */
+    bool Out_Of_Service;
+    /* Change of Value flag */
+    bool Change_Of_Value;
+    /* object name storage */
+    char Object_Name[64];
+    /* object description storage */
+    char Object_Description[64];
+    /* object state text storage - allocated when first written */
+    char (*State_Text)[64];
+};
+/* frees the state text of a deleted object */
+static void Multistate_Value_Free(
+    uint32_t object_instance,
+    void *data)
+{
+    struct object_data *pObject = data;
+
+    (void) object_instance;
+    free(pObject->State_Text);
+}
+
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(struct object_data), Multistate_Value_Free);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Properties_Required[] = {
@@ -99,74 +118,147 @@ void Multistate_Value_Property_Lists(
     return;
 }
 
-void Multistate_Value_Init(
-    void)
+/**
+ * Determines if a given Multi-State Value instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool Multistate_Value_Valid_Instance(
+    uint32_t object_instance)
 {
-    unsigned int i;
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
 
-    /* initialize all the analog output priority arrays to NULL */
-    for (i = 0; i < MAX_MULTISTATE_VALUES; i++) {
-        Present_Value[i] = 1;
-        sprintf(&Object_Name[i][0], "MULTISTATE VALUE %u", i);
-        sprintf(&Object_Description[i][0], "MULTISTATE VALUE %u", i);
-    }
+/**
+ * Determines the number of Multi-State Value objects
+ *
+ * @return  Number of Multi-State Value objects
+ */
+unsigned Multistate_Value_Count(
+    void)
+{
+    return Object_Store_Count(&Objects);
+}
 
-    return;
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of Multi-State Value objects where N is Multistate_Value_Count().
+ *
+ * @param  index - 0..N where N is Multistate_Value_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t Multistate_Value_Index_To_Instance(
+    unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of Multi-State Value objects where N is Multistate_Value_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or Multistate_Value_Count()
+ * if not valid.
+ */
 unsigned Multistate_Value_Instance_To_Index(
     uint32_t object_instance)
 {
-    unsigned index = MAX_MULTISTATE_VALUES;
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
+}
 
-    if (object_instance < MAX_MULTISTATE_VALUES)
-        index = object_instance;
+/**
+ * Creates a Multi-State Value object with default values
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool Multistate_Value_Create(
+    uint32_t object_instance)
+{
+    struct object_data *pObject;
 
-    return index;
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
+        return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    pObject->Present_Value = 1;
+    sprintf(pObject->Object_Name, "MULTISTATE VALUE %lu",
+        (unsigned long) object_instance);
+    sprintf(pObject->Object_Description, "MULTISTATE VALUE %lu",
+        (unsigned long) object_instance);
+    pObject->State_Text = NULL;
+
+    Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_VALUE, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t Multistate_Value_Index_To_Instance(
-    unsigned index)
+/**
+ * Deletes a Multi-State Value object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool Multistate_Value_Delete(
+    uint32_t object_instance)
 {
-    return index;
+    bool status = false;
+
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_VALUE,
+            object_instance);
+    }
+
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned Multistate_Value_Count(
+/**
+ * Deletes all the Multi-State Value objects and their data
+ */
+void Multistate_Value_Cleanup(
     void)
 {
-    return MAX_MULTISTATE_VALUES;
+    Object_Store_Cleanup(&Objects);
 }
 
-bool Multistate_Value_Valid_Instance(
-    uint32_t object_instance)
+/**
+ * Initializes the Multi-State Value objects
+ */
+void Multistate_Value_Init(
+    void)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    unsigned i;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        return true;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_MULTISTATE_VALUES; i++) {
+            Multistate_Value_Create(i);
+        }
     }
 
-    return false;
+    return;
 }
 
 uint32_t Multistate_Value_Present_Value(
     uint32_t object_instance)
 {
     uint32_t value = 1;
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        value = Present_Value[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Present_Value;
     }
 
     return value;
@@ -177,15 +269,17 @@ bool Multistate_Value_Present_Value_Set(
     uint32_t value)
 {
     bool status = false;
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         if ((value > 0) && (value <= MULTISTATE_NUMBER_OF_STATES)) {
-            if (Present_Value[index] != (uint8_t)value) {
-                Change_Of_Value[index] = true;
+            if (pObject->Present_Value != (uint8_t)value) {
+                pObject->Change_Of_Value = true;
+                handler_cov_object_changed(OBJECT_MULTI_STATE_VALUE,
+                    object_instance);
             }
-            Present_Value[index] = (uint8_t) value;
+            pObject->Present_Value = (uint8_t) value;
             status = true;
         }
     }
@@ -197,11 +291,11 @@ bool Multistate_Value_Out_Of_Service(
     uint32_t object_instance)
 {
     bool value = false;
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        value = Out_Of_Service[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = pObject->Out_Of_Service;
     }
 
     return value;
@@ -211,14 +305,15 @@ void Multistate_Value_Out_Of_Service_Set(
     uint32_t object_instance,
     bool value)
 {
-    unsigned index = 0;
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        if (Out_Of_Service[index] != value) {
-            Change_Of_Value[index] = true;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        if (pObject->Out_Of_Service != value) {
+            pObject->Change_Of_Value = true;
+            handler_cov_object_changed(OBJECT_MULTI_STATE_VALUE, object_instance);
         }
-        Out_Of_Service[index] = value;
+        pObject->Out_Of_Service = value;
     }
 
     return;
@@ -227,12 +322,12 @@ void Multistate_Value_Out_Of_Service_Set(
 char *Multistate_Value_Description(
     uint32_t object_instance)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     char *pName = NULL; /* return value */
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        pName = Object_Description[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pName = pObject->Object_Description;
     }
 
     return pName;
@@ -242,23 +337,23 @@ bool Multistate_Value_Description_Set(
     uint32_t object_instance,
     char *new_name)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         status = true;
         if (new_name) {
-            for (i = 0; i < sizeof(Object_Description[index]); i++) {
-                Object_Description[index][i] = new_name[i];
+            for (i = 0; i < sizeof(pObject->Object_Description); i++) {
+                pObject->Object_Description[i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
                 }
             }
         } else {
-            for (i = 0; i < sizeof(Object_Description[index]); i++) {
-                Object_Description[index][i] = 0;
+            for (i = 0; i < sizeof(pObject->Object_Description); i++) {
+                pObject->Object_Description[i] = 0;
             }
         }
     }
@@ -270,12 +365,12 @@ bool Multistate_Value_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     bool status = false;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        status = characterstring_init_ansi(object_name, Object_Name[index]);
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        status = characterstring_init_ansi(object_name, pObject->Object_Name);
     }
 
     return status;
@@ -286,28 +381,33 @@ bool Multistate_Value_Name_Set(
     uint32_t object_instance,
     char *new_name)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
         status = true;
         /* FIXME: check to see if there is a matching name */
         if (new_name) {
-            for (i = 0; i < sizeof(Object_Name[index]); i++) {
-                Object_Name[index][i] = new_name[i];
+            for (i = 0; i < sizeof(pObject->Object_Name); i++) {
+                pObject->Object_Name[i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
                 }
             }
         } else {
-            for (i = 0; i < sizeof(Object_Name[index]); i++) {
-                Object_Name[index][i] = 0;
+            for (i = 0; i < sizeof(pObject->Object_Name); i++) {
+                pObject->Object_Name[i] = 0;
             }
         }
     }
 
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_MULTI_STATE_VALUE,
+            object_instance);
+    }
+
     return status;
 }
 
@@ -315,14 +415,18 @@ char *Multistate_Value_State_Text(
     uint32_t object_instance,
     uint32_t state_index)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     char *pName = NULL; /* return value */
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if ((index < MAX_MULTISTATE_VALUES) && (state_index > 0) &&
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if ((pObject) && (state_index > 0) &&
         (state_index <= MULTISTATE_NUMBER_OF_STATES)) {
         state_index--;
-        pName = State_Text[index][state_index];
+        if (pObject->State_Text) {
+            pName = pObject->State_Text[state_index];
+        } else {
+            pName = "";
+        }
     }
 
     return pName;
@@ -334,41 +438,53 @@ bool Multistate_Value_State_Text_Set(
     uint32_t state_index,
     char *new_name)
 {
-    unsigned index = 0; /* offset from instance lookup */
+    struct object_data *pObject;
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if ((index < MAX_MULTISTATE_VALUES) && (state_index > 0) &&
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if ((pObject) && (state_index > 0) &&
         (state_index <= MULTISTATE_NUMBER_OF_STATES)) {
         state_index--;
+        if (!pObject->State_Text) {
+            if (!new_name) {
+                /* nothing stored yet - already empty */
+                return true;
+            }
+            pObject->State_Text =
+                calloc(MULTISTATE_NUMBER_OF_STATES,
+                sizeof(pObject->State_Text[0]));
+            if (!pObject->State_Text) {
+                return false;
+            }
+        }
         status = true;
         if (new_name) {
-            for (i = 0; i < sizeof(State_Text[index][state_index]); i++) {
-                State_Text[index][state_index][i] = new_name[i];
+            for (i = 0; i < sizeof(pObject->State_Text[state_index]); i++) {
+                pObject->State_Text[state_index][i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
                 }
             }
         } else {
-            for (i = 0; i < sizeof(State_Text[index][state_index]); i++) {
-                State_Text[index][state_index][i] = 0;
+            for (i = 0; i < sizeof(pObject->State_Text[state_index]); i++) {
+                pObject->State_Text[state_index][i] = 0;
             }
         }
     }
 
-    return status;;
+    return status;
 }
 
 bool Multistate_Value_Change_Of_Value(
     uint32_t object_instance)
 {
     bool status = false;
-    unsigned index;
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        status = Change_Of_Value[index];
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        status = pObject->Change_Of_Value;
     }
 
     return status;
@@ -377,11 +493,11 @@ bool Multistate_Value_Change_Of_Value(
 void Multistate_Value_Change_Of_Value_Clear(
     uint32_t object_instance)
 {
-    unsigned index;
+    struct object_data *pObject;
 
-    index = Multistate_Value_Instance_To_Index(object_instance);
-    if (index < MAX_MULTISTATE_VALUES) {
-        Change_Of_Value[index] = false;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        pObject->Change_Of_Value = false;
     }
 
     return;
@@ -651,6 +767,14 @@ bool Multistate_Value_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -665,6 +789,14 @@ bool WPValidateArgType(
     return false;
 }
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 void testMultistateInput(
     Test * pTest)
 {
@@ -690,6 +822,17 @@ void testMultistateInput(
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, Multistate_Value_Create(100000));
+    ct_test(pTest, Multistate_Value_Count() == (MAX_MULTISTATE_VALUES + 1));
+    ct_test(pTest, Multistate_Value_Present_Value(100000) == 1);
+    ct_test(pTest, strcmp(Multistate_Value_State_Text(100000, 1), "") == 0);
+    ct_test(pTest, Multistate_Value_State_Text_Set(100000, 1, "Off"));
+    ct_test(pTest, strcmp(Multistate_Value_State_Text(100000, 1), "Off") == 0);
+    ct_test(pTest, Multistate_Value_Delete(100000));
+    ct_test(pTest, Multistate_Value_State_Text(100000, 1) == NULL);
+    Multistate_Value_Cleanup();
+    ct_test(pTest, Multistate_Value_Count() == 0);
 
     return;
 }
@@ -104,6 +104,12 @@ extern "C" {
         uint32_t object_instance,
         uint32_t state_index);
 
+    bool Multistate_Value_Create(
+        uint32_t object_instance);
+    bool Multistate_Value_Delete(
+        uint32_t object_instance);
+    void Multistate_Value_Cleanup(
+        void);
     void Multistate_Value_Init(
         void);
 
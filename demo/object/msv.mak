@@ -18,6 +18,8 @@ SRCS = msv.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/lighting.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(TEST_DIR)/ctest.c
 
 TARGET = multistate_value
@@ -56,6 +56,23 @@
 #if defined(INTRINSIC_REPORTING)
 static NOTIFICATION_CLASS_INFO NC_Info[MAX_NOTIFICATION_CLASSES];
 
+/* The addresses of the recipients of each Notification Class, looked up
+   once and kept until the Recipient_List is written or the address
+   bindings change, so that an event costs one send per recipient. */
+typedef struct NC_Resolved_Recipient {
+    bool bound;
+    unsigned max_apdu;
+    BACNET_ADDRESS address;
+} NC_RESOLVED_RECIPIENT;
+
+typedef struct NC_Resolved_Info {
+    bool valid;
+    uint32_t address_revision;
+    NC_RESOLVED_RECIPIENT Recipient[NC_MAX_RECIPIENTS];
+} NC_RESOLVED_INFO;
+
+static NC_RESOLVED_INFO NC_Resolved[MAX_NOTIFICATION_CLASSES];
+
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Notification_Properties_Required[] = {
     PROP_OBJECT_IDENTIFIER,
@@ -104,6 +121,7 @@ void Notification_Class_Init(
         NC_Info[NotifyIdx].Priority[TRANSITION_TO_OFFNORMAL] = 255;     /* The lowest priority for Normal message. */
         NC_Info[NotifyIdx].Priority[TRANSITION_TO_FAULT] = 255; /* The lowest priority for Normal message. */
         NC_Info[NotifyIdx].Priority[TRANSITION_TO_NORMAL] = 255;        /* The lowest priority for Normal message. */
+        NC_Resolved[NotifyIdx].valid = false;
     }
 
     return;
@@ -160,7 +178,7 @@ bool Notification_Class_Object_Name(
     uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     unsigned int index;
     bool status = false;
 
@@ -757,6 +775,9 @@ bool Notification_Class_Write_Property(
                     /* address_bind_request(BACNET_MAX_INSTANCE, &max_apdu, &src); */
                 }
             }
+            /* the addresses are looked up again with the next event */
+            NC_Resolved[Notification_Class_Instance_To_Index(wp_data->
+                    object_instance)].valid = false;
 
             status = true;
 
@@ -846,12 +867,60 @@ static bool IsRecipientActive(
 }
 
 
+/* returns the addresses of the recipients of a Notification Class,
+   looking them up again only if the address bindings have changed */
+static NC_RESOLVED_INFO *Notification_Class_Resolved(
+    uint32_t notify_index)
+{
+    NOTIFICATION_CLASS_INFO *CurrentNotify = &NC_Info[notify_index];
+    NC_RESOLVED_INFO *Resolved = &NC_Resolved[notify_index];
+    NC_RESOLVED_RECIPIENT *pRecipient;
+    BACNET_DESTINATION *pBacDest;
+    uint32_t revision = address_revision();
+    uint32_t device_id;
+    uint8_t index;
+
+    if (Resolved->valid && (Resolved->address_revision == revision)) {
+        return Resolved;
+    }
+    pBacDest = &CurrentNotify->Recipient_List[0];
+    pRecipient = &Resolved->Recipient[0];
+    for (index = 0; index < NC_MAX_RECIPIENTS;
+        index++, pBacDest++, pRecipient++) {
+        pRecipient->bound = false;
+        if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
+            pRecipient->bound =
+                address_get_by_device(pBacDest->Recipient._.DeviceIdentifier,
+                &pRecipient->max_apdu, &pRecipient->address);
+        } else if (pBacDest->Recipient.RecipientType ==
+            RECIPIENT_TYPE_ADDRESS) {
+            pRecipient->address = pBacDest->Recipient._.Address;
+            pRecipient->max_apdu = MAX_APDU;
+            if (pBacDest->ConfirmedNotify == true) {
+                /* a confirmed request needs the device to be bound */
+                pRecipient->bound =
+                    address_get_device_id(&pRecipient->address, &device_id)
+                    && address_get_by_device(device_id,
+                    &pRecipient->max_apdu, &pRecipient->address);
+            } else {
+                pRecipient->bound = true;
+            }
+        }
+    }
+    Resolved->address_revision = revision;
+    Resolved->valid = true;
+
+    return Resolved;
+}
+
 void Notification_Class_common_reporting_function(
     BACNET_EVENT_NOTIFICATION_DATA * event_data)
 {
     /* Fill the parameters common for all types of events. */
 
     NOTIFICATION_CLASS_INFO *CurrentNotify;
+    NC_RESOLVED_INFO *Resolved;
+    NC_RESOLVED_RECIPIENT *pRecipient;
     BACNET_DESTINATION *pBacDest;
     uint32_t notify_index;
     uint8_t index;
@@ -904,43 +973,31 @@ void Notification_Class_common_reporting_function(
     }
 
     /* send notifications for active recipients */
+    Resolved = Notification_Class_Resolved(notify_index);
     /* pointer to first recipient */
     pBacDest = &CurrentNotify->Recipient_List[0];
-    for (index = 0; index < NC_MAX_RECIPIENTS; index++, pBacDest++) {
+    pRecipient = &Resolved->Recipient[0];
+    for (index = 0; index < NC_MAX_RECIPIENTS;
+        index++, pBacDest++, pRecipient++) {
         /* check if recipient is defined */
         if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_NOTINITIALIZED)
             break;      /* recipient doesn't defined - end of list */
 
-        if (IsRecipientActive(pBacDest, event_data->toState) == true) {
-            BACNET_ADDRESS dest;
-            uint32_t device_id;
-            unsigned max_apdu;
+        /* recipient address is not known yet */
+        if (!pRecipient->bound)
+            continue;
 
+        if (IsRecipientActive(pBacDest, event_data->toState) == true) {
             /* Process Identifier */
             event_data->processIdentifier = pBacDest->ProcessIdentifier;
 
-            /* send notification */
-            if (pBacDest->Recipient.RecipientType == RECIPIENT_TYPE_DEVICE) {
-                /* send notification to the specified device */
-                device_id = pBacDest->Recipient._.DeviceIdentifier;
-
-                if (pBacDest->ConfirmedNotify == true)
-                    Send_CEvent_Notify(device_id, event_data);
-                else if (address_get_by_device(device_id, &max_apdu, &dest))
-                    Send_UEvent_Notify(Handler_Transmit_Buffer, event_data,
-                        &dest);
-            } else if (pBacDest->Recipient.RecipientType ==
-                RECIPIENT_TYPE_ADDRESS) {
-                /* send notification to the address indicated */
-                if (pBacDest->ConfirmedNotify == true) {
-                    if (address_get_device_id(&dest, &device_id))
-                        Send_CEvent_Notify(device_id, event_data);
-                } else {
-                    dest = pBacDest->Recipient._.Address;
-                    Send_UEvent_Notify(Handler_Transmit_Buffer, event_data,
-                        &dest);
-                }
-            }
+            /* send notification to the device or address indicated */
+            if (pBacDest->ConfirmedNotify == true)
+                Send_CEvent_Notify_Address(&pRecipient->address,
+                    pRecipient->max_apdu, event_data);
+            else
+                Send_UEvent_Notify(Handler_Transmit_Buffer, event_data,
+                    &pRecipient->address);
         }
     }
 }
@@ -951,6 +1008,7 @@ void Notification_Class_find_recipient(
     void)
 {
     NOTIFICATION_CLASS_INFO *CurrentNotify;
+    NC_RESOLVED_INFO *Resolved;
     BACNET_DESTINATION *pBacDest;
     BACNET_ADDRESS src = { 0 };
     unsigned max_apdu = 0;
@@ -964,9 +1022,16 @@ void Notification_Class_find_recipient(
         /* pointer to current notification */
         CurrentNotify =
             &NC_Info[Notification_Class_Instance_To_Index(notify_index)];
+        /* only the devices not already bound need to be looked for */
+        Resolved =
+            Notification_Class_Resolved(Notification_Class_Instance_To_Index
+            (notify_index));
         /* pointer to first recipient */
         pBacDest = &CurrentNotify->Recipient_List[0];
         for (idx = 0; idx < NC_MAX_RECIPIENTS; idx++, pBacDest++) {
+            if (Resolved->Recipient[idx].bound) {
+                continue;
+            }
             if (CurrentNotify->Recipient_List[idx].Recipient.RecipientType ==
                 RECIPIENT_TYPE_DEVICE) {
                 /* Device ID */
@@ -302,6 +302,8 @@ bool Network_Port_Name_Set(
     index = Network_Port_Instance_To_Index(object_instance);
     if (index < BACNET_NETWORK_PORTS_MAX) {
         Object_List[index].Object_Name = new_name;
+        Device_Object_Name_Index_Update(OBJECT_NETWORK_PORT, object_instance);
+        status = true;
     }
 
     return status;
@@ -2456,6 +2458,14 @@ void Network_Port_Init(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
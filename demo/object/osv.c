@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "bacdef.h"
@@ -38,14 +39,17 @@
 #include "config.h"     /* the custom stuff */
 #include "device.h"
 #include "handlers.h"
+#include "objstore.h"
 #include "osv.h"
 
-
+/* number of demo objects created by OctetString_Value_Init() */
 #ifndef MAX_OCTETSTRING_VALUES
 #define MAX_OCTETSTRING_VALUES 4
 #endif
 
-OCTETSTRING_VALUE_DESCR AV_Descr[MAX_OCTETSTRING_VALUES];
+/* sparse store of object data, keyed by object instance */
+static OBJECT_STORE Objects =
+    OBJECT_STORE_INIT(sizeof(OCTETSTRING_VALUE_DESCR), NULL);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int OctetString_Value_Properties_Required[] = {
@@ -82,53 +86,123 @@ void OctetString_Value_Property_Lists(const int **pRequired,
     return;
 }
 
-void OctetString_Value_Init(void)
+/**
+ * Determines if a given OctetString Value instance is valid
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the instance exists
+ */
+bool OctetString_Value_Valid_Instance(uint32_t object_instance)
 {
-    unsigned i;
+    return Object_Store_Valid_Instance(&Objects, object_instance);
+}
 
-    for (i = 0; i < MAX_OCTETSTRING_VALUES; i++) {
-        memset(&AV_Descr[i], 0x00, sizeof(OCTETSTRING_VALUE_DESCR));
-        octetstring_init(&AV_Descr[i].Present_Value, NULL, 0);
-    }
+/**
+ * Determines the number of OctetString Value objects
+ *
+ * @return  Number of OctetString Value objects
+ */
+unsigned OctetString_Value_Count(void)
+{
+    return Object_Store_Count(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need validate that the */
-/* given instance exists */
-bool OctetString_Value_Valid_Instance(uint32_t object_instance)
+/**
+ * Determines the object instance-number for a given 0..N index
+ * of OctetString Value objects where N is OctetString_Value_Count().
+ *
+ * @param  index - 0..N where N is OctetString_Value_Count()
+ *
+ * @return  object instance-number for the given index
+ */
+uint32_t OctetString_Value_Index_To_Instance(unsigned index)
+{
+    return Object_Store_Index_To_Instance(&Objects, index);
+}
+
+/**
+ * For a given object instance-number, determines a 0..N index
+ * of OctetString Value objects where N is OctetString_Value_Count().
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  index for the given instance-number, or OctetString_Value_Count()
+ * if not valid.
+ */
+unsigned OctetString_Value_Instance_To_Index(uint32_t object_instance)
 {
-    if (object_instance < MAX_OCTETSTRING_VALUES)
+    return Object_Store_Instance_To_Index(&Objects, object_instance);
+}
+
+/**
+ * Creates a OctetString Value object with an empty present-value
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was created or already exists
+ */
+bool OctetString_Value_Create(uint32_t object_instance)
+{
+    OCTETSTRING_VALUE_DESCR *pObject;
+
+    if (Object_Store_Valid_Instance(&Objects, object_instance)) {
         return true;
+    }
+    pObject = Object_Store_Create(&Objects, object_instance);
+    if (!pObject) {
+        return false;
+    }
+    octetstring_init(&pObject->Present_Value, NULL, 0);
 
-    return false;
+    Device_Object_Name_Index_Update(OBJECT_OCTETSTRING_VALUE, object_instance);
+
+    return true;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then count how many you have */
-unsigned OctetString_Value_Count(void)
+/**
+ * Deletes a OctetString Value object
+ *
+ * @param  object_instance - object-instance number of the object
+ *
+ * @return  true if the object was deleted
+ */
+bool OctetString_Value_Delete(uint32_t object_instance)
 {
-    return MAX_OCTETSTRING_VALUES;
+    bool status = false;
+
+    status = Object_Store_Delete(&Objects, object_instance);
+    if (status) {
+        Device_Object_Name_Index_Update(OBJECT_OCTETSTRING_VALUE,
+            object_instance);
+    }
+
+    return status;
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the instance */
-/* that correlates to the correct index */
-uint32_t OctetString_Value_Index_To_Instance(unsigned index)
+/**
+ * Deletes all the OctetString Value objects and their data
+ */
+void OctetString_Value_Cleanup(void)
 {
-    return index;
+    Object_Store_Cleanup(&Objects);
 }
 
-/* we simply have 0-n object instances.  Yours might be */
-/* more complex, and then you need to return the index */
-/* that correlates to the correct instance number */
-unsigned OctetString_Value_Instance_To_Index(uint32_t object_instance)
+/**
+ * Initializes the OctetString Value objects
+ */
+void OctetString_Value_Init(void)
 {
-    unsigned index = MAX_OCTETSTRING_VALUES;
+    unsigned i;
 
-    if (object_instance < MAX_OCTETSTRING_VALUES)
-        index = object_instance;
+    if (Object_Store_Init(&Objects)) {
+        /* create the demo objects */
+        for (i = 0; i < MAX_OCTETSTRING_VALUES; i++) {
+            OctetString_Value_Create(i);
+        }
+    }
 
-    return index;
+    return;
 }
 
 /**
@@ -145,12 +219,12 @@ bool OctetString_Value_Present_Value_Set(uint32_t object_instance,
     BACNET_OCTET_STRING * value,
     uint8_t priority)
 {
-    unsigned index = 0;
+    OCTETSTRING_VALUE_DESCR *pObject;
     bool status = false;
 
-    index = OctetString_Value_Instance_To_Index(object_instance);
-    if (index < MAX_OCTETSTRING_VALUES) {
-        octetstring_copy(&AV_Descr[index].Present_Value, value);
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        octetstring_copy(&pObject->Present_Value, value);
         status = true;
     }
     return status;
@@ -159,11 +233,11 @@ bool OctetString_Value_Present_Value_Set(uint32_t object_instance,
 BACNET_OCTET_STRING *OctetString_Value_Present_Value(uint32_t object_instance)
 {
     BACNET_OCTET_STRING *value = NULL;
-    unsigned index = 0;
+    OCTETSTRING_VALUE_DESCR *pObject;
 
-    index = OctetString_Value_Instance_To_Index(object_instance);
-    if (index < MAX_OCTETSTRING_VALUES) {
-        value = &AV_Descr[index].Present_Value;
+    pObject = Object_Store_Data(&Objects, object_instance);
+    if (pObject) {
+        value = &pObject->Present_Value;
     }
 
     return value;
@@ -173,10 +247,10 @@ BACNET_OCTET_STRING *OctetString_Value_Present_Value(uint32_t object_instance)
 bool OctetString_Value_Object_Name(uint32_t object_instance,
     BACNET_CHARACTER_STRING * object_name)
 {
-    static char text_string[32] = "";   /* okay for single thread */
+    char text_string[32] = "";
     bool status = false;
 
-    if (object_instance < MAX_OCTETSTRING_VALUES) {
+    if (OctetString_Value_Valid_Instance(object_instance)) {
         sprintf(text_string, "OCTETSTRING VALUE %lu",
             (unsigned long) object_instance);
         status = characterstring_init_ansi(object_name, text_string);
@@ -192,7 +266,6 @@ int OctetString_Value_Read_Property(BACNET_READ_PROPERTY_DATA * rpdata)
     BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     BACNET_OCTET_STRING *real_value = NULL;
-    unsigned object_index = 0;
     bool state = false;
     uint8_t *apdu = NULL;
     OCTETSTRING_VALUE_DESCR *CurrentAV;
@@ -204,12 +277,12 @@ int OctetString_Value_Read_Property(BACNET_READ_PROPERTY_DATA * rpdata)
 
     apdu = rpdata->application_data;
 
-    object_index =
-        OctetString_Value_Instance_To_Index(rpdata->object_instance);
-    if (object_index < MAX_OCTETSTRING_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else
+    CurrentAV = Object_Store_Data(&Objects, rpdata->object_instance);
+    if (!CurrentAV) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return BACNET_STATUS_ERROR;
+    }
 
     switch (rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
@@ -280,7 +353,6 @@ int OctetString_Value_Read_Property(BACNET_READ_PROPERTY_DATA * rpdata)
 bool OctetString_Value_Write_Property(BACNET_WRITE_PROPERTY_DATA * wp_data)
 {
     bool status = false;        /* return value */
-    unsigned int object_index = 0;
     int len = 0;
     BACNET_APPLICATION_DATA_VALUE value;
     OCTETSTRING_VALUE_DESCR *CurrentAV;
@@ -304,12 +376,12 @@ bool OctetString_Value_Write_Property(BACNET_WRITE_PROPERTY_DATA * wp_data)
         wp_data->error_code = ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY;
         return false;
     }
-    object_index =
-        OctetString_Value_Instance_To_Index(wp_data->object_instance);
-    if (object_index < MAX_OCTETSTRING_VALUES)
-        CurrentAV = &AV_Descr[object_index];
-    else
+    CurrentAV = Object_Store_Data(&Objects, wp_data->object_instance);
+    if (!CurrentAV) {
+        wp_data->error_class = ERROR_CLASS_OBJECT;
+        wp_data->error_code = ERROR_CODE_UNKNOWN_OBJECT;
         return false;
+    }
 
     switch (wp_data->object_property) {
         case PROP_PRESENT_VALUE:
@@ -375,6 +447,14 @@ void OctetString_Value_Intrinsic_Reporting(uint32_t object_instance)
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 bool WPValidateArgType(BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
     BACNET_ERROR_CLASS * pErrorClass,
@@ -412,6 +492,14 @@ void testOctetString_Value(Test * pTest)
     len = decode_object_id(&apdu[len], &decoded_type, &decoded_instance);
     ct_test(pTest, decoded_type == rpdata.object_type);
     ct_test(pTest, decoded_instance == rpdata.object_instance);
+    /* sparse instances */
+    ct_test(pTest, OctetString_Value_Create(1000000));
+    ct_test(pTest, OctetString_Value_Count() == (MAX_OCTETSTRING_VALUES + 1));
+    ct_test(pTest, OctetString_Value_Present_Value(1000000) != NULL);
+    ct_test(pTest, OctetString_Value_Delete(1000000));
+    ct_test(pTest, OctetString_Value_Present_Value(1000000) == NULL);
+    OctetString_Value_Cleanup();
+    ct_test(pTest, OctetString_Value_Count() == 0);
 
     return;
 }
@@ -82,6 +82,9 @@ extern "C" {
        even when INTRINSIC_REPORTING is not defined */
     void OctetString_Value_Intrinsic_Reporting(uint32_t object_instance);
 
+    bool OctetString_Value_Create(uint32_t object_instance);
+    bool OctetString_Value_Delete(uint32_t object_instance);
+    void OctetString_Value_Cleanup(void);
     void OctetString_Value_Init(void);
 
 #ifdef TEST
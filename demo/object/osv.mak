@@ -19,6 +19,8 @@ SRCS = osv.c \
 	$(SRC_DIR)/bacapp.c \
 	$(SRC_DIR)/bactext.c \
 	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/objstore.c \
+	$(SRC_DIR)/keylist.c \
 	$(TEST_DIR)/ctest.c
 
 TARGET = octetstring_value
@@ -467,11 +467,12 @@ static void Wait_For_Answer_Or_Timeout(
 
         if (action == waitAnswer) {
             /* Response was received. Exit. */
-            if (tsm_invoke_id_free(Request_Invoke_ID)) {
+            if (tsm_peer_invoke_id_free(&Target_Address, Request_Invoke_ID)) {
                 break;
-            } else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+            } else if (tsm_peer_invoke_id_failed(&Target_Address,
+                Request_Invoke_ID)) {
                 LogError("TSM Timeout!");
-                tsm_free_invoke_id(Request_Invoke_ID);
+                tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                 break;
             }
         } else if (action == waitBind) {
@@ -837,6 +837,20 @@ bool Device_Valid_Object_Name(
     return found;
 }
 
+/** Called by the objects when their names change.  Names are looked up
+ * in every object here, so there is no index to update.
+ * @param object_type [in] The BACNET_OBJECT_TYPE of the changed Object.
+ * @param object_instance [in] The object instance number of the changed
+ *  Object.
+ */
+void Device_Object_Name_Index_Update(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
 /** Determine if we have an object of this type and instance number.
  * @param object_type [in] The desired BACNET_OBJECT_TYPE
  * @param object_instance [in] The object instance number to be looked up.
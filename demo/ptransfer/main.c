@@ -349,7 +349,8 @@ int main(
 
                             break;
                     }
-                } else if (tsm_invoke_id_free(invoke_id)) {
+                } else if (tsm_peer_invoke_id_free(&Target_Address,
+                    invoke_id)) {
                     if (iCount != MY_MAX_BLOCK) {
                         iCount++;
                         invoke_id = 0;
@@ -361,9 +362,10 @@ int main(
                         if (iType > 2)
                             break;
                     }
-                } else if (tsm_invoke_id_failed(invoke_id)) {
+                } else if (tsm_peer_invoke_id_failed(&Target_Address,
+                    invoke_id)) {
                     fprintf(stderr, "\rError: TSM Timeout!\r\n");
-                    tsm_free_invoke_id(invoke_id);
+                    tsm_free_peer_invoke_id(&Target_Address, invoke_id);
                     Error_Detected = true;
                     /* try again or abort? */
                     break;
@@ -174,7 +174,7 @@ static void AtomicReadFileAckHandler(
 static void LocalIAmHandler(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     uint32_t device_id = 0;
@@ -182,13 +182,13 @@ static void LocalIAmHandler(
     int segmentation = 0;
     uint16_t vendor_id = 0;
 
-    (void) src;
+    (void) context;
     (void) service_len;
     len =
         iam_decode_service_request(service_request, &device_id, &max_apdu,
         &segmentation, &vendor_id);
     if (len != -1) {
-        address_add(device_id, max_apdu, src);
+        address_add(device_id, max_apdu, context->src);
     } else
         fprintf(stderr, "!\n");
 
@@ -368,7 +368,8 @@ int main(
             }
             /* has the previous invoke id expired or returned?
                note: invoke ID = 0 is invalid, so it will be idle */
-            if ((invoke_id == 0) || tsm_invoke_id_free(invoke_id)) {
+            if ((invoke_id == 0) || tsm_peer_invoke_id_free(&Target_Address,
+                invoke_id)) {
                 if (End_Of_File_Detected || Error_Detected) {
                     break;
                 }
@@ -380,9 +381,9 @@ int main(
                     Target_File_Object_Instance, Target_File_Start_Position,
                     Target_File_Requested_Octet_Count);
                 Request_Invoke_ID = invoke_id;
-            } else if (tsm_invoke_id_failed(invoke_id)) {
+            } else if (tsm_peer_invoke_id_failed(&Target_Address, invoke_id)) {
                 fprintf(stderr, "\rError: TSM Timeout!\n");
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(&Target_Address, invoke_id);
                 /* try again or abort? */
                 Error_Detected = true;
                 break;
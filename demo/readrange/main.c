@@ -361,11 +361,13 @@ int main(
                 Request_Invoke_ID = Send_ReadRange_Request(
                     Target_Device_Object_Instance,
                     &RR_Request);
-            } else if (tsm_invoke_id_free(Request_Invoke_ID))
+            } else if (tsm_peer_invoke_id_free(&Target_Address,
+                Request_Invoke_ID))
                 break;
-            else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+            else if (tsm_peer_invoke_id_failed(&Target_Address,
+                Request_Invoke_ID)) {
                 fprintf(stderr, "\rError: TSM Timeout!\n");
-                tsm_free_invoke_id(Request_Invoke_ID);
+                tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                 Error_Detected = true;
                 /* try again or abort? */
                 break;
@@ -47,6 +47,7 @@
 #include "address.h"
 #include "npdu.h"
 #include "apdu.h"
+#include "handlers.h"
 #include "client.h"
 #include "net.h"
 #include "version.h"
@@ -1004,6 +1005,7 @@ static void my_routing_npdu_handler(
     int apdu_offset = 0;
     BACNET_ADDRESS dest = { 0 };
     BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_REQUEST_CONTEXT context;
 
     if (!pdu) {
         /* no packet */
@@ -1040,7 +1042,8 @@ static void my_routing_npdu_handler(
                     /* add a Device object and application layer */
                     if ((dest.net == 0) ||
                         (dest.net == BACNET_BROADCAST_NETWORK)) {
-                        apdu_handler(src, &pdu[apdu_offset],
+                        handler_context_init(&context, src);
+                        apdu_handler(&context, &pdu[apdu_offset],
                         (uint16_t) (pdu_len - apdu_offset));
                     }
                 }
@@ -0,0 +1,316 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+
+/* command line tool that measures how many ReadProperty requests
+   a BACnet/IP device answers each second */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "config.h"
+#include "bacdef.h"
+#include "bacdcode.h"
+#include "bacenum.h"
+#include "npdu.h"
+#include "rp.h"
+#include "bip.h"
+#include "version.h"
+/* some demo stuff needed */
+#include "filename.h"
+
+/** @file rpbench/main.c  ReadProperty load generator.
+ *
+ * Each client socket keeps a window of requests outstanding, and sends
+ * a new request for each reply.  Since a server with several workers
+ * spreads the requests by their source address and port, many sockets
+ * are used, like the many clients of a busy gateway.
+ */
+
+/* most client sockets */
+#define RPBENCH_SOCKETS_MAX 256
+/* milliseconds without a reply after which a window is sent again */
+#define RPBENCH_TIMEOUT 1000
+
+struct rpbench_client {
+    int fd;
+    uint8_t invoke_id;
+    unsigned outstanding;
+    uint64_t last_reply;
+};
+
+static struct rpbench_client Client[RPBENCH_SOCKETS_MAX];
+static struct pollfd Client_Poll[RPBENCH_SOCKETS_MAX];
+static struct sockaddr_in Target_Address;
+static uint32_t Target_Device_Instance;
+static BACNET_PROPERTY_ID Target_Property = PROP_OBJECT_NAME;
+static unsigned long Replies;
+static unsigned long Errors;
+static unsigned long Timeouts;
+
+static uint64_t rpbench_milliseconds(
+    void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+/* sends one ReadProperty request from a client socket */
+static void rpbench_send(
+    struct rpbench_client *client)
+{
+    uint8_t mtu[MAX_MPDU] = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    int len = 4;
+
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    len += npdu_encode_pdu(&mtu[len], &dest, NULL, &npdu_data);
+    rpdata.object_type = OBJECT_DEVICE;
+    rpdata.object_instance = Target_Device_Instance;
+    rpdata.object_property = Target_Property;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    len += rp_encode_apdu(&mtu[len], client->invoke_id++, &rpdata);
+    mtu[0] = BVLL_TYPE_BACNET_IP;
+    mtu[1] = BVLC_ORIGINAL_UNICAST_NPDU;
+    (void) encode_unsigned16(&mtu[2], (uint16_t) len);
+    if (sendto(client->fd, (char *) mtu, len, 0,
+            (struct sockaddr *) &Target_Address,
+            sizeof(Target_Address)) == len) {
+        client->outstanding++;
+    }
+}
+
+/* counts the replies waiting on a client socket, and sends a request
+   in place of each of them */
+static void rpbench_receive(
+    struct rpbench_client *client,
+    uint64_t now)
+{
+    uint8_t mtu[MAX_MPDU] = { 0 };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    ssize_t mtu_len = 0;
+    int apdu_offset = 0;
+
+    for (;;) {
+        mtu_len = recv(client->fd, (char *) mtu, sizeof(mtu), MSG_DONTWAIT);
+        if (mtu_len <= 4) {
+            break;
+        }
+        if ((mtu[0] != BVLL_TYPE_BACNET_IP) ||
+            (mtu[4] != BACNET_PROTOCOL_VERSION)) {
+            continue;
+        }
+        apdu_offset = npdu_decode(&mtu[4], &dest, &src, &npdu_data);
+        if ((apdu_offset <= 0) || ((4 + apdu_offset) >= mtu_len)) {
+            continue;
+        }
+        if ((mtu[4 + apdu_offset] & 0xF0) == PDU_TYPE_COMPLEX_ACK) {
+            Replies++;
+        } else {
+            Errors++;
+        }
+        client->last_reply = now;
+        if (client->outstanding) {
+            client->outstanding--;
+        }
+        rpbench_send(client);
+    }
+}
+
+static void print_usage(
+    const char *filename)
+{
+    printf("Usage: %s device-instance IP[:port]\n", filename);
+    printf("       [--seconds S][--sockets N][--window W][--property P]\n");
+    printf("       [--version][--help]\n");
+}
+
+static void print_help(
+    const char *filename)
+{
+    printf("Send ReadProperty requests to a BACnet/IP device as fast as\n"
+        "it answers them, and print the replies each second.\n"
+        "\n"
+        "device-instance:\n"
+        "Device Object Instance number of the device, whose Device\n"
+        "object is read.\n"
+        "IP[:port]:\n"
+        "Unicast IP address of the device; the port is 47808 by default.\n"
+        "--seconds S\n"
+        "Seconds to run for.  Default is 10.\n"
+        "--sockets N\n"
+        "Client sockets, each with its own port.  Default is 64.\n"
+        "--window W\n"
+        "Requests outstanding on each socket.  Default is 4.\n"
+        "--property P\n"
+        "Property of the Device object to read.  Default is 77,\n"
+        "the Object_Name.\n"
+        "\nExample:\n"
+        "%s 1234 192.168.0.10 --seconds 5\n", filename);
+}
+
+int main(
+    int argc,
+    char *argv[])
+{
+    unsigned seconds = 10;
+    unsigned sockets = 64;
+    unsigned window = 4;
+    unsigned i = 0;
+    unsigned w = 0;
+    int argi = 0;
+    int target_args = 0;
+    char *port = NULL;
+    const char *filename = NULL;
+    uint64_t start = 0;
+    uint64_t now = 0;
+    uint64_t elapsed = 0;
+    unsigned long replies_last = 0;
+
+    filename = filename_remove_path(argv[0]);
+    Target_Address.sin_family = AF_INET;
+    Target_Address.sin_port = htons(0xBAC0);
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--help") == 0) {
+            print_usage(filename);
+            print_help(filename);
+            return 0;
+        } else if (strcmp(argv[argi], "--version") == 0) {
+            printf("%s %s\n", filename, BACNET_VERSION_TEXT);
+            printf("Copyright (C) 2018 by Steve Karg and others.\n"
+                "This is free software; see the source for copying conditions.\n"
+                "There is NO warranty; not even for MERCHANTABILITY or\n"
+                "FITNESS FOR A PARTICULAR PURPOSE.\n");
+            return 0;
+        } else if ((strcmp(argv[argi], "--seconds") == 0) &&
+            (++argi < argc)) {
+            seconds = strtoul(argv[argi], NULL, 0);
+        } else if ((strcmp(argv[argi], "--sockets") == 0) &&
+            (++argi < argc)) {
+            sockets = strtoul(argv[argi], NULL, 0);
+        } else if ((strcmp(argv[argi], "--window") == 0) &&
+            (++argi < argc)) {
+            window = strtoul(argv[argi], NULL, 0);
+        } else if ((strcmp(argv[argi], "--property") == 0) &&
+            (++argi < argc)) {
+            Target_Property = (BACNET_PROPERTY_ID) strtoul(argv[argi], NULL, 0);
+        } else if (target_args == 0) {
+            Target_Device_Instance = strtoul(argv[argi], NULL, 0);
+            target_args++;
+        } else if (target_args == 1) {
+            port = strchr(argv[argi], ':');
+            if (port) {
+                *port = 0;
+                Target_Address.sin_port = htons(strtoul(port + 1, NULL, 0));
+            }
+            if (inet_pton(AF_INET, argv[argi], &Target_Address.sin_addr) != 1) {
+                fprintf(stderr, "%s: invalid IP address\n", argv[argi]);
+                return 1;
+            }
+            target_args++;
+        }
+    }
+    if (target_args < 2) {
+        print_usage(filename);
+        return 0;
+    }
+    if (Target_Device_Instance > BACNET_MAX_INSTANCE) {
+        fprintf(stderr, "device-instance=%u - it must be less than %u\n",
+            Target_Device_Instance, BACNET_MAX_INSTANCE);
+        return 1;
+    }
+    if ((sockets == 0) || (sockets > RPBENCH_SOCKETS_MAX)) {
+        sockets = RPBENCH_SOCKETS_MAX;
+    }
+    if (window == 0) {
+        window = 1;
+    }
+    for (i = 0; i < sockets; i++) {
+        Client[i].fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (Client[i].fd < 0) {
+            fprintf(stderr, "socket: %s\n", strerror(errno));
+            return 1;
+        }
+        Client_Poll[i].fd = Client[i].fd;
+        Client_Poll[i].events = POLLIN;
+    }
+    start = rpbench_milliseconds();
+    for (i = 0; i < sockets; i++) {
+        Client[i].last_reply = start;
+        for (w = 0; w < window; w++) {
+            rpbench_send(&Client[i]);
+        }
+    }
+    printf("second  replies/s\n");
+    for (;;) {
+        (void) poll(Client_Poll, sockets, 100);
+        now = rpbench_milliseconds();
+        for (i = 0; i < sockets; i++) {
+            if (Client_Poll[i].revents & POLLIN) {
+                rpbench_receive(&Client[i], now);
+            } else if ((now - Client[i].last_reply) > RPBENCH_TIMEOUT) {
+                /* the window was lost: start it again */
+                Timeouts += Client[i].outstanding;
+                Client[i].outstanding = 0;
+                Client[i].last_reply = now;
+                for (w = 0; w < window; w++) {
+                    rpbench_send(&Client[i]);
+                }
+            }
+        }
+        if ((now - start) >= ((elapsed + 1) * 1000)) {
+            elapsed++;
+            printf("%6lu  %lu\n", (unsigned long) elapsed,
+                Replies - replies_last);
+            replies_last = Replies;
+            fflush(stdout);
+            if (elapsed >= seconds) {
+                break;
+            }
+        }
+    }
+    printf("replies=%lu errors=%lu timeouts=%lu rate=%lu RP/s\n", Replies,
+        Errors, Timeouts, (unsigned long) (Replies / elapsed));
+    for (i = 0; i < sockets; i++) {
+        close(Client[i].fd);
+    }
+
+    return 0;
+}
@@ -53,14 +53,13 @@
 #include "client.h"
 #include "txbuf.h"
 #include "dlenv.h"
+#include "cov_client.h"
 
 /* buffer used for receive */
 static uint8_t Rx_Buf[MAX_MPDU] = { 0 };
 
 /* converted command line arguments */
 static uint32_t Target_Device_Object_Instance = BACNET_MAX_INSTANCE;
-/* Process identifier for matching replies */
-static uint32_t Target_Device_Process_Identifier = 0;
 /* the invoke id is needed to filter incoming messages */
 static uint8_t Request_Invoke_ID = 0;
 /* MAC and SNET address of target */
@@ -69,9 +68,8 @@ static BACNET_ADDRESS Target_Address;
 static bool Error_Detected = false;
 /* data used in COV subscription request */
 BACNET_SUBSCRIBE_COV_DATA *COV_Subscribe_Data = NULL;
-/* flags to signal early termination */
+/* flag to signal early termination */
 static bool Simple_Ack_Detected = false;
-static bool Cancel_Requested = false;
 
 static void MyErrorHandler(
     BACNET_ADDRESS * src,
@@ -116,21 +114,49 @@ void MyRejectHandler(
     }
 }
 
-void My_Unconfirmed_COV_Notification_Handler(
-    uint8_t * service_request,
-    uint16_t service_len,
-    BACNET_ADDRESS * src)
+/* prints the values of a subscribed object, as notified or polled */
+static void My_COV_Value_Handler(
+    uint32_t device_id,
+    BACNET_OBJECT_ID * object_id,
+    BACNET_PROPERTY_VALUE * values,
+    void *context)
 {
-    handler_ucov_notification(service_request, service_len, src);
-}
+    BACNET_OBJECT_PROPERTY_VALUE object_value;
+    BACNET_APPLICATION_DATA_VALUE *value = NULL;
 
-void My_Confirmed_COV_Notification_Handler(
-    uint8_t * service_request,
-    uint16_t service_len,
-    BACNET_ADDRESS * src,
-    BACNET_CONFIRMED_SERVICE_DATA * service_data)
-{
-    handler_ccov_notification(service_request, service_len, src, service_data);
+    (void) context;
+    printf("COV: device %lu %s %lu\r\n", (unsigned long) device_id,
+        bactext_object_type_name(object_id->type),
+        (unsigned long) object_id->instance);
+    while (values) {
+        if (values->propertyIdentifier < 512) {
+            printf("COV: %s",
+                bactext_property_name(values->propertyIdentifier));
+        } else {
+            printf("COV: proprietary %u", values->propertyIdentifier);
+        }
+        if (values->propertyArrayIndex != BACNET_ARRAY_ALL) {
+            printf("[%u]", values->propertyArrayIndex);
+        }
+        printf(": ");
+        object_value.object_type = (BACNET_OBJECT_TYPE) object_id->type;
+        object_value.object_instance = object_id->instance;
+        object_value.object_property =
+            (BACNET_PROPERTY_ID) values->propertyIdentifier;
+        object_value.array_index = values->propertyArrayIndex;
+        value = &values->value;
+        while (value) {
+            object_value.value = value;
+            bacapp_print_value(stdout, &object_value);
+            value = value->next;
+            if (value) {
+                printf(",");
+            }
+        }
+        printf("\r\n");
+        values = values->next;
+    }
+    fflush(stdout);
 }
 
 void MyWritePropertySimpleAckHandler(
@@ -160,12 +186,9 @@ static void Init_Service_Handlers(
     /* we must implement read property - it's required! */
     apdu_set_confirmed_handler(SERVICE_CONFIRMED_READ_PROPERTY,
         handler_read_property);
-    /* handle the data coming back from COV subscriptions */
-    apdu_set_confirmed_handler(SERVICE_CONFIRMED_COV_NOTIFICATION,
-        My_Confirmed_COV_Notification_Handler);
-    apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_COV_NOTIFICATION,
-        My_Unconfirmed_COV_Notification_Handler);
-    /* handle the Simple ack coming back from SubscribeCOV */
+    /* handle the Simple ack coming back from a cancellation; the COV
+       client sets up the handlers for the notifications and for the
+       replies to the subscriptions, passing on the rest to these */
     apdu_set_confirmed_simple_ack_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
         MyWritePropertySimpleAckHandler);
     /* handle any errors coming back */
@@ -208,6 +231,7 @@ int main(
     bool print_usage_terse = false;
     bool print_usage_verbose = false;
     BACNET_SUBSCRIBE_COV_DATA *cov_data = NULL;
+    BACNET_SUBSCRIBE_COV_DATA *subscribe_data = NULL;
     int argi = 0;
     int arg_remaining = 0;
 
@@ -241,7 +265,11 @@ int main(
             "Optional flag to subscribe using Confirmed notifications.\r\n"
             "Use the word \'confirmed\' or \'unconfirmed\'.\r\n" "\r\n"
             "lifetime:\r\n"
-            "Optional subscription lifetime is conveyed in seconds.\r\n" "\r\n"
+            "Optional subscription lifetime is conveyed in seconds.\r\n"
+            "The subscription is renewed until the longest lifetime\r\n"
+            "has passed, and an object that does not support COV has\r\n"
+            "its Present_Value polled instead.  All of the subscriptions\r\n"
+            "must use the same process-id.\r\n" "\r\n"
             "cancel:\r\n"
             "Use the word \'cancel\' instead of confirm and lifetime.\r\n"
             "This shall indicate a cancellation request.\r\n" "\r\n"
@@ -319,6 +347,22 @@ int main(
             cov_data = cov_data->next;
         }
     }
+    /* the COV client subscribes with one process identifier */
+    for (cov_data = COV_Subscribe_Data; cov_data; cov_data = cov_data->next) {
+        if (cov_data->cancellationRequest) {
+            continue;
+        }
+        if (!subscribe_data) {
+            subscribe_data = cov_data;
+        } else if (cov_data->subscriberProcessIdentifier !=
+            subscribe_data->subscriberProcessIdentifier) {
+            fprintf(stderr, "process-id=%u - subscriptions must share "
+                "the process-id %u\r\n",
+                cov_data->subscriberProcessIdentifier,
+                subscribe_data->subscriberProcessIdentifier);
+            return 1;
+        }
+    }
     /* setup my info */
     Device_Set_Object_Instance_Number(BACNET_MAX_INSTANCE);
     address_init();
@@ -328,6 +372,32 @@ int main(
     /* configure the timeout values */
     last_seconds = time(NULL);
     timeout_seconds = (apdu_timeout() / 1000) * apdu_retries();
+    /* the COV client binds, subscribes and renews the subscriptions,
+       and polls the objects that do not support COV */
+    if (subscribe_data) {
+        cov_client_init(subscribe_data->subscriberProcessIdentifier);
+    }
+    for (cov_data = COV_Subscribe_Data; cov_data; cov_data = cov_data->next) {
+        if (cov_data->cancellationRequest) {
+            continue;
+        }
+        if (!cov_client_subscribe(Target_Device_Object_Instance,
+                (BACNET_OBJECT_TYPE) cov_data->monitoredObjectIdentifier.
+                type, cov_data->monitoredObjectIdentifier.instance,
+                cov_data->issueConfirmedNotifications, cov_data->lifetime,
+                My_COV_Value_Handler, NULL)) {
+            fprintf(stderr, "Error: no room to subscribe!\r\n");
+            return 1;
+        }
+        if (timeout_seconds < cov_data->lifetime) {
+            /* increase the timeout to the longest lifetime */
+            timeout_seconds = cov_data->lifetime;
+        }
+    }
+    if (subscribe_data) {
+        printf("Subscribing. Waiting up to %u seconds....\r\n",
+            (unsigned) timeout_seconds);
+    }
     /* try to bind with the device */
     found =
         address_bind_request(Target_Device_Object_Instance, &max_apdu,
@@ -336,8 +406,11 @@ int main(
         Send_WhoIs(Target_Device_Object_Instance,
             Target_Device_Object_Instance);
     }
-    /* start at the beginning of the subscribe list */
+    /* the cancellations are sent one at a time */
     cov_data = COV_Subscribe_Data;
+    while (cov_data && !cov_data->cancellationRequest) {
+        cov_data = cov_data->next;
+    }
     /* loop forever */
     for (;;) {
         /* increment timer - exit if timed out */
@@ -348,12 +421,18 @@ int main(
             delta_seconds = current_seconds - last_seconds;
             elapsed_seconds += delta_seconds;
             tsm_timer_milliseconds((delta_seconds * 1000));
+            if (subscribe_data) {
+                cov_client_timer_seconds((uint32_t) delta_seconds);
+            }
             /* keep track of time for next check */
             last_seconds = current_seconds;
         }
         if (Error_Detected) {
             break;
         }
+        if (subscribe_data) {
+            cov_client_task();
+        }
         /* wait until the device is bound, or timeout and quit */
         if (!found) {
             found =
@@ -361,38 +440,33 @@ int main(
                 &Target_Address);
         }
         if (found) {
-            if (Request_Invoke_ID == 0) {
-                Simple_Ack_Detected = false;
-                if (cov_data->cancellationRequest) {
-                    Cancel_Requested = true;
-                } else {
-                    Cancel_Requested = false;
+            if (!cov_data) {
+                /* all of the cancellations are done */
+                if (!subscribe_data) {
+                    break;
                 }
-                Target_Device_Process_Identifier =
-                    cov_data->subscriberProcessIdentifier;
+            } else if (Request_Invoke_ID == 0) {
+                Simple_Ack_Detected = false;
                 Request_Invoke_ID =
                     Send_COV_Subscribe(Target_Device_Object_Instance,
                     cov_data);
-                if (!cov_data->cancellationRequest &&
-                    (timeout_seconds < cov_data->lifetime)) {
-                    /* increase the timeout to the longest lifetime */
-                    timeout_seconds = cov_data->lifetime;
-                }
-                printf("Sent SubscribeCOV request. "
+                printf("Sent SubscribeCOV cancellation. "
                     " Waiting up to %u seconds....\r\n",
                     (unsigned) (timeout_seconds - elapsed_seconds));
-            } else if (tsm_invoke_id_free(Request_Invoke_ID)) {
-                if (cov_data->next) {
-                    cov_data = cov_data->next;
-                    Request_Invoke_ID = 0;
-                } else {
-                    if (Cancel_Requested && Simple_Ack_Detected) {
-                        break;
-                    }
+            } else if (tsm_peer_invoke_id_free(&Target_Address,
+                    Request_Invoke_ID)) {
+                if (!Simple_Ack_Detected) {
+                    Error_Detected = true;
+                    break;
                 }
-            } else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+                do {
+                    cov_data = cov_data->next;
+                } while (cov_data && !cov_data->cancellationRequest);
+                Request_Invoke_ID = 0;
+            } else if (tsm_peer_invoke_id_failed(&Target_Address,
+                    Request_Invoke_ID)) {
                 fprintf(stderr, "\rError: TSM Timeout!\r\n");
-                tsm_free_invoke_id(Request_Invoke_ID);
+                tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                 Error_Detected = true;
                 break;
             }
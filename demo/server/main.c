@@ -63,6 +63,13 @@
 #if defined(BAC_UCI)
 #include "ucix.h"
 #endif /* defined(BAC_UCI) */
+/* on Linux, the BACnet/IP server sleeps in an event loop until a
+   datagram arrives or a timer is due */
+#if defined(__linux__) && defined(BACDL_BIP)
+#define SERVER_EVLOOP 1
+#include "evloop.h"
+#include "bip-workers.h"
+#endif
 
 
 /** @file server/main.c  Example server application using the BACnet Stack. */
@@ -74,6 +81,250 @@
 
 /** Buffer used for receiving */
 static uint8_t Rx_Buf[MAX_MPDU] = { 0 };
+/** Set by a termination signal to leave the main loop */
+static volatile sig_atomic_t Exit_Requested;
+
+/** Ask the main loop to stop, so that the atexit() handlers run.
+ * @param signo [in] signal number, unused
+ */
+static void sig_exit(
+    int signo)
+{
+    (void) signo;
+    Exit_Requested = 1;
+#if defined(SERVER_EVLOOP)
+    evloop_wakeup();
+#endif
+}
+
+/** Receive a frame, and then the rest of the burst it came in,
+ *  and handle each of them.
+ * @param timeout [in] milliseconds to wait for the first frame
+ */
+static void server_receive(
+    unsigned timeout)
+{
+    BACNET_ADDRESS src = {
+        0
+    };  /* address where message came from */
+    uint16_t pdu_len = 0;
+
+    /* returns 0 bytes on timeout */
+    pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout);
+    if (pdu_len) {
+        npdu_handler(&src, &Rx_Buf[0], pdu_len);
+    }
+    while (datalink_receive_pending()) {
+        pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, 0);
+        if (pdu_len) {
+            npdu_handler(&src, &Rx_Buf[0], pdu_len);
+        }
+    }
+}
+
+/** Run the tasks that are timed in seconds.
+ * @param elapsed_seconds [in] seconds since the last call
+ */
+static void server_timer_seconds(
+    uint32_t elapsed_seconds)
+{
+    static uint32_t address_binding_tmr = 0;
+#if defined(INTRINSIC_REPORTING)
+    static uint32_t recipient_scan_tmr = 0;
+#endif
+#if defined(BACNET_TIME_MASTER)
+    BACNET_DATE_TIME bdatetime;
+#endif
+
+    dcc_timer_seconds(elapsed_seconds);
+#if defined(BACDL_BIP) && BBMD_ENABLED
+    bvlc_maintenance_timer(elapsed_seconds);
+#endif
+    dlenv_maintenance_timer(elapsed_seconds);
+    Load_Control_State_Machine_Handler();
+    handler_cov_timer_seconds(elapsed_seconds);
+    trend_log_timer(elapsed_seconds);
+#if defined(INTRINSIC_REPORTING)
+    Device_local_reporting(elapsed_seconds);
+#endif
+#if defined(BACNET_TIME_MASTER)
+    Device_getCurrentDateTime(&bdatetime);
+    handler_timesync_task(&bdatetime);
+#endif
+    /* scan cache address */
+    address_binding_tmr += elapsed_seconds;
+    if (address_binding_tmr >= 60) {
+        address_cache_timer(address_binding_tmr);
+        address_binding_tmr = 0;
+    }
+#if defined(INTRINSIC_REPORTING)
+    /* try to find addresses of recipients */
+    recipient_scan_tmr += elapsed_seconds;
+    if (recipient_scan_tmr >= NC_RESCAN_RECIPIENTS_SECS) {
+        Notification_Class_find_recipient();
+        recipient_scan_tmr = 0;
+    }
+#endif
+}
+
+#if defined(SERVER_EVLOOP)
+/** Runs the tasks that are timed in seconds, once a second */
+static struct evloop_timer Seconds_Timer;
+/** Due at the next retry or timeout of a confirmed transaction */
+static struct evloop_timer Tsm_Timer;
+/** Due when handler_cov_fsm() next has a notification to send */
+static struct evloop_timer Cov_Timer;
+/** evloop_milliseconds() of the last second counted */
+static uint32_t Seconds_Clock;
+/** evloop_milliseconds() of the last tsm_timer_milliseconds() call */
+static uint32_t Tsm_Clock;
+
+/* brings the transaction timers up to now, which sends the retries and
+   ends the transactions that are due; the caller holds the lock */
+static void server_tsm_clock(
+    void)
+{
+    uint32_t now = evloop_milliseconds();
+    uint32_t elapsed_milliseconds = now - Tsm_Clock;
+
+    while (elapsed_milliseconds > UINT16_MAX) {
+        tsm_timer_milliseconds(UINT16_MAX);
+        elapsed_milliseconds -= UINT16_MAX;
+    }
+    tsm_timer_milliseconds((uint16_t) elapsed_milliseconds);
+    Tsm_Clock = now;
+}
+
+static void server_datalink_readable(
+    int fd,
+    void *context)
+{
+    (void) fd;
+    (void) context;
+    bip_workers_lock();
+    server_receive(0);
+    bip_workers_unlock();
+    /* a subscription, or a reply that frees a transaction, may let a
+       notification go */
+    evloop_timer_start(&Cov_Timer, 0);
+}
+
+static void server_seconds_expired(
+    void *context)
+{
+    uint32_t elapsed_milliseconds = 0;
+
+    (void) context;
+    elapsed_milliseconds = evloop_milliseconds() - Seconds_Clock;
+    if (elapsed_milliseconds >= 1000) {
+        Seconds_Clock += (elapsed_milliseconds / 1000) * 1000;
+        bip_workers_lock();
+        server_timer_seconds(elapsed_milliseconds / 1000);
+        bip_workers_unlock();
+    }
+    /* keep to whole seconds from the start, however late this ran */
+    evloop_timer_start(&Seconds_Timer,
+        1000 - (evloop_milliseconds() - Seconds_Clock) % 1000);
+}
+
+static void server_tsm_expired(
+    void *context)
+{
+    (void) context;
+    bip_workers_lock();
+    server_tsm_clock();
+    bip_workers_unlock();
+    /* a transaction that timed out is free for a waiting notification */
+    evloop_timer_start(&Cov_Timer, 0);
+}
+
+static void server_cov_expired(
+    void *context)
+{
+    (void) context;
+    bip_workers_lock();
+    (void) handler_cov_fsm();
+    bip_workers_unlock();
+}
+
+/** Send what the callbacks queued, and set the transaction and COV
+ *  timers for their next deadlines.  Runs after each wait of the event
+ *  loop.
+ */
+static void server_evloop_tasks(
+    void)
+{
+    uint32_t milliseconds = 0;
+    bool pending = false;
+
+    /* the clock is kept current so that a transaction started in the
+       meantime, such as a segmented response from a worker, is timed
+       from now */
+    bip_workers_lock();
+    server_tsm_clock();
+    pending = tsm_timer_next(&milliseconds);
+    if (pending) {
+        evloop_timer_start(&Tsm_Timer, milliseconds);
+    } else {
+        evloop_timer_stop(&Tsm_Timer);
+    }
+    /* notifications waiting for a transaction are not counted here;
+       the datalink and TSM callbacks start the COV timer for them, and
+       that earlier start is kept */
+    pending = handler_cov_fsm_next(&milliseconds);
+    if (pending && (!evloop_timer_pending(&Cov_Timer) ||
+            ((int32_t) (Cov_Timer.expires - evloop_milliseconds()) >
+                (int32_t) milliseconds))) {
+        evloop_timer_start(&Cov_Timer, milliseconds);
+    }
+    bip_workers_unlock();
+    datalink_flush();
+}
+
+/** Set up the event loop to wait on the datalink and the timers.
+ * @return true if the event loop is ready to run
+ */
+static bool server_evloop_init(
+    void)
+{
+    if (!evloop_init()) {
+        return false;
+    }
+    if (!evloop_fd_add(bip_socket(), server_datalink_readable, NULL)) {
+        evloop_cleanup();
+        return false;
+    }
+    atexit(evloop_cleanup);
+    Seconds_Clock = Tsm_Clock = evloop_milliseconds();
+    evloop_timer_init(&Seconds_Timer, server_seconds_expired, NULL);
+    evloop_timer_init(&Tsm_Timer, server_tsm_expired, NULL);
+    evloop_timer_init(&Cov_Timer, server_cov_expired, NULL);
+    evloop_timer_start(&Seconds_Timer, 1000);
+
+    return true;
+}
+
+/** Start the threads that serve unicast requests, as many as the
+ *  BACNET_BIP_WORKERS environment variable asks for.  The main loop
+ *  keeps the broadcasts and the timers.
+ */
+static void server_workers_init(
+    void)
+{
+    char *pEnv = NULL;
+    unsigned count = 0;
+
+    pEnv = getenv("BACNET_BIP_WORKERS");
+    if (pEnv) {
+        count = (unsigned) strtoul(pEnv, NULL, 0);
+    }
+    if (count && bip_workers_start(count, npdu_handler,
+            Device_Objects_Refresh)) {
+        atexit(bip_workers_stop);
+        printf("BACnet/IP Workers: %u\n", bip_workers_count());
+    }
+}
+#endif
 
 /** Initialize the handlers we will utilize.
  * @see Device_Init, apdu_set_unconfirmed_handler, apdu_set_confirmed_handler
@@ -130,6 +381,11 @@ static void Init_Service_Handlers(
         handler_timesync);
     apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
         handler_cov_subscribe);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY,
+        handler_cov_subscribe_property);
+    apdu_set_confirmed_handler
+        (SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE,
+        handler_cov_subscribe_property_multiple);
     apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_COV_NOTIFICATION,
         handler_ucov_notification);
     /* handle communication so we can shutup when asked */
@@ -178,7 +434,7 @@ static void print_help(const char *filename)
  *      datalink_receive, npdu_handler,
  *      dcc_timer_seconds, bvlc_maintenance_timer,
  *      Load_Control_State_Machine_Handler, handler_cov_task,
- *      tsm_timer_milliseconds
+ *      tsm_timer_milliseconds, evloop_run_once
  *
  * @param argc [in] Arg count.
  * @param argv [in] Takes one argument: the Device Instance #.
@@ -188,20 +444,10 @@ int main(
     int argc,
     char *argv[])
 {
-    BACNET_ADDRESS src = {
-        0
-    };  /* address where message came from */
-    uint16_t pdu_len = 0;
     unsigned timeout = 1;       /* milliseconds */
     time_t last_seconds = 0;
     time_t current_seconds = 0;
     uint32_t elapsed_seconds = 0;
-    uint32_t elapsed_milliseconds = 0;
-    uint32_t address_binding_tmr = 0;
-    uint32_t recipient_scan_tmr = 0;
-#if defined(BACNET_TIME_MASTER)
-    BACNET_DATE_TIME bdatetime;
-#endif
 #if defined(BAC_UCI)
     int uciId = 0;
     struct uci_context *ctx;
@@ -250,66 +496,50 @@ int main(
     printf("BACnet Server Demo\n" "BACnet Stack Version %s\n"
         "BACnet Device ID: %u\n" "Max APDU: %d\n", BACnet_Version,
         Device_Object_Instance_Number(), MAX_APDU);
+    /* keep the address bindings across restarts, if asked to */
+    address_snapshot_filename_set(getenv("BACNET_ADDRESS_SNAPSHOT"));
     /* load any static address bindings to show up
        in our device bindings list */
     address_init();
+    atexit(address_snapshot_cleanup);
     Init_Service_Handlers();
     dlenv_init();
     atexit(datalink_cleanup);
+    /* replies are sent together by datalink_flush() in the loop */
+    datalink_set_send_queue(true);
+    signal(SIGINT, sig_exit);
+    signal(SIGTERM, sig_exit);
     /* configure the timeout values */
     last_seconds = time(NULL);
     /* broadcast an I-Am on startup */
     Send_I_Am(&Handler_Transmit_Buffer[0]);
-    /* loop forever */
-    for (;;) {
+#if defined(SERVER_EVLOOP)
+    /* sleep until a datagram arrives or a timer is due */
+    if (server_evloop_init()) {
+        server_workers_init();
+        while (!Exit_Requested) {
+            server_evloop_tasks();
+            evloop_run_once();
+        }
+    }
+#endif
+    /* otherwise, poll the datalink; loop until asked to stop */
+    while (!Exit_Requested) {
         /* input */
         current_seconds = time(NULL);
 
-        /* returns 0 bytes on timeout */
-        pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout);
-
         /* process */
-        if (pdu_len) {
-            npdu_handler(&src, &Rx_Buf[0], pdu_len);
-        }
+        server_receive(timeout);
         /* at least one second has passed */
         elapsed_seconds = (uint32_t) (current_seconds - last_seconds);
         if (elapsed_seconds) {
             last_seconds = current_seconds;
-            dcc_timer_seconds(elapsed_seconds);
-#if defined(BACDL_BIP) && BBMD_ENABLED
-            bvlc_maintenance_timer(elapsed_seconds);
-#endif
-            dlenv_maintenance_timer(elapsed_seconds);
-            Load_Control_State_Machine_Handler();
-            elapsed_milliseconds = elapsed_seconds * 1000;
-            handler_cov_timer_seconds(elapsed_seconds);
-            tsm_timer_milliseconds(elapsed_milliseconds);
-            trend_log_timer(elapsed_seconds);
-#if defined(INTRINSIC_REPORTING)
-            Device_local_reporting();
-#endif
-#if defined(BACNET_TIME_MASTER)
-            Device_getCurrentDateTime(&bdatetime);
-            handler_timesync_task(&bdatetime);
-#endif
+            server_timer_seconds(elapsed_seconds);
+            tsm_timer_milliseconds(elapsed_seconds * 1000);
         }
         handler_cov_task();
-        /* scan cache address */
-        address_binding_tmr += elapsed_seconds;
-        if (address_binding_tmr >= 60) {
-            address_cache_timer(address_binding_tmr);
-            address_binding_tmr = 0;
-        }
-#if defined(INTRINSIC_REPORTING)
-        /* try to find addresses of recipients */
-        recipient_scan_tmr += elapsed_seconds;
-        if (recipient_scan_tmr >= NC_RESCAN_RECIPIENTS_SECS) {
-            Notification_Class_find_recipient();
-            recipient_scan_tmr = 0;
-        }
-#endif
         /* output */
+        datalink_flush();
 
         /* blink LEDs, Turn on or off outputs, etc */
     }
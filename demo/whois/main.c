@@ -143,8 +143,9 @@ void address_table_add(
 void my_i_am_handler(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
+    BACNET_ADDRESS *src = context->src;
     int len = 0;
     uint32_t device_id = 0;
     unsigned max_apdu = 0;
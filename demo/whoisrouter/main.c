@@ -145,6 +145,7 @@ void My_NPDU_Handler(
     int apdu_offset = 0;
     BACNET_ADDRESS dest = { 0 };
     BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_REQUEST_CONTEXT context;
 
     apdu_offset = npdu_decode(&pdu[0], &dest, src, &npdu_data);
     if (npdu_data.network_layer_message) {
@@ -156,7 +157,8 @@ void My_NPDU_Handler(
             /* only handle the version that we know how to handle */
             /* and we are not a router, so ignore messages with
                routing information cause they are not for us */
-            apdu_handler(src, &pdu[apdu_offset],
+            handler_context_init(&context, src);
+            apdu_handler(&context, &pdu[apdu_offset],
                 (uint16_t) (pdu_len - apdu_offset));
         } else {
             if (dest.net) {
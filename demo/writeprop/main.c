@@ -391,11 +391,13 @@ int main(
                     Target_Object_Property, &Target_Object_Property_Value[0],
                     Target_Object_Property_Priority,
                     Target_Object_Property_Index);
-            } else if (tsm_invoke_id_free(Request_Invoke_ID))
+            } else if (tsm_peer_invoke_id_free(&Target_Address,
+                Request_Invoke_ID))
                 break;
-            else if (tsm_invoke_id_failed(Request_Invoke_ID)) {
+            else if (tsm_peer_invoke_id_failed(&Target_Address,
+                Request_Invoke_ID)) {
                 fprintf(stderr, "\rError: TSM Timeout!\n");
-                tsm_free_invoke_id(Request_Invoke_ID);
+                tsm_free_peer_invoke_id(&Target_Address, Request_Invoke_ID);
                 Error_Detected = true;
                 /* try again or abort? */
                 break;
@@ -73,6 +73,21 @@ extern "C" {
     unsigned address_count(
         void);
 
+    unsigned address_cache_size(
+        void);
+
+    uint32_t address_revision(
+        void);
+
+    bool address_snapshot_save(
+        const char *pFilename);
+    int address_snapshot_load(
+        const char *pFilename);
+    void address_snapshot_filename_set(
+        const char *pFilename);
+    void address_snapshot_cleanup(
+        void);
+
     bool address_match(
         BACNET_ADDRESS * dest,
         BACNET_ADDRESS * src);
@@ -48,6 +48,19 @@ typedef struct _confirmed_service_ack_data {
     uint8_t proposed_window_number;
 } BACNET_CONFIRMED_SERVICE_ACK_DATA;
 
+/* everything a service handler needs to process one request and send its
+   reply: where the request came from, the buffer to encode the reply into,
+   and room for any intermediate encoding.  Each request processed at the
+   same time as another needs its own buffers. */
+typedef struct BACnet_Request_Context {
+    BACNET_ADDRESS *src;
+    /* holds an NPDU header and the largest reply, segmented or not */
+    uint8_t *tx_buffer;
+    unsigned tx_buffer_size;
+    uint8_t *scratch;
+    unsigned scratch_size;
+} BACNET_REQUEST_CONTEXT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -62,7 +75,7 @@ extern "C" {
         *unconfirmed_function) (
         uint8_t * service_request,
         uint16_t len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
 /* generic confirmed function handler */
 /* Suitable to handle the following services: */
@@ -84,7 +97,7 @@ extern "C" {
         *confirmed_function) (
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
 /* generic confirmed simple ack function handler */
@@ -132,6 +145,14 @@ extern "C" {
         BACNET_CONFIRMED_SERVICE service_choice,
         confirmed_simple_ack_function pFunction);
 
+/* the handlers set so far, so that a module setting its own can pass on
+   the replies that are not to its requests */
+    confirmed_ack_function apdu_get_confirmed_ack_handler(
+        BACNET_CONFIRMED_SERVICE service_choice);
+
+    confirmed_simple_ack_function apdu_get_confirmed_simple_ack_handler(
+        BACNET_CONFIRMED_SERVICE service_choice);
+
 /* configure reject for confirmed services that are not supported */
     void apdu_set_unrecognized_service_handler_handler(
         confirmed_function pFunction);
@@ -167,6 +188,15 @@ extern "C" {
     void apdu_set_reject_handler(
         reject_function pFunction);
 
+    error_function apdu_get_error_handler(
+        BACNET_CONFIRMED_SERVICE service_choice);
+
+    abort_function apdu_get_abort_handler(
+        void);
+
+    reject_function apdu_get_reject_handler(
+        void);
+
     uint16_t apdu_decode_confirmed_service_request(
         uint8_t * apdu, /* APDU data */
         uint16_t apdu_len,
@@ -183,9 +213,13 @@ extern "C" {
         void);
     void apdu_retries_set(
         uint8_t value);
+    uint16_t apdu_segment_timeout(
+        void);
+    void apdu_segment_timeout_set(
+        uint16_t milliseconds);
 
     void apdu_handler(
-        BACNET_ADDRESS * src,   /* source address */
+        BACNET_REQUEST_CONTEXT * context,       /* source address, buffers */
         uint8_t * apdu, /* APDU data */
         uint16_t pdu_len);      /* for confirmed messages */
 
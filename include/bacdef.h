@@ -167,6 +167,11 @@ typedef struct BACnet_Object_Id {
 
 #define MAX_NPDU (1+1+2+1+MAX_MAC_LEN+2+1+MAX_MAC_LEN+1+1+2)
 #define MAX_PDU (MAX_APDU + MAX_NPDU)
+/* largest response that is sent as a segmented ComplexACK */
+#define MAX_APDU_SEGMENTED (MAX_APDU * MAX_SEGMENTS_TRANSMIT)
+#define MAX_PDU_SEGMENTED (MAX_APDU_SEGMENTED + MAX_NPDU)
+/* largest response that is received as a segmented ComplexACK */
+#define MAX_APDU_REASSEMBLED (MAX_APDU * MAX_SEGMENTS_ACCEPTED)
 
 #define BACNET_ID_VALUE(bacnet_object_instance, bacnet_object_type) ((((bacnet_object_type) & BACNET_MAX_OBJECT) << BACNET_INSTANCE_BITS) | ((bacnet_object_instance) & BACNET_MAX_INSTANCE))
 #define BACNET_INSTANCE(bacnet_object_id_num) ((bacnet_object_id_num)&BACNET_MAX_INSTANCE)
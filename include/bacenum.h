@@ -1351,6 +1351,8 @@ typedef enum {
     SERVICE_CONFIRMED_SUBSCRIBE_COV = 5,
     SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY = 28,
     SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION = 27,
+    SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE = 30,
+    SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE = 31,
     /* File Access Services */
     SERVICE_CONFIRMED_ATOMIC_READ_FILE = 6,
     SERVICE_CONFIRMED_ATOMIC_WRITE_FILE = 7,
@@ -1382,7 +1384,9 @@ typedef enum {
     /* lifeSafetyOperation (27) see Alarm and Event Services */
     /* subscribeCOVProperty (28) see Alarm and Event Services */
     /* getEventInformation (29) see Alarm and Event Services */
-    MAX_BACNET_CONFIRMED_SERVICE = 30
+    /* subscribeCOVPropertyMultiple (30) see Alarm and Event Services */
+    /* confirmedCOVNotificationMultiple (31) see Alarm and Event Services */
+    MAX_BACNET_CONFIRMED_SERVICE = 32
 } BACNET_CONFIRMED_SERVICE;
 
 typedef enum {
@@ -1398,12 +1402,14 @@ typedef enum {
     SERVICE_UNCONFIRMED_UTC_TIME_SYNCHRONIZATION = 9,
     /* addendum 2010-aa */
     SERVICE_UNCONFIRMED_WRITE_GROUP = 10,
+    /* addendum 2012-ai */
+    SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE = 11,
     /* Other services to be added as they are defined. */
     /* All choice values in this production are reserved */
     /* for definition by ASHRAE. */
     /* Proprietary extensions are made by using the */
     /* UnconfirmedPrivateTransfer service. See Clause 23. */
-    MAX_BACNET_UNCONFIRMED_SERVICE = 11
+    MAX_BACNET_UNCONFIRMED_SERVICE = 12
 } BACNET_UNCONFIRMED_SERVICE;
 
 /* Bit String Enumerations */
@@ -1418,6 +1424,9 @@ typedef enum {
     SERVICE_SUPPORTED_SUBSCRIBE_COV = 5,
     SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY = 38,
     SERVICE_SUPPORTED_LIFE_SAFETY_OPERATION = 37,
+    SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE = 41,
+    SERVICE_SUPPORTED_CONFIRMED_COV_NOTIFICATION_MULTIPLE = 42,
+    SERVICE_SUPPORTED_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE = 43,
     /* File Access Services */
     SERVICE_SUPPORTED_ATOMIC_READ_FILE = 6,
     SERVICE_SUPPORTED_ATOMIC_WRITE_FILE = 7,
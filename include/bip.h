@@ -58,6 +58,9 @@ extern "C" {
         int sock_fd);
     int bip_socket(
         void);
+    /* a socket of the calling thread, used instead of bip_socket() */
+    void bip_set_thread_socket(
+        int sock_fd);
     bool bip_valid(
         void);
     void bip_get_broadcast_address(
@@ -81,6 +84,34 @@ extern "C" {
         uint16_t max_pdu,       /* amount of space available in the PDU  */
         unsigned timeout);      /* milliseconds to wait for a packet */
 
+    /* sends and receives one datagram, with its BVLL header; a port
+       that defines BIP_BURST_SIZE moves a burst of them per system call */
+    int bip_send_mpdu(
+        struct sockaddr_in *dest,
+        uint8_t * mtu,
+        uint16_t mtu_len);
+    int bip_receive_mpdu(
+        struct sockaddr_in *sin,
+        uint8_t * mtu,
+        uint16_t max_mtu,
+        unsigned timeout);
+    /* datagrams received in the last burst and not yet returned */
+    unsigned bip_receive_pending(
+        void);
+    /* when enabled, datagrams are queued until bip_flush() */
+    void bip_set_send_queue(
+        bool enable);
+    void bip_flush(
+        void);
+    /* Linux: more sockets sharing the unicast datagrams of the port,
+       one per thread, which may look at a datagram before taking it */
+    int bip_reuseport_socket(
+        void);
+    bool bip_receive_wait(
+        unsigned timeout);
+    uint8_t *bip_receive_peek(
+        uint16_t * mtu_len);
+
     /* use network byte order for setting */
     void bip_set_port(
         uint16_t port);
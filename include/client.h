@@ -105,6 +105,12 @@ extern "C" {
         BACNET_OBJECT_TYPE object_type,
         uint32_t object_instance,
         BACNET_CHARACTER_STRING * object_name);
+    void Send_I_Have_Buffer(
+        uint8_t * buffer,
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_CHARACTER_STRING * object_name);
 
     int Send_UCOV_Notify(
         uint8_t * buffer,
@@ -219,6 +225,10 @@ extern "C" {
     uint8_t Send_CEvent_Notify(
         uint32_t device_id,
         BACNET_EVENT_NOTIFICATION_DATA * data);
+    uint8_t Send_CEvent_Notify_Address(
+        BACNET_ADDRESS * dest,
+        unsigned max_apdu,
+        BACNET_EVENT_NOTIFICATION_DATA * data);
 
     int Send_Network_Layer_Message(
         BACNET_NETWORK_MESSAGE_TYPE network_message_type,
@@ -108,6 +108,28 @@
 #endif
 #endif
 
+/* A response that does not fit in one APDU is sent as a segmented */
+/* ComplexACK of up to this many segments, if the client accepts */
+/* segmented responses.  The default of 1 sends unsegmented responses */
+/* only, which keeps the transmit buffer at MAX_PDU.  Segmentation */
+/* multiplies the transmit and reassembly buffers by the number of */
+/* segments, so a build that wants it opts in, for example with */
+/* -DMAX_SEGMENTS_TRANSMIT=32 in its makefile or project. */
+#if !defined(MAX_SEGMENTS_TRANSMIT)
+#define MAX_SEGMENTS_TRANSMIT 1
+#endif
+/* A ComplexACK received as a segmented response to one of our */
+/* requests is reassembled from up to this many segments. */
+/* The default of 1 requests unsegmented responses only. */
+#if !defined(MAX_SEGMENTS_ACCEPTED)
+#define MAX_SEGMENTS_ACCEPTED 1
+#endif
+/* Number of segments proposed to be sent before waiting for */
+/* a SegmentACK, or received before sending one, from 1 to 127. */
+#if !defined(MAX_SEGMENT_WINDOW)
+#define MAX_SEGMENT_WINDOW 16
+#endif
+
 /* for confirmed messages, this is the number of transactions */
 /* that we hold in a queue waiting for timeout. */
 /* Configure to zero if you don't want any confirmed messages */
@@ -116,6 +138,16 @@
 #if !defined(MAX_TSM_TRANSACTIONS)
 #define MAX_TSM_TRANSACTIONS 255
 #endif
+/* Since an invoke ID only needs to be unique for each peer device, */
+/* the transaction table grows as needed from MAX_TSM_TRANSACTIONS */
+/* up to this many outstanding confirmed requests. Configure it */
+/* equal to MAX_TSM_TRANSACTIONS for a fixed size table. */
+#if !defined(MAX_TSM_TRANSACTIONS_DYNAMIC)
+#define MAX_TSM_TRANSACTIONS_DYNAMIC 4096
+#endif
+#if (!MAX_TSM_TRANSACTIONS) && (MAX_SEGMENTS_ACCEPTED > 1)
+#error "MAX_SEGMENTS_ACCEPTED needs MAX_TSM_TRANSACTIONS"
+#endif
 /* The address cache is used for binding to BACnet devices */
 /* The number of entries corresponds to the number of */
 /* devices that might respond to an I-Am on the network. */
@@ -124,6 +156,22 @@
 #if !defined(MAX_ADDRESS_CACHE)
 #define MAX_ADDRESS_CACHE 255
 #endif
+/* The address cache starts with MAX_ADDRESS_CACHE entries and grows */
+/* as devices are found, up to this many entries. */
+#if !defined(MAX_ADDRESS_CACHE_DYNAMIC)
+#define MAX_ADDRESS_CACHE_DYNAMIC 65536
+#endif
+
+/* Storage class of the scratch buffers used while a request is served.
+   Where threads are available, each thread that serves requests gets
+   its own copy of them. */
+#if !defined(BACNET_THREAD_LOCAL)
+#if defined(__GNUC__) && defined(__linux__)
+#define BACNET_THREAD_LOCAL __thread
+#else
+#define BACNET_THREAD_LOCAL
+#endif
+#endif
 
 /* some modules have debugging enabled using PRINT_ENABLED */
 #if !defined(PRINT_ENABLED)
@@ -52,6 +52,56 @@ typedef struct BACnet_Subscribe_COV_Data {
     struct BACnet_Subscribe_COV_Data *next;
 } BACNET_SUBSCRIBE_COV_DATA;
 
+/* a property to monitor, in a SubscribeCOVPropertyMultiple request */
+typedef struct BACnet_COV_Reference {
+    BACNET_PROPERTY_REFERENCE monitoredProperty;
+    bool covIncrementPresent;   /* true if present */
+    float covIncrement; /* optional */
+    bool timestamped;
+    struct BACnet_COV_Reference *next;
+} BACNET_COV_REFERENCE;
+
+/* the properties to monitor of an object */
+typedef struct BACnet_COV_Subscription_Specification {
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* simple linked list of properties */
+    BACNET_COV_REFERENCE *listOfCOVReferences;
+    struct BACnet_COV_Subscription_Specification *next;
+} BACNET_COV_SUBSCRIPTION_SPECIFICATION;
+
+typedef struct BACnet_Subscribe_COV_Multiple_Data {
+    uint32_t subscriberProcessIdentifier;
+    bool cancellationRequest;   /* true if this is a cancellation request */
+    bool issueConfirmedNotifications;   /* optional */
+    uint32_t lifetime;  /* seconds, optional */
+    uint32_t maxNotificationDelay;      /* seconds, optional */
+    /* simple linked list of objects */
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION *listOfCOVSubscriptionSpecifications;
+    BACNET_ERROR_CLASS error_class;
+    BACNET_ERROR_CODE error_code;
+    /* the first subscription that failed, for the Error response */
+    BACNET_OBJECT_ID failedObjectIdentifier;
+    BACNET_PROPERTY_REFERENCE failedProperty;
+} BACNET_SUBSCRIBE_COV_MULTIPLE_DATA;
+
+/* the values of an object, in a COV-Multiple notification */
+typedef struct BACnet_COV_Notification {
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* simple linked list of values */
+    BACNET_PROPERTY_VALUE *listOfValues;
+    struct BACnet_COV_Notification *next;
+} BACNET_COV_NOTIFICATION;
+
+typedef struct BACnet_COV_Multiple_Data {
+    uint32_t subscriberProcessIdentifier;
+    uint32_t initiatingDeviceIdentifier;
+    uint32_t timeRemaining;     /* seconds */
+    bool timestampPresent;      /* true if present */
+    BACNET_DATE_TIME timestamp; /* optional */
+    /* simple linked list of objects */
+    BACNET_COV_NOTIFICATION *listOfCOVNotifications;
+} BACNET_COV_MULTIPLE_DATA;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -83,6 +133,27 @@ extern "C" {
         uint8_t * invoke_id,
         BACNET_COV_DATA * data);
 
+    /* encode the values once for many subscribers */
+    int cov_notify_encode_values(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_PROPERTY_VALUE * value_list);
+
+    int ucov_notify_encode_apdu_values(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_COV_DATA * data,
+        uint8_t * values,
+        unsigned values_len);
+
+    int ccov_notify_encode_apdu_values(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_COV_DATA * data,
+        uint8_t * values,
+        unsigned values_len);
+
     /* common for both confirmed and unconfirmed */
     int cov_notify_decode_service_request(
         uint8_t * apdu,
@@ -116,6 +187,61 @@ extern "C" {
         BACNET_PROPERTY_VALUE *value_list,
         size_t count);
 
+    /* COV-Multiple services */
+    int ucov_notify_multiple_encode_apdu(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    int ccov_notify_multiple_encode_apdu(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    /* encode notifications built up by the caller */
+    int ucov_notify_multiple_encode_apdu_notifications(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data,
+        uint8_t * notifications,
+        unsigned notifications_len);
+
+    int ccov_notify_multiple_encode_apdu_notifications(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_COV_MULTIPLE_DATA * data,
+        uint8_t * notifications,
+        unsigned notifications_len);
+
+    /* common for both confirmed and unconfirmed */
+    int cov_notify_multiple_decode_service_request(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    int cov_subscribe_property_multiple_encode_apdu(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data);
+
+    int cov_subscribe_property_multiple_decode_service_request(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data);
+
+    int cov_subscribe_property_multiple_error_encode(
+        uint8_t * apdu,
+        uint8_t invoke_id,
+        BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data);
+
+    int cov_subscribe_property_multiple_error_decode_service_request(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data);
+
 #ifdef TEST
 #include "ctest.h"
     void testCOVNotify(
@@ -124,6 +250,12 @@ extern "C" {
         Test * pTest);
     void testCOVSubscribe(
         Test * pTest);
+    void testCOVNotifyMultiple(
+        Test * pTest);
+    void testCOVSubscribePropertyMultiple(
+        Test * pTest);
+    void testCOVSubscribePropertyMultipleError(
+        Test * pTest);
 #endif
 
 #ifdef __cplusplus
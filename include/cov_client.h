@@ -0,0 +1,111 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef COV_CLIENT_H
+#define COV_CLIENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacdef.h"
+#include "bacenum.h"
+#include "bacapp.h"
+#include "apdu.h"
+
+/** @file cov_client.h  Keeps COV subscriptions to the points of other
+ *  devices, renewing them, or polling devices that do not support COV. */
+
+/* called with the values of a point, as notified or as polled */
+typedef void (
+    *cov_client_notify_function) (
+    uint32_t device_id,
+    BACNET_OBJECT_ID * object_id,
+    BACNET_PROPERTY_VALUE * values,
+    void *context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    void cov_client_init(
+        uint32_t process_identifier);
+    bool cov_client_subscribe(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        bool confirmed,
+        uint32_t lifetime,
+        cov_client_notify_function callback,
+        void *context);
+    bool cov_client_unsubscribe(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    bool cov_client_device_polled(
+        uint32_t device_id);
+    void cov_client_poll_interval_set(
+        uint32_t seconds);
+    void cov_client_requests_max_set(
+        unsigned count);
+    void cov_client_timer_seconds(
+        uint32_t elapsed_seconds);
+    void cov_client_task(
+        void);
+
+    /* handlers, which cov_client_init() sets up with apdu_set_...() */
+    void cov_client_ucov_notification_handler(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_REQUEST_CONTEXT * context);
+    void cov_client_ccov_notification_handler(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_REQUEST_CONTEXT * context,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    void cov_client_subscribe_ack_handler(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id);
+    void cov_client_read_property_ack_handler(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
+    void cov_client_error_handler(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        BACNET_ERROR_CLASS error_class,
+        BACNET_ERROR_CODE error_code);
+    void cov_client_abort_handler(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t abort_reason,
+        bool server);
+    void cov_client_reject_handler(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t reject_reason);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
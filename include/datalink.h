@@ -71,6 +71,9 @@
 #endif
 #define datalink_cleanup bip_cleanup
 #define datalink_get_broadcast_address bip_get_broadcast_address
+#define datalink_flush bip_flush
+#define datalink_receive_pending bip_receive_pending
+#define datalink_set_send_queue bip_set_send_queue
 #ifdef BAC_ROUTING
 extern void routed_get_my_address(
     BACNET_ADDRESS * my_address);
@@ -124,6 +127,17 @@ extern "C" {
 }
 #endif /* __cplusplus */
 #endif
+
+/* datalinks that send and receive each frame at once */
+#ifndef datalink_flush
+#define datalink_flush()
+#endif
+#ifndef datalink_receive_pending
+#define datalink_receive_pending() 0
+#endif
+#ifndef datalink_set_send_queue
+#define datalink_set_send_queue(enable)
+#endif
 /** @defgroup DataLink The BACnet Network (DataLink) Layer
  * <b>6 THE NETWORK LAYER </b><br>
  * The purpose of the BACnet network layer is to provide the means by which
@@ -0,0 +1,64 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef FNV_H
+#define FNV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bacdef.h"
+
+/** @file fnv.h  FNV-1a hashing of octets, for hash tables */
+
+/* the FNV-1a offset basis, which starts each hash */
+#define FNV_HASH_INIT 2166136261UL
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    uint32_t FNV_Hash_Octet(
+        uint8_t value,
+        uint32_t hash);
+    uint32_t FNV_Hash(
+        const uint8_t * data,
+        size_t length,
+        uint32_t hash);
+    uint32_t FNV_Hash_Unsigned32(
+        uint32_t value,
+        uint32_t hash);
+    uint32_t FNV_Hash_Address(
+        BACNET_ADDRESS * address,
+        uint32_t hash);
+
+#ifdef TEST
+#include "ctest.h"
+    void testFNV(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -51,6 +51,11 @@ typedef int (
     unsigned index,
     BACNET_GET_EVENT_INFORMATION_DATA * getevent_data);
 
+/* return the index, as used above, of an object instance */
+typedef unsigned (
+    *get_event_index_function) (
+    uint32_t object_instance);
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
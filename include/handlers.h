@@ -50,7 +50,7 @@ extern "C" {
     void handler_unrecognized_service(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * dest,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void npdu_handler(
@@ -58,6 +58,10 @@ extern "C" {
         uint8_t * pdu,  /* PDU data */
         uint16_t pdu_len);      /* length PDU  */
 
+    void handler_context_init(
+        BACNET_REQUEST_CONTEXT * context,
+        BACNET_ADDRESS * src);
+
     void npdu_handler_cleanup(void);
     void npdu_handler_init(
         uint16_t bip_net,
@@ -86,47 +90,47 @@ extern "C" {
     void handler_who_is(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_who_is_unicast(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_who_is_bcast_for_routing(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_who_is_unicast_for_routing(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_who_has(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_who_has_for_routing(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_i_am_add(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_i_am_bind(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void handler_read_property(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_read_property_ack(
@@ -138,13 +142,13 @@ extern "C" {
     void handler_write_property(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_write_property_multiple(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     bool WPValidateString(
@@ -163,7 +167,7 @@ extern "C" {
     void handler_atomic_read_file(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_atomic_read_file_ack(
@@ -175,19 +179,19 @@ extern "C" {
     void handler_atomic_write_file(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_reinitialize_device(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_device_communication_control(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
     void handler_dcc_password_set(
         char *new_password);
@@ -196,17 +200,17 @@ extern "C" {
     void handler_i_have(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     /* time synchronization handlers */
     void handler_timesync(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
     void handler_timesync_utc(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
     /* time sync master features */
     int handler_timesync_encode_recipients(
         uint8_t * apdu,
@@ -228,7 +232,7 @@ extern "C" {
     void handler_read_property_multiple(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_read_property_multiple_ack(
@@ -254,14 +258,32 @@ extern "C" {
     void handler_cov_subscribe(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    void handler_cov_subscribe_property(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_REQUEST_CONTEXT * context,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    void handler_cov_subscribe_property_multiple(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
     bool handler_cov_fsm(
         void);
+    bool handler_cov_fsm_next(
+        uint32_t * milliseconds);
     void handler_cov_task(
         void);
     void handler_cov_timer_seconds(
         uint32_t elapsed_seconds);
+    void handler_cov_object_changed(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    void handler_cov_object_deleted(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
     void handler_cov_init(
         void);
     int handler_cov_encode_subscriptions(
@@ -271,23 +293,23 @@ extern "C" {
     void handler_ucov_notification(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
     void handler_ccov_notification(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_lso(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_alarm_ack(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_alarm_ack_set(
@@ -297,7 +319,7 @@ extern "C" {
     void handler_conf_private_trans(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_conf_private_trans_ack(
@@ -309,7 +331,7 @@ extern "C" {
     void handler_unconfirmed_private_transfer(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src);
+        BACNET_REQUEST_CONTEXT * context);
 
     void private_transfer_print_data(
         BACNET_PRIVATE_TRANSFER_DATA *private_data);
@@ -317,7 +339,7 @@ extern "C" {
     void handler_read_range(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_read_range_ack(
@@ -330,10 +352,23 @@ extern "C" {
         BACNET_OBJECT_TYPE object_type,
         get_event_info_function pFunction);
 
+    void handler_event_index_set(
+        BACNET_OBJECT_TYPE object_type,
+        get_event_index_function pFunction);
+    void handler_event_index_update(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        bool active);
+    bool handler_event_index_next(
+        BACNET_OBJECT_ID * object_id,
+        unsigned *index);
+    bool handler_event_index_valid(
+        BACNET_OBJECT_TYPE object_type);
+
     void handler_get_event_information(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void handler_get_alarm_summary_set(
@@ -343,7 +378,7 @@ extern "C" {
     void handler_get_alarm_summary(
         uint8_t * service_request,
         uint16_t service_len,
-        BACNET_ADDRESS * src,
+        BACNET_REQUEST_CONTEXT * context,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
 
     void get_alarm_summary_ack_handler(
@@ -89,6 +89,11 @@ extern "C" {
         OS_Keylist list,
         KEY key);
 
+/* returns the index of the node specified by key, or of the next larger */
+    int Keylist_Index_Nearest(
+        OS_Keylist list,
+        KEY key);
+
 /* returns the data specified by key */
     void *Keylist_Data_Index(
         OS_Keylist list,
@@ -0,0 +1,94 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef MINHEAP_H
+#define MINHEAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+
+/** @file minheap.h  Binary min-heap of timer deadlines */
+
+/* the position of an item that is not in the heap */
+#define MIN_HEAP_NO_POSITION UINT_MAX
+
+/* told where an item now sits in the heap, or MIN_HEAP_NO_POSITION
+   once it has been removed, so that its owner can remove it later */
+typedef void (
+    *min_heap_moved_function) (
+    void *context,
+    unsigned item,
+    unsigned position);
+
+struct min_heap_node {
+    uint32_t key;       /* the deadline, compared across wrap */
+    unsigned item;      /* the owner's index of the item */
+};
+
+typedef struct min_heap {
+    struct min_heap_node *nodes;
+    unsigned count;     /* number of items in the heap */
+    unsigned size;      /* number of nodes allocated */
+    min_heap_moved_function moved;
+    void *context;
+} MIN_HEAP;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    void Min_Heap_Init(
+        MIN_HEAP * heap,
+        min_heap_moved_function moved,
+        void *context);
+    void Min_Heap_Cleanup(
+        MIN_HEAP * heap);
+    bool Min_Heap_Reserve(
+        MIN_HEAP * heap,
+        unsigned size);
+    bool Min_Heap_Insert(
+        MIN_HEAP * heap,
+        unsigned item,
+        uint32_t key);
+    bool Min_Heap_Remove(
+        MIN_HEAP * heap,
+        unsigned position);
+    bool Min_Heap_Peek(
+        MIN_HEAP const *heap,
+        unsigned *item,
+        uint32_t * key);
+    unsigned Min_Heap_Count(
+        MIN_HEAP const *heap);
+
+#ifdef TEST
+#include "ctest.h"
+    void testMinHeap(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,95 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef OBJSTORE_H
+#define OBJSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "keylist.h"
+
+/** @file objstore.h  Sparse store of the objects of one type */
+
+/* called with the data of an object before it is freed, so that its
+   owner can free what the data points to, or forget the object */
+typedef void (
+    *object_store_free_function) (
+    uint32_t object_instance,
+    void *data);
+
+/* the objects of one type, each with data_size octets of its own,
+   sorted by object instance */
+typedef struct object_store {
+    OS_Keylist list;
+    size_t data_size;
+    object_store_free_function free_function;
+} OBJECT_STORE;
+
+/* initializer for a static OBJECT_STORE */
+#define OBJECT_STORE_INIT(data_size, free_function) \
+    { NULL, (data_size), (free_function) }
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    bool Object_Store_Init(
+        OBJECT_STORE * store);
+    void *Object_Store_Create(
+        OBJECT_STORE * store,
+        uint32_t object_instance);
+    bool Object_Store_Delete(
+        OBJECT_STORE * store,
+        uint32_t object_instance);
+    void Object_Store_Cleanup(
+        OBJECT_STORE * store);
+    void *Object_Store_Data(
+        OBJECT_STORE * store,
+        uint32_t object_instance);
+    void *Object_Store_Data_Index(
+        OBJECT_STORE * store,
+        unsigned index);
+    bool Object_Store_Valid_Instance(
+        OBJECT_STORE * store,
+        uint32_t object_instance);
+    unsigned Object_Store_Count(
+        OBJECT_STORE * store);
+    uint32_t Object_Store_Index_To_Instance(
+        OBJECT_STORE * store,
+        unsigned index);
+    unsigned Object_Store_Instance_To_Index(
+        OBJECT_STORE * store,
+        uint32_t object_instance);
+
+#ifdef TEST
+#include "ctest.h"
+    void testObjectStore(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -29,18 +29,21 @@
 #include <stddef.h>
 #include "bacdef.h"
 #include "npdu.h"
+#include "apdu.h"
 
 /* note: TSM functionality is optional - only needed if we are
    doing client requests */
 #if (!MAX_TSM_TRANSACTIONS)
-#define tsm_free_invoke_id(x) (void)x;
+#define tsm_free_peer_invoke_id(s,x) (void)s; (void)x;
+#define tsm_set_lock_handlers(l,u) (void)l; (void)u;
 #else
 typedef enum {
     TSM_STATE_IDLE,
     TSM_STATE_AWAIT_CONFIRMATION,
     TSM_STATE_AWAIT_RESPONSE,
     TSM_STATE_SEGMENTED_REQUEST,
-    TSM_STATE_SEGMENTED_CONFIRMATION
+    TSM_STATE_SEGMENTED_CONFIRMATION,
+    TSM_STATE_SEGMENTED_RESPONSE
 } BACNET_TSM_STATE;
 
 /* 5.4.1 Variables And Parameters */
@@ -50,22 +53,22 @@ typedef struct BACnet_TSM_Data {
     /* used to count APDU retries */
     uint8_t RetryCount;
     /* used to count segment retries */
-    /*uint8_t SegmentRetryCount;  */
+    uint8_t SegmentRetryCount;
     /* used to control APDU retries and the acceptance of server replies */
     /*bool SentAllSegments;  */
     /* stores the sequence number of the last segment received in order */
-    /*uint8_t LastSequenceNumber; */
+    uint8_t LastSequenceNumber;
     /* stores the sequence number of the first segment of */
     /* a sequence of segments that fill a window */
-    /*uint8_t InitialSequenceNumber; */
+    uint8_t InitialSequenceNumber;
     /* stores the current window size */
-    /*uint8_t ActualWindowSize; */
+    uint8_t ActualWindowSize;
     /* stores the window size proposed by the segment sender */
-    /*uint8_t ProposedWindowSize;  */
+    uint8_t ProposedWindowSize;
     /*  used to perform timeout on PDU segments */
     /*uint8_t SegmentTimer; */
     /* used to perform timeout on Confirmed Requests */
-    /* in milliseconds */
+    /* in milliseconds, as loaded when the timer was last started */
     uint16_t RequestTimer;
     /* unique id */
     uint8_t InvokeID;
@@ -76,14 +79,20 @@ typedef struct BACnet_TSM_Data {
     /* the network layer info */
     BACNET_NPDU_DATA npdu_data;
     /* copy of the APDU, should we need to send it again */
-    uint8_t apdu[MAX_PDU];
+    /* allocated from a pool to fit apdu_len */
+    uint8_t *apdu;
     unsigned apdu_len;
 } BACNET_TSM_DATA;
 
 typedef void (
     *tsm_timeout_function) (
+    BACNET_ADDRESS * dest,
     uint8_t invoke_id);
 
+typedef void (
+    *tsm_lock_function) (
+    void);
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,19 +100,25 @@ extern "C" {
 
     void tsm_set_timeout_handler(
         tsm_timeout_function pFunction);
+    void tsm_set_lock_handlers(
+        tsm_lock_function lock,
+        tsm_lock_function unlock);
 
     bool tsm_transaction_available(
         void);
-    uint8_t tsm_transaction_idle_count(
+    unsigned tsm_transaction_idle_count(
         void);
     void tsm_timer_milliseconds(
         uint16_t milliseconds);
+    bool tsm_timer_next(
+        uint32_t * milliseconds);
 /* free the invoke ID when the reply comes back */
-    void tsm_free_invoke_id(
+    void tsm_free_peer_invoke_id(
+        BACNET_ADDRESS * src,
         uint8_t invokeID);
-/* use these in tandem */
-    uint8_t tsm_next_free_invokeID(
-        void);
+/* invoke IDs only need to be unique for each peer */
+    uint8_t tsm_next_free_peer_invokeID(
+        BACNET_ADDRESS * dest);
     void tsm_invokeID_set(
         uint8_t invokeID);
 /* returns the same invoke ID that was given */
@@ -114,21 +129,71 @@ extern "C" {
         uint8_t * apdu,
         uint16_t apdu_len);
 /* returns true if transaction is found */
-    bool tsm_get_transaction_pdu(
+    bool tsm_get_peer_transaction_pdu(
+        BACNET_ADDRESS * src,
         uint8_t invokeID,
-        BACNET_ADDRESS * dest,
         BACNET_NPDU_DATA * ndpu_data,
         uint8_t * apdu,
         uint16_t * apdu_len);
 
-    bool tsm_invoke_id_free(
+    bool tsm_peer_invoke_id_free(
+        BACNET_ADDRESS * dest,
+        uint8_t invokeID);
+    bool tsm_peer_invoke_id_failed(
+        BACNET_ADDRESS * dest,
         uint8_t invokeID);
-    bool tsm_invoke_id_failed(
+/* round trip time estimates, for sizing batches of requests */
+    bool tsm_peer_rtt(
+        BACNET_ADDRESS * dest,
+        uint32_t * srtt,
+        uint32_t * rttvar);
+    uint16_t tsm_peer_timeout(
+        BACNET_ADDRESS * dest);
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+/* responding to a confirmed request with a ComplexACK */
+    unsigned tsm_complex_ack_max(
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    int tsm_send_complex_ack(
+        BACNET_ADDRESS * dest,
+        BACNET_NPDU_DATA * npdu_data,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data,
+        uint8_t * pdu,
+        unsigned npdu_len,
+        unsigned apdu_len);
+    void tsm_segment_ack_received(
+        BACNET_ADDRESS * src,
+        uint8_t invokeID,
+        uint8_t sequence_number,
+        uint8_t actual_window_size);
+    void tsm_free_peer_response(
+        BACNET_ADDRESS * src,
         uint8_t invokeID);
+#endif
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+/* reassembling a segmented ComplexACK to one of our requests */
+    uint8_t *tsm_segmented_ack_received(
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data,
+        uint8_t * service_request,
+        uint16_t * service_request_len);
+#endif
 
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
 /* define out any functions necessary for compile */
 #endif
+/* without segmentation, a ComplexACK has to fit in one APDU */
+#if (!MAX_TSM_TRANSACTIONS) || (MAX_SEGMENTS_TRANSMIT < 2)
+#define tsm_complex_ack_max(s) \
+    ((unsigned) (((s)->max_resp < MAX_APDU) ? (s)->max_resp : MAX_APDU))
+#define tsm_send_complex_ack(d,n,s,p,l,a) \
+    datalink_send_pdu(d, n, p, (l) + (a))
+#define tsm_segment_ack_received(s,x,q,w) (void)s; (void)x; (void)q; (void)w;
+#define tsm_free_peer_response(s,x) (void)s; (void)x;
+#endif
+/* without reassembly, the segments of a ComplexACK are dropped */
+#if (MAX_SEGMENTS_ACCEPTED < 2)
+#define tsm_segmented_ack_received(s,d,r,l) ((uint8_t *) NULL)
+#endif
 #endif
@@ -30,6 +30,16 @@
 #include "config.h"
 #include "datalink.h"
 
-extern uint8_t Handler_Transmit_Buffer[MAX_PDU];
+/* the scratch space of a request context, used by ReadPropertyMultiple,
+   ReadRange and PrivateTransfer to encode a value before it is copied into
+   the reply.  Devices without those services may define it as 0. */
+#ifndef MAX_HANDLER_SCRATCH
+#define MAX_HANDLER_SCRATCH MAX_APDU_SEGMENTED
+#endif
+
+extern BACNET_THREAD_LOCAL uint8_t Handler_Transmit_Buffer[MAX_PDU_SEGMENTED];
+#if MAX_HANDLER_SCRATCH
+extern BACNET_THREAD_LOCAL uint8_t Handler_Scratch_Buffer[MAX_HANDLER_SCRATCH];
+#endif
 
 #endif
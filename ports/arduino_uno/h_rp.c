@@ -87,7 +87,7 @@ int Encode_Property_APDU(uint8_t * apdu,
 
 void handler_read_property(uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_READ_PROPERTY_DATA data;
@@ -104,12 +104,12 @@ void handler_read_property(uint8_t * service_request,
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     if (service_data->segmented_message) {
         /* we don't support segmentation - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
         goto RP_ABORT;
@@ -118,21 +118,21 @@ void handler_read_property(uint8_t * service_request,
     if (len < 0) {
         /* bad decoding - send an abort */
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
         goto RP_ABORT;
     }
     /* most cases will be error */
     ack_len =
-        rp_ack_encode_apdu_init(&Handler_Transmit_Buffer[pdu_len],
+        rp_ack_encode_apdu_init(&context->tx_buffer[pdu_len],
         service_data->invoke_id, &data);
     /* FIXME: add buffer len as passed into function or use smart buffer */
     property_len =
-        Encode_Property_APDU(&Handler_Transmit_Buffer[pdu_len + ack_len],
+        Encode_Property_APDU(&context->tx_buffer[pdu_len + ack_len],
         &data, &error_class, &error_code);
     if (property_len >= 0) {
         len =
-            rp_ack_encode_apdu_object_property_end(&Handler_Transmit_Buffer
+            rp_ack_encode_apdu_object_property_end(&context->tx_buffer
             [pdu_len + property_len + ack_len]);
         len += ack_len + property_len;
     } else {
@@ -140,13 +140,13 @@ void handler_read_property(uint8_t * service_request,
                 /* BACnet APDU too small to fit data, so proper response is Abort */
             case BACNET_STATUS_ABORT:
                 len =
-                    abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    abort_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id,
                     ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, true);
                 break;
             default:
                 len =
-                    bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_READ_PROPERTY,
                     error_class, error_code);
                 break;
@@ -155,7 +155,8 @@ void handler_read_property(uint8_t * service_request,
   RP_ABORT:
     pdu_len += len;
 
-    datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+        pdu_len);
 
     return;
 }
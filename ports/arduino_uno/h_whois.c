@@ -69,7 +69,7 @@ void sendIamUnicast(uint8_t * buffer,
 
 void handler_who_is(uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     int32_t low_limit = 0;
@@ -80,12 +80,12 @@ void handler_who_is(uint8_t * service_request,
         whois_decode_service_request(service_request, service_len, &low_limit,
         &high_limit);
     if (len == 0) {
-        sendIamUnicast(&Handler_Transmit_Buffer[0], src);
+        sendIamUnicast(&context->tx_buffer[0], context->src);
     } else if (len != -1) {
         /* is my device id within the limits? */
         target_device = Device_Object_Instance_Number();
         if (((target_device >= low_limit) && (target_device <= high_limit)) {
-            sendIamUnicast(&Handler_Transmit_Buffer[0], src);
+            sendIamUnicast(&context->tx_buffer[0], context->src);
         }
     }
 
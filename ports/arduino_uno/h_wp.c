@@ -46,7 +46,7 @@ static BACNET_WRITE_PROPERTY_DATA wp_data;
 
 void handler_write_property(uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -62,16 +62,16 @@ void handler_write_property(uint8_t * service_request,
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     /* bad decoding or something we didn't understand - send an abort */
     if (len <= 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
     } else if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
     } else {
@@ -79,12 +79,12 @@ void handler_write_property(uint8_t * service_request,
             case OBJECT_DEVICE:
                 if (Device_Write_Property(&wp_data, &error_class, &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -94,12 +94,12 @@ void handler_write_property(uint8_t * service_request,
                 if (Analog_Value_Write_Property(&wp_data, &error_class,
                         &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -109,12 +109,12 @@ void handler_write_property(uint8_t * service_request,
                 if (Binary_Value_Write_Property(&wp_data, &error_class,
                         &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -122,14 +122,15 @@ void handler_write_property(uint8_t * service_request,
                 break;
             default:
                 len =
-                    bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY,
                     error_class, error_code);
                 break;
         }
     }
     pdu_len += len;
-    datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+    datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
+        pdu_len);
 
     return;
 }
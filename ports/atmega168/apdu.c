@@ -91,7 +91,7 @@ uint16_t apdu_decode_confirmed_service_request(
 }
 
 void apdu_handler(
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len)
 {
@@ -110,17 +110,17 @@ void apdu_handler(
                     &service_request_len);
                 if (service_choice == SERVICE_CONFIRMED_READ_PROPERTY) {
                     handler_read_property(service_request, service_request_len,
-                        src, &service_data);
+                        context, &service_data);
                 }
 #ifdef WRITE_PROPERTY
                 else if (service_choice == SERVICE_CONFIRMED_WRITE_PROPERTY) {
                     handler_write_property(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 }
 #endif
                 else {
                     handler_unrecognized_service(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 }
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
@@ -128,7 +128,8 @@ void apdu_handler(
                 service_request = &apdu[2];
                 service_request_len = apdu_len - 2;
                 if (service_choice == SERVICE_UNCONFIRMED_WHO_IS) {
-                    handler_who_is(service_request, service_request_len, src);
+                    handler_who_is(service_request, service_request_len,
+                        context);
                 }
                 break;
             case PDU_TYPE_SIMPLE_ACK:
@@ -42,14 +42,14 @@ bool Send_I_Am_Flag = true;
 void handler_who_is(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src)
+    BACNET_REQUEST_CONTEXT * context)
 {
     int len = 0;
     int32_t low_limit = 0;
     int32_t high_limit = 0;
     int32_t target_device;
 
-    (void) src;
+    (void) context;
     len =
         whois_decode_service_request(service_request, service_len, &low_limit,
         &high_limit);
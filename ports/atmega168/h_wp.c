@@ -47,7 +47,7 @@ static BACNET_WRITE_PROPERTY_DATA wp_data;
 void handler_write_property(
     uint8_t * service_request,
     uint16_t service_len,
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     int len = 0;
@@ -64,16 +64,16 @@ void handler_write_property(
     datalink_get_my_address(&my_address);
     npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
     pdu_len =
-        npdu_encode_pdu(&Handler_Transmit_Buffer[0], src, &my_address,
+        npdu_encode_pdu(&context->tx_buffer[0], context->src, &my_address,
         &npdu_data);
     /* bad decoding or something we didn't understand - send an abort */
     if (len <= 0) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_OTHER, true);
     } else if (service_data->segmented_message) {
         len =
-            abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            abort_encode_apdu(&context->tx_buffer[pdu_len],
             service_data->invoke_id, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
             true);
     } else {
@@ -81,12 +81,12 @@ void handler_write_property(
             case OBJECT_DEVICE:
                 if (Device_Write_Property(&wp_data, &error_class, &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -96,12 +96,12 @@ void handler_write_property(
                 if (Analog_Value_Write_Property(&wp_data, &error_class,
                         &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -111,12 +111,12 @@ void handler_write_property(
                 if (Binary_Value_Write_Property(&wp_data, &error_class,
                         &error_code)) {
                     len =
-                        encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+                        encode_simple_ack(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY);
                 } else {
                     len =
-                        bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                        bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                         service_data->invoke_id,
                         SERVICE_CONFIRMED_WRITE_PROPERTY, error_class,
                         error_code);
@@ -124,7 +124,7 @@ void handler_write_property(
                 break;
             default:
                 len =
-                    bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                    bacerror_encode_apdu(&context->tx_buffer[pdu_len],
                     service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY,
                     error_class, error_code);
                 break;
@@ -132,7 +132,7 @@ void handler_write_property(
     }
     pdu_len += len;
     bytes_sent =
-        datalink_send_pdu(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        datalink_send_pdu(context->src, &npdu_data, &context->tx_buffer[0],
         pdu_len);
 
     return;
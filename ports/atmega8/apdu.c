@@ -83,7 +83,7 @@ uint16_t apdu_decode_confirmed_service_request(
 }
 
 void apdu_handler(
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len)
 {
@@ -102,10 +102,10 @@ void apdu_handler(
                     &service_request_len);
                 if (service_choice == SERVICE_CONFIRMED_READ_PROPERTY) {
                     handler_read_property(service_request, service_request_len,
-                        src, &service_data);
+                        context, &service_data);
                 } else {
                     handler_unrecognized_service(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 }
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
@@ -151,7 +151,7 @@ static void Read_Properties(
         if (next_device) {
             next_device = false;
             index++;
-            if (index >= MAX_ADDRESS_CACHE)
+            if (index >= address_cache_size())
                 index = 0;
             property = 0;
         }
@@ -192,7 +192,7 @@ static void print_address_cache(
     unsigned max_apdu = 0;
 
     fprintf(stderr, "Device\tMAC\tMaxAPDU\tNet\n");
-    for (i = 0; i < MAX_ADDRESS_CACHE; i++) {
+    for (i = 0; i < address_cache_size(); i++) {
         if (address_get_by_index(i, &device_id, &max_apdu, &address)) {
             fprintf(stderr, "%u\t", device_id);
             for (j = 0; j < address.mac_len; j++) {
@@ -208,12 +208,12 @@ static void print_address_cache(
 static void print_tsm_stats(
     void)
 {
-    int idle = 0;
-    int total = 0;
+    unsigned idle = 0;
+    unsigned total = 0;
 
     idle = tsm_transaction_idle_count();
-    total = MAX_TSM_TRANSACTIONS;
-    fprintf(stderr, "TSM: %d idle of %d transactions\n", idle, total);
+    total = MAX_TSM_TRANSACTIONS_DYNAMIC;
+    fprintf(stderr, "TSM: %u idle of %u transactions\n", idle, total);
 }
 
 static void sig_handler(
@@ -32,6 +32,7 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 
+#define _GNU_SOURCE     /* for recvmmsg() and sendmmsg() */
 #include <stdint.h>     /* for standard integer types uint8_t etc. */
 #include <stdbool.h>    /* for the standard bool type. */
 #include "bacdcode.h"
@@ -215,6 +216,276 @@ bool bip_init(
     return true;
 }
 
+/** Opens another socket on the BACnet/IP port, bound to the address of
+ *  the interface with SO_REUSEPORT.  The kernel spreads the unicast
+ *  datagrams among such sockets by their source address and port, and
+ *  they take no broadcasts, which stay with the socket of bip_init().
+ *  Each should be used by one thread, set with bip_set_thread_socket().
+ *
+ * @return The socket, or -1 on failure.
+ */
+int bip_reuseport_socket(
+    void)
+{
+    struct sockaddr_in sin;
+    int sockopt = 1;
+    int sock_fd = -1;
+
+    if (bip_get_addr() == 0) {
+        /* bound to any address, it would take broadcasts too */
+        return -1;
+    }
+    sock_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock_fd < 0) {
+        return -1;
+    }
+    if ((setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockopt,
+                sizeof(sockopt)) < 0) ||
+        (setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &sockopt,
+                sizeof(sockopt)) < 0) ||
+        (setsockopt(sock_fd, SOL_SOCKET, SO_BROADCAST, &sockopt,
+                sizeof(sockopt)) < 0)) {
+        close(sock_fd);
+        return -1;
+    }
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = bip_get_addr();
+    sin.sin_port = bip_get_port();
+    memset(&(sin.sin_zero), '\0', sizeof(sin.sin_zero));
+    if (bind(sock_fd, (const struct sockaddr *) &sin,
+            sizeof(struct sockaddr)) < 0) {
+        close(sock_fd);
+        return -1;
+    }
+
+    return sock_fd;
+}
+
+#if (BIP_BURST_SIZE > 1)
+/* Each thread that receives or sends has its own burst of datagrams */
+/* datagrams received by the last recvmmsg(), returned one per call */
+static BACNET_THREAD_LOCAL uint8_t Rx_Buf[BIP_BURST_SIZE][MAX_MPDU];
+static BACNET_THREAD_LOCAL struct sockaddr_in Rx_Addr[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL struct iovec Rx_Iov[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL struct mmsghdr Rx_Msg[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL unsigned Rx_Count;
+static BACNET_THREAD_LOCAL unsigned Rx_Next;
+/* datagrams waiting for the next sendmmsg() */
+static BACNET_THREAD_LOCAL uint8_t Tx_Buf[BIP_BURST_SIZE][MAX_MPDU];
+static BACNET_THREAD_LOCAL struct sockaddr_in Tx_Addr[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL struct iovec Tx_Iov[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL struct mmsghdr Tx_Msg[BIP_BURST_SIZE];
+static BACNET_THREAD_LOCAL unsigned Tx_Count;
+static BACNET_THREAD_LOCAL bool Tx_Queue_Enabled;
+
+/** Queues the datagrams sent until bip_flush(), so that the replies
+ *  to a burst of requests leave in one sendmmsg() call.
+ *  Off by default, since a client that sends and then waits for a
+ *  reply must call bip_flush() before it waits.
+ * @param enable [in] True to queue.
+ */
+void bip_set_send_queue(
+    bool enable)
+{
+    if (!enable) {
+        bip_flush();
+    }
+    Tx_Queue_Enabled = enable;
+}
+
+/** Sends the queued datagrams, as many per sendmmsg() as it takes.
+ *  A datagram that the socket refuses is dropped, as sendto() would.
+ */
+void bip_flush(
+    void)
+{
+    unsigned sent = 0;
+    int rv = 0;
+
+    while (sent < Tx_Count) {
+        rv = sendmmsg(bip_socket(), &Tx_Msg[sent], Tx_Count - sent, 0);
+        if (rv > 0) {
+            sent += rv;
+        } else if ((rv < 0) && (errno == EINTR)) {
+            continue;
+        } else {
+            /* skip the datagram that failed */
+            sent++;
+        }
+    }
+    Tx_Count = 0;
+}
+
+/** Sends one BACnet/IP datagram, or queues it for bip_flush().
+ *
+ * @param dest [in] Destination address and port, in network byte order.
+ * @param mtu [in] The BVLL header and the NPDU.
+ * @param mtu_len [in] Number of bytes in the mtu buffer.
+ * @return Number of bytes sent or queued, negative number on failure.
+ */
+int bip_send_mpdu(
+    struct sockaddr_in *dest,
+    uint8_t * mtu,
+    uint16_t mtu_len)
+{
+    if (!bip_valid()) {
+        return -1;
+    }
+    if (!Tx_Queue_Enabled || (mtu_len > MAX_MPDU)) {
+        return sendto(bip_socket(), (char *) mtu, mtu_len, 0,
+            (struct sockaddr *) dest, sizeof(struct sockaddr));
+    }
+    if (Tx_Count >= BIP_BURST_SIZE) {
+        bip_flush();
+    }
+    memcpy(Tx_Buf[Tx_Count], mtu, mtu_len);
+    Tx_Addr[Tx_Count] = *dest;
+    Tx_Iov[Tx_Count].iov_base = Tx_Buf[Tx_Count];
+    Tx_Iov[Tx_Count].iov_len = mtu_len;
+    memset(&Tx_Msg[Tx_Count], 0, sizeof(Tx_Msg[Tx_Count]));
+    Tx_Msg[Tx_Count].msg_hdr.msg_name = &Tx_Addr[Tx_Count];
+    Tx_Msg[Tx_Count].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    Tx_Msg[Tx_Count].msg_hdr.msg_iov = &Tx_Iov[Tx_Count];
+    Tx_Msg[Tx_Count].msg_hdr.msg_iovlen = 1;
+    Tx_Count++;
+
+    return mtu_len;
+}
+
+/** Gets the number of datagrams from the last burst that
+ *  bip_receive_mpdu() will return without waiting.
+ * @return The number of datagrams pending.
+ */
+unsigned bip_receive_pending(
+    void)
+{
+    return Rx_Count - Rx_Next;
+}
+
+/* reads a burst of datagrams that are already waiting on the socket */
+static void bip_receive_burst(
+    void)
+{
+    unsigned i = 0;
+    int rv = 0;
+
+    for (i = 0; i < BIP_BURST_SIZE; i++) {
+        Rx_Iov[i].iov_base = Rx_Buf[i];
+        Rx_Iov[i].iov_len = MAX_MPDU;
+        memset(&Rx_Msg[i], 0, sizeof(Rx_Msg[i]));
+        Rx_Msg[i].msg_hdr.msg_name = &Rx_Addr[i];
+        Rx_Msg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        Rx_Msg[i].msg_hdr.msg_iov = &Rx_Iov[i];
+        Rx_Msg[i].msg_hdr.msg_iovlen = 1;
+    }
+    rv = recvmmsg(bip_socket(), Rx_Msg, BIP_BURST_SIZE, MSG_DONTWAIT,
+        NULL);
+    Rx_Next = 0;
+    Rx_Count = (rv > 0) ? (unsigned) rv : 0;
+}
+
+/** Waits for a datagram, unless some of the last burst are pending,
+ *  and then reads a burst of them.  Any queued datagrams are sent
+ *  before waiting on the socket.
+ * @param timeout [in] The number of milliseconds to wait for a datagram.
+ * @return true if bip_receive_mpdu() has a datagram to return at once.
+ */
+bool bip_receive_wait(
+    unsigned timeout)
+{
+    fd_set read_fds;
+    struct timeval select_timeout;
+    int sock_fd = bip_socket();
+
+    if (sock_fd < 0) {
+        return false;
+    }
+    if (Rx_Next < Rx_Count) {
+        return true;
+    }
+    bip_flush();
+    select_timeout.tv_sec = timeout / 1000;
+    select_timeout.tv_usec = 1000 * (timeout % 1000);
+    FD_ZERO(&read_fds);
+    FD_SET(sock_fd, &read_fds);
+    if (select(sock_fd + 1, &read_fds, NULL, NULL, &select_timeout) <= 0) {
+        return false;
+    }
+    bip_receive_burst();
+
+    return (Rx_Next < Rx_Count);
+}
+
+/* skips the pending datagrams larger than a BACnet/IP MPDU */
+static struct mmsghdr *bip_receive_next(
+    uint16_t max_mtu)
+{
+    struct mmsghdr *msg = NULL;
+
+    while (Rx_Next < Rx_Count) {
+        msg = &Rx_Msg[Rx_Next];
+        if ((msg->msg_hdr.msg_flags & MSG_TRUNC) || (msg->msg_len > max_mtu)) {
+            Rx_Next++;
+            continue;
+        }
+        return msg;
+    }
+
+    return NULL;
+}
+
+/** Looks at the datagram that bip_receive_mpdu() will return next,
+ *  without taking it, so that the caller can decide how to handle it.
+ * @param mtu_len [out] Number of bytes in the datagram.
+ * @return The BVLL header and the NPDU, or NULL if none is pending.
+ */
+uint8_t *bip_receive_peek(
+    uint16_t * mtu_len)
+{
+    struct mmsghdr *msg = bip_receive_next(MAX_MPDU);
+
+    if (!msg) {
+        return NULL;
+    }
+    *mtu_len = (uint16_t) msg->msg_len;
+
+    return (uint8_t *) msg->msg_hdr.msg_iov->iov_base;
+}
+
+/** Receives one BACnet/IP datagram.  The socket is read a burst at a
+ *  time with recvmmsg(), and the rest of the burst is returned by the
+ *  next calls without a system call.  Any queued datagrams are sent
+ *  before waiting on the socket.
+ *
+ * @param sin [out] Source address and port, in network byte order.
+ * @param mtu [out] Buffer for the BVLL header and the NPDU.
+ * @param max_mtu [in] Size of the mtu buffer.
+ * @param timeout [in] The number of milliseconds to wait for a datagram.
+ * @return Number of bytes received, or zero if none.
+ */
+int bip_receive_mpdu(
+    struct sockaddr_in *sin,
+    uint8_t * mtu,
+    uint16_t max_mtu,
+    unsigned timeout)
+{
+    struct mmsghdr *msg = NULL;
+
+    if (!bip_receive_wait(timeout)) {
+        return 0;
+    }
+    msg = bip_receive_next(max_mtu);
+    if (!msg) {
+        return 0;
+    }
+    Rx_Next++;
+    memcpy(mtu, msg->msg_hdr.msg_iov->iov_base, msg->msg_len);
+    *sin = *(struct sockaddr_in *) msg->msg_hdr.msg_name;
+
+    return (int) msg->msg_len;
+}
+#endif
+
 /** Cleanup and close out the BACnet/IP services by closing the socket.
  * @ingroup DLBIP
   */
@@ -224,6 +495,11 @@ void bip_cleanup(
     int sock_fd = 0;
 
     if (bip_valid()) {
+#if (BIP_BURST_SIZE > 1)
+        bip_flush();
+        Rx_Count = 0;
+        Rx_Next = 0;
+#endif
         sock_fd = bip_socket();
         close(sock_fd);
     }
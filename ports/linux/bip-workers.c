@@ -0,0 +1,321 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#define _GNU_SOURCE     /* for pthread_rwlockattr_setkind_np() */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "bacdef.h"
+#include "bacenum.h"
+#include "bits.h"
+#include "npdu.h"
+#include "bip.h"
+#include "datalink.h"
+#include "tsm.h"
+#include "bip-workers.h"
+
+/** @file linux/bip-workers.c  Threads that serve BACnet/IP requests.
+ *
+ * Each worker has a socket from bip_reuseport_socket(), among which the
+ * kernel spreads the unicast datagrams by their source address, and its
+ * own receive burst, transmit queue and Handler_Transmit_Buffer.
+ *
+ * The objects are guarded by a readers/writer lock.  A worker looks at
+ * each datagram before it takes it, and serves the requests that only
+ * read the objects - unsegmented ReadProperty and ReadPropertyMultiple,
+ * Who-Is and Who-Has - under the shared lock, so that those do not wait
+ * for each other.  Anything else, and the tasks of the main loop, are
+ * run under the exclusive lock, one at a time as before.  The few TSM
+ * functions that the readers call take a mutex of their own.
+ *
+ * How far this raises throughput depends on the cores that the
+ * server and its clients have; bin/bacrpbench.sh measures it for each
+ * worker count on the machine at hand.
+ */
+
+struct bip_worker {
+    pthread_t thread;
+    int sock_fd;
+};
+static struct bip_worker Worker[MAX_BIP_WORKERS];
+static unsigned Worker_Count;
+/* true while the workers use the lock */
+static bool Workers_Running;
+/* read by the workers while the main thread sets it */
+static bool Workers_Stop;
+static bip_worker_handler Workers_Handler;
+static bip_worker_refresh Workers_Refresh;
+static pthread_rwlock_t Workers_Lock;
+static pthread_mutex_t Workers_TSM_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* milliseconds that an idle worker waits before it looks for a stop;
+   bip_workers_stop() wakes the workers at once */
+#define BIP_WORKER_TIMEOUT 10000
+
+static void bip_workers_tsm_lock(
+    void)
+{
+    pthread_mutex_lock(&Workers_TSM_Mutex);
+}
+
+static void bip_workers_tsm_unlock(
+    void)
+{
+    pthread_mutex_unlock(&Workers_TSM_Mutex);
+}
+
+/** Tells whether a datagram may be served under the shared lock: an
+ *  NPDU for this device with an unsegmented ReadProperty or
+ *  ReadPropertyMultiple request, or a Who-Is or Who-Has.
+ *
+ * @param mtu [in] The BVLL header and the NPDU.
+ * @param mtu_len [in] Number of bytes in the mtu buffer.
+ * @return true if serving it only reads the objects.
+ */
+bool bip_workers_shared(
+    uint8_t * mtu,
+    uint16_t mtu_len)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t *apdu = NULL;
+    uint16_t offset = 0;
+    int apdu_offset = 0;
+
+    if ((mtu_len < 4) || (mtu[0] != BVLL_TYPE_BACNET_IP)) {
+        return false;
+    }
+    switch (mtu[1]) {
+        case BVLC_ORIGINAL_UNICAST_NPDU:
+        case BVLC_ORIGINAL_BROADCAST_NPDU:
+            offset = 4;
+            break;
+        case BVLC_FORWARDED_NPDU:
+            offset = 4 + 6;
+            break;
+        default:
+            /* BBMD tables and results are changed by these */
+            return false;
+    }
+    if ((mtu_len <= offset) || (mtu[offset] != BACNET_PROTOCOL_VERSION)) {
+        return false;
+    }
+    apdu_offset = npdu_decode(&mtu[offset], &dest, &src, &npdu_data);
+    if (npdu_data.network_layer_message || (apdu_offset <= 0) ||
+        ((offset + apdu_offset + 2) > mtu_len)) {
+        return false;
+    }
+    if ((dest.net != 0) && (dest.net != BACNET_BROADCAST_NETWORK)) {
+        return false;
+    }
+    apdu = &mtu[offset + apdu_offset];
+    switch (apdu[0] & 0xF0) {
+        case PDU_TYPE_CONFIRMED_SERVICE_REQUEST:
+            /* the segments of a request are put together by the TSM */
+            if ((apdu[0] & BIT3) || ((offset + apdu_offset + 4) > mtu_len)) {
+                return false;
+            }
+            return ((apdu[3] == SERVICE_CONFIRMED_READ_PROPERTY) ||
+                (apdu[3] == SERVICE_CONFIRMED_READ_PROP_MULTIPLE));
+        case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
+            return ((apdu[1] == SERVICE_UNCONFIRMED_WHO_IS) ||
+                (apdu[1] == SERVICE_UNCONFIRMED_WHO_HAS));
+        default:
+            break;
+    }
+
+    return false;
+}
+
+/** Takes the lock for changing the objects, which waits until
+ *  no worker is reading them.  Does nothing without workers.
+ */
+void bip_workers_lock(
+    void)
+{
+    if (Workers_Running) {
+        pthread_rwlock_wrlock(&Workers_Lock);
+    }
+}
+
+/** Makes the objects ready to be read again, and releases the lock
+ *  taken by bip_workers_lock().
+ */
+void bip_workers_unlock(
+    void)
+{
+    if (Workers_Running) {
+        if (Workers_Refresh) {
+            Workers_Refresh();
+        }
+        pthread_rwlock_unlock(&Workers_Lock);
+    }
+}
+
+static void *bip_worker_thread(
+    void *context)
+{
+    struct bip_worker *worker = (struct bip_worker *) context;
+    BACNET_ADDRESS src = { 0 };
+    uint8_t pdu[MAX_MPDU];
+    uint16_t pdu_len = 0;
+    uint8_t *mtu = NULL;
+    uint16_t mtu_len = 0;
+    bool shared = false;
+
+    bip_set_thread_socket(worker->sock_fd);
+    /* the replies to a burst leave together, when the burst is done */
+    bip_set_send_queue(true);
+    while (!__atomic_load_n(&Workers_Stop, __ATOMIC_RELAXED)) {
+        if (!bip_receive_wait(BIP_WORKER_TIMEOUT)) {
+            continue;
+        }
+        while ((mtu = bip_receive_peek(&mtu_len)) != NULL) {
+            shared = bip_workers_shared(mtu, mtu_len);
+            if (shared) {
+                pthread_rwlock_rdlock(&Workers_Lock);
+            } else {
+                bip_workers_lock();
+            }
+            pdu_len = datalink_receive(&src, &pdu[0], MAX_MPDU, 0);
+            if (pdu_len) {
+                Workers_Handler(&src, &pdu[0], pdu_len);
+            }
+            if (shared) {
+                pthread_rwlock_unlock(&Workers_Lock);
+            } else {
+                bip_workers_unlock();
+            }
+        }
+    }
+    bip_set_send_queue(false);
+
+    return NULL;
+}
+
+/** Starts threads that serve the unicast requests to the BACnet/IP
+ *  port, each on a socket of its own.  The broadcasts still arrive at
+ *  the socket of bip_init(), which the caller serves as before, under
+ *  bip_workers_lock().  The caller also takes that lock whenever it
+ *  runs anything that uses the objects, the TSM or the BBMD tables.
+ *
+ * @param count [in] Number of threads, up to MAX_BIP_WORKERS.
+ * @param handler [in] Handler of each received NPDU.
+ * @param refresh [in] Called under the exclusive lock, before it is
+ *  released, to make the objects ready to be read at once; or NULL.
+ * @return true if at least one worker was started.
+ */
+bool bip_workers_start(
+    unsigned count,
+    bip_worker_handler handler,
+    bip_worker_refresh refresh)
+{
+    pthread_rwlockattr_t attr;
+    sigset_t signals;
+    sigset_t old_signals;
+    unsigned i = 0;
+
+    if (Workers_Running || !handler || (count == 0)) {
+        return false;
+    }
+    if (count > MAX_BIP_WORKERS) {
+        count = MAX_BIP_WORKERS;
+    }
+    Workers_Handler = handler;
+    Workers_Refresh = refresh;
+    pthread_rwlockattr_init(&attr);
+    /* otherwise a steady stream of readers keeps the main loop out */
+    pthread_rwlockattr_setkind_np(&attr,
+        PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&Workers_Lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    if (Workers_Refresh) {
+        Workers_Refresh();
+    }
+    tsm_set_lock_handlers(bip_workers_tsm_lock, bip_workers_tsm_unlock);
+    __atomic_store_n(&Workers_Stop, false, __ATOMIC_RELAXED);
+    Workers_Running = true;
+    /* the signals are left to the main thread */
+    sigfillset(&signals);
+    pthread_sigmask(SIG_SETMASK, &signals, &old_signals);
+    for (i = 0; i < count; i++) {
+        Worker[Worker_Count].sock_fd = bip_reuseport_socket();
+        if (Worker[Worker_Count].sock_fd < 0) {
+            break;
+        }
+        if (pthread_create(&Worker[Worker_Count].thread, NULL,
+                bip_worker_thread, &Worker[Worker_Count]) != 0) {
+            close(Worker[Worker_Count].sock_fd);
+            break;
+        }
+        Worker_Count++;
+    }
+    pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+    if (Worker_Count == 0) {
+        Workers_Running = false;
+        tsm_set_lock_handlers(NULL, NULL);
+        pthread_rwlock_destroy(&Workers_Lock);
+        return false;
+    }
+
+    return true;
+}
+
+/** Stops the workers and closes their sockets. */
+void bip_workers_stop(
+    void)
+{
+    unsigned i = 0;
+
+    if (!Workers_Running) {
+        return;
+    }
+    __atomic_store_n(&Workers_Stop, true, __ATOMIC_RELAXED);
+    /* a shutdown wakes a thread that is waiting on the socket */
+    for (i = 0; i < Worker_Count; i++) {
+        shutdown(Worker[i].sock_fd, SHUT_RD);
+    }
+    for (i = 0; i < Worker_Count; i++) {
+        pthread_join(Worker[i].thread, NULL);
+        close(Worker[i].sock_fd);
+    }
+    Worker_Count = 0;
+    Workers_Running = false;
+    tsm_set_lock_handlers(NULL, NULL);
+    pthread_rwlock_destroy(&Workers_Lock);
+}
+
+/** Gets the number of workers that are running.
+ * @return number of workers
+ */
+unsigned bip_workers_count(
+    void)
+{
+    return Worker_Count;
+}
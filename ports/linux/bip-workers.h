@@ -0,0 +1,77 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef BIP_WORKERS_H
+#define BIP_WORKERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacdef.h"
+
+/** @file linux/bip-workers.h  Threads that serve BACnet/IP requests,
+ *  each with a socket of its own from bip_reuseport_socket(). */
+
+/* Most threads that can serve requests at once */
+#ifndef MAX_BIP_WORKERS
+#define MAX_BIP_WORKERS 64
+#endif
+
+/* handles a received NPDU, such as npdu_handler() */
+typedef void (
+    *bip_worker_handler) (
+    BACNET_ADDRESS * src,
+    uint8_t * pdu,
+    uint16_t pdu_len);
+
+/* makes the objects ready to be read by several threads at once */
+typedef void (
+    *bip_worker_refresh) (
+    void);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    bool bip_workers_start(
+        unsigned count,
+        bip_worker_handler handler,
+        bip_worker_refresh refresh);
+    void bip_workers_stop(
+        void);
+    unsigned bip_workers_count(
+        void);
+
+    void bip_workers_lock(
+        void);
+    void bip_workers_unlock(
+        void);
+
+    bool bip_workers_shared(
+        uint8_t * mtu,
+        uint16_t mtu_len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,509 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "evloop.h"
+
+/** @file linux/evloop.c  Event loop of file descriptors and timers.
+ *
+ * Each evloop_run_once() arms one timerfd for the earliest timer, then
+ * sleeps in epoll_wait() until that timer or a watched descriptor is
+ * ready, so an idle task uses no CPU time.  An eventfd lets a signal
+ * handler or another thread end the wait early.
+ *
+ * The timers are kept in a hierarchical timer wheel with millisecond
+ * ticks: level 0 has one slot per millisecond for the next 64 ms,
+ * and each higher level has slots 64 times as long.  A timer is moved
+ * down a level each time its slot comes around ("cascade"), so a start
+ * or stop costs the same no matter how many timers are running.
+ */
+
+#define EVLOOP_WHEEL_BITS 6
+#define EVLOOP_WHEEL_SIZE (1 << EVLOOP_WHEEL_BITS)
+#define EVLOOP_WHEEL_MASK (EVLOOP_WHEEL_SIZE - 1)
+#define EVLOOP_WHEEL_LEVELS 4
+/* the longest interval the wheel holds; longer timers are cascaded
+   at the top level until they are in range */
+#define EVLOOP_WHEEL_RANGE \
+    ((1UL << (EVLOOP_WHEEL_BITS * EVLOOP_WHEEL_LEVELS)) - 1)
+
+static struct evloop_timer
+    *Wheel[EVLOOP_WHEEL_LEVELS][EVLOOP_WHEEL_SIZE];
+static unsigned Wheel_Count[EVLOOP_WHEEL_LEVELS];
+/* the next tick of the wheel to be run */
+static uint32_t Wheel_Clock;
+
+struct evloop_source {
+    int fd;
+    evloop_fd_callback callback;
+    void *context;
+};
+static struct evloop_source Source[MAX_EVLOOP_FDS];
+
+static int Epoll_Fd = -1;
+static int Timer_Fd = -1;
+static int Event_Fd = -1;
+
+/**
+ * Gets the milliseconds of the monotonic clock that the timers use.
+ * It wraps around after about 49 days.
+ *
+ * @return milliseconds since some unspecified time
+ */
+uint32_t evloop_milliseconds(
+    void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t) now.tv_sec * 1000 + (uint32_t) (now.tv_nsec / 1000000);
+}
+
+static void evloop_timer_link(
+    struct evloop_timer **head,
+    struct evloop_timer *timer)
+{
+    timer->next = *head;
+    if (timer->next) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void evloop_timer_unlink(
+    struct evloop_timer *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+    Wheel_Count[timer->level]--;
+}
+
+/* puts a timer in the slot for its expiry, relative to Wheel_Clock */
+static void evloop_timer_insert(
+    struct evloop_timer *timer)
+{
+    int32_t delta = (int32_t) (timer->expires - Wheel_Clock);
+    uint32_t expires = timer->expires;
+    unsigned level = 0;
+    unsigned slot = 0;
+
+    if (delta < 0) {
+        /* overdue: run on the next tick */
+        expires = Wheel_Clock;
+    } else if ((uint32_t) delta > EVLOOP_WHEEL_RANGE) {
+        expires = Wheel_Clock + EVLOOP_WHEEL_RANGE;
+        level = EVLOOP_WHEEL_LEVELS - 1;
+    } else {
+        while ((level < (EVLOOP_WHEEL_LEVELS - 1)) &&
+            ((uint32_t) delta >= (1UL << (EVLOOP_WHEEL_BITS * (level +
+                            1))))) {
+            level++;
+        }
+    }
+    slot = (expires >> (EVLOOP_WHEEL_BITS * level)) & EVLOOP_WHEEL_MASK;
+    timer->level = level;
+    Wheel_Count[level]++;
+    evloop_timer_link(&Wheel[level][slot], timer);
+}
+
+/* moves the timers of the slots that come due at Wheel_Clock down */
+static void evloop_timer_cascade(
+    void)
+{
+    struct evloop_timer *list = NULL;
+    struct evloop_timer *timer = NULL;
+    unsigned level = 0;
+    unsigned slot = 0;
+
+    for (level = 1; level < EVLOOP_WHEEL_LEVELS; level++) {
+        slot = (Wheel_Clock >> (EVLOOP_WHEEL_BITS * level)) &
+            EVLOOP_WHEEL_MASK;
+        list = Wheel[level][slot];
+        Wheel[level][slot] = NULL;
+        if (list) {
+            list->pprev = &list;
+        }
+        while (list) {
+            timer = list;
+            evloop_timer_unlink(timer);
+            evloop_timer_insert(timer);
+        }
+        if (slot != 0) {
+            break;
+        }
+    }
+}
+
+/* runs the timers that are due at or before now */
+static void evloop_timer_advance(
+    uint32_t now)
+{
+    struct evloop_timer *list = NULL;
+    struct evloop_timer *timer = NULL;
+    unsigned level = 0;
+    uint32_t span = 0;
+    uint32_t next = 0;
+    unsigned slot = 0;
+
+    while ((int32_t) (now - Wheel_Clock) >= 0) {
+        if (Wheel_Count[0] == 0) {
+            /* nothing to run until the next cascade of a higher level */
+            for (level = 1; level < EVLOOP_WHEEL_LEVELS; level++) {
+                if (Wheel_Count[level]) {
+                    break;
+                }
+            }
+            if (level == EVLOOP_WHEEL_LEVELS) {
+                Wheel_Clock = now + 1;
+                break;
+            }
+            span = 1UL << (EVLOOP_WHEEL_BITS * level);
+            next = (Wheel_Clock + span - 1) & ~(span - 1);
+            if ((int32_t) (now - next) < 0) {
+                Wheel_Clock = now + 1;
+                break;
+            }
+            Wheel_Clock = next;
+        }
+        slot = Wheel_Clock & EVLOOP_WHEEL_MASK;
+        if (slot == 0) {
+            evloop_timer_cascade();
+        }
+        list = Wheel[0][slot];
+        Wheel[0][slot] = NULL;
+        if (list) {
+            list->pprev = &list;
+        }
+        /* a timer started by a callback is due on a later tick */
+        Wheel_Clock++;
+        while (list) {
+            timer = list;
+            evloop_timer_unlink(timer);
+            timer->callback(timer->context);
+        }
+    }
+}
+
+/* gets the tick of the next timer or cascade; false if none */
+static bool evloop_timer_next(
+    uint32_t * tick)
+{
+    bool found = false;
+    unsigned level = 0;
+    unsigned slot = 0;
+    unsigned i = 0;
+    uint32_t span = 0;
+    uint32_t next = 0;
+
+    if (Wheel_Count[0]) {
+        for (i = 0; i < EVLOOP_WHEEL_SIZE; i++) {
+            if (Wheel[0][(Wheel_Clock + i) & EVLOOP_WHEEL_MASK]) {
+                *tick = Wheel_Clock + i;
+                found = true;
+                break;
+            }
+        }
+    }
+    for (level = 1; level < EVLOOP_WHEEL_LEVELS; level++) {
+        if (Wheel_Count[level] == 0) {
+            continue;
+        }
+        span = 1UL << (EVLOOP_WHEEL_BITS * level);
+        next = (Wheel_Clock + span - 1) & ~(span - 1);
+        slot = (next >> (EVLOOP_WHEEL_BITS * level)) & EVLOOP_WHEEL_MASK;
+        for (i = 0; i < EVLOOP_WHEEL_SIZE; i++) {
+            if (Wheel[level][(slot + i) & EVLOOP_WHEEL_MASK]) {
+                next += i * span;
+                if (!found || ((int32_t) (next - *tick) < 0)) {
+                    *tick = next;
+                    found = true;
+                }
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+/**
+ * Sets up a timer before it is first started.
+ *
+ * @param timer - timer to set up
+ * @param callback - function called when the timer expires
+ * @param context - passed to the callback
+ */
+void evloop_timer_init(
+    struct evloop_timer *timer,
+    evloop_timer_callback callback,
+    void *context)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->level = 0;
+    timer->callback = callback;
+    timer->context = context;
+}
+
+/**
+ * Starts a timer, or restarts it if it is pending.  The callback is
+ * run once, from evloop_run_once(), and may start the timer again.
+ * A timer whose tick has already been run, such as one started for
+ * zero milliseconds, is run on the next tick.
+ *
+ * @param timer - timer set up by evloop_timer_init()
+ * @param milliseconds - time from now until the timer expires
+ */
+void evloop_timer_start(
+    struct evloop_timer *timer,
+    uint32_t milliseconds)
+{
+    if (timer->pprev) {
+        evloop_timer_unlink(timer);
+    }
+    timer->expires = evloop_milliseconds() + milliseconds;
+    evloop_timer_insert(timer);
+}
+
+/**
+ * Stops a timer, if it is pending.
+ *
+ * @param timer - timer set up by evloop_timer_init()
+ */
+void evloop_timer_stop(
+    struct evloop_timer *timer)
+{
+    if (timer->pprev) {
+        evloop_timer_unlink(timer);
+    }
+}
+
+/**
+ * @param timer - timer set up by evloop_timer_init()
+ * @return true if the timer is started and has not yet expired
+ */
+bool evloop_timer_pending(
+    struct evloop_timer *timer)
+{
+    return (timer->pprev != NULL);
+}
+
+/* empties the counter of the eventfd or the timerfd */
+static void evloop_counter_read(
+    int fd,
+    void *context)
+{
+    uint64_t count = 0;
+
+    (void) context;
+    while (read(fd, &count, sizeof(count)) == sizeof(count)) {
+        /* nothing else to do - it only ends the wait */
+    }
+}
+
+/**
+ * Adds a file descriptor to the loop.  The callback is run from
+ * evloop_run_once() while the descriptor is readable, so it should
+ * read at least some of what is waiting.
+ *
+ * @param fd - file descriptor, such as a socket
+ * @param callback - function called when fd is readable
+ * @param context - passed to the callback
+ * @return true if added
+ */
+bool evloop_fd_add(
+    int fd,
+    evloop_fd_callback callback,
+    void *context)
+{
+    struct epoll_event event = { 0 };
+    unsigned i = 0;
+
+    if ((Epoll_Fd < 0) || (fd < 0)) {
+        return false;
+    }
+    for (i = 0; i < MAX_EVLOOP_FDS; i++) {
+        if (Source[i].callback == NULL) {
+            event.events = EPOLLIN;
+            event.data.ptr = &Source[i];
+            if (epoll_ctl(Epoll_Fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+                return false;
+            }
+            Source[i].fd = fd;
+            Source[i].callback = callback;
+            Source[i].context = context;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Removes a file descriptor from the loop.
+ *
+ * @param fd - file descriptor given to evloop_fd_add()
+ */
+void evloop_fd_remove(
+    int fd)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_EVLOOP_FDS; i++) {
+        if (Source[i].callback && (Source[i].fd == fd)) {
+            (void) epoll_ctl(Epoll_Fd, EPOLL_CTL_DEL, fd, NULL);
+            Source[i].fd = -1;
+            Source[i].callback = NULL;
+            Source[i].context = NULL;
+        }
+    }
+}
+
+/**
+ * Waits until a timer is due or a file descriptor is readable, then
+ * runs the callbacks of the readable file descriptors, and then those
+ * of the timers that are due.  It does not wait if a timer is already
+ * due, and waits without a time limit if no timer is pending.
+ */
+void evloop_run_once(
+    void)
+{
+    struct epoll_event events[MAX_EVLOOP_FDS];
+    struct itimerspec spec = { {0} };
+    struct evloop_source *source = NULL;
+    uint32_t tick = 0;
+    int32_t delta = 0;
+    int timeout = -1;
+    int count = 0;
+    int i = 0;
+
+    if (Epoll_Fd < 0) {
+        return;
+    }
+    evloop_timer_advance(evloop_milliseconds());
+    if (evloop_timer_next(&tick)) {
+        delta = (int32_t) (tick - evloop_milliseconds());
+        if (delta > 0) {
+            spec.it_value.tv_sec = delta / 1000;
+            spec.it_value.tv_nsec = (delta % 1000) * 1000000L;
+        } else {
+            timeout = 0;
+        }
+    }
+    /* a zero it_value disarms the timer */
+    (void) timerfd_settime(Timer_Fd, 0, &spec, NULL);
+    count = epoll_wait(Epoll_Fd, events, MAX_EVLOOP_FDS, timeout);
+    for (i = 0; i < count; i++) {
+        source = events[i].data.ptr;
+        /* skip one removed by an earlier callback */
+        if (source->callback) {
+            source->callback(source->fd, source->context);
+        }
+    }
+    evloop_timer_advance(evloop_milliseconds());
+}
+
+/**
+ * Ends the wait of evloop_run_once().  It is safe to call from a signal
+ * handler or from another thread.
+ */
+void evloop_wakeup(
+    void)
+{
+    uint64_t count = 1;
+
+    if (Event_Fd >= 0) {
+        (void) write(Event_Fd, &count, sizeof(count));
+    }
+}
+
+/**
+ * Closes the epoll, timerfd and eventfd descriptors.  The file
+ * descriptors that were added are not closed, and timers are left
+ * pending.
+ */
+void evloop_cleanup(
+    void)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < MAX_EVLOOP_FDS; i++) {
+        Source[i].fd = -1;
+        Source[i].callback = NULL;
+        Source[i].context = NULL;
+    }
+    if (Timer_Fd >= 0) {
+        close(Timer_Fd);
+        Timer_Fd = -1;
+    }
+    if (Event_Fd >= 0) {
+        close(Event_Fd);
+        Event_Fd = -1;
+    }
+    if (Epoll_Fd >= 0) {
+        close(Epoll_Fd);
+        Epoll_Fd = -1;
+    }
+}
+
+/**
+ * Creates the epoll, timerfd and eventfd descriptors of the loop.
+ *
+ * @return true if the loop is ready for use
+ */
+bool evloop_init(
+    void)
+{
+    if (Epoll_Fd >= 0) {
+        return true;
+    }
+    Wheel_Clock = evloop_milliseconds();
+    Epoll_Fd = epoll_create1(EPOLL_CLOEXEC);
+    Timer_Fd =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    Event_Fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((Epoll_Fd < 0) || (Timer_Fd < 0) || (Event_Fd < 0) ||
+        !evloop_fd_add(Timer_Fd, evloop_counter_read, NULL) ||
+        !evloop_fd_add(Event_Fd, evloop_counter_read, NULL)) {
+        evloop_cleanup();
+        return false;
+    }
+
+    return true;
+}
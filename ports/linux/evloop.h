@@ -0,0 +1,99 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @file linux/evloop.h  Event loop of file descriptors and timers,
+ *  built on epoll, timerfd and eventfd, so that a task sleeps until a
+ *  socket is readable or a timer is due. */
+
+/* Number of file descriptors that can be watched at once */
+#ifndef MAX_EVLOOP_FDS
+#define MAX_EVLOOP_FDS 16
+#endif
+
+typedef void (
+    *evloop_fd_callback) (
+    int fd,
+    void *context);
+
+typedef void (
+    *evloop_timer_callback) (
+    void *context);
+
+/* A timer of the hierarchical timer wheel.  It is owned by the caller
+   and only linked into the wheel while it is pending. */
+struct evloop_timer {
+    struct evloop_timer *next;
+    struct evloop_timer **pprev;
+    /* evloop_milliseconds() at which the timer is due */
+    uint32_t expires;
+    uint8_t level;
+    evloop_timer_callback callback;
+    void *context;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    bool evloop_init(
+        void);
+    void evloop_cleanup(
+        void);
+
+    bool evloop_fd_add(
+        int fd,
+        evloop_fd_callback callback,
+        void *context);
+    void evloop_fd_remove(
+        int fd);
+
+    uint32_t evloop_milliseconds(
+        void);
+    void evloop_timer_init(
+        struct evloop_timer *timer,
+        evloop_timer_callback callback,
+        void *context);
+    void evloop_timer_start(
+        struct evloop_timer *timer,
+        uint32_t milliseconds);
+    void evloop_timer_stop(
+        struct evloop_timer *timer);
+    bool evloop_timer_pending(
+        struct evloop_timer *timer);
+
+    void evloop_run_once(
+        void);
+    void evloop_wakeup(
+        void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
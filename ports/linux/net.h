@@ -102,6 +102,12 @@
 
 /** @file linux/net.h  Includes Linux network headers. */
 
+/* Number of datagrams moved per recvmmsg() or sendmmsg() call
+   by the BACnet/IP datalink; 1 receives and sends them singly */
+#ifndef BIP_BURST_SIZE
+#define BIP_BURST_SIZE 32
+#endif
+
 /* Local helper functions for this port */
 extern int bip_get_local_netmask(
     struct in_addr *netmask);
@@ -160,7 +160,7 @@ static bool apdu_unconfirmed_dcc_disabled(
 }
 
 void apdu_handler(
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len)
 {
@@ -185,21 +185,21 @@ void apdu_handler(
                 }
                 if (service_choice == SERVICE_CONFIRMED_READ_PROPERTY) {
                     handler_read_property(service_request, service_request_len,
-                        src, &service_data);
+                        context, &service_data);
                 } else if (service_choice == SERVICE_CONFIRMED_WRITE_PROPERTY) {
                     handler_write_property(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 } else if (service_choice ==
                     SERVICE_CONFIRMED_REINITIALIZE_DEVICE) {
                     handler_reinitialize_device(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 } else if (service_choice ==
                     SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL) {
                     handler_device_communication_control(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 } else {
                     handler_unrecognized_service(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 }
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
@@ -215,7 +215,8 @@ void apdu_handler(
                     break;
                 }
                 if (service_choice == SERVICE_UNCONFIRMED_WHO_IS) {
-                    handler_who_is(service_request, service_request_len, src);
+                    handler_who_is(service_request, service_request_len,
+                        context);
                 }
                 break;
             case PDU_TYPE_SIMPLE_ACK:
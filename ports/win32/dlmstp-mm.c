@@ -677,13 +677,14 @@ bool dlmstp_init(
 
 #ifdef TEST_DLMSTP
 #include <stdio.h>
+#include "apdu.h"
 
 void apdu_handler(
-    BACNET_ADDRESS * src,       /* source address */
+    BACNET_REQUEST_CONTEXT * context,   /* source address, buffers */
     uint8_t * apdu,     /* APDU data */
     uint16_t pdu_len)
 {       /* for confirmed messages */
-    (void) src;
+    (void) context;
     (void) apdu;
     (void) pdu_len;
 }
@@ -131,7 +131,7 @@ static void Read_Properties(
         if (next_device) {
             next_device = false;
             index++;
-            if (index >= MAX_ADDRESS_CACHE)
+            if (index >= address_cache_size())
                 index = 0;
             property = 0;
         }
@@ -240,7 +240,7 @@ static void print_address_cache(
     unsigned max_apdu = 0;
 
     fprintf(stderr, "Device\tMAC\tMaxAPDU\tNet\n");
-    for (i = 0; i < MAX_ADDRESS_CACHE; i++) {
+    for (i = 0; i < address_cache_size(); i++) {
         if (address_get_by_index(i, &device_id, &max_apdu, &address)) {
             fprintf(stderr, "%u\t", device_id);
             for (j = 0; j < address.mac_len; j++) {
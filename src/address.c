@@ -33,12 +33,15 @@
 ####COPYRIGHTEND####*/
 #include <stddef.h>
 #include <stdint.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "config.h"
 #include "bacaddr.h"
 #include "address.h"
+#include "fnv.h"
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "readrange.h"
@@ -49,6 +52,27 @@
 #define BACNET_ADDRESS_CACHE_FILE
 #endif
 #endif
+#if !defined(BACNET_ADDRESS_CACHE_SNAPSHOT)
+#if PRINT_ENABLED
+#define BACNET_ADDRESS_CACHE_SNAPSHOT
+#endif
+#endif
+
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define ADDRESS_SNAPSHOT_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+/* how often the snapshot is written by address_cache_timer(), if the
+   bindings have changed */
+#if !defined(ADDRESS_SNAPSHOT_INTERVAL)
+#define ADDRESS_SNAPSHOT_INTERVAL 300
+#endif
+#endif
 
 /** @file address.c  Handle address binding */
 
@@ -59,13 +83,51 @@
 static uint32_t Top_Protected_Entry;
 static uint32_t Own_Device_ID = 0xFFFFFFFF;
 
-static struct Address_Cache_Entry {
+struct Address_Cache_Entry {
     uint8_t Flags;
     uint32_t device_id;
     unsigned max_apdu;
     BACNET_ADDRESS address;
     uint32_t TimeToLive;
-} Address_Cache[MAX_ADDRESS_CACHE];
+    /* next entry in the same device ID hash bucket */
+    unsigned next_device;
+    /* next entry in the same address hash bucket, or on the free list */
+    unsigned next_address;
+    /* which lists the entry is linked into */
+    uint8_t Links;
+};
+
+/* marks the end of a chain of Address_Cache indexes */
+#define ADDRESS_NO_INDEX UINT_MAX
+
+/* The cache starts out with room for MAX_ADDRESS_CACHE entries and */
+/* grows as needed up to MAX_ADDRESS_CACHE_DYNAMIC entries, after */
+/* which the entry nearest expiry is replaced.  Entries keep their */
+/* index while the cache grows. */
+static struct Address_Cache_Entry *Address_Cache;
+static unsigned Address_Cache_Size;
+/* number of bound entries */
+static unsigned Address_Bound_Count;
+/* changes whenever an entry is bound, rebound or unbound */
+static uint32_t Address_Revision;
+/* chain of unused entries */
+static unsigned Address_Free_Head = ADDRESS_NO_INDEX;
+/* chains of in use entries hashed by device ID, and of bound entries */
+/* hashed by address; both have Address_Hash_Size (a power of 2) buckets */
+static unsigned *Address_Device_Hash;
+static unsigned *Address_MAC_Hash;
+static unsigned Address_Hash_Size;
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+/* bindings have changed since the snapshot was read or written */
+static bool Address_Snapshot_Dirty;
+/* seconds since the snapshot was last written */
+static uint32_t Address_Snapshot_Seconds;
+#endif
+
+/* Links flags for cache entries */
+#define ADDRESS_LINK_DEVICE 1   /* in the device ID hash */
+#define ADDRESS_LINK_MAC    2   /* in the address hash, and bound */
+#define ADDRESS_LINK_FREE   4   /* on the free list */
 
 /* State flags for cache entries */
 
@@ -129,24 +191,241 @@ bool address_match(
     return true;
 }
 
-void address_remove_device(
+static unsigned address_device_bucket(
     uint32_t device_id)
 {
-    struct Address_Cache_Entry *pMatch;
-    uint32_t index = 0;
+    device_id ^= device_id >> 16;
+    device_id *= 0x45d9f3bUL;
+    device_id ^= device_id >> 16;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            pMatch->Flags = 0;
-            if (index < Top_Protected_Entry) {
-                Top_Protected_Entry--;
+    return (unsigned) (device_id & (Address_Hash_Size - 1));
+}
+
+static unsigned address_mac_bucket(
+    BACNET_ADDRESS * src)
+{
+    return (unsigned) (FNV_Hash_Address(src, FNV_HASH_INIT) &
+        (Address_Hash_Size - 1));
+}
+
+/* removes the entry from the hash chains it is in */
+static void address_entry_unlink(
+    unsigned index)
+{
+    struct Address_Cache_Entry *pMatch = &Address_Cache[index];
+    unsigned *link = NULL;
+
+    if (pMatch->Links & ADDRESS_LINK_DEVICE) {
+        link = &Address_Device_Hash[address_device_bucket(pMatch->device_id)];
+        while (*link != ADDRESS_NO_INDEX) {
+            if (*link == index) {
+                *link = pMatch->next_device;
+                break;
             }
-            break;
+            link = &Address_Cache[*link].next_device;
         }
-        pMatch++;
-        index++;
+    }
+    if (pMatch->Links & ADDRESS_LINK_MAC) {
+        link = &Address_MAC_Hash[address_mac_bucket(&pMatch->address)];
+        while (*link != ADDRESS_NO_INDEX) {
+            if (*link == index) {
+                *link = pMatch->next_address;
+                break;
+            }
+            link = &Address_Cache[*link].next_address;
+        }
+        Address_Bound_Count--;
+        Address_Revision++;
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+        Address_Snapshot_Dirty = true;
+#endif
+    }
+    pMatch->Links &= ~(ADDRESS_LINK_DEVICE | ADDRESS_LINK_MAC);
+}
+
+/* adds the entry to the hash chains matching its flags */
+static void address_entry_link(
+    unsigned index)
+{
+    struct Address_Cache_Entry *pMatch = &Address_Cache[index];
+    unsigned bucket = 0;
+
+    if (pMatch->Flags & BAC_ADDR_IN_USE) {
+        bucket = address_device_bucket(pMatch->device_id);
+        pMatch->next_device = Address_Device_Hash[bucket];
+        Address_Device_Hash[bucket] = index;
+        pMatch->Links |= ADDRESS_LINK_DEVICE;
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {
+            bucket = address_mac_bucket(&pMatch->address);
+            pMatch->next_address = Address_MAC_Hash[bucket];
+            Address_MAC_Hash[bucket] = index;
+            pMatch->Links |= ADDRESS_LINK_MAC;
+            Address_Bound_Count++;
+            Address_Revision++;
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+            Address_Snapshot_Dirty = true;
+#endif
+        }
+    }
+}
+
+/* true if the binding differs from the entry, or the entry is not bound;
+   a device that answers again from the same address keeps its hash
+   links, and does not bump the revision or dirty the snapshot */
+static bool address_entry_changed(
+    struct Address_Cache_Entry *pMatch,
+    unsigned max_apdu,
+    BACNET_ADDRESS * src)
+{
+    if ((pMatch->Links & ADDRESS_LINK_MAC) == 0) {
+        return true;
+    }
+    if (pMatch->max_apdu != max_apdu) {
+        return true;
+    }
+
+    return !bacnet_address_same(&pMatch->address, src);
+}
+
+/* clears the entry and puts it on the free list */
+static void address_entry_free(
+    unsigned index)
+{
+    struct Address_Cache_Entry *pMatch = &Address_Cache[index];
+
+    address_entry_unlink(index);
+    pMatch->Flags = 0;
+    if ((pMatch->Links & ADDRESS_LINK_FREE) == 0) {
+        pMatch->next_address = Address_Free_Head;
+        Address_Free_Head = index;
+        pMatch->Links = ADDRESS_LINK_FREE;
+    }
+}
+
+/* rebuilds the hash chains and the free list, lowest index first */
+static void address_cache_relink(
+    void)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < Address_Hash_Size; i++) {
+        Address_Device_Hash[i] = ADDRESS_NO_INDEX;
+        Address_MAC_Hash[i] = ADDRESS_NO_INDEX;
+    }
+    Address_Bound_Count = 0;
+    Address_Revision++;
+    Address_Free_Head = ADDRESS_NO_INDEX;
+    for (i = Address_Cache_Size; i > 0; i--) {
+        Address_Cache[i - 1].Links = 0;
+        if (Address_Cache[i - 1].Flags == 0) {
+            address_entry_free(i - 1);
+        } else {
+            address_entry_link(i - 1);
+        }
+    }
+}
+
+/* doubles the size of the cache, up to MAX_ADDRESS_CACHE_DYNAMIC */
+static bool address_cache_grow(
+    void)
+{
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    struct Address_Cache_Entry *cache = NULL;
+    unsigned *device_hash = NULL;
+    unsigned *mac_hash = NULL;
+
+    if (Address_Cache_Size) {
+        size = Address_Cache_Size * 2;
+    } else {
+        size = MAX_ADDRESS_CACHE;
+    }
+    if (size > MAX_ADDRESS_CACHE_DYNAMIC) {
+        size = MAX_ADDRESS_CACHE_DYNAMIC;
+    }
+    if (size <= Address_Cache_Size) {
+        return false;
+    }
+    hash_size = 1;
+    while (hash_size < size) {
+        hash_size *= 2;
+    }
+    cache = realloc(Address_Cache, size * sizeof(struct Address_Cache_Entry));
+    if (!cache) {
+        return false;
+    }
+    Address_Cache = cache;
+    device_hash = realloc(Address_Device_Hash, hash_size * sizeof(unsigned));
+    if (!device_hash) {
+        return false;
+    }
+    Address_Device_Hash = device_hash;
+    mac_hash = realloc(Address_MAC_Hash, hash_size * sizeof(unsigned));
+    if (!mac_hash) {
+        return false;
+    }
+    Address_MAC_Hash = mac_hash;
+    memset(&Address_Cache[Address_Cache_Size], 0,
+        (size - Address_Cache_Size) * sizeof(struct Address_Cache_Entry));
+    Address_Cache_Size = size;
+    Address_Hash_Size = hash_size;
+    address_cache_relink();
+
+    return true;
+}
+
+/* takes an entry from the free list, growing the cache if needed;
+   returns ADDRESS_NO_INDEX if the cache is full */
+static unsigned address_entry_alloc(
+    void)
+{
+    unsigned index = ADDRESS_NO_INDEX;
+
+    if (Address_Free_Head == ADDRESS_NO_INDEX) {
+        (void) address_cache_grow();
+    }
+    index = Address_Free_Head;
+    if (index != ADDRESS_NO_INDEX) {
+        Address_Free_Head = Address_Cache[index].next_address;
+        Address_Cache[index].Links = 0;
+    }
+
+    return index;
+}
+
+/* returns the in use (bound or bind requested) entry for the device */
+static struct Address_Cache_Entry *address_device_entry(
+    uint32_t device_id,
+    unsigned *index)
+{
+    unsigned i = ADDRESS_NO_INDEX;
+
+    if (Address_Hash_Size) {
+        i = Address_Device_Hash[address_device_bucket(device_id)];
+        while (i != ADDRESS_NO_INDEX) {
+            if (Address_Cache[i].device_id == device_id) {
+                break;
+            }
+            i = Address_Cache[i].next_device;
+        }
+    }
+    if (index) {
+        *index = i;
+    }
+
+    return (i == ADDRESS_NO_INDEX) ? NULL : &Address_Cache[i];
+}
+
+void address_remove_device(
+    uint32_t device_id)
+{
+    unsigned index = 0;
+
+    if (address_device_entry(device_id, &index)) {
+        if (index < Top_Protected_Entry) {
+            Top_Protected_Entry--;
+        }
+        address_entry_free(index);
     }
 
     return;
@@ -154,68 +433,64 @@ void address_remove_device(
 
 /*****************************************************************************
  * Search the cache for the entry nearest expiry and delete it. Mark the     *
- * entry as reserved with a 1 hour TTL and return a pointer to the reserved  *
- * entry. Will not delete a static entry and returns NULL pointer if no      *
+ * entry as reserved with a 1 hour TTL and return the index of the reserved  *
+ * entry. Will not delete a static entry and returns ADDRESS_NO_INDEX if no  *
  * entry available to free up. Does not check for free entries as it is      *
  * assumed we are calling this due to the lack of those.                     *
  *****************************************************************************/
 
 
-static struct Address_Cache_Entry *address_remove_oldest(
+static unsigned address_remove_oldest(
     void)
 {
     struct Address_Cache_Entry *pMatch;
-    struct Address_Cache_Entry *pCandidate;
+    unsigned index;
+    unsigned candidate;
     uint32_t ulTime;
 
-    pCandidate = NULL;
-    if (Top_Protected_Entry > (MAX_ADDRESS_CACHE - 1)) {
-       return pCandidate;
+    candidate = ADDRESS_NO_INDEX;
+    if (Top_Protected_Entry >= Address_Cache_Size) {
+       return candidate;
     }
     ulTime = BAC_ADDR_FOREVER - 1;      /* Longest possible non static time to live */
 
     /* First pass - try only in use and bound entries */
 
-    pMatch = &Address_Cache[Top_Protected_Entry];
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    for (index = Top_Protected_Entry; index < Address_Cache_Size; index++) {
+        pMatch = &Address_Cache[index];
         if ((pMatch->
                 Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ |
                     BAC_ADDR_STATIC)) == BAC_ADDR_IN_USE) {
             if (pMatch->TimeToLive <= ulTime) { /* Shorter lived entry found */
                 ulTime = pMatch->TimeToLive;
-                pCandidate = pMatch;
+                candidate = index;
             }
         }
-        pMatch++;
     }
 
-    if (pCandidate != NULL) {   /* Found something to free up */
-        pCandidate->Flags = BAC_ADDR_RESERVED;
-        pCandidate->TimeToLive = BAC_ADDR_SHORT_TIME;   /* only reserve it for a short while */
-        return (pCandidate);
-    }
-
-    /* Second pass - try in use and un bound as last resort */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if ((pMatch->
-                Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ |
-                    BAC_ADDR_STATIC)) ==
-            ((uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ))) {
-            if (pMatch->TimeToLive <= ulTime) { /* Shorter lived entry found */
-                ulTime = pMatch->TimeToLive;
-                pCandidate = pMatch;
+    if (candidate == ADDRESS_NO_INDEX) {
+        /* Second pass - try in use and un bound as last resort */
+        for (index = 0; index < Address_Cache_Size; index++) {
+            pMatch = &Address_Cache[index];
+            if ((pMatch->
+                    Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ |
+                        BAC_ADDR_STATIC)) ==
+                ((uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ))) {
+                if (pMatch->TimeToLive <= ulTime) { /* Shorter lived entry found */
+                    ulTime = pMatch->TimeToLive;
+                    candidate = index;
+                }
             }
         }
-        pMatch++;
     }
 
-    if (pCandidate != NULL) {   /* Found something to free up */
-        pCandidate->Flags = BAC_ADDR_RESERVED;
-        pCandidate->TimeToLive = BAC_ADDR_SHORT_TIME;   /* only reserve it for a short while */
+    if (candidate != ADDRESS_NO_INDEX) {   /* Found something to free up */
+        address_entry_unlink(candidate);
+        Address_Cache[candidate].Flags = BAC_ADDR_RESERVED;
+        Address_Cache[candidate].TimeToLive = BAC_ADDR_SHORT_TIME;   /* only reserve it for a short while */
     }
 
-    return (pCandidate);
+    return (candidate);
 }
 
 /** Initialize a BACNET_MAC_ADDRESS
@@ -361,6 +636,327 @@ static void address_file_init(
 }
 #endif
 
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+/* Binary snapshot of the bound entries, so that a restart comes back
+   with the bindings it had instead of rediscovering every device.
+   Static entries are not saved; they come from the address_cache file
+   or the application on every start.  No snapshot is read or written
+   until the application names the file with
+   address_snapshot_filename_set().
+   All values are big endian.
+   Header (24 octets):
+     0  magic "BACA"
+     4  version (2 octets)
+     6  record size (2 octets)
+     8  record count (4 octets)
+    12  time saved, seconds since the epoch (4 octets)
+    16  FNV-1a checksum of the records (4 octets)
+    20  reserved (4 octets)
+   Record (32 octets):
+     0  device ID (4 octets)
+     4  time to live in seconds (4 octets)
+     8  max APDU (2 octets)
+    10  flags: 2=short TTL (1=static is skipped when read)
+    11  MAC length
+    12  network number (2 octets)
+    14  remote address length
+    15  reserved
+    16  MAC (8 octets)
+    24  remote address (8 octets)
+*/
+/* file used by address_init(), address_cache_timer() and
+   address_snapshot_cleanup(); NULL (the default) if not wanted */
+static const char *Address_Cache_Snapshot_Filename;
+
+#define ADDRESS_SNAPSHOT_VERSION 1
+#define ADDRESS_SNAPSHOT_HEADER_SIZE 24
+#define ADDRESS_SNAPSHOT_RECORD_SIZE 32
+#define ADDRESS_SNAPSHOT_ADDRESS_SIZE 8
+#define ADDRESS_SNAPSHOT_STATIC 1
+#define ADDRESS_SNAPSHOT_SHORT_TTL 2
+
+#if (MAX_MAC_LEN > ADDRESS_SNAPSHOT_ADDRESS_SIZE)
+#error MAX_MAC_LEN is too large for the address cache snapshot
+#endif
+
+static void address_snapshot_encode(
+    uint8_t * record,
+    struct Address_Cache_Entry *pMatch)
+{
+    uint8_t flags = 0;
+
+    memset(record, 0, ADDRESS_SNAPSHOT_RECORD_SIZE);
+    encode_unsigned32(&record[0], pMatch->device_id);
+    encode_unsigned32(&record[4], pMatch->TimeToLive);
+    encode_unsigned16(&record[8], (uint16_t) pMatch->max_apdu);
+    if (pMatch->Flags & BAC_ADDR_SHORT_TTL) {
+        flags |= ADDRESS_SNAPSHOT_SHORT_TTL;
+    }
+    record[10] = flags;
+    record[11] = pMatch->address.mac_len;
+    encode_unsigned16(&record[12], pMatch->address.net);
+    record[14] = pMatch->address.len;
+    memcpy(&record[16], pMatch->address.mac, MAX_MAC_LEN);
+    memcpy(&record[24], pMatch->address.adr, MAX_MAC_LEN);
+}
+
+/** Write the bound, non-static entries of the address cache to a
+ *  snapshot file.
+ *  The file is written under a temporary name and then renamed, so
+ *  a reader never sees a partial snapshot.
+ * @param pFilename [in] name of the snapshot file
+ * @return true if the snapshot was written
+ */
+bool address_snapshot_save(
+    const char *pFilename)
+{
+    FILE *pFile = NULL;
+    char temp_name[256] = { "" };
+    uint8_t header[ADDRESS_SNAPSHOT_HEADER_SIZE] = { 0 };
+    uint8_t record[ADDRESS_SNAPSHOT_RECORD_SIZE];
+    uint32_t hash = FNV_HASH_INIT;
+    uint32_t count = 0;
+    unsigned index = 0;
+    bool status = true;
+
+    if (strlen(pFilename) + 5 > sizeof(temp_name)) {
+        return false;
+    }
+    sprintf(temp_name, "%s.tmp", pFilename);
+    pFile = fopen(temp_name, "wb");
+    if (!pFile) {
+        return false;
+    }
+    /* the header is rewritten once the count and checksum are known */
+    if (fwrite(header, sizeof(header), 1, pFile) != 1) {
+        status = false;
+    }
+    for (index = 0; status && (index < Address_Cache_Size); index++) {
+        if ((Address_Cache[index].Flags & (BAC_ADDR_IN_USE |
+                    BAC_ADDR_BIND_REQ | BAC_ADDR_STATIC)) == BAC_ADDR_IN_USE) {
+            address_snapshot_encode(record, &Address_Cache[index]);
+            hash = FNV_Hash(record, sizeof(record), hash);
+            if (fwrite(record, sizeof(record), 1, pFile) != 1) {
+                status = false;
+            }
+            count++;
+        }
+    }
+    if (status) {
+        header[0] = 'B';
+        header[1] = 'A';
+        header[2] = 'C';
+        header[3] = 'A';
+        encode_unsigned16(&header[4], ADDRESS_SNAPSHOT_VERSION);
+        encode_unsigned16(&header[6], ADDRESS_SNAPSHOT_RECORD_SIZE);
+        encode_unsigned32(&header[8], count);
+        encode_unsigned32(&header[12], (uint32_t) time(NULL));
+        encode_unsigned32(&header[16], hash);
+        if ((fseek(pFile, 0L, SEEK_SET) != 0) ||
+            (fwrite(header, sizeof(header), 1, pFile) != 1)) {
+            status = false;
+        }
+    }
+    if (fclose(pFile) != 0) {
+        status = false;
+    }
+    if (status) {
+#if defined(_WIN32)
+        /* rename() will not replace an existing file on Windows */
+        remove(pFilename);
+#endif
+        if (rename(temp_name, pFilename) != 0) {
+            status = false;
+        }
+    }
+    if (!status) {
+        remove(temp_name);
+    } else {
+        Address_Snapshot_Dirty = false;
+        Address_Snapshot_Seconds = 0;
+    }
+
+    return status;
+}
+
+/* adds the bindings held in a snapshot image to the cache */
+static int address_snapshot_decode(
+    uint8_t * image,
+    size_t image_len)
+{
+    uint8_t *record = NULL;
+    struct Address_Cache_Entry *pMatch = NULL;
+    uint16_t version = 0;
+    uint16_t record_size = 0;
+    uint16_t max_apdu = 0;
+    uint32_t count = 0;
+    uint32_t saved = 0;
+    uint32_t hash = 0;
+    uint32_t elapsed = 0;
+    uint32_t device_id = 0;
+    uint32_t ttl = 0;
+    uint32_t now = 0;
+    uint32_t i = 0;
+    unsigned index = 0;
+    int loaded = 0;
+
+    if ((image_len < ADDRESS_SNAPSHOT_HEADER_SIZE) ||
+        (memcmp(image, "BACA", 4) != 0)) {
+        return -1;
+    }
+    decode_unsigned16(&image[4], &version);
+    decode_unsigned16(&image[6], &record_size);
+    decode_unsigned32(&image[8], &count);
+    decode_unsigned32(&image[12], &saved);
+    decode_unsigned32(&image[16], &hash);
+    if ((version != ADDRESS_SNAPSHOT_VERSION) ||
+        (record_size != ADDRESS_SNAPSHOT_RECORD_SIZE) ||
+        (count > ((image_len - ADDRESS_SNAPSHOT_HEADER_SIZE) /
+                ADDRESS_SNAPSHOT_RECORD_SIZE)) ||
+        (image_len != (ADDRESS_SNAPSHOT_HEADER_SIZE +
+                ((size_t) count * ADDRESS_SNAPSHOT_RECORD_SIZE)))) {
+        return -1;
+    }
+    if (hash != FNV_Hash(&image[ADDRESS_SNAPSHOT_HEADER_SIZE],
+            image_len - ADDRESS_SNAPSHOT_HEADER_SIZE, FNV_HASH_INIT)) {
+        return -1;
+    }
+    /* bindings age while the snapshot sits on disk */
+    now = (uint32_t) time(NULL);
+    if (now > saved) {
+        elapsed = now - saved;
+    }
+    for (i = 0; i < count; i++) {
+        record = &image[ADDRESS_SNAPSHOT_HEADER_SIZE +
+            (i * ADDRESS_SNAPSHOT_RECORD_SIZE)];
+        decode_unsigned32(&record[0], &device_id);
+        decode_unsigned32(&record[4], &ttl);
+        decode_unsigned16(&record[8], &max_apdu);
+        if ((record[11] > MAX_MAC_LEN) || (record[14] > MAX_MAC_LEN) ||
+            (record[10] & ADDRESS_SNAPSHOT_STATIC)) {
+            continue;
+        }
+        if (ttl <= elapsed) {
+            continue;
+        }
+        ttl -= elapsed;
+        /* entries already known, such as static ones, are kept */
+        if ((device_id == Own_Device_ID) ||
+            address_device_entry(device_id, NULL)) {
+            continue;
+        }
+        index = address_entry_alloc();
+        if (index == ADDRESS_NO_INDEX) {
+            break;
+        }
+        pMatch = &Address_Cache[index];
+        pMatch->Flags = BAC_ADDR_IN_USE;
+        if (record[10] & ADDRESS_SNAPSHOT_SHORT_TTL) {
+            pMatch->Flags |= BAC_ADDR_SHORT_TTL;
+        }
+        pMatch->device_id = device_id;
+        pMatch->max_apdu = max_apdu;
+        pMatch->TimeToLive = ttl;
+        memset(&pMatch->address, 0, sizeof(pMatch->address));
+        pMatch->address.mac_len = record[11];
+        decode_unsigned16(&record[12], &pMatch->address.net);
+        pMatch->address.len = record[14];
+        memcpy(pMatch->address.mac, &record[16], pMatch->address.mac_len);
+        memcpy(pMatch->address.adr, &record[24], pMatch->address.len);
+        address_entry_link(index);
+        loaded++;
+    }
+
+    return loaded;
+}
+
+/** Add the bindings from a snapshot file to the address cache.
+ *  Expired bindings and devices already in the cache are skipped.
+ * @param pFilename [in] name of the snapshot file
+ * @return number of bindings added, or -1 if the file is missing,
+ *  of another version, or damaged
+ */
+int address_snapshot_load(
+    const char *pFilename)
+{
+    int loaded = -1;
+#if defined(ADDRESS_SNAPSHOT_MMAP)
+    int fd = -1;
+    struct stat st;
+    void *image = MAP_FAILED;
+
+    fd = open(pFilename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+        image = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (image != MAP_FAILED) {
+        loaded =
+            address_snapshot_decode((uint8_t *) image, (size_t) st.st_size);
+        munmap(image, (size_t) st.st_size);
+    }
+#else
+    FILE *pFile = NULL;
+    uint8_t *image = NULL;
+    long image_len = 0;
+
+    pFile = fopen(pFilename, "rb");
+    if (!pFile) {
+        return -1;
+    }
+    if ((fseek(pFile, 0L, SEEK_END) == 0) &&
+        ((image_len = ftell(pFile)) > 0) &&
+        (fseek(pFile, 0L, SEEK_SET) == 0)) {
+        image = malloc((size_t) image_len);
+    }
+    if (image) {
+        if (fread(image, (size_t) image_len, 1, pFile) == 1) {
+            loaded = address_snapshot_decode(image, (size_t) image_len);
+        }
+        free(image);
+    }
+    fclose(pFile);
+#endif
+    if (loaded >= 0) {
+        Address_Snapshot_Dirty = false;
+        Address_Snapshot_Seconds = 0;
+    }
+
+    return loaded;
+}
+
+#endif
+
+/** Set the snapshot file that is read when the cache is initialized
+ *  and written as the bindings change.  There is none by default.
+ * @param pFilename [in] name of the snapshot file, or NULL for none
+ */
+void address_snapshot_filename_set(
+    const char *pFilename)
+{
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+    Address_Cache_Snapshot_Filename = pFilename;
+#else
+    (void) pFilename;
+#endif
+}
+
+/** Write the address cache snapshot if the bindings have changed
+ *  since it was last read or written; for use at shutdown.
+ */
+void address_snapshot_cleanup(
+    void)
+{
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+    if (Address_Snapshot_Dirty && Address_Cache_Snapshot_Filename) {
+        (void) address_snapshot_save(Address_Cache_Snapshot_Filename);
+    }
+#endif
+}
+
 /****************************************************************************
  * Clear down the cache and make sure the full complement of entries are    *
  * available. Assume no persistance of memory.                              *
@@ -369,15 +965,21 @@ static void address_file_init(
 void address_init(
     void)
 {
-    struct Address_Cache_Entry *pMatch;
+    unsigned index;
 
    Top_Protected_Entry = 0;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        pMatch->Flags = 0;
-        pMatch++;
+    for (index = 0; index < Address_Cache_Size; index++) {
+        Address_Cache[index].Flags = 0;
+    }
+    if (Address_Cache_Size) {
+        address_cache_relink();
     }
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+    if (Address_Cache_Snapshot_Filename) {
+        (void) address_snapshot_load(Address_Cache_Snapshot_Filename);
+    }
+#endif
 #ifdef BACNET_ADDRESS_CACHE_FILE
     address_file_init(Address_Cache_Filename);
 #endif
@@ -396,9 +998,10 @@ void address_init_partial(
     void)
 {
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    for (index = 0; index < Address_Cache_Size; index++) {
+        pMatch = &Address_Cache[index];
         if ((pMatch->Flags & BAC_ADDR_IN_USE) != 0) {   /* It's in use so let's check further */
             if (((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0) ||
                 (pMatch->TimeToLive == 0))
@@ -408,8 +1011,9 @@ void address_init_partial(
         if ((pMatch->Flags & BAC_ADDR_RESERVED) != 0) { /* Reserved entries should be cleared */
             pMatch->Flags = 0;
         }
-
-        pMatch++;
+    }
+    if (Address_Cache_Size) {
+        address_cache_relink();
     }
  #ifdef BACNET_ADDRESS_CACHE_FILE
     address_file_init(Address_Cache_Filename);
@@ -433,24 +1037,19 @@ void address_set_device_TTL(
 {
     struct Address_Cache_Entry *pMatch;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then we have either static or normaal */
-                if (StaticFlag) {
-                    pMatch->Flags |= BAC_ADDR_STATIC;
-                    pMatch->TimeToLive = BAC_ADDR_FOREVER;
-                } else {
-                    pMatch->Flags &= ~BAC_ADDR_STATIC;
-                    pMatch->TimeToLive = TimeOut;
-                }
+    pMatch = address_device_entry(device_id, NULL);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then we have either static or normaal */
+            if (StaticFlag) {
+                pMatch->Flags |= BAC_ADDR_STATIC;
+                pMatch->TimeToLive = BAC_ADDR_FOREVER;
             } else {
-                pMatch->TimeToLive = TimeOut;   /* For unbound we can only set the time to live */
+                pMatch->Flags &= ~BAC_ADDR_STATIC;
+                pMatch->TimeToLive = TimeOut;
             }
-            break;      /* Exit now if found at all - bound or unbound */
+        } else {
+            pMatch->TimeToLive = TimeOut;   /* For unbound we can only set the time to live */
         }
-        pMatch++;
     }
 }
 
@@ -463,18 +1062,13 @@ bool address_get_by_device(
     struct Address_Cache_Entry *pMatch;
     bool found = false; /* return value */
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then fetch data */
-                bacnet_address_copy(src, &pMatch->address);
-                *max_apdu = pMatch->max_apdu;
-                found = true;   /* Prove we found it */
-            }
-            break;      /* Exit now if found at all - bound or unbound */
+    pMatch = address_device_entry(device_id, NULL);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then fetch data */
+            bacnet_address_copy(src, &pMatch->address);
+            *max_apdu = pMatch->max_apdu;
+            found = true;   /* Prove we found it */
         }
-        pMatch++;
     }
 
     return found;
@@ -487,20 +1081,22 @@ bool address_get_device_id(
     uint32_t * device_id)
 {
     struct Address_Cache_Entry *pMatch;
+    unsigned index = ADDRESS_NO_INDEX;
     bool found = false; /* return value */
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) == BAC_ADDR_IN_USE) {       /* If bound */
-            if (bacnet_address_same(&pMatch->address, src)) {
-                if (device_id) {
-                    *device_id = pMatch->device_id;
-                }
-                found = true;
-                break;
+    if (Address_Hash_Size) {
+        index = Address_MAC_Hash[address_mac_bucket(src)];
+    }
+    while (index != ADDRESS_NO_INDEX) {
+        pMatch = &Address_Cache[index];
+        if (bacnet_address_same(&pMatch->address, src)) {
+            if (device_id) {
+                *device_id = pMatch->device_id;
             }
+            found = true;
+            break;
         }
-        pMatch++;
+        index = pMatch->next_address;
     }
 
     return found;
@@ -511,8 +1107,9 @@ void address_add(
     unsigned max_apdu,
     BACNET_ADDRESS * src)
 {
-    bool found = false; /* return value */
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
+    bool changed = false;
 
     if (Own_Device_ID == device_id) {
         return;
@@ -525,58 +1122,47 @@ void address_add(
        bind request if it exists */
 
     /* existing device or bind request outstanding - update address */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
+    pMatch = address_device_entry(device_id, &index);
+    if (pMatch) {
+        changed = address_entry_changed(pMatch, max_apdu, src);
+        if (changed) {
+            address_entry_unlink(index);
             bacnet_address_copy(&pMatch->address, src);
             pMatch->max_apdu = max_apdu;
+        }
 
-            /* Pick the right time to live */
+        /* Pick the right time to live */
 
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0)       /* Bind requested so long time */
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
-            else if ((pMatch->Flags & BAC_ADDR_STATIC) != 0)    /* Static already so make sure it never expires */
-                pMatch->TimeToLive = BAC_ADDR_FOREVER;
-            else if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) /* Opportunistic entry so leave on short fuse */
-                pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
-            else
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;        /* Renewing existing entry */
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0)       /* Bind requested so long time */
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
+        else if ((pMatch->Flags & BAC_ADDR_STATIC) != 0)    /* Static already so make sure it never expires */
+            pMatch->TimeToLive = BAC_ADDR_FOREVER;
+        else if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) /* Opportunistic entry so leave on short fuse */
+            pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
+        else
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;        /* Renewing existing entry */
 
-            pMatch->Flags &= ~BAC_ADDR_BIND_REQ;        /* Clear bind request flag just in case */
-            found = true;
-            break;
+        pMatch->Flags &= ~BAC_ADDR_BIND_REQ;        /* Clear bind request flag just in case */
+        if (changed) {
+            address_entry_link(index);
         }
-        pMatch++;
+        return;
     }
 
-    /* new device - add to cache if there is room */
-    if (!found) {
-        pMatch = Address_Cache;
-        while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-            if ((pMatch->Flags & BAC_ADDR_IN_USE) == 0) {
-                pMatch->Flags = BAC_ADDR_IN_USE;
-                pMatch->device_id = device_id;
-                pMatch->max_apdu = max_apdu;
-                bacnet_address_copy(&pMatch->address, src);
-                pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;       /* Opportunistic entry so leave on short fuse */
-                found = true;
-                break;
-            }
-            pMatch++;
-        }
+    /* new device - add to cache if there is room,
+       else see if we can squeeze it in */
+    index = address_entry_alloc();
+    if (index == ADDRESS_NO_INDEX) {
+        index = address_remove_oldest();
     }
-
-    /* See if we can squeeze it in */
-    if (!found) {
-        pMatch = address_remove_oldest();
-        if (pMatch != NULL) {
-            pMatch->Flags = BAC_ADDR_IN_USE;
-            pMatch->device_id = device_id;
-            pMatch->max_apdu = max_apdu;
-            bacnet_address_copy(&pMatch->address, src);
-            pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;   /* Opportunistic entry so leave on short fuse */
-        }
+    if (index != ADDRESS_NO_INDEX) {
+        pMatch = &Address_Cache[index];
+        pMatch->Flags = BAC_ADDR_IN_USE;
+        pMatch->device_id = device_id;
+        pMatch->max_apdu = max_apdu;
+        bacnet_address_copy(&pMatch->address, src);
+        pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;       /* Opportunistic entry so leave on short fuse */
+        address_entry_link(index);
     }
     return;
 }
@@ -591,55 +1177,45 @@ bool address_device_bind_request(
 {
     bool found = false; /* return value */
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
 
     /* existing device - update address info if currently bound */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* Already bound */
-                found = true;
-                if (src) {
-                    bacnet_address_copy(src, &pMatch->address);
-                }
-                if (max_apdu) {
-                    *max_apdu = pMatch->max_apdu;
-                }
-                if (device_ttl) {
-                    *device_ttl = pMatch->TimeToLive;
-                }
-                if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) {        /* Was picked up opportunistacilly */
-                    pMatch->Flags &= ~BAC_ADDR_SHORT_TTL;       /* Convert to normal entry  */
-                    pMatch->TimeToLive = BAC_ADDR_LONG_TIME;    /* And give it a decent time to live */
-                }
+    pMatch = address_device_entry(device_id, NULL);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* Already bound */
+            found = true;
+            if (src) {
+                bacnet_address_copy(src, &pMatch->address);
+            }
+            if (max_apdu) {
+                *max_apdu = pMatch->max_apdu;
+            }
+            if (device_ttl) {
+                *device_ttl = pMatch->TimeToLive;
+            }
+            if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) {        /* Was picked up opportunistacilly */
+                pMatch->Flags &= ~BAC_ADDR_SHORT_TTL;       /* Convert to normal entry  */
+                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;    /* And give it a decent time to live */
             }
-            return (found);     /* True if bound, false if bind request outstanding */
         }
-        pMatch++;
+        return (found);     /* True if bound, false if bind request outstanding */
     }
 
-    /* Not there already so look for a free entry to put it in */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) == 0) {
-            /* In use and awaiting binding */
-            pMatch->Flags = (uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ);
-            pMatch->device_id = device_id;
-            /* No point in leaving bind requests in for long haul */
-            pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
-            /* now would be a good time to do a Who-Is request */
-            return (false);
-        }
-        pMatch++;
+    /* Not there already so look for a free entry to put it in, and if
+       there are none see if we can squeeze it in by dropping an existing one */
+    index = address_entry_alloc();
+    if (index == ADDRESS_NO_INDEX) {
+        index = address_remove_oldest();
     }
-
-    /* No free entries, See if we can squeeze it in by dropping an existing one */
-    pMatch = address_remove_oldest();
-    if (pMatch != NULL) {
+    if (index != ADDRESS_NO_INDEX) {
+        pMatch = &Address_Cache[index];
+        /* In use and awaiting binding */
         pMatch->Flags = (uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ);
         pMatch->device_id = device_id;
         /* No point in leaving bind requests in for long haul */
         pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
+        address_entry_link(index);
+        /* now would be a good time to do a Who-Is request */
     }
     return (false);
 }
@@ -660,24 +1236,28 @@ void address_add_binding(
     BACNET_ADDRESS * src)
 {
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
+    bool changed = false;
 
     /* existing device or bind request - update address */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
+    pMatch = address_device_entry(device_id, &index);
+    if (pMatch) {
+        changed = address_entry_changed(pMatch, max_apdu, src);
+        if (changed) {
+            address_entry_unlink(index);
             bacnet_address_copy(&pMatch->address, src);
             pMatch->max_apdu = max_apdu;
-            /* Clear bind request flag in case it was set */
-            pMatch->Flags &= ~BAC_ADDR_BIND_REQ;
-            /* Only update TTL if not static */
-            if ((pMatch->Flags & BAC_ADDR_STATIC) == 0) {
-                /* and set it on a long fuse */
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
-            }
-            break;
         }
-        pMatch++;
+        /* Clear bind request flag in case it was set */
+        pMatch->Flags &= ~BAC_ADDR_BIND_REQ;
+        /* Only update TTL if not static */
+        if ((pMatch->Flags & BAC_ADDR_STATIC) == 0) {
+            /* and set it on a long fuse */
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
+        }
+        if (changed) {
+            address_entry_link(index);
+        }
     }
     return;
 }
@@ -692,7 +1272,7 @@ bool address_device_get_by_index(
     struct Address_Cache_Entry *pMatch;
     bool found = false; /* return value */
 
-    if (index < MAX_ADDRESS_CACHE) {
+    if (index < Address_Cache_Size) {
         pMatch = &Address_Cache[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
@@ -727,20 +1307,24 @@ bool address_get_by_index(
 unsigned address_count(
     void)
 {
-    struct Address_Cache_Entry *pMatch;
-    unsigned count = 0; /* return value */
-
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        /* Only count bound entries */
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
-            BAC_ADDR_IN_USE)
-            count++;
+    /* Only count bound entries */
+    return Address_Bound_Count;
+}
 
-        pMatch++;
-    }
+/* changes whenever a device is bound, rebound or unbound, so that
+   addresses looked up here can be kept until it changes again */
+uint32_t address_revision(
+    void)
+{
+    return Address_Revision;
+}
 
-    return count;
+/* number of entries the cache currently has room for; the indexes
+   used with address_get_by_index() are less than this */
+unsigned address_cache_size(
+    void)
+{
+    return Address_Cache_Size;
 }
 
 /****************************************************************************
@@ -754,6 +1338,7 @@ int address_list_encode(
 {
     int iLen = 0;
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
     BACNET_OCTET_STRING MAC_Address;
 
     /* FIXME: I really shouild check the length remaining here but it is
@@ -761,8 +1346,8 @@ int address_list_encode(
        the packet to work with as at the moment it is just MAX_APDU */
     apdu_len = apdu_len;
     /* look for matching address */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    for (index = 0; index < Address_Cache_Size; index++) {
+        pMatch = &Address_Cache[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
             iLen +=
@@ -785,7 +1370,6 @@ int address_list_encode(
                     encode_application_octet_string(&apdu[iLen], &MAC_Address);
             }
         }
-        pMatch++;
     }
 
     return (iLen);
@@ -945,7 +1529,9 @@ int rr_address_list_encode(
         pMatch++;
         pRequest->ItemCount++;  /* Chalk up another one for the response count */
 
-        while ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) != BAC_ADDR_IN_USE)      /* Find next bound entry */
+        /* Find next bound entry, without running off the end of the cache */
+        while ((uiIndex <= uiTarget) &&
+            ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) != BAC_ADDR_IN_USE))
             pMatch++;
     }
 
@@ -971,23 +1557,27 @@ void address_cache_timer(
     uint16_t uSeconds)
 {       /* Approximate number of seconds since last call to this function */
     struct Address_Cache_Entry *pMatch;
+    unsigned index;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    for (index = 0; index < Address_Cache_Size; index++) {
+        pMatch = &Address_Cache[index];
         if (((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) != 0)
             && ((pMatch->Flags & BAC_ADDR_STATIC) == 0)) {      /* Check all entries holding a slot except statics */
             if (pMatch->TimeToLive >= uSeconds)
                 pMatch->TimeToLive -= uSeconds;
             else
-                pMatch->Flags = 0;
+                address_entry_free(index);
         }
-
-        pMatch++;
     }
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+    Address_Snapshot_Seconds += uSeconds;
+    if (Address_Snapshot_Dirty && Address_Cache_Snapshot_Filename &&
+        (Address_Snapshot_Seconds >= ADDRESS_SNAPSHOT_INTERVAL)) {
+        (void) address_snapshot_save(Address_Cache_Snapshot_Filename);
+    }
+#endif
 }
 
-
-
 #ifdef TEST
 #include <assert.h>
 #include <string.h>
@@ -1143,6 +1733,196 @@ void testAddress(
     }
 }
 
+/* a distinct address for each of many devices */
+static void set_wide_address(
+    unsigned index,
+    BACNET_ADDRESS * dest)
+{
+    memset(dest, 0, sizeof(BACNET_ADDRESS));
+    dest->mac[0] = 10;
+    dest->mac[1] = (uint8_t) (index >> 16);
+    dest->mac[2] = (uint8_t) (index >> 8);
+    dest->mac[3] = (uint8_t) index;
+    dest->mac[4] = 0xBA;
+    dest->mac[5] = 0xC0;
+    dest->mac_len = 6;
+    dest->net = 0;
+    dest->len = 0;
+}
+
+void testAddressDynamic(
+    Test * pTest)
+{
+    unsigned i, count;
+    BACNET_ADDRESS src;
+    unsigned max_apdu = 1476;
+    BACNET_ADDRESS test_address;
+    uint32_t test_device_id = 0;
+    unsigned test_max_apdu = 0;
+    const unsigned devices = MAX_ADDRESS_CACHE * 60;
+    uint32_t revision = 0;
+
+    address_init();
+    /* the cache grows past its starting size */
+    for (i = 0; i < devices; i++) {
+        set_wide_address(i, &src);
+        address_add(100000 + i, max_apdu, &src);
+    }
+    ct_test(pTest, address_count() == devices);
+    ct_test(pTest, address_cache_size() >= devices);
+    for (i = 0; i < devices; i++) {
+        set_wide_address(i, &src);
+        ct_test(pTest, address_get_by_device(100000 + i, &test_max_apdu,
+                &test_address));
+        ct_test(pTest, bacnet_address_same(&test_address, &src));
+        ct_test(pTest, address_get_device_id(&src, &test_device_id));
+        ct_test(pTest, test_device_id == (100000 + i));
+    }
+    /* entries keep their index */
+    ct_test(pTest, address_get_by_index(0, &test_device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, test_device_id == 100000);
+    ct_test(pTest, address_get_by_index(devices - 1, &test_device_id,
+            &test_max_apdu, &test_address));
+    ct_test(pTest, test_device_id == (100000 + devices - 1));
+    /* a bind request is found by device but not by address,
+       and does not change the bindings */
+    revision = address_revision();
+    ct_test(pTest, !address_bind_request(7, &test_max_apdu, &test_address));
+    ct_test(pTest, !address_bind_request(7, &test_max_apdu, &test_address));
+    ct_test(pTest, address_count() == devices);
+    ct_test(pTest, address_revision() == revision);
+    set_wide_address(devices, &src);
+    ct_test(pTest, !address_get_device_id(&src, &test_device_id));
+    address_add_binding(7, max_apdu, &src);
+    ct_test(pTest, address_revision() != revision);
+    ct_test(pTest, address_count() == (devices + 1));
+    ct_test(pTest, address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, test_device_id == 7);
+    ct_test(pTest, address_bind_request(7, &test_max_apdu, &test_address));
+    ct_test(pTest, bacnet_address_same(&test_address, &src));
+    /* a device that answers again from the same address is unchanged */
+    revision = address_revision();
+    address_add(7, max_apdu, &src);
+    address_add_binding(7, max_apdu, &src);
+    ct_test(pTest, address_revision() == revision);
+    address_add(7, max_apdu - 1, &src);
+    ct_test(pTest, address_revision() != revision);
+    address_add(7, max_apdu, &src);
+    /* a device that moves is only found at its new address */
+    set_wide_address(devices + 1, &src);
+    address_add(7, max_apdu, &src);
+    ct_test(pTest, address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, test_device_id == 7);
+    set_wide_address(devices, &src);
+    ct_test(pTest, !address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, address_count() == (devices + 1));
+    /* static entries outlive the others */
+    address_set_device_TTL(100001, 0, true);
+    address_cache_timer(60);
+    ct_test(pTest, address_count() == (devices + 1));
+    for (i = 0; i < 61; i++) {
+        address_cache_timer(60);
+    }
+    ct_test(pTest, address_count() == 2);
+    ct_test(pTest, address_get_by_device(100001, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, address_get_by_device(7, &test_max_apdu, &test_address));
+    set_wide_address(5, &src);
+    ct_test(pTest, !address_get_device_id(&src, &test_device_id));
+    /* freed entries are reused */
+    count = address_cache_size();
+    for (i = 0; i < devices; i++) {
+        set_wide_address(i, &src);
+        address_add(200000 + i, max_apdu, &src);
+    }
+    ct_test(pTest, address_count() == (devices + 2));
+    ct_test(pTest, address_cache_size() == count);
+    ct_test(pTest, address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, test_device_id == (200000 + devices - 1));
+    revision = address_revision();
+    for (i = 0; i < devices; i++) {
+        address_remove_device(200000 + i);
+    }
+    ct_test(pTest, address_count() == 2);
+    ct_test(pTest, address_revision() != revision);
+    address_init();
+    ct_test(pTest, address_count() == 0);
+    ct_test(pTest, !address_get_by_device(7, &test_max_apdu, &test_address));
+}
+
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+void testAddressSnapshot(
+    Test * pTest)
+{
+    const char *pFilename = "address_test.snapshot";
+    const unsigned devices = MAX_ADDRESS_CACHE * 4;
+    unsigned i;
+    BACNET_ADDRESS src;
+    BACNET_ADDRESS test_address;
+    uint32_t test_device_id = 0;
+    uint32_t test_ttl = 0;
+    unsigned test_max_apdu = 0;
+    FILE *pFile = NULL;
+    uint8_t octet = 0;
+
+    remove(pFilename);
+    address_init();
+    ct_test(pTest, address_snapshot_load(pFilename) == -1);
+    for (i = 0; i < devices; i++) {
+        set_wide_address(i, &src);
+        address_add(300000 + i, 50 + i, &src);
+    }
+    /* a bind request and a static entry are not saved */
+    ct_test(pTest, !address_bind_request(8, &test_max_apdu, &test_address));
+    address_set_device_TTL(300002, 0, true);
+    ct_test(pTest, address_snapshot_save(pFilename));
+    address_init();
+    ct_test(pTest, address_count() == 0);
+    ct_test(pTest, address_snapshot_load(pFilename) == (int) (devices - 1));
+    ct_test(pTest, address_count() == (devices - 1));
+    for (i = 0; i < devices; i++) {
+        if (i == 2) {
+            continue;
+        }
+        set_wide_address(i, &src);
+        ct_test(pTest, address_get_by_device(300000 + i, &test_max_apdu,
+                &test_address));
+        ct_test(pTest, test_max_apdu == (50 + i));
+        ct_test(pTest, bacnet_address_same(&test_address, &src));
+        ct_test(pTest, address_get_device_id(&src, &test_device_id));
+        ct_test(pTest, test_device_id == (300000 + i));
+    }
+    ct_test(pTest, !address_device_bind_request(8, NULL, NULL, NULL));
+    ct_test(pTest, !address_device_bind_request(300002, NULL, NULL, NULL));
+    ct_test(pTest, address_device_bind_request(300003, &test_ttl, NULL,
+            NULL));
+    ct_test(pTest, test_ttl <= BAC_ADDR_SHORT_TIME);
+    /* devices already in the cache are kept */
+    address_init();
+    set_wide_address(devices + 1, &src);
+    address_add(300001, 480, &src);
+    ct_test(pTest, address_snapshot_load(pFilename) == (int) (devices - 2));
+    ct_test(pTest, address_get_by_device(300001, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, bacnet_address_same(&test_address, &src));
+    /* a damaged snapshot is ignored */
+    pFile = fopen(pFilename, "r+b");
+    ct_test(pTest, pFile != NULL);
+    if (pFile) {
+        fseek(pFile, 40L, SEEK_SET);
+        octet = (uint8_t) fgetc(pFile);
+        fseek(pFile, 40L, SEEK_SET);
+        fputc(octet ^ 0xFF, pFile);
+        fclose(pFile);
+    }
+    address_init();
+    ct_test(pTest, address_snapshot_load(pFilename) == -1);
+    ct_test(pTest, address_count() == 0);
+    remove(pFilename);
+}
+#endif
+
 #ifdef TEST_ADDRESS
 int main(
     void)
@@ -1154,6 +1934,12 @@ int main(
     /* individual tests */
     rc = ct_addTestFunction(pTest, testAddress);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testAddressDynamic);
+    assert(rc);
+#ifdef BACNET_ADDRESS_CACHE_SNAPSHOT
+    rc = ct_addTestFunction(pTest, testAddressSnapshot);
+    assert(rc);
+#endif
 #ifdef BACNET_ADDRESS_CACHE_FILE
     rc = ct_addTestFunction(pTest, testAddressFile);
     assert(rc);
@@ -56,6 +56,8 @@ extern int Routed_Device_Service_Approval(
 static uint16_t Timeout_Milliseconds = 3000;
 /* Number of APDU Retries */
 static uint8_t Number_Of_Retries = 3;
+/* APDU Segment Timeout in Milliseconds */
+static uint16_t Segment_Timeout_Milliseconds = 2000;
 
 /* a simple table for crossing the services supported */
 static BACNET_SERVICES_SUPPORTED
@@ -89,7 +91,9 @@ static BACNET_SERVICES_SUPPORTED
     SERVICE_SUPPORTED_READ_RANGE,
     SERVICE_SUPPORTED_LIFE_SAFETY_OPERATION,
     SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY,
-    SERVICE_SUPPORTED_GET_EVENT_INFORMATION
+    SERVICE_SUPPORTED_GET_EVENT_INFORMATION,
+    SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE,
+    SERVICE_SUPPORTED_CONFIRMED_COV_NOTIFICATION_MULTIPLE
 };
 
 /* a simple table for crossing the services supported */
@@ -104,7 +108,9 @@ static BACNET_SERVICES_SUPPORTED
     SERVICE_SUPPORTED_TIME_SYNCHRONIZATION,
     SERVICE_SUPPORTED_WHO_HAS,
     SERVICE_SUPPORTED_WHO_IS,
-    SERVICE_SUPPORTED_UTC_TIME_SYNCHRONIZATION
+    SERVICE_SUPPORTED_UTC_TIME_SYNCHRONIZATION,
+    SERVICE_SUPPORTED_WRITE_GROUP,
+    SERVICE_SUPPORTED_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE
 };
 
 /* Confirmed Function Handlers */
@@ -241,6 +247,8 @@ void apdu_set_confirmed_simple_ack_handler(
         case SERVICE_CONFIRMED_EVENT_NOTIFICATION:
         case SERVICE_CONFIRMED_SUBSCRIBE_COV:
         case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY:
+        case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE:
+        case SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE:
         case SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION:
             /* Object Access Services */
         case SERVICE_CONFIRMED_ADD_LIST_ELEMENT:
@@ -295,6 +303,27 @@ void apdu_set_confirmed_ack_handler(
     }
 }
 
+/* returns the handler of the complex ack of the service, or NULL */
+confirmed_ack_function apdu_get_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    if (service_choice < MAX_BACNET_CONFIRMED_SERVICE)
+        return Confirmed_ACK_Function[service_choice];
+
+    return NULL;
+}
+
+/* returns the handler of the simple ack of the service, or NULL */
+confirmed_simple_ack_function apdu_get_confirmed_simple_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    if (service_choice < MAX_BACNET_CONFIRMED_SERVICE)
+        return (confirmed_simple_ack_function)
+            Confirmed_ACK_Function[service_choice];
+
+    return NULL;
+}
+
 static error_function Error_Function[MAX_BACNET_CONFIRMED_SERVICE];
 
 void apdu_set_error_handler(
@@ -305,6 +334,15 @@ void apdu_set_error_handler(
         Error_Function[service_choice] = pFunction;
 }
 
+error_function apdu_get_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    if (service_choice < MAX_BACNET_CONFIRMED_SERVICE)
+        return Error_Function[service_choice];
+
+    return NULL;
+}
+
 static abort_function Abort_Function;
 
 void apdu_set_abort_handler(
@@ -313,6 +351,12 @@ void apdu_set_abort_handler(
     Abort_Function = pFunction;
 }
 
+abort_function apdu_get_abort_handler(
+    void)
+{
+    return Abort_Function;
+}
+
 static reject_function Reject_Function;
 
 void apdu_set_reject_handler(
@@ -321,6 +365,12 @@ void apdu_set_reject_handler(
     Reject_Function = pFunction;
 }
 
+reject_function apdu_get_reject_handler(
+    void)
+{
+    return Reject_Function;
+}
+
 uint16_t apdu_decode_confirmed_service_request(
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len,
@@ -374,6 +424,18 @@ void apdu_retries_set(
     Number_Of_Retries = value;
 }
 
+uint16_t apdu_segment_timeout(
+    void)
+{
+    return Segment_Timeout_Milliseconds;
+}
+
+void apdu_segment_timeout_set(
+    uint16_t milliseconds)
+{
+    Segment_Timeout_Milliseconds = milliseconds;
+}
+
 
 /* When network communications are completely disabled,
    only DeviceCommunicationControl and ReinitializeDevice APDUs
@@ -435,15 +497,17 @@ static bool apdu_unconfirmed_dcc_disabled(
  * Almost all requests and ACKs invoke this function.
  * @ingroup MISCHNDLR
  *
- * @param src [in] The BACNET_ADDRESS of the message's source.
+ * @param context [in] The source address of the message, and the buffers
+ *                     that the service handlers reply with.
  * @param apdu [in] The apdu portion of the request, to be processed.
  * @param apdu_len [in] The total (remaining) length of the apdu.
  */
 void apdu_handler(
-    BACNET_ADDRESS * src,
+    BACNET_REQUEST_CONTEXT * context,
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len)
 {
+    BACNET_ADDRESS *src = context->src;
     BACNET_CONFIRMED_SERVICE_DATA service_data = { 0 };
     BACNET_CONFIRMED_SERVICE_ACK_DATA service_ack_data = { 0 };
     uint8_t invoke_id = 0;
@@ -474,10 +538,10 @@ void apdu_handler(
                 if ((service_choice < MAX_BACNET_CONFIRMED_SERVICE) &&
                     (Confirmed_Function[service_choice]))
                     Confirmed_Function[service_choice] (service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 else if (Unrecognized_Service_Handler)
                     Unrecognized_Service_Handler(service_request,
-                        service_request_len, src, &service_data);
+                        service_request_len, context, &service_data);
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
                 service_choice = apdu[1];
@@ -494,7 +558,7 @@ void apdu_handler(
                 if (service_choice < MAX_BACNET_UNCONFIRMED_SERVICE) {
                     if (Unconfirmed_Function[service_choice])
                         Unconfirmed_Function[service_choice] (service_request,
-                            service_request_len, src);
+                            service_request_len, context);
                 }
                 break;
             case PDU_TYPE_SIMPLE_ACK:
@@ -506,6 +570,8 @@ void apdu_handler(
                     case SERVICE_CONFIRMED_EVENT_NOTIFICATION:
                     case SERVICE_CONFIRMED_SUBSCRIBE_COV:
                     case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY:
+                    case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE:
+                    case SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE:
                     case SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION:
                         /* Object Access Services */
                     case SERVICE_CONFIRMED_ADD_LIST_ELEMENT:
@@ -526,7 +592,7 @@ void apdu_handler(
                                 Confirmed_ACK_Function[service_choice]) (src,
                                 invoke_id);
                         }
-                        tsm_free_invoke_id(invoke_id);
+                        tsm_free_peer_invoke_id(src, invoke_id);
                         break;
                     default:
                         break;
@@ -546,6 +612,15 @@ void apdu_handler(
                 service_choice = apdu[len++];
                 service_request = &apdu[len];
                 service_request_len = apdu_len - (uint16_t) len;
+                if (service_ack_data.segmented_message) {
+                    /* the handler gets the whole ComplexACK */
+                    service_request =
+                        tsm_segmented_ack_received(src, &service_ack_data,
+                        service_request, &service_request_len);
+                    if (!service_request) {
+                        break;
+                    }
+                }
                 switch (service_choice) {
                     case SERVICE_CONFIRMED_GET_ALARM_SUMMARY:
                     case SERVICE_CONFIRMED_GET_ENROLLMENT_SUMMARY:
@@ -570,16 +645,19 @@ void apdu_handler(
                                 (service_request, service_request_len, src,
                                 &service_ack_data);
                         }
-                        tsm_free_invoke_id(invoke_id);
+                        tsm_free_peer_invoke_id(src, invoke_id);
                         break;
                     default:
                         break;
                 }
                 break;
             case PDU_TYPE_SEGMENT_ACK:
-                /* FIXME: what about a denial of service attack here?
-                   we could check src to see if that matched the tsm */
-                tsm_free_invoke_id(invoke_id);
+                /* only a client acknowledges the segments we send, and
+                   the TSM checks that src matches the transaction */
+                server = apdu[0] & 0x01;
+                if ((apdu_len >= 4) && (!server)) {
+                    tsm_segment_ack_received(src, apdu[1], apdu[2], apdu[3]);
+                }
                 break;
             case PDU_TYPE_ERROR:
                 invoke_id = apdu[1];
@@ -591,7 +669,10 @@ void apdu_handler(
                    WritePropertyMultiple-Error and VTClose_Error but they may be left as
                    is for now until support for these services is added */
 
-                if (service_choice == SERVICE_CONFIRMED_PRIVATE_TRANSFER) {     /* skip over opening tag 0 */
+                if ((service_choice == SERVICE_CONFIRMED_PRIVATE_TRANSFER) ||
+                    (service_choice ==
+                        SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE)) {
+                    /* skip over opening tag 0 */
                     if (decode_is_opening_tag_number(&apdu[len], 0)) {
                         len++;  /* a tag number of 0 is not extended so only one octet */
                     }
@@ -607,7 +688,10 @@ void apdu_handler(
                 /* FIXME: we could validate that the tag is enumerated... */
                 len += decode_enumerated(&apdu[len], len_value, &error_code);
 
-                if (service_choice == SERVICE_CONFIRMED_PRIVATE_TRANSFER) {     /* skip over closing tag 0 */
+                if ((service_choice == SERVICE_CONFIRMED_PRIVATE_TRANSFER) ||
+                    (service_choice ==
+                        SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE)) {
+                    /* skip over closing tag 0 */
                     if (decode_is_closing_tag_number(&apdu[len], 0)) {
                         len++;  /* a tag number of 0 is not extended so only one octet */
                     }
@@ -618,14 +702,14 @@ void apdu_handler(
                             (BACNET_ERROR_CLASS) error_class,
                             (BACNET_ERROR_CODE) error_code);
                 }
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(src, invoke_id);
                 break;
             case PDU_TYPE_REJECT:
                 invoke_id = apdu[1];
                 reason = apdu[2];
                 if (Reject_Function)
                     Reject_Function(src, invoke_id, reason);
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(src, invoke_id);
                 break;
             case PDU_TYPE_ABORT:
                 server = apdu[0] & 0x01;
@@ -633,7 +717,12 @@ void apdu_handler(
                 reason = apdu[2];
                 if (Abort_Function)
                     Abort_Function(src, invoke_id, reason, server);
-                tsm_free_invoke_id(invoke_id);
+                if (server) {
+                    tsm_free_peer_invoke_id(src, invoke_id);
+                } else {
+                    /* the client aborted our response */
+                    tsm_free_peer_response(src, invoke_id);
+                }
                 break;
             default:
                 break;
@@ -46,6 +46,8 @@
 /** @file bip.c  Configuration and Operations for BACnet/IP */
 
 static int BIP_Socket = -1;
+/* the socket of a thread that has one of its own */
+static BACNET_THREAD_LOCAL int BIP_Thread_Socket = -1;
 /* port to use - stored in network byte order */
 static uint16_t BIP_Port = 0;   /* this will force initialization in demos */
 /* IP Address - stored in network byte order */
@@ -63,13 +65,29 @@ void bip_set_socket(
     BIP_Socket = sock_fd;
 }
 
+/** Setter for a BACnet/IP socket used only by the calling thread,
+ *  such as one from bip_reuseport_socket().  The thread then sends
+ *  and receives with it instead of the shared socket.
+ *
+ * @param sock_fd [in] Handle for the socket, or -1 for the shared one.
+ */
+void bip_set_thread_socket(
+    int sock_fd)
+{
+    BIP_Thread_Socket = sock_fd;
+}
+
 /** Getter for the BACnet/IP socket handle.
  *
- * @return The handle to the BACnet/IP socket.
+ * @return The handle to the BACnet/IP socket of the calling thread.
  */
 int bip_socket(
     void)
 {
+    if (BIP_Thread_Socket >= 0) {
+        return BIP_Thread_Socket;
+    }
+
     return BIP_Socket;
 }
 
@@ -198,13 +216,115 @@ int bip_send_pdu(
     mtu_len += pdu_len;
 
     /* Send the packet */
-    bytes_sent =
-        sendto(BIP_Socket, (char *) mtu, mtu_len, 0,
-        (struct sockaddr *) &bip_dest, sizeof(struct sockaddr));
+    bytes_sent = bip_send_mpdu(&bip_dest, mtu, (uint16_t) mtu_len);
 
     return bytes_sent;
 }
 
+#if !(defined(BIP_BURST_SIZE) && (BIP_BURST_SIZE > 1))
+/* Ports that move a burst of datagrams per system call define
+   BIP_BURST_SIZE in their net.h, and these functions in their port. */
+
+/** Sends one BACnet/IP datagram.
+ *
+ * @param dest [in] Destination address and port, in network byte order.
+ * @param mtu [in] The BVLL header and the NPDU.
+ * @param mtu_len [in] Number of bytes in the mtu buffer.
+ * @return Number of bytes sent on success, negative number on failure.
+ */
+int bip_send_mpdu(
+    struct sockaddr_in *dest,
+    uint8_t * mtu,
+    uint16_t mtu_len)
+{
+    int sock_fd = bip_socket();
+
+    if (sock_fd < 0) {
+        return sock_fd;
+    }
+
+    return sendto(sock_fd, (char *) mtu, mtu_len, 0,
+        (struct sockaddr *) dest, sizeof(struct sockaddr));
+}
+
+/** Receives one BACnet/IP datagram.
+ *
+ * @param sin [out] Source address and port, in network byte order.
+ * @param mtu [out] Buffer for the BVLL header and the NPDU.
+ * @param max_mtu [in] Size of the mtu buffer.
+ * @param timeout [in] The number of milliseconds to wait for a datagram.
+ * @return Number of bytes received, or zero if none.
+ */
+int bip_receive_mpdu(
+    struct sockaddr_in *sin,
+    uint8_t * mtu,
+    uint16_t max_mtu,
+    unsigned timeout)
+{
+    int received_bytes = 0;
+    fd_set read_fds;
+    struct timeval select_timeout;
+    socklen_t sin_len = sizeof(struct sockaddr_in);
+    int sock_fd = bip_socket();
+
+    if (sock_fd < 0) {
+        return 0;
+    }
+    /* we could just use a non-blocking socket, but that consumes all
+       the CPU time.  We can use a timeout; it is only supported as
+       a select. */
+    if (timeout >= 1000) {
+        select_timeout.tv_sec = timeout / 1000;
+        select_timeout.tv_usec =
+            1000 * (timeout - select_timeout.tv_sec * 1000);
+    } else {
+        select_timeout.tv_sec = 0;
+        select_timeout.tv_usec = 1000 * timeout;
+    }
+    FD_ZERO(&read_fds);
+    FD_SET(sock_fd, &read_fds);
+    /* see if there is a packet for us */
+    if (select(sock_fd + 1, &read_fds, NULL, NULL, &select_timeout) > 0) {
+        received_bytes =
+            recvfrom(sock_fd, (char *) &mtu[0], max_mtu, 0,
+            (struct sockaddr *) sin, &sin_len);
+    }
+    if (received_bytes < 0) {
+        received_bytes = 0;
+    }
+
+    return received_bytes;
+}
+
+/** Sends the datagrams queued by bip_send_mpdu(); each one is
+ *  sent at once here, so there is nothing to do.
+ */
+void bip_flush(
+    void)
+{
+}
+
+/** Gets the number of received datagrams that bip_receive_mpdu()
+ *  returns without waiting.
+ * @return always zero here, where each one is received alone.
+ */
+unsigned bip_receive_pending(
+    void)
+{
+    return 0;
+}
+
+/** Queues the datagrams sent until bip_flush(); each one is
+ *  sent at once here.
+ * @param enable [in] True to queue.
+ */
+void bip_set_send_queue(
+    bool enable)
+{
+    (void) enable;
+}
+#endif
+
 /** Implementation of the receive() function for BACnet/IP; receives one
  * packet, verifies its BVLC header, and removes the BVLC header from
  * the PDU data before returning.
@@ -224,11 +344,7 @@ uint16_t bip_receive(
 {
     int received_bytes = 0;
     uint16_t pdu_len = 0;       /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = { 0 };
-    socklen_t sin_len = sizeof(sin);
     uint16_t i = 0;
     int function = 0;
 
@@ -236,35 +352,9 @@ uint16_t bip_receive(
     if (BIP_Socket < 0)
         return 0;
 
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec =
-            1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(BIP_Socket, &read_fds);
-    max = BIP_Socket;
-    /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0)
-        received_bytes =
-            recvfrom(BIP_Socket, (char *) &pdu[0], max_pdu, 0,
-            (struct sockaddr *) &sin, &sin_len);
-    else
-        return 0;
-
-    /* See if there is a problem */
-    if (received_bytes < 0) {
-        return 0;
-    }
-
-    /* no problem, just no bytes */
-    if (received_bytes == 0)
+    received_bytes = bip_receive_mpdu(&sin, pdu, max_pdu, timeout);
+    /* no bytes, or a problem */
+    if (received_bytes <= 0)
         return 0;
 
     /* the signature of a BACnet/IP packet */
@@ -64,7 +64,7 @@ static bool BVLC_NAT_Handling = false;
 BACNET_BVLC_RESULT BVLC_Result_Code = BVLC_RESULT_SUCCESSFUL_COMPLETION;
 
 /** The current BVLC Function Code being handled. */
-BACNET_BVLC_FUNCTION BVLC_Function_Code = BVLC_RESULT;  /* A safe default */
+BACNET_THREAD_LOCAL BACNET_BVLC_FUNCTION BVLC_Function_Code = BVLC_RESULT;  /* A safe default */
 
 /* Define BBMD_ENABLED to get the functions that a
  * BBMD needs to handle its services.
@@ -889,8 +889,7 @@ int bvlc_send_mpdu(
     bvlc_dest.sin_port = dest->sin_port;
     memset(&(bvlc_dest.sin_zero), '\0', 8);
     /* Send the packet */
-    return sendto(bip_socket(), (char *) mtu, mtu_len, 0,
-        (struct sockaddr *) &bvlc_dest, sizeof(struct sockaddr));
+    return bip_send_mpdu(&bvlc_dest, mtu, mtu_len);
 }
 
 #if defined(BBMD_ENABLED) && BBMD_ENABLED
@@ -1183,13 +1182,9 @@ uint16_t bvlc_receive(
     unsigned timeout)
 {
     uint16_t npdu_len = 0;      /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = { 0 };
     struct sockaddr_in original_sin = { 0 };
     struct sockaddr_in dest = { 0 };
-    socklen_t sin_len = sizeof(sin);
     int received_bytes = 0;
     uint16_t result_code = 0;
     uint16_t i = 0;
@@ -1200,35 +1195,9 @@ uint16_t bvlc_receive(
     if (bip_socket() < 0) {
         return 0;
     }
-
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec =
-            1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(bip_socket(), &read_fds);
-    max = bip_socket();
-    /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0) {
-        received_bytes =
-            recvfrom(bip_socket(), (char *) &npdu[0], max_npdu, 0,
-            (struct sockaddr *) &sin, &sin_len);
-    } else {
-        return 0;
-    }
-    /* See if there is a problem */
-    if (received_bytes < 0) {
-        return 0;
-    }
-    /* no problem, just no bytes */
-    if (received_bytes == 0) {
+    received_bytes = bip_receive_mpdu(&sin, npdu, max_npdu, timeout);
+    /* no bytes, or a problem */
+    if (received_bytes <= 0) {
         return 0;
     }
     /* the signature of a BACnet/IP packet */
@@ -32,6 +32,7 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 #include <stdint.h>
+#include <string.h>
 #include "bacenum.h"
 #include "bacdcode.h"
 #include "bacdef.h"
@@ -48,36 +49,59 @@ COV Subscribe Property
 COV Notification
 Unconfirmed COV Notification
 */
-static int notify_encode_apdu(
+/* encodes the service parameters that come before the listOfValues */
+static int notify_encode_header(
     uint8_t * apdu,
-    unsigned max_apdu_len,
     BACNET_COV_DATA * data)
 {
     int len = 0;        /* length of each encoding */
     int apdu_len = 0;   /* total length of the apdu, return value */
+
+    /* tag 0 - subscriberProcessIdentifier */
+    len =
+        encode_context_unsigned(&apdu[apdu_len], 0,
+        data->subscriberProcessIdentifier);
+    apdu_len += len;
+    /* tag 1 - initiatingDeviceIdentifier */
+    len =
+        encode_context_object_id(&apdu[apdu_len], 1, OBJECT_DEVICE,
+        data->initiatingDeviceIdentifier);
+    apdu_len += len;
+    /* tag 2 - monitoredObjectIdentifier */
+    len =
+        encode_context_object_id(&apdu[apdu_len], 2,
+        (int) data->monitoredObjectIdentifier.type,
+        data->monitoredObjectIdentifier.instance);
+    apdu_len += len;
+    /* tag 3 - timeRemaining */
+    len = encode_context_unsigned(&apdu[apdu_len], 3, data->timeRemaining);
+    apdu_len += len;
+
+    return apdu_len;
+}
+
+/** Encode the listOfValues of a COV notification, so that it can be
+ *  encoded once and then sent to each subscriber of the object with
+ *  ccov_notify_encode_apdu_values() or ucov_notify_encode_apdu_values().
+ *
+ * @param apdu [out] buffer for the encoding
+ * @param max_apdu_len [in] size of the buffer
+ * @param value_list [in] the values, linked by their next member
+ * @return number of bytes encoded
+ */
+int cov_notify_encode_values(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_PROPERTY_VALUE * value_list)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
     BACNET_PROPERTY_VALUE *value = NULL;        /* value in list */
 	BACNET_APPLICATION_DATA_VALUE *app_data = NULL;
 
+    /* FIXME: unused parameter */
+    max_apdu_len = max_apdu_len;
     if (apdu) {
-        /* tag 0 - subscriberProcessIdentifier */
-        len =
-            encode_context_unsigned(&apdu[apdu_len], 0,
-            data->subscriberProcessIdentifier);
-        apdu_len += len;
-        /* tag 1 - initiatingDeviceIdentifier */
-        len =
-            encode_context_object_id(&apdu[apdu_len], 1, OBJECT_DEVICE,
-            data->initiatingDeviceIdentifier);
-        apdu_len += len;
-        /* tag 2 - monitoredObjectIdentifier */
-        len =
-            encode_context_object_id(&apdu[apdu_len], 2,
-            (int) data->monitoredObjectIdentifier.type,
-            data->monitoredObjectIdentifier.instance);
-        apdu_len += len;
-        /* tag 3 - timeRemaining */
-        len = encode_context_unsigned(&apdu[apdu_len], 3, data->timeRemaining);
-        apdu_len += len;
         /* tag 4 - listOfValues */
         len = encode_opening_tag(&apdu[apdu_len], 4);
         apdu_len += len;
@@ -85,7 +109,7 @@ static int notify_encode_apdu(
         /* FIXME: for small implementations, we might try a partial
            approach like the rpm.c where the values are encoded with
            a separate function */
-        value = data->listOfValues;
+        value = value_list;
         while (value != NULL) {
             /* tag 0 - propertyIdentifier */
             len =
@@ -132,6 +156,47 @@ static int notify_encode_apdu(
     return apdu_len;
 }
 
+static int notify_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
+
+    if (apdu) {
+        len = notify_encode_header(&apdu[0], data);
+        apdu_len += len;
+        len =
+            cov_notify_encode_values(&apdu[apdu_len], max_apdu_len - apdu_len,
+            data->listOfValues);
+        apdu_len += len;
+    }
+
+    return apdu_len;
+}
+
+/* encodes the service parameters followed by an encoded listOfValues */
+static int notify_encode_apdu_values(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_DATA * data,
+    uint8_t * values,
+    unsigned values_len)
+{
+    uint8_t header[32];
+    int len = 0;
+
+    len = notify_encode_header(&header[0], data);
+    if (!memcopylen(0, max_apdu_len, len + values_len)) {
+        return BACNET_STATUS_ERROR;
+    }
+    memcpy(&apdu[0], &header[0], len);
+    memcpy(&apdu[len], values, values_len);
+
+    return len + values_len;
+}
+
 int ccov_notify_encode_apdu(
     uint8_t * apdu,
     unsigned max_apdu_len,
@@ -185,6 +250,88 @@ int ucov_notify_encode_apdu(
     return apdu_len;
 }
 
+/** Encode an unconfirmed COV notification around a listOfValues that
+ *  was encoded by cov_notify_encode_values(); data->listOfValues is
+ *  not used.
+ *
+ * @param apdu [out] buffer for the encoding
+ * @param max_apdu_len [in] size of the buffer
+ * @param data [in] the subscriber and object of the notification
+ * @param values [in] the encoded listOfValues
+ * @param values_len [in] length of the encoded listOfValues
+ * @return number of bytes encoded, or BACNET_STATUS_ERROR if they
+ *  do not fit
+ */
+int ucov_notify_encode_apdu_values(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_DATA * data,
+    uint8_t * values,
+    unsigned values_len)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && values && memcopylen(0, max_apdu_len, 2)) {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = SERVICE_UNCONFIRMED_COV_NOTIFICATION; /* service choice */
+        apdu_len = 2;
+        len = notify_encode_apdu_values(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, values, values_len);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/** Encode a confirmed COV notification around a listOfValues that
+ *  was encoded by cov_notify_encode_values(); data->listOfValues is
+ *  not used.
+ *
+ * @param apdu [out] buffer for the encoding
+ * @param max_apdu_len [in] size of the buffer
+ * @param invoke_id [in] invoke ID of the request
+ * @param data [in] the subscriber and object of the notification
+ * @param values [in] the encoded listOfValues
+ * @param values_len [in] length of the encoded listOfValues
+ * @return number of bytes encoded, or BACNET_STATUS_ERROR if they
+ *  do not fit
+ */
+int ccov_notify_encode_apdu_values(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_DATA * data,
+    uint8_t * values,
+    unsigned values_len)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && values && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_COV_NOTIFICATION;
+        apdu_len = 4;
+        len = notify_encode_apdu_values(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, values, values_len);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
 /* decode the service request only */
 /* COV and Unconfirmed COV are the same */
 int cov_notify_decode_service_request(
@@ -697,116 +844,1105 @@ void cov_data_value_list_link(
     }
 }
 
-#ifdef TEST
-#include <assert.h>
-#include <string.h>
-#include "ctest.h"
-#include "bacapp.h"
+/*
+ConfirmedCOVNotificationMultiple-Request ::= SEQUENCE {
+    subscriberProcessIdentifier [0] Unsigned32,
+    initiatingDeviceIdentifier  [1] BACnetObjectIdentifier,
+    timeRemaining               [2] Unsigned,
+    timestamp                   [3] BACnetDateTime OPTIONAL,
+    listOfCOVNotifications      [4] SEQUENCE OF SEQUENCE {
+        monitoredObjectIdentifier [0] BACnetObjectIdentifier,
+        listOfValues              [1] SEQUENCE OF SEQUENCE {
+            propertyIdentifier [0] BACnetPropertyIdentifier,
+            propertyArrayIndex [1] Unsigned OPTIONAL,
+            value              [2] ABSTRACT-SYNTAX.&Type,
+            timeOfChange       [3] Time OPTIONAL
+            }
+        }
+    }
+UnconfirmedCOVNotificationMultiple-Request is the same.
+*/
 
-int ccov_notify_decode_apdu(
+/* encodes the service parameters ahead of the listOfCOVNotifications */
+static int notify_multiple_encode_header(
     uint8_t * apdu,
-    unsigned apdu_len,
-    uint8_t * invoke_id,
-    BACNET_COV_DATA * data)
+    BACNET_COV_MULTIPLE_DATA * data)
 {
-    int len = 0;
-    unsigned offset = 0;
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
 
-    if (!apdu) {
-        return -1;
+    /* tag 0 - subscriberProcessIdentifier */
+    len =
+        encode_context_unsigned(&apdu[apdu_len], 0,
+        data->subscriberProcessIdentifier);
+    apdu_len += len;
+    /* tag 1 - initiatingDeviceIdentifier */
+    len =
+        encode_context_object_id(&apdu[apdu_len], 1, OBJECT_DEVICE,
+        data->initiatingDeviceIdentifier);
+    apdu_len += len;
+    /* tag 2 - timeRemaining */
+    len = encode_context_unsigned(&apdu[apdu_len], 2, data->timeRemaining);
+    apdu_len += len;
+    /* tag 3 - timestamp OPTIONAL */
+    if (data->timestampPresent) {
+        len =
+            bacapp_encode_context_datetime(&apdu[apdu_len], 3,
+            &data->timestamp);
+        apdu_len += len;
     }
-    /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
-        return -2;
-    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
-    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
-    if (apdu[3] != SERVICE_CONFIRMED_COV_NOTIFICATION)
-        return -3;
-    offset = 4;
 
-    /* optional limits - must be used as a pair */
-    if (apdu_len > offset) {
+    return apdu_len;
+}
+
+/* encodes the entries of the listOfCOVNotifications, one per object */
+static int notify_multiple_encode_notifications(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_NOTIFICATION * notification)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
+    BACNET_PROPERTY_VALUE *value = NULL;        /* value in list */
+    BACNET_APPLICATION_DATA_VALUE *app_data = NULL;
+
+    while (notification != NULL) {
+        /* tag 0 - monitoredObjectIdentifier */
         len =
-            cov_notify_decode_service_request(&apdu[offset], apdu_len - offset,
-            data);
+            encode_context_object_id(&apdu[apdu_len], 0,
+            (int) notification->monitoredObjectIdentifier.type,
+            notification->monitoredObjectIdentifier.instance);
+        apdu_len += len;
+        /* tag 1 - listOfValues */
+        len = encode_opening_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        value = notification->listOfValues;
+        while (value != NULL) {
+            /* tag 0 - propertyIdentifier */
+            len =
+                encode_context_enumerated(&apdu[apdu_len], 0,
+                value->propertyIdentifier);
+            apdu_len += len;
+            /* tag 1 - propertyArrayIndex OPTIONAL */
+            if (value->propertyArrayIndex != BACNET_ARRAY_ALL) {
+                len =
+                    encode_context_unsigned(&apdu[apdu_len], 1,
+                    value->propertyArrayIndex);
+                apdu_len += len;
+            }
+            /* tag 2 - value */
+            len = encode_opening_tag(&apdu[apdu_len], 2);
+            apdu_len += len;
+            app_data = &value->value;
+            while (app_data != NULL) {
+                len =
+                    bacapp_encode_application_data(&apdu[apdu_len],
+                    app_data);
+                apdu_len += len;
+                app_data = app_data->next;
+            }
+            len = encode_closing_tag(&apdu[apdu_len], 2);
+            apdu_len += len;
+            value = value->next;
+        }
+        len = encode_closing_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        /* TODO: too late here to notice that we overran the buffer */
+        if ((unsigned) apdu_len > max_apdu_len) {
+            return BACNET_STATUS_ERROR;
+        }
+        notification = notification->next;
     }
 
-    return len;
+    return apdu_len;
 }
 
-int ucov_notify_decode_apdu(
+static int notify_multiple_encode_apdu(
     uint8_t * apdu,
-    unsigned apdu_len,
-    BACNET_COV_DATA * data)
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
 {
-    int len = 0;
-    unsigned offset = 0;
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
 
-    if (!apdu)
-        return -1;
-    /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST)
-        return -2;
-    if (apdu[1] != SERVICE_UNCONFIRMED_COV_NOTIFICATION)
-        return -3;
-    /* optional limits - must be used as a pair */
-    offset = 2;
-    if (apdu_len > offset) {
-        len =
-            cov_notify_decode_service_request(&apdu[offset], apdu_len - offset,
-            data);
+    len = notify_multiple_encode_header(&apdu[0], data);
+    apdu_len += len;
+    /* tag 4 - listOfCOVNotifications */
+    len = encode_opening_tag(&apdu[apdu_len], 4);
+    apdu_len += len;
+    len =
+        notify_multiple_encode_notifications(&apdu[apdu_len],
+        max_apdu_len - apdu_len, data->listOfCOVNotifications);
+    if (len < 0) {
+        return len;
     }
+    apdu_len += len;
+    len = encode_closing_tag(&apdu[apdu_len], 4);
+    apdu_len += len;
 
-    return len;
+    return apdu_len;
 }
 
-int cov_subscribe_decode_apdu(
+/* encodes the service parameters around already encoded entries
+   of the listOfCOVNotifications */
+static int notify_multiple_encode_apdu_notifications(
     uint8_t * apdu,
-    unsigned apdu_len,
-    uint8_t * invoke_id,
-    BACNET_SUBSCRIBE_COV_DATA * data)
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data,
+    uint8_t * notifications,
+    unsigned notifications_len)
 {
+    uint8_t header[32];
     int len = 0;
-    unsigned offset = 0;
-
-    if (!apdu)
-        return -1;
-    /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
-        return -2;
-    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
-    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
-    if (apdu[3] != SERVICE_CONFIRMED_SUBSCRIBE_COV)
-        return -3;
-    offset = 4;
 
-    /* optional limits - must be used as a pair */
-    if (apdu_len > offset) {
-        len =
-            cov_subscribe_decode_service_request(&apdu[offset],
-            apdu_len - offset, data);
+    len = notify_multiple_encode_header(&header[0], data);
+    /* the opening and closing tags 4 take one octet each */
+    if (!memcopylen(0, max_apdu_len, len + 1 + notifications_len + 1)) {
+        return BACNET_STATUS_ERROR;
     }
+    memcpy(&apdu[0], &header[0], len);
+    len += encode_opening_tag(&apdu[len], 4);
+    memcpy(&apdu[len], notifications, notifications_len);
+    len += notifications_len;
+    len += encode_closing_tag(&apdu[len], 4);
 
     return len;
 }
 
-int cov_subscribe_property_decode_apdu(
+int ucov_notify_multiple_encode_apdu(
     uint8_t * apdu,
-    unsigned apdu_len,
-    uint8_t * invoke_id,
-    BACNET_SUBSCRIBE_COV_DATA * data)
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
 {
-    int len = 0;
-    unsigned offset = 0;
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
 
-    if (!apdu)
-        return -1;
-    /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
-        return -2;
-    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
-    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
-    if (apdu[3] != SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY)
+    if (apdu && data && memcopylen(0, max_apdu_len, 2)) {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 2;
+        len =
+            notify_multiple_encode_apdu(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+int ccov_notify_multiple_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 4;
+        len =
+            notify_multiple_encode_apdu(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/** Encode an unconfirmed COV notification multiple around entries of
+ *  the listOfCOVNotifications that the caller has encoded, so that
+ *  they can be added one at a time up to the size the peer accepts;
+ *  data->listOfCOVNotifications is not used.
+ *
+ * @param apdu [out] buffer for the encoding
+ * @param max_apdu_len [in] size of the buffer
+ * @param data [in] the subscriber of the notification
+ * @param notifications [in] the encoded entries, without the tags 4
+ * @param notifications_len [in] length of the encoded entries
+ * @return number of bytes encoded, or BACNET_STATUS_ERROR if they
+ *  do not fit
+ */
+int ucov_notify_multiple_encode_apdu_notifications(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data,
+    uint8_t * notifications,
+    unsigned notifications_len)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && notifications && memcopylen(0, max_apdu_len, 2)) {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 2;
+        len =
+            notify_multiple_encode_apdu_notifications(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, notifications, notifications_len);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/** Encode a confirmed COV notification multiple around entries of
+ *  the listOfCOVNotifications that the caller has encoded;
+ *  data->listOfCOVNotifications is not used.
+ *
+ * @param apdu [out] buffer for the encoding
+ * @param max_apdu_len [in] size of the buffer
+ * @param invoke_id [in] invoke ID of the request
+ * @param data [in] the subscriber of the notification
+ * @param notifications [in] the encoded entries, without the tags 4
+ * @param notifications_len [in] length of the encoded entries
+ * @return number of bytes encoded, or BACNET_STATUS_ERROR if they
+ *  do not fit
+ */
+int ccov_notify_multiple_encode_apdu_notifications(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_MULTIPLE_DATA * data,
+    uint8_t * notifications,
+    unsigned notifications_len)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && notifications && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 4;
+        len =
+            notify_multiple_encode_apdu_notifications(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, notifications, notifications_len);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/** Decode the service request of a COV notification multiple, which is
+ *  the same for confirmed and unconfirmed.
+ *  The objects are stored in the data->listOfCOVNotifications list.
+ *  The values of all of the objects are taken in turn from the
+ *  listOfValues of the first object, so all of the value storage can
+ *  be linked there; each object is left with its own part of it.
+ *
+ * @param apdu [in] the service request
+ * @param apdu_len [in] length of the service request
+ * @param data [out] the decoded notification
+ * @return number of bytes decoded, or BACNET_STATUS_ERROR if the request
+ *  is malformed or there is not enough storage for it
+ */
+int cov_notify_multiple_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* return value */
+    int app_len = 0;
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    uint32_t decoded_value = 0; /* for decoding */
+    uint16_t decoded_type = 0;  /* for decoding */
+    uint32_t property = 0;      /* for decoding */
+    BACNET_COV_NOTIFICATION *notification = NULL;
+    BACNET_PROPERTY_VALUE *value = NULL;        /* value in list */
+    BACNET_PROPERTY_VALUE *values = NULL;       /* unused value storage */
+    BACNET_APPLICATION_DATA_VALUE *app_data = NULL;
+
+    if (!apdu_len || !data) {
+        return BACNET_STATUS_ERROR;
+    }
+    /* tag 0 - subscriberProcessIdentifier */
+    if (!decode_is_context_tag(&apdu[len], 0)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+    data->subscriberProcessIdentifier = decoded_value;
+    /* tag 1 - initiatingDeviceIdentifier */
+    if (!decode_is_context_tag(&apdu[len], 1)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len +=
+        decode_object_id(&apdu[len], &decoded_type,
+        &data->initiatingDeviceIdentifier);
+    if (decoded_type != OBJECT_DEVICE) {
+        return BACNET_STATUS_ERROR;
+    }
+    /* tag 2 - timeRemaining */
+    if (!decode_is_context_tag(&apdu[len], 2)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+    data->timeRemaining = decoded_value;
+    /* tag 3 - timestamp OPTIONAL */
+    data->timestampPresent = false;
+    if (decode_is_opening_tag_number(&apdu[len], 3)) {
+        app_len =
+            bacapp_decode_context_datetime(&apdu[len], 3, &data->timestamp);
+        if (app_len < 0) {
+            return BACNET_STATUS_ERROR;
+        }
+        len += app_len;
+        data->timestampPresent = true;
+    }
+    /* tag 4: opening context tag - listOfCOVNotifications */
+    if (!decode_is_opening_tag_number(&apdu[len], 4)) {
+        return BACNET_STATUS_ERROR;
+    }
+    /* a tag number of 4 is not extended so only one octet */
+    len++;
+    notification = data->listOfCOVNotifications;
+    if (notification == NULL) {
+        /* no space to store any objects */
+        return BACNET_STATUS_ERROR;
+    }
+    values = notification->listOfValues;
+    while (notification != NULL) {
+        /* tag 0 - monitoredObjectIdentifier */
+        if (!decode_is_context_tag(&apdu[len], 0)) {
+            return BACNET_STATUS_ERROR;
+        }
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len +=
+            decode_object_id(&apdu[len], &decoded_type,
+            &notification->monitoredObjectIdentifier.instance);
+        notification->monitoredObjectIdentifier.type = decoded_type;
+        /* tag 1: opening context tag - listOfValues */
+        if (!decode_is_opening_tag_number(&apdu[len], 1)) {
+            return BACNET_STATUS_ERROR;
+        }
+        len++;
+        notification->listOfValues = values;
+        value = NULL;
+        while (!decode_is_closing_tag_number(&apdu[len], 1)) {
+            if (value) {
+                value = value->next;
+            } else {
+                value = notification->listOfValues;
+            }
+            if (value == NULL) {
+                /* out of room to store more values */
+                return BACNET_STATUS_ERROR;
+            }
+            /* tag 0 - propertyIdentifier */
+            if (!decode_is_context_tag(&apdu[len], 0)) {
+                return BACNET_STATUS_ERROR;
+            }
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            len += decode_enumerated(&apdu[len], len_value, &property);
+            value->propertyIdentifier = (BACNET_PROPERTY_ID) property;
+            /* tag 1 - propertyArrayIndex OPTIONAL */
+            if (decode_is_context_tag(&apdu[len], 1)) {
+                len +=
+                    decode_tag_number_and_value(&apdu[len], &tag_number,
+                    &len_value);
+                len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+                value->propertyArrayIndex = decoded_value;
+            } else {
+                value->propertyArrayIndex = BACNET_ARRAY_ALL;
+            }
+            /* tag 2: opening context tag - value */
+            if (!decode_is_opening_tag_number(&apdu[len], 2)) {
+                return BACNET_STATUS_ERROR;
+            }
+            len++;
+            app_data = &value->value;
+            while (!decode_is_closing_tag_number(&apdu[len], 2)) {
+                if (app_data == NULL) {
+                    /* out of room to store more values */
+                    return BACNET_STATUS_ERROR;
+                }
+                app_len =
+                    bacapp_decode_application_data(&apdu[len], apdu_len - len,
+                    app_data);
+                if (app_len < 0) {
+                    return BACNET_STATUS_ERROR;
+                }
+                len += app_len;
+                app_data = app_data->next;
+            }
+            len++;
+            value->priority = BACNET_NO_PRIORITY;
+            /* tag 3 - timeOfChange OPTIONAL, which is not kept */
+            if (decode_is_context_tag(&apdu[len], 3)) {
+                len +=
+                    decode_tag_number_and_value(&apdu[len], &tag_number,
+                    &len_value);
+                len += len_value;
+            }
+            if ((unsigned) len >= apdu_len) {
+                return BACNET_STATUS_ERROR;
+            }
+        }
+        /* a tag number of 1 is not extended so only one octet */
+        len++;
+        /* the rest of the value storage is for the next object */
+        if (value) {
+            values = value->next;
+            value->next = NULL;
+        } else {
+            notification->listOfValues = NULL;
+        }
+        /* end of list? */
+        if (decode_is_closing_tag_number(&apdu[len], 4)) {
+            notification->next = NULL;
+            break;
+        }
+        notification = notification->next;
+        if (notification == NULL) {
+            /* out of room to store more objects */
+            return BACNET_STATUS_ERROR;
+        }
+    }
+    /* a tag number of 4 is not extended so only one octet */
+    len++;
+
+    return len;
+}
+
+/*
+SubscribeCOVPropertyMultiple-Request ::= SEQUENCE {
+    subscriberProcessIdentifier  [0] Unsigned32,
+    issueConfirmedNotifications  [1] BOOLEAN OPTIONAL,
+    lifetime                     [2] Unsigned OPTIONAL,
+    maxNotificationDelay         [3] Unsigned OPTIONAL,
+    listOfCOVSubscriptionSpecifications [4] SEQUENCE OF SEQUENCE {
+        monitoredObjectIdentifier [0] BACnetObjectIdentifier,
+        listOfCOVReferences       [1] SEQUENCE OF SEQUENCE {
+            monitoredProperty [0] BACnetPropertyReference,
+            covIncrement      [1] REAL OPTIONAL,
+            timestamped       [2] BOOLEAN
+            }
+        }
+    }
+*/
+
+int cov_subscribe_property_multiple_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION *specification = NULL;
+    BACNET_COV_REFERENCE *reference = NULL;
+
+    if (apdu && data && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE;
+        apdu_len = 4;
+        /* tag 0 - subscriberProcessIdentifier */
+        len =
+            encode_context_unsigned(&apdu[apdu_len], 0,
+            data->subscriberProcessIdentifier);
+        apdu_len += len;
+        if (!data->cancellationRequest) {
+            /* tag 1 - issueConfirmedNotifications */
+            len =
+                encode_context_boolean(&apdu[apdu_len], 1,
+                data->issueConfirmedNotifications);
+            apdu_len += len;
+            /* tag 2 - lifetime */
+            len = encode_context_unsigned(&apdu[apdu_len], 2, data->lifetime);
+            apdu_len += len;
+        }
+        /* tag 3 - maxNotificationDelay */
+        if (data->maxNotificationDelay) {
+            len =
+                encode_context_unsigned(&apdu[apdu_len], 3,
+                data->maxNotificationDelay);
+            apdu_len += len;
+        }
+        /* tag 4 - listOfCOVSubscriptionSpecifications */
+        len = encode_opening_tag(&apdu[apdu_len], 4);
+        apdu_len += len;
+        specification = data->listOfCOVSubscriptionSpecifications;
+        while (specification != NULL) {
+            /* tag 0 - monitoredObjectIdentifier */
+            len =
+                encode_context_object_id(&apdu[apdu_len], 0,
+                (int) specification->monitoredObjectIdentifier.type,
+                specification->monitoredObjectIdentifier.instance);
+            apdu_len += len;
+            /* tag 1 - listOfCOVReferences */
+            len = encode_opening_tag(&apdu[apdu_len], 1);
+            apdu_len += len;
+            reference = specification->listOfCOVReferences;
+            while (reference != NULL) {
+                /* tag 0 - monitoredProperty */
+                len = encode_opening_tag(&apdu[apdu_len], 0);
+                apdu_len += len;
+                len =
+                    encode_context_enumerated(&apdu[apdu_len], 0,
+                    reference->monitoredProperty.propertyIdentifier);
+                apdu_len += len;
+                if (reference->monitoredProperty.propertyArrayIndex !=
+                    BACNET_ARRAY_ALL) {
+                    len =
+                        encode_context_unsigned(&apdu[apdu_len], 1,
+                        reference->monitoredProperty.propertyArrayIndex);
+                    apdu_len += len;
+                }
+                len = encode_closing_tag(&apdu[apdu_len], 0);
+                apdu_len += len;
+                /* tag 1 - covIncrement */
+                if (reference->covIncrementPresent) {
+                    len =
+                        encode_context_real(&apdu[apdu_len], 1,
+                        reference->covIncrement);
+                    apdu_len += len;
+                }
+                /* tag 2 - timestamped */
+                len =
+                    encode_context_boolean(&apdu[apdu_len], 2,
+                    reference->timestamped);
+                apdu_len += len;
+                reference = reference->next;
+            }
+            len = encode_closing_tag(&apdu[apdu_len], 1);
+            apdu_len += len;
+            /* TODO: too late here to notice that we overran the buffer */
+            if ((unsigned) apdu_len > max_apdu_len) {
+                return BACNET_STATUS_ERROR;
+            }
+            specification = specification->next;
+        }
+        len = encode_closing_tag(&apdu[apdu_len], 4);
+        apdu_len += len;
+    }
+
+    return apdu_len;
+}
+
+/** Decode the service request of a SubscribeCOVPropertyMultiple.
+ *  The objects are stored in the data->listOfCOVSubscriptionSpecifications
+ *  list.  The references of all of the objects are taken in turn from
+ *  the listOfCOVReferences of the first object, so all of the reference
+ *  storage can be linked there; each object is left with its own part.
+ *
+ * @param apdu [in] the service request
+ * @param apdu_len [in] length of the service request
+ * @param data [out] the decoded request
+ * @return number of bytes decoded, BACNET_STATUS_REJECT if the request
+ *  is malformed, or BACNET_STATUS_ABORT if there is not enough storage
+ *  for it; data->error_code tells which
+ */
+int cov_subscribe_property_multiple_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* return value */
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    uint32_t decoded_value = 0; /* for decoding */
+    uint16_t decoded_type = 0;  /* for decoding */
+    uint32_t property = 0;      /* for decoding */
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION *specification = NULL;
+    BACNET_COV_REFERENCE *reference = NULL;
+    BACNET_COV_REFERENCE *references = NULL;    /* unused storage */
+
+    if (!apdu_len || !data) {
+        return BACNET_STATUS_ERROR;
+    }
+    /* tag 0 - subscriberProcessIdentifier */
+    if (!decode_is_context_tag(&apdu[len], 0)) {
+        data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+        return BACNET_STATUS_REJECT;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+    data->subscriberProcessIdentifier = decoded_value;
+    /* tag 1 - issueConfirmedNotifications - optional */
+    data->cancellationRequest = true;
+    if (decode_is_context_tag(&apdu[len], 1)) {
+        data->cancellationRequest = false;
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        data->issueConfirmedNotifications =
+            decode_context_boolean(&apdu[len]);
+        len++;
+    } else {
+        data->issueConfirmedNotifications = false;
+    }
+    /* tag 2 - lifetime - optional */
+    if (decode_is_context_tag(&apdu[len], 2)) {
+        data->cancellationRequest = false;
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+        data->lifetime = decoded_value;
+    } else {
+        data->lifetime = 0;
+    }
+    /* tag 3 - maxNotificationDelay - optional */
+    if (decode_is_context_tag(&apdu[len], 3)) {
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+        data->maxNotificationDelay = decoded_value;
+    } else {
+        data->maxNotificationDelay = 0;
+    }
+    /* tag 4: opening context tag - listOfCOVSubscriptionSpecifications */
+    if (!decode_is_opening_tag_number(&apdu[len], 4)) {
+        data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+        return BACNET_STATUS_REJECT;
+    }
+    /* a tag number of 4 is not extended so only one octet */
+    len++;
+    specification = data->listOfCOVSubscriptionSpecifications;
+    if (specification == NULL) {
+        data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+        return BACNET_STATUS_ABORT;
+    }
+    references = specification->listOfCOVReferences;
+    while (specification != NULL) {
+        /* tag 0 - monitoredObjectIdentifier */
+        if (!decode_is_context_tag(&apdu[len], 0)) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len +=
+            decode_object_id(&apdu[len], &decoded_type,
+            &specification->monitoredObjectIdentifier.instance);
+        specification->monitoredObjectIdentifier.type = decoded_type;
+        /* tag 1: opening context tag - listOfCOVReferences */
+        if (!decode_is_opening_tag_number(&apdu[len], 1)) {
+            data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+            return BACNET_STATUS_REJECT;
+        }
+        len++;
+        specification->listOfCOVReferences = references;
+        reference = NULL;
+        while (!decode_is_closing_tag_number(&apdu[len], 1)) {
+            if (reference) {
+                reference = reference->next;
+            } else {
+                reference = specification->listOfCOVReferences;
+            }
+            if (reference == NULL) {
+                data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+                return BACNET_STATUS_ABORT;
+            }
+            /* tag 0: opening context tag - monitoredProperty */
+            if (!decode_is_opening_tag_number(&apdu[len], 0)) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            len++;
+            /* the propertyIdentifier is tag 0 */
+            if (!decode_is_context_tag(&apdu[len], 0)) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            len += decode_enumerated(&apdu[len], len_value, &property);
+            reference->monitoredProperty.propertyIdentifier =
+                (BACNET_PROPERTY_ID) property;
+            /* the optional array index is tag 1 */
+            if (decode_is_context_tag(&apdu[len], 1)) {
+                len +=
+                    decode_tag_number_and_value(&apdu[len], &tag_number,
+                    &len_value);
+                len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+                reference->monitoredProperty.propertyArrayIndex =
+                    decoded_value;
+            } else {
+                reference->monitoredProperty.propertyArrayIndex =
+                    BACNET_ARRAY_ALL;
+            }
+            if (!decode_is_closing_tag_number(&apdu[len], 0)) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            len++;
+            /* tag 1 - covIncrement - optional */
+            if (decode_is_context_tag(&apdu[len], 1)) {
+                reference->covIncrementPresent = true;
+                len +=
+                    decode_tag_number_and_value(&apdu[len], &tag_number,
+                    &len_value);
+                len += decode_real(&apdu[len], &reference->covIncrement);
+            } else {
+                reference->covIncrementPresent = false;
+            }
+            /* tag 2 - timestamped */
+            if (!decode_is_context_tag(&apdu[len], 2)) {
+                data->error_code = ERROR_CODE_REJECT_INVALID_TAG;
+                return BACNET_STATUS_REJECT;
+            }
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            reference->timestamped = decode_context_boolean(&apdu[len]);
+            len++;
+            if ((unsigned) len >= apdu_len) {
+                data->error_code = ERROR_CODE_REJECT_MISSING_REQUIRED_PARAMETER;
+                return BACNET_STATUS_REJECT;
+            }
+        }
+        /* a tag number of 1 is not extended so only one octet */
+        len++;
+        /* the rest of the reference storage is for the next object */
+        if (reference) {
+            references = reference->next;
+            reference->next = NULL;
+        } else {
+            specification->listOfCOVReferences = NULL;
+        }
+        /* end of list? */
+        if (decode_is_closing_tag_number(&apdu[len], 4)) {
+            specification->next = NULL;
+            break;
+        }
+        specification = specification->next;
+        if (specification == NULL) {
+            data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+            return BACNET_STATUS_ABORT;
+        }
+    }
+    /* a tag number of 4 is not extended so only one octet */
+    len++;
+
+    return len;
+}
+
+/**
+ * Encode a SubscribeCOVPropertyMultiple-Error (Clause 13.16.1.4), which
+ * reports the error along with the first subscription that failed.
+ *
+ * @param apdu - buffer of at least MAX_APDU octets
+ * @param invoke_id - the invoke ID of the request
+ * @param data - error_class, error_code and the failed object and property
+ *
+ * @return number of bytes encoded
+ */
+int cov_subscribe_property_multiple_error_encode(
+    uint8_t * apdu,
+    uint8_t invoke_id,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
+
+    if (apdu && data) {
+        apdu[0] = PDU_TYPE_ERROR;
+        apdu[1] = invoke_id;
+        apdu[2] = SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE;
+        apdu_len = 3;
+        /* error-type */
+        len = encode_opening_tag(&apdu[apdu_len], 0);
+        apdu_len += len;
+        len =
+            encode_application_enumerated(&apdu[apdu_len],
+            data->error_class);
+        apdu_len += len;
+        len =
+            encode_application_enumerated(&apdu[apdu_len], data->error_code);
+        apdu_len += len;
+        len = encode_closing_tag(&apdu[apdu_len], 0);
+        apdu_len += len;
+        /* first-failed-subscription */
+        len = encode_opening_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        len =
+            encode_context_object_id(&apdu[apdu_len], 0,
+            (int) data->failedObjectIdentifier.type,
+            data->failedObjectIdentifier.instance);
+        apdu_len += len;
+        len = encode_opening_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        len =
+            encode_context_enumerated(&apdu[apdu_len], 0,
+            data->failedProperty.propertyIdentifier);
+        apdu_len += len;
+        if (data->failedProperty.propertyArrayIndex != BACNET_ARRAY_ALL) {
+            len =
+                encode_context_unsigned(&apdu[apdu_len], 1,
+                data->failedProperty.propertyArrayIndex);
+            apdu_len += len;
+        }
+        len = encode_closing_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        len = encode_opening_tag(&apdu[apdu_len], 2);
+        apdu_len += len;
+        len =
+            encode_application_enumerated(&apdu[apdu_len],
+            data->error_class);
+        apdu_len += len;
+        len =
+            encode_application_enumerated(&apdu[apdu_len], data->error_code);
+        apdu_len += len;
+        len = encode_closing_tag(&apdu[apdu_len], 2);
+        apdu_len += len;
+        len = encode_closing_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+    }
+
+    return apdu_len;
+}
+
+/**
+ * Decode the service parameters of a SubscribeCOVPropertyMultiple-Error,
+ * which follow the error PDU header.
+ *
+ * @param apdu - the service parameters
+ * @param apdu_len - number of valid bytes in the buffer
+ * @param data - filled with the error and the first failed subscription
+ *
+ * @return number of bytes decoded, or BACNET_STATUS_ERROR if malformed
+ */
+int cov_subscribe_property_multiple_error_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* return value */
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    uint32_t decoded_value = 0; /* for decoding */
+    uint16_t decoded_type = 0;  /* for decoding */
+
+    if (!apdu || !apdu_len || !data) {
+        return BACNET_STATUS_ERROR;
+    }
+    /* error-type */
+    if (!decode_is_opening_tag_number(&apdu[len], 0)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    if (tag_number != BACNET_APPLICATION_TAG_ENUMERATED) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_enumerated(&apdu[len], len_value, &decoded_value);
+    data->error_class = (BACNET_ERROR_CLASS) decoded_value;
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    if (tag_number != BACNET_APPLICATION_TAG_ENUMERATED) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_enumerated(&apdu[len], len_value, &decoded_value);
+    data->error_code = (BACNET_ERROR_CODE) decoded_value;
+    if (!decode_is_closing_tag_number(&apdu[len], 0)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    /* first-failed-subscription */
+    if (!decode_is_opening_tag_number(&apdu[len], 1)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    if (!decode_is_context_tag(&apdu[len], 0)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len +=
+        decode_object_id(&apdu[len], &decoded_type,
+        &data->failedObjectIdentifier.instance);
+    data->failedObjectIdentifier.type = decoded_type;
+    if (!decode_is_opening_tag_number(&apdu[len], 1)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    if (!decode_is_context_tag(&apdu[len], 0)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len += decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+    len += decode_enumerated(&apdu[len], len_value, &decoded_value);
+    data->failedProperty.propertyIdentifier =
+        (BACNET_PROPERTY_ID) decoded_value;
+    if (decode_is_context_tag(&apdu[len], 1) &&
+        !decode_is_closing_tag(&apdu[len])) {
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+        data->failedProperty.propertyArrayIndex = decoded_value;
+    } else {
+        data->failedProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+    }
+    if (!decode_is_closing_tag_number(&apdu[len], 1)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    /* the error-type of the failed subscription repeats the one above */
+    if (!decode_is_opening_tag_number(&apdu[len], 2)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    while (!decode_is_closing_tag_number(&apdu[len], 2)) {
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len += len_value;
+        if ((unsigned) len >= apdu_len) {
+            return BACNET_STATUS_ERROR;
+        }
+    }
+    len++;
+    if (!decode_is_closing_tag_number(&apdu[len], 1)) {
+        return BACNET_STATUS_ERROR;
+    }
+    len++;
+    if ((unsigned) len > apdu_len) {
+        return BACNET_STATUS_ERROR;
+    }
+
+    return len;
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include "ctest.h"
+#include "bacapp.h"
+
+int ccov_notify_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_COV_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu) {
+        return -1;
+    }
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
+    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
+    if (apdu[3] != SERVICE_CONFIRMED_COV_NOTIFICATION)
+        return -3;
+    offset = 4;
+
+    /* optional limits - must be used as a pair */
+    if (apdu_len > offset) {
+        len =
+            cov_notify_decode_service_request(&apdu[offset], apdu_len - offset,
+            data);
+    }
+
+    return len;
+}
+
+int ucov_notify_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_COV_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu)
+        return -1;
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST)
+        return -2;
+    if (apdu[1] != SERVICE_UNCONFIRMED_COV_NOTIFICATION)
+        return -3;
+    /* optional limits - must be used as a pair */
+    offset = 2;
+    if (apdu_len > offset) {
+        len =
+            cov_notify_decode_service_request(&apdu[offset], apdu_len - offset,
+            data);
+    }
+
+    return len;
+}
+
+int cov_subscribe_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_SUBSCRIBE_COV_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu)
+        return -1;
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
+    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
+    if (apdu[3] != SERVICE_CONFIRMED_SUBSCRIBE_COV)
+        return -3;
+    offset = 4;
+
+    /* optional limits - must be used as a pair */
+    if (apdu_len > offset) {
+        len =
+            cov_subscribe_decode_service_request(&apdu[offset],
+            apdu_len - offset, data);
+    }
+
+    return len;
+}
+
+int cov_subscribe_property_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_SUBSCRIBE_COV_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu)
+        return -1;
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
+    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
+    if (apdu[3] != SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY)
         return -3;
     offset = 4;
 
@@ -907,6 +2043,51 @@ void testCCOVNotifyData(
     testCOVNotifyData(pTest, data, &test_data);
 }
 
+/* the values encoded once give the same notification */
+void testCOVNotifyValues(
+    Test * pTest,
+    uint8_t invoke_id,
+    BACNET_COV_DATA * data)
+{
+    uint8_t apdu[480] = { 0 };
+    uint8_t test_apdu[480] = { 0 };
+    uint8_t values[480] = { 0 };
+    int len = 0;
+    int test_len = 0;
+    int values_len = 0;
+
+    values_len =
+        cov_notify_encode_values(&values[0], sizeof(values),
+        data->listOfValues);
+    ct_test(pTest, values_len > 0);
+    len = ucov_notify_encode_apdu(&apdu[0], sizeof(apdu), data);
+    test_len =
+        ucov_notify_encode_apdu_values(&test_apdu[0], sizeof(test_apdu),
+        data, &values[0], values_len);
+    ct_test(pTest, len == test_len);
+    ct_test(pTest, memcmp(&apdu[0], &test_apdu[0], len) == 0);
+    len = ccov_notify_encode_apdu(&apdu[0], sizeof(apdu), invoke_id, data);
+    test_len =
+        ccov_notify_encode_apdu_values(&test_apdu[0], sizeof(test_apdu),
+        invoke_id, data, &values[0], values_len);
+    ct_test(pTest, len == test_len);
+    ct_test(pTest, memcmp(&apdu[0], &test_apdu[0], len) == 0);
+    /* the subscriber fields change without encoding the values again */
+    data->subscriberProcessIdentifier = 0x12345;
+    data->timeRemaining = 0;
+    len = ucov_notify_encode_apdu(&apdu[0], sizeof(apdu), data);
+    test_len =
+        ucov_notify_encode_apdu_values(&test_apdu[0], sizeof(test_apdu),
+        data, &values[0], values_len);
+    ct_test(pTest, len == test_len);
+    ct_test(pTest, memcmp(&apdu[0], &test_apdu[0], len) == 0);
+    /* too small */
+    test_len =
+        ucov_notify_encode_apdu_values(&test_apdu[0], len - 1, data,
+        &values[0], values_len);
+    ct_test(pTest, test_len == BACNET_STATUS_ERROR);
+}
+
 void testCOVNotify(
     Test * pTest)
 {
@@ -936,6 +2117,7 @@ void testCOVNotify(
 
     testUCOVNotifyData(pTest, &data);
     testCCOVNotifyData(pTest, invoke_id, &data);
+    testCOVNotifyValues(pTest, invoke_id, &data);
 }
 
 void testCOVSubscribeData(
@@ -1076,6 +2258,433 @@ void testCOVSubscribeProperty(
     testCOVSubscribePropertyEncoding(pTest, invoke_id, &data);
 }
 
+int ccov_notify_multiple_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    if (!apdu)
+        return -1;
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    *invoke_id = apdu[2];
+    if (apdu[3] != SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE)
+        return -3;
+
+    return cov_notify_multiple_decode_service_request(&apdu[4],
+        apdu_len - 4, data);
+}
+
+int ucov_notify_multiple_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    if (!apdu)
+        return -1;
+    if (apdu[0] != PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST)
+        return -2;
+    if (apdu[1] != SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE)
+        return -3;
+
+    return cov_notify_multiple_decode_service_request(&apdu[2],
+        apdu_len - 2, data);
+}
+
+int cov_subscribe_property_multiple_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA * data)
+{
+    if (!apdu)
+        return -1;
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    *invoke_id = apdu[2];
+    if (apdu[3] != SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE)
+        return -3;
+
+    return cov_subscribe_property_multiple_decode_service_request(&apdu[4],
+        apdu_len - 4, data);
+}
+
+static void testCOVNotifyMultipleData(
+    Test * pTest,
+    BACNET_COV_MULTIPLE_DATA * data,
+    BACNET_COV_MULTIPLE_DATA * test_data)
+{
+    BACNET_COV_NOTIFICATION *notification = NULL;
+    BACNET_COV_NOTIFICATION *test_notification = NULL;
+    BACNET_PROPERTY_VALUE *value = NULL;
+    BACNET_PROPERTY_VALUE *test_value = NULL;
+
+    ct_test(pTest,
+        test_data->subscriberProcessIdentifier ==
+        data->subscriberProcessIdentifier);
+    ct_test(pTest,
+        test_data->initiatingDeviceIdentifier ==
+        data->initiatingDeviceIdentifier);
+    ct_test(pTest, test_data->timeRemaining == data->timeRemaining);
+    ct_test(pTest, test_data->timestampPresent == data->timestampPresent);
+    notification = data->listOfCOVNotifications;
+    test_notification = test_data->listOfCOVNotifications;
+    while (notification) {
+        ct_test(pTest, test_notification != NULL);
+        if (!test_notification) {
+            break;
+        }
+        ct_test(pTest,
+            test_notification->monitoredObjectIdentifier.type ==
+            notification->monitoredObjectIdentifier.type);
+        ct_test(pTest,
+            test_notification->monitoredObjectIdentifier.instance ==
+            notification->monitoredObjectIdentifier.instance);
+        value = notification->listOfValues;
+        test_value = test_notification->listOfValues;
+        while (value) {
+            ct_test(pTest, test_value != NULL);
+            if (!test_value) {
+                break;
+            }
+            ct_test(pTest,
+                test_value->propertyIdentifier == value->propertyIdentifier);
+            ct_test(pTest,
+                test_value->propertyArrayIndex == value->propertyArrayIndex);
+            ct_test(pTest, bacapp_same_value(&test_value->value,
+                    &value->value));
+            value = value->next;
+            test_value = test_value->next;
+        }
+        ct_test(pTest, test_value == NULL);
+        notification = notification->next;
+        test_notification = test_notification->next;
+    }
+    ct_test(pTest, test_notification == NULL);
+}
+
+void testCOVNotifyMultiple(
+    Test * pTest)
+{
+    uint8_t apdu[480] = { 0 };
+    uint8_t test_apdu[480] = { 0 };
+    uint8_t entries[480] = { 0 };
+    uint8_t invoke_id = 12;
+    uint8_t test_invoke_id = 0;
+    int len = 0;
+    int test_len = 0;
+    int entries_len = 0;
+    BACNET_COV_MULTIPLE_DATA data;
+    BACNET_COV_MULTIPLE_DATA test_data;
+    BACNET_COV_NOTIFICATION notification[2];
+    BACNET_COV_NOTIFICATION test_notification[3];
+    BACNET_PROPERTY_VALUE value_list[3] = {{0}};
+    BACNET_PROPERTY_VALUE test_value_list[4] = {{0}};
+    unsigned i = 0;
+
+    data.subscriberProcessIdentifier = 1;
+    data.initiatingDeviceIdentifier = 123;
+    data.timeRemaining = 456;
+    data.timestampPresent = false;
+    data.listOfCOVNotifications = &notification[0];
+    notification[0].monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+    notification[0].monitoredObjectIdentifier.instance = 321;
+    notification[0].listOfValues = &value_list[0];
+    notification[0].next = &notification[1];
+    notification[1].monitoredObjectIdentifier.type = OBJECT_BINARY_INPUT;
+    notification[1].monitoredObjectIdentifier.instance = 5;
+    notification[1].listOfValues = &value_list[2];
+    notification[1].next = NULL;
+    value_list[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    bacapp_parse_application_data(BACNET_APPLICATION_TAG_REAL, "21.0",
+        &value_list[0].value);
+    value_list[0].next = &value_list[1];
+    value_list[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    bacapp_parse_application_data(BACNET_APPLICATION_TAG_BIT_STRING, "0000",
+        &value_list[1].value);
+    value_list[1].next = NULL;
+    value_list[2].propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list[2].propertyArrayIndex = BACNET_ARRAY_ALL;
+    bacapp_parse_application_data(BACNET_APPLICATION_TAG_ENUMERATED, "1",
+        &value_list[2].value);
+    value_list[2].next = NULL;
+    /* the decoder takes the values of every object from the first */
+    for (i = 0; i < 3; i++) {
+        test_notification[i].next = (i < 2) ? &test_notification[i + 1] : NULL;
+        test_notification[i].listOfValues = NULL;
+    }
+    for (i = 0; i < 4; i++) {
+        test_value_list[i].next = (i < 3) ? &test_value_list[i + 1] : NULL;
+    }
+    test_notification[0].listOfValues = &test_value_list[0];
+    test_data.listOfCOVNotifications = &test_notification[0];
+
+    len = ucov_notify_multiple_encode_apdu(&apdu[0], sizeof(apdu), &data);
+    ct_test(pTest, len > 0);
+    test_len =
+        ucov_notify_multiple_decode_apdu(&apdu[0], len, &test_data);
+    ct_test(pTest, test_len == (len - 2));
+    testCOVNotifyMultipleData(pTest, &data, &test_data);
+
+    /* the entries encoded by the caller give the same notification */
+    entries_len = ucov_notify_multiple_encode_apdu(&entries[0],
+        sizeof(entries), &data);
+    /* strip the service choice, header and the tags 4 */
+    data.listOfCOVNotifications = NULL;
+    test_len = ucov_notify_multiple_encode_apdu(&test_apdu[0],
+        sizeof(test_apdu), &data);
+    data.listOfCOVNotifications = &notification[0];
+    memmove(&entries[0], &entries[test_len - 1], entries_len - test_len);
+    entries_len -= test_len;
+    test_len =
+        ucov_notify_multiple_encode_apdu_notifications(&test_apdu[0],
+        sizeof(test_apdu), &data, &entries[0], entries_len);
+    ct_test(pTest, len == test_len);
+    ct_test(pTest, memcmp(&apdu[0], &test_apdu[0], len) == 0);
+    test_len =
+        ucov_notify_multiple_encode_apdu_notifications(&test_apdu[0],
+        len - 1, &data, &entries[0], entries_len);
+    ct_test(pTest, test_len == BACNET_STATUS_ERROR);
+
+    /* confirmed, with a timestamp */
+    data.timestampPresent = true;
+    datetime_set_values(&data.timestamp, 2018, 6, 4, 12, 30, 15, 0);
+    test_notification[0].listOfValues = &test_value_list[0];
+    test_notification[0].next = &test_notification[1];
+    test_notification[1].next = &test_notification[2];
+    for (i = 0; i < 4; i++) {
+        test_value_list[i].next = (i < 3) ? &test_value_list[i + 1] : NULL;
+    }
+    len =
+        ccov_notify_multiple_encode_apdu(&apdu[0], sizeof(apdu), invoke_id,
+        &data);
+    ct_test(pTest, len > 0);
+    test_len =
+        ccov_notify_multiple_decode_apdu(&apdu[0], len, &test_invoke_id,
+        &test_data);
+    ct_test(pTest, test_len == (len - 4));
+    ct_test(pTest, test_invoke_id == invoke_id);
+    testCOVNotifyMultipleData(pTest, &data, &test_data);
+    ct_test(pTest, datetime_compare(&data.timestamp,
+            &test_data.timestamp) == 0);
+    test_len =
+        ccov_notify_multiple_encode_apdu_notifications(&test_apdu[0],
+        sizeof(test_apdu), invoke_id, &data, &entries[0], entries_len);
+    ct_test(pTest, len == test_len);
+    ct_test(pTest, memcmp(&apdu[0], &test_apdu[0], len) == 0);
+
+    /* not enough storage for the values */
+    test_notification[0].listOfValues = &test_value_list[2];
+    test_notification[0].next = &test_notification[1];
+    test_notification[1].next = &test_notification[2];
+    test_value_list[2].next = &test_value_list[3];
+    test_value_list[3].next = NULL;
+    test_len =
+        ccov_notify_multiple_decode_apdu(&apdu[0], len, &test_invoke_id,
+        &test_data);
+    ct_test(pTest, test_len == BACNET_STATUS_ERROR);
+}
+
+void testCOVSubscribePropertyMultiple(
+    Test * pTest)
+{
+    uint8_t apdu[480] = { 0 };
+    uint8_t invoke_id = 7;
+    uint8_t test_invoke_id = 0;
+    int len = 0;
+    int test_len = 0;
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA data;
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA test_data;
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION specification[2];
+    BACNET_COV_SUBSCRIPTION_SPECIFICATION test_specification[2];
+    BACNET_COV_REFERENCE reference[3];
+    BACNET_COV_REFERENCE test_reference[3];
+    BACNET_COV_REFERENCE *ref = NULL;
+    BACNET_COV_REFERENCE *test_ref = NULL;
+    unsigned i = 0;
+    unsigned count = 0;
+
+    data.subscriberProcessIdentifier = 3;
+    data.cancellationRequest = false;
+    data.issueConfirmedNotifications = true;
+    data.lifetime = 600;
+    data.maxNotificationDelay = 2;
+    data.listOfCOVSubscriptionSpecifications = &specification[0];
+    specification[0].monitoredObjectIdentifier.type = OBJECT_ANALOG_VALUE;
+    specification[0].monitoredObjectIdentifier.instance = 1;
+    specification[0].listOfCOVReferences = &reference[0];
+    specification[0].next = &specification[1];
+    specification[1].monitoredObjectIdentifier.type = OBJECT_BINARY_VALUE;
+    specification[1].monitoredObjectIdentifier.instance = 2;
+    specification[1].listOfCOVReferences = &reference[2];
+    specification[1].next = NULL;
+    reference[0].monitoredProperty.propertyIdentifier = PROP_PRESENT_VALUE;
+    reference[0].monitoredProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+    reference[0].covIncrementPresent = true;
+    reference[0].covIncrement = 0.5;
+    reference[0].timestamped = false;
+    reference[0].next = &reference[1];
+    reference[1].monitoredProperty.propertyIdentifier = PROP_PRIORITY_ARRAY;
+    reference[1].monitoredProperty.propertyArrayIndex = 8;
+    reference[1].covIncrementPresent = false;
+    reference[1].timestamped = true;
+    reference[1].next = NULL;
+    reference[2].monitoredProperty.propertyIdentifier = PROP_STATUS_FLAGS;
+    reference[2].monitoredProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+    reference[2].covIncrementPresent = false;
+    reference[2].timestamped = false;
+    reference[2].next = NULL;
+    test_specification[0].next = &test_specification[1];
+    test_specification[1].next = NULL;
+    test_specification[0].listOfCOVReferences = &test_reference[0];
+    for (i = 0; i < 3; i++) {
+        test_reference[i].next = (i < 2) ? &test_reference[i + 1] : NULL;
+    }
+    test_data.listOfCOVSubscriptionSpecifications = &test_specification[0];
+
+    len =
+        cov_subscribe_property_multiple_encode_apdu(&apdu[0], sizeof(apdu),
+        invoke_id, &data);
+    ct_test(pTest, len > 0);
+    test_len =
+        cov_subscribe_property_multiple_decode_apdu(&apdu[0], len,
+        &test_invoke_id, &test_data);
+    ct_test(pTest, test_len == (len - 4));
+    ct_test(pTest, test_invoke_id == invoke_id);
+    ct_test(pTest,
+        test_data.subscriberProcessIdentifier ==
+        data.subscriberProcessIdentifier);
+    ct_test(pTest, test_data.cancellationRequest == false);
+    ct_test(pTest, test_data.issueConfirmedNotifications == true);
+    ct_test(pTest, test_data.lifetime == data.lifetime);
+    ct_test(pTest, test_data.maxNotificationDelay == 2);
+    for (i = 0; i < 2; i++) {
+        ct_test(pTest,
+            test_specification[i].monitoredObjectIdentifier.type ==
+            specification[i].monitoredObjectIdentifier.type);
+        ct_test(pTest,
+            test_specification[i].monitoredObjectIdentifier.instance ==
+            specification[i].monitoredObjectIdentifier.instance);
+        ref = specification[i].listOfCOVReferences;
+        test_ref = test_specification[i].listOfCOVReferences;
+        while (ref) {
+            ct_test(pTest, test_ref != NULL);
+            if (!test_ref) {
+                break;
+            }
+            count++;
+            ct_test(pTest,
+                test_ref->monitoredProperty.propertyIdentifier ==
+                ref->monitoredProperty.propertyIdentifier);
+            ct_test(pTest,
+                test_ref->monitoredProperty.propertyArrayIndex ==
+                ref->monitoredProperty.propertyArrayIndex);
+            ct_test(pTest,
+                test_ref->covIncrementPresent == ref->covIncrementPresent);
+            if (ref->covIncrementPresent) {
+                ct_test(pTest, test_ref->covIncrement == ref->covIncrement);
+            }
+            ct_test(pTest, test_ref->timestamped == ref->timestamped);
+            ref = ref->next;
+            test_ref = test_ref->next;
+        }
+        ct_test(pTest, test_ref == NULL);
+    }
+    ct_test(pTest, count == 3);
+    ct_test(pTest, test_specification[1].next == NULL);
+
+    /* cancellation */
+    data.cancellationRequest = true;
+    data.maxNotificationDelay = 0;
+    test_specification[0].next = &test_specification[1];
+    test_specification[0].listOfCOVReferences = &test_reference[0];
+    for (i = 0; i < 3; i++) {
+        test_reference[i].next = (i < 2) ? &test_reference[i + 1] : NULL;
+    }
+    len =
+        cov_subscribe_property_multiple_encode_apdu(&apdu[0], sizeof(apdu),
+        invoke_id, &data);
+    test_len =
+        cov_subscribe_property_multiple_decode_apdu(&apdu[0], len,
+        &test_invoke_id, &test_data);
+    ct_test(pTest, test_len == (len - 4));
+    ct_test(pTest, test_data.cancellationRequest == true);
+    ct_test(pTest, test_data.maxNotificationDelay == 0);
+
+    /* not enough storage for the references */
+    test_specification[0].next = &test_specification[1];
+    test_specification[0].listOfCOVReferences = &test_reference[1];
+    test_reference[1].next = &test_reference[2];
+    test_reference[2].next = NULL;
+    test_len =
+        cov_subscribe_property_multiple_decode_apdu(&apdu[0], len,
+        &test_invoke_id, &test_data);
+    ct_test(pTest, test_len == BACNET_STATUS_ABORT);
+    ct_test(pTest, test_data.error_code == ERROR_CODE_ABORT_BUFFER_OVERFLOW);
+}
+
+void testCOVSubscribePropertyMultipleError(
+    Test * pTest)
+{
+    uint8_t apdu[MAX_APDU] = { 0 };
+    uint8_t invoke_id = 9;
+    int len = 0;
+    int test_len = 0;
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA data;
+    BACNET_SUBSCRIBE_COV_MULTIPLE_DATA test_data;
+
+    data.error_class = ERROR_CLASS_PROPERTY;
+    data.error_code = ERROR_CODE_NOT_COV_PROPERTY;
+    data.failedObjectIdentifier.type = OBJECT_ANALOG_VALUE;
+    data.failedObjectIdentifier.instance = 42;
+    data.failedProperty.propertyIdentifier = PROP_PRIORITY_ARRAY;
+    data.failedProperty.propertyArrayIndex = 8;
+    len = cov_subscribe_property_multiple_error_encode(&apdu[0], invoke_id,
+        &data);
+    ct_test(pTest, len > 3);
+    ct_test(pTest, apdu[0] == PDU_TYPE_ERROR);
+    ct_test(pTest, apdu[1] == invoke_id);
+    ct_test(pTest,
+        apdu[2] == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE);
+    test_len =
+        cov_subscribe_property_multiple_error_decode_service_request(&apdu[3],
+        len - 3, &test_data);
+    ct_test(pTest, test_len == (len - 3));
+    ct_test(pTest, test_data.error_class == data.error_class);
+    ct_test(pTest, test_data.error_code == data.error_code);
+    ct_test(pTest,
+        test_data.failedObjectIdentifier.type ==
+        data.failedObjectIdentifier.type);
+    ct_test(pTest,
+        test_data.failedObjectIdentifier.instance ==
+        data.failedObjectIdentifier.instance);
+    ct_test(pTest,
+        test_data.failedProperty.propertyIdentifier ==
+        data.failedProperty.propertyIdentifier);
+    ct_test(pTest, test_data.failedProperty.propertyArrayIndex == 8);
+
+    /* no array index */
+    data.failedProperty.propertyIdentifier = PROP_PRESENT_VALUE;
+    data.failedProperty.propertyArrayIndex = BACNET_ARRAY_ALL;
+    len = cov_subscribe_property_multiple_error_encode(&apdu[0], invoke_id,
+        &data);
+    test_len =
+        cov_subscribe_property_multiple_error_decode_service_request(&apdu[3],
+        len - 3, &test_data);
+    ct_test(pTest, test_len == (len - 3));
+    ct_test(pTest,
+        test_data.failedProperty.propertyArrayIndex == BACNET_ARRAY_ALL);
+
+    /* truncated */
+    test_len =
+        cov_subscribe_property_multiple_error_decode_service_request(&apdu[3],
+        len - 5, &test_data);
+    ct_test(pTest, test_len == BACNET_STATUS_ERROR);
+}
+
 #ifdef TEST_COV
 int main(
     int argc,
@@ -1092,6 +2701,12 @@ int main(
     assert(rc);
     rc = ct_addTestFunction(pTest, testCOVSubscribeProperty);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVNotifyMultiple);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVSubscribePropertyMultiple);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVSubscribePropertyMultipleError);
+    assert(rc);
 
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -0,0 +1,192 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacdef.h"
+#include "fnv.h"
+
+/** @file fnv.c  FNV-1a hashing of octets, for hash tables
+ *
+ * The Fowler/Noll/Vo FNV-1a hash is quick to compute a byte at a time,
+ * and spreads short keys such as addresses and object identifiers well
+ * enough for the power of two sized hash tables used in this stack.
+ * It is not a cryptographic hash, and is not meant to resist keys
+ * chosen to collide.
+ */
+
+#define FNV_PRIME 16777619UL
+
+/** Add one octet to the hash.
+ * @param value [in] the octet to add
+ * @param hash [in] the hash so far, or FNV_HASH_INIT to begin
+ * @return the new hash
+ */
+uint32_t FNV_Hash_Octet(
+    uint8_t value,
+    uint32_t hash)
+{
+    return (uint32_t) ((hash ^ value) * FNV_PRIME);
+}
+
+/** Add a block of octets to the hash.
+ * @param data [in] the octets to add
+ * @param length [in] the number of octets
+ * @param hash [in] the hash so far, or FNV_HASH_INIT to begin
+ * @return the new hash
+ */
+uint32_t FNV_Hash(
+    const uint8_t * data,
+    size_t length,
+    uint32_t hash)
+{
+    size_t i = 0;
+
+    for (i = 0; i < length; i++) {
+        hash = FNV_Hash_Octet(data[i], hash);
+    }
+
+    return hash;
+}
+
+/** Add a 32-bit value to the hash, least significant octet first.
+ * @param value [in] the value to add
+ * @param hash [in] the hash so far, or FNV_HASH_INIT to begin
+ * @return the new hash
+ */
+uint32_t FNV_Hash_Unsigned32(
+    uint32_t value,
+    uint32_t hash)
+{
+    hash = FNV_Hash_Octet((uint8_t) (value & 0xFF), hash);
+    hash = FNV_Hash_Octet((uint8_t) ((value >> 8) & 0xFF), hash);
+    hash = FNV_Hash_Octet((uint8_t) ((value >> 16) & 0xFF), hash);
+    hash = FNV_Hash_Octet((uint8_t) ((value >> 24) & 0xFF), hash);
+
+    return hash;
+}
+
+/** Add a BACnet address to the hash.  The network number is hashed,
+ * and then the remote address if there is one, or else the local MAC
+ * address, so that addresses bacnet_address_same() finds equal always
+ * hash the same.
+ * @param address [in] the address to add
+ * @param hash [in] the hash so far, or FNV_HASH_INIT to begin
+ * @return the new hash
+ */
+uint32_t FNV_Hash_Address(
+    BACNET_ADDRESS * address,
+    uint32_t hash)
+{
+    uint8_t len = 0;
+    uint8_t *adr = NULL;
+
+    hash = FNV_Hash_Octet((uint8_t) (address->net & 0xFF), hash);
+    hash = FNV_Hash_Octet((uint8_t) (address->net >> 8), hash);
+    if (address->net) {
+        len = address->len;
+        adr = address->adr;
+    } else {
+        len = address->mac_len;
+        adr = address->mac;
+    }
+    if (len > MAX_MAC_LEN) {
+        len = MAX_MAC_LEN;
+    }
+
+    return FNV_Hash(adr, len, hash);
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include "ctest.h"
+
+void testFNV(
+    Test * pTest)
+{
+    BACNET_ADDRESS a = { 0 };
+    BACNET_ADDRESS b = { 0 };
+    const uint8_t foobar[] = { 'f', 'o', 'o', 'b', 'a', 'r' };
+    const uint8_t word[] = { 0x78, 0x56, 0x34, 0x12 };
+    uint32_t hash = 0;
+
+    /* published FNV-1a test vectors */
+    ct_test(pTest, FNV_Hash(NULL, 0, FNV_HASH_INIT) == 0x811c9dc5UL);
+    ct_test(pTest, FNV_Hash_Octet('a', FNV_HASH_INIT) == 0xe40c292cUL);
+    ct_test(pTest, FNV_Hash(foobar, sizeof(foobar),
+            FNV_HASH_INIT) == 0xbf9cf968UL);
+    /* a hash may be built up in pieces */
+    hash = FNV_Hash(foobar, 3, FNV_HASH_INIT);
+    hash = FNV_Hash(&foobar[3], 3, hash);
+    ct_test(pTest, hash == 0xbf9cf968UL);
+    ct_test(pTest, FNV_Hash_Unsigned32(0x12345678UL,
+            FNV_HASH_INIT) == FNV_Hash(word, sizeof(word), FNV_HASH_INIT));
+    /* a local address hashes the network and the MAC address only */
+    a.mac_len = 6;
+    a.mac[0] = 192;
+    a.mac[5] = 0xBA;
+    b = a;
+    b.len = 1;
+    b.adr[0] = 9;
+    ct_test(pTest, FNV_Hash_Address(&a, FNV_HASH_INIT) ==
+        FNV_Hash_Address(&b, FNV_HASH_INIT));
+    b.mac[5] = 0xBB;
+    ct_test(pTest, FNV_Hash_Address(&a, FNV_HASH_INIT) !=
+        FNV_Hash_Address(&b, FNV_HASH_INIT));
+    /* a remote address hashes the network and the remote address only */
+    a.net = 5;
+    a.len = 1;
+    a.adr[0] = 9;
+    b = a;
+    b.mac[0] = 10;
+    ct_test(pTest, FNV_Hash_Address(&a, FNV_HASH_INIT) ==
+        FNV_Hash_Address(&b, FNV_HASH_INIT));
+    b.net = 6;
+    ct_test(pTest, FNV_Hash_Address(&a, FNV_HASH_INIT) !=
+        FNV_Hash_Address(&b, FNV_HASH_INIT));
+}
+
+#ifdef TEST_FNV
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("FNV Hash", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testFNV);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_FNV */
+#endif /* TEST */
@@ -41,6 +41,7 @@
 /* static data */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "keylist.h"    /* check for valid prototypes */
 
@@ -72,6 +73,8 @@ static struct Keylist *KeylistCreate(
 
 /* check to see if the array is big enough for an addition */
 /* or is too big when we are deleting and we can shrink */
+/* The array grows and shrinks geometrically so that building */
+/* a list of n nodes costs O(n) copies rather than O(n*n). */
 /* returns TRUE if success, FALSE if failed */
 static int CheckArraySize(
     OS_Keylist list)
@@ -79,33 +82,29 @@ static int CheckArraySize(
     int new_size = 0;   /* set it up so that no size change is the default */
     const int chunk = 8;        /* minimum number of nodes to allocate memory for */
     struct Keylist_Node **new_array;    /* new array of nodes, if needed */
-    int i;      /* counter */
     if (!list)
         return FALSE;
 
     /* indicates the need for more memory allocation */
-    if (list->count == list->size)
-        new_size = list->size + chunk;
-
-    /* allow for shrinking memory */
-    else if ((list->size > chunk) && (list->count < (list->size - chunk)))
-        new_size = list->size - chunk;
+    if (list->count == list->size) {
+        if (list->size < chunk)
+            new_size = chunk;
+        else
+            new_size = list->size * 2;
+    }
+    /* allow for shrinking memory - hysteresis avoids thrashing */
+    else if ((list->size > chunk) && (list->count < (list->size / 4)))
+        new_size = list->size / 2;
     if (new_size) {
 
-        /* Allocate more room for node pointer array */
-        new_array = calloc((size_t) new_size, sizeof(new_array));
+        /* Resize the node pointer array, keeping the nodes */
+        new_array =
+            realloc(list->array,
+            (size_t) new_size * sizeof(struct Keylist_Node *));
 
         /* See if we got the memory we wanted */
         if (!new_array)
             return FALSE;
-
-        /* copy the nodes from the old array to the new array */
-        if (list->array) {
-            for (i = 0; i < list->count; i++) {
-                new_array[i] = list->array[i];
-            }
-            free(list->array);
-        }
         list->array = new_array;
         list->size = new_size;
     }
@@ -180,7 +179,6 @@ int Keylist_Data_Add(
 {
     struct Keylist_Node *node;  /* holds the new node */
     int index = -1;     /* return value */
-    int i;      /* counts through the array */
 
     if (list && CheckArraySize(list)) {
         /* figure out where to put the new node */
@@ -195,9 +193,9 @@ int Keylist_Data_Add(
                 index = list->count;
 
             /* Move all the items up to make room for the new one */
-            for (i = list->count; i > index; i--) {
-                list->array[i] = list->array[i - 1];
-            }
+            memmove(&list->array[index + 1], &list->array[index],
+                (size_t) (list->count - index) *
+                sizeof(struct Keylist_Node *));
         }
 
         else {
@@ -243,11 +241,9 @@ void *Keylist_Data_Delete_By_Index(
         }
         /* Move all the nodes down one */
         else {
-            int i;      /* counter */
-            int count = list->count - 1;
-            for (i = index; i < count; i++) {
-                list->array[i] = list->array[i + 1];
-            }
+            memmove(&list->array[index], &list->array[index + 1],
+                (size_t) (list->count - 1 - index) *
+                sizeof(struct Keylist_Node *));
         }
         list->count--;
         if (node)
@@ -324,6 +320,22 @@ int Keylist_Index(
     return index;
 }
 
+/* returns the index of the node specified by key, or else of the node */
+/* with the next larger key, or the count if there is none, so that a */
+/* sorted walk can resume at a key that may have since been deleted */
+int Keylist_Index_Nearest(
+    OS_Keylist list,
+    KEY key)
+{
+    int index = 0;
+
+    if (list && list->array && list->count) {
+        (void) FindIndex(list, key, &index);
+    }
+
+    return index;
+}
+
 
 /* returns the data specified by index */
 void *Keylist_Data_Index(
@@ -666,6 +678,34 @@ static void testKeyListDataIndex(
     return;
 }
 
+static void testKeyListIndexNearest(
+    Test * pTest)
+{
+    OS_Keylist list;
+    int data1 = 42;
+    KEY key;
+
+    list = Keylist_Create();
+    ct_test(pTest, list != NULL);
+    ct_test(pTest, Keylist_Index_Nearest(list, 1) == 0);
+    for (key = 10; key <= 50; key += 10) {
+        (void) Keylist_Data_Add(list, key, &data1);
+    }
+    ct_test(pTest, Keylist_Index_Nearest(list, 0) == 0);
+    ct_test(pTest, Keylist_Index_Nearest(list, 10) == 0);
+    ct_test(pTest, Keylist_Index_Nearest(list, 11) == 1);
+    ct_test(pTest, Keylist_Index_Nearest(list, 29) == 2);
+    ct_test(pTest, Keylist_Index_Nearest(list, 30) == 2);
+    ct_test(pTest, Keylist_Index_Nearest(list, 50) == 4);
+    ct_test(pTest, Keylist_Index_Nearest(list, 51) == 5);
+    (void) Keylist_Data_Delete(list, 30);
+    ct_test(pTest, Keylist_Index_Nearest(list, 30) == 2);
+    ct_test(pTest, Keylist_Key(list, 2) == 40);
+    Keylist_Delete(list);
+
+    return;
+}
+
 /* test access of a lot of entries */
 static void testKeyListLarge(
     Test * pTest)
@@ -713,6 +753,8 @@ void testKeyList(
     assert(rc);
     rc = ct_addTestFunction(pTest, testKeyListDataIndex);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testKeyListIndexNearest);
+    assert(rc);
     rc = ct_addTestFunction(pTest, testKeyListLarge);
     assert(rc);
 }
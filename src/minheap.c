@@ -0,0 +1,365 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "minheap.h"
+
+/** @file minheap.c  Binary min-heap of timer deadlines
+ *
+ * Each node holds a 32-bit key, usually the clock value at which a
+ * timer runs out, and the index of the item it belongs to in the
+ * owner's table.  The earliest key is always at the top, so the next
+ * timer to run out is found in O(1), and inserting or removing any
+ * timer is O(log n).
+ *
+ * Keys are compared by their signed difference, so deadlines keep their
+ * order across the wrap of a free running clock, as long as no two keys
+ * in the heap are more than 2^31 apart.
+ *
+ * The heap tells the owner where each item moves to, so that the owner
+ * can keep the position with the item and remove it in O(log n), as
+ * when a timer is stopped early.
+ */
+
+/* initial number of nodes, which doubles as needed */
+#define MIN_HEAP_SIZE 16
+
+/* true if key a runs out before key b */
+static bool min_heap_before(
+    uint32_t a,
+    uint32_t b)
+{
+    /* signed difference keeps the order correct across clock wrap */
+    return ((int32_t) (a - b) < 0);
+}
+
+static void min_heap_set(
+    MIN_HEAP * heap,
+    unsigned position,
+    struct min_heap_node *node)
+{
+    heap->nodes[position] = *node;
+    if (heap->moved) {
+        heap->moved(heap->context, node->item, position);
+    }
+}
+
+static void min_heap_sift_up(
+    MIN_HEAP * heap,
+    unsigned position)
+{
+    struct min_heap_node node = heap->nodes[position];
+    unsigned parent = 0;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (!min_heap_before(node.key, heap->nodes[parent].key)) {
+            break;
+        }
+        min_heap_set(heap, position, &heap->nodes[parent]);
+        position = parent;
+    }
+    min_heap_set(heap, position, &node);
+}
+
+static void min_heap_sift_down(
+    MIN_HEAP * heap,
+    unsigned position)
+{
+    struct min_heap_node node = heap->nodes[position];
+    unsigned child = 0;
+
+    for (;;) {
+        child = (2 * position) + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (((child + 1) < heap->count) &&
+            min_heap_before(heap->nodes[child + 1].key,
+                heap->nodes[child].key)) {
+            child++;
+        }
+        if (!min_heap_before(heap->nodes[child].key, node.key)) {
+            break;
+        }
+        min_heap_set(heap, position, &heap->nodes[child]);
+        position = child;
+    }
+    min_heap_set(heap, position, &node);
+}
+
+/** Set up an empty heap.  No memory is allocated until the first
+ * item is inserted, or Min_Heap_Reserve() is called.
+ * @param heap [in] the heap
+ * @param moved [in] told where each item moves to, or NULL
+ * @param context [in] passed to the moved function
+ */
+void Min_Heap_Init(
+    MIN_HEAP * heap,
+    min_heap_moved_function moved,
+    void *context)
+{
+    heap->nodes = NULL;
+    heap->count = 0;
+    heap->size = 0;
+    heap->moved = moved;
+    heap->context = context;
+}
+
+/** Free the memory of the heap, which is left empty.
+ * The owner is not told about the items that were in it.
+ * @param heap [in] the heap
+ */
+void Min_Heap_Cleanup(
+    MIN_HEAP * heap)
+{
+    free(heap->nodes);
+    heap->nodes = NULL;
+    heap->count = 0;
+    heap->size = 0;
+}
+
+/** Make room for at least this many items, so that inserting them
+ * cannot fail.  Owners whose tables grow can reserve a node for every
+ * entry when they grow.
+ * @param heap [in] the heap
+ * @param size [in] the number of items to make room for
+ * @return true if there is room
+ */
+bool Min_Heap_Reserve(
+    MIN_HEAP * heap,
+    unsigned size)
+{
+    struct min_heap_node *nodes = NULL;
+
+    if (size > heap->size) {
+        nodes = realloc(heap->nodes, size * sizeof(struct min_heap_node));
+        if (!nodes) {
+            return false;
+        }
+        heap->nodes = nodes;
+        heap->size = size;
+    }
+
+    return true;
+}
+
+/** Add an item to the heap, growing it if needed.  O(log n).
+ * @param heap [in] the heap
+ * @param item [in] the owner's index of the item
+ * @param key [in] the deadline of the item
+ * @return false if the heap could not grow to hold the item
+ */
+bool Min_Heap_Insert(
+    MIN_HEAP * heap,
+    unsigned item,
+    uint32_t key)
+{
+    unsigned size = 0;
+
+    if (heap->count == heap->size) {
+        if (heap->size) {
+            size = heap->size * 2;
+        } else {
+            size = MIN_HEAP_SIZE;
+        }
+        if (!Min_Heap_Reserve(heap, size)) {
+            return false;
+        }
+    }
+    heap->nodes[heap->count].key = key;
+    heap->nodes[heap->count].item = item;
+    heap->count++;
+    min_heap_sift_up(heap, heap->count - 1);
+
+    return true;
+}
+
+/** Remove the item at this position from the heap.  O(log n).
+ * @param heap [in] the heap
+ * @param position [in] where the item is, as last told to the owner
+ * @return false if there is no item at the position
+ */
+bool Min_Heap_Remove(
+    MIN_HEAP * heap,
+    unsigned position)
+{
+    unsigned item = 0;
+
+    if (position >= heap->count) {
+        return false;
+    }
+    item = heap->nodes[position].item;
+    heap->count--;
+    if (position < heap->count) {
+        heap->nodes[position] = heap->nodes[heap->count];
+        min_heap_sift_down(heap, position);
+        /* the last node may belong above the removed one instead */
+        min_heap_sift_up(heap, position);
+    }
+    if (heap->moved) {
+        heap->moved(heap->context, item, MIN_HEAP_NO_POSITION);
+    }
+
+    return true;
+}
+
+/** Get the item with the earliest deadline, leaving it in the heap.
+ * @param heap [in] the heap
+ * @param item [out] the owner's index of the item, if not NULL
+ * @param key [out] the deadline of the item, if not NULL
+ * @return false if the heap is empty
+ */
+bool Min_Heap_Peek(
+    MIN_HEAP const *heap,
+    unsigned *item,
+    uint32_t * key)
+{
+    if (heap->count == 0) {
+        return false;
+    }
+    if (item) {
+        *item = heap->nodes[0].item;
+    }
+    if (key) {
+        *key = heap->nodes[0].key;
+    }
+
+    return true;
+}
+
+/** Get the number of items in the heap.
+ * @param heap [in] the heap
+ * @return the number of items
+ */
+unsigned Min_Heap_Count(
+    MIN_HEAP const *heap)
+{
+    return heap->count;
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include "ctest.h"
+
+#define TEST_ITEMS 100
+static unsigned Test_Position[TEST_ITEMS];
+
+static void testMinHeapMoved(
+    void *context,
+    unsigned item,
+    unsigned position)
+{
+    (void) context;
+    Test_Position[item] = position;
+}
+
+void testMinHeap(
+    Test * pTest)
+{
+    MIN_HEAP heap;
+    unsigned item = 0;
+    uint32_t key = 0;
+    uint32_t last = 0;
+    unsigned i = 0;
+
+    Min_Heap_Init(&heap, testMinHeapMoved, NULL);
+    ct_test(pTest, Min_Heap_Count(&heap) == 0);
+    ct_test(pTest, !Min_Heap_Peek(&heap, &item, &key));
+    ct_test(pTest, !Min_Heap_Remove(&heap, 0));
+    /* items come out in deadline order, whatever order they went in */
+    for (i = 0; i < TEST_ITEMS; i++) {
+        Test_Position[i] = MIN_HEAP_NO_POSITION;
+        ct_test(pTest, Min_Heap_Insert(&heap, i, (i * 37) % TEST_ITEMS));
+    }
+    ct_test(pTest, Min_Heap_Count(&heap) == TEST_ITEMS);
+    ct_test(pTest, heap.size >= TEST_ITEMS);
+    for (i = 0; i < TEST_ITEMS; i++) {
+        ct_test(pTest, Test_Position[i] < TEST_ITEMS);
+        ct_test(pTest, heap.nodes[Test_Position[i]].item == i);
+    }
+    /* any item can be removed by its position */
+    for (i = 0; i < TEST_ITEMS; i += 3) {
+        ct_test(pTest, Min_Heap_Remove(&heap, Test_Position[i]));
+        ct_test(pTest, Test_Position[i] == MIN_HEAP_NO_POSITION);
+    }
+    last = 0;
+    while (Min_Heap_Peek(&heap, &item, &key)) {
+        ct_test(pTest, key >= last);
+        ct_test(pTest, key == ((item * 37) % TEST_ITEMS));
+        ct_test(pTest, (item % 3) != 0);
+        ct_test(pTest, Test_Position[item] == 0);
+        last = key;
+        ct_test(pTest, Min_Heap_Remove(&heap, 0));
+    }
+    ct_test(pTest, Min_Heap_Count(&heap) == 0);
+    /* deadlines keep their order across the wrap of the clock */
+    ct_test(pTest, Min_Heap_Insert(&heap, 1, 0x00000010UL));
+    ct_test(pTest, Min_Heap_Insert(&heap, 2, 0xFFFFFFF0UL));
+    ct_test(pTest, Min_Heap_Insert(&heap, 3, 0x00000000UL));
+    ct_test(pTest, Min_Heap_Peek(&heap, &item, NULL));
+    ct_test(pTest, item == 2);
+    ct_test(pTest, Min_Heap_Remove(&heap, Test_Position[2]));
+    ct_test(pTest, Min_Heap_Peek(&heap, &item, NULL));
+    ct_test(pTest, item == 3);
+    ct_test(pTest, Min_Heap_Remove(&heap, Test_Position[1]));
+    ct_test(pTest, Min_Heap_Peek(&heap, &item, &key));
+    ct_test(pTest, (item == 3) && (key == 0));
+    Min_Heap_Cleanup(&heap);
+    ct_test(pTest, Min_Heap_Count(&heap) == 0);
+    /* a reserved heap does not need to grow */
+    ct_test(pTest, Min_Heap_Reserve(&heap, 4));
+    ct_test(pTest, heap.size == 4);
+    for (i = 0; i < 4; i++) {
+        ct_test(pTest, Min_Heap_Insert(&heap, i, 4 - i));
+    }
+    ct_test(pTest, heap.size == 4);
+    Min_Heap_Cleanup(&heap);
+}
+
+#ifdef TEST_MIN_HEAP
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("Min Heap", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testMinHeap);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_MIN_HEAP */
+#endif /* TEST */
@@ -574,11 +574,51 @@ void testNPDU1(
 
 #ifdef TEST_NPDU
 /* dummy stub for testing */
-void tsm_free_invoke_id(
+void tsm_free_peer_invoke_id(
+    BACNET_ADDRESS * src,
     uint8_t invokeID)
 {
+    (void) src;
+    (void) invokeID;
+}
+
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+void tsm_segment_ack_received(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID,
+    uint8_t sequence_number,
+    uint8_t actual_window_size)
+{
+    (void) src;
     (void) invokeID;
+    (void) sequence_number;
+    (void) actual_window_size;
+}
+
+void tsm_free_peer_response(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    (void) src;
+    (void) invokeID;
+}
+#endif
+
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+uint8_t *tsm_segmented_ack_received(
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data,
+    uint8_t * service_request,
+    uint16_t * service_request_len)
+{
+    (void) src;
+    (void) service_data;
+    (void) service_request;
+    (void) service_request_len;
+
+    return NULL;
 }
+#endif
 
 void iam_handler(
     uint8_t * service_request,
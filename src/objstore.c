@@ -0,0 +1,368 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "bacdef.h"
+#include "keylist.h"
+#include "objstore.h"
+
+/** @file objstore.c  Sparse store of the objects of one type
+ *
+ * The objects of a type are kept in a keyed list, sorted by object
+ * instance, with a block of data of the same size for each.  Instance
+ * numbers may be sparse, and objects may be created and deleted at any
+ * time.  Finding an object by instance is a binary search, O(log n),
+ * and by index is O(1).  Creating or deleting an object moves the
+ * entries above it along with memmove(), O(n), and the list grows and
+ * shrinks by doubling and halving, so that is amortized rather than a
+ * reallocation each time.  The demo objects use the store in place of
+ * fixed arrays indexed 0..MAX-1.
+ *
+ * Create and delete are O(n), not O(1).  An FNV-1a hash of the
+ * instance (fnv.c) would find the slot in O(1), but the objects are
+ * also reached by index, for the Object_List and the Index_To_Instance
+ * functions, and in instance order.  A hash alone would lose that
+ * order.  Keeping both would double the bookkeeping, and the moves only
+ * happen when objects are created or deleted, not when they are read.
+ */
+
+/** Sets up the store, unless it has been set up already.
+ * @param store [in] the store
+ * @return true if the store was set up now, so that its first objects
+ *  can be created; false if it was already set up, or memory is short
+ */
+bool Object_Store_Init(
+    OBJECT_STORE * store)
+{
+    if (store->list) {
+        return false;
+    }
+    store->list = Keylist_Create();
+
+    return (store->list != NULL);
+}
+
+/** Adds an object to the store, with its data zeroed.  O(n).
+ * @param store [in] the store, which is set up if it was not
+ * @param object_instance [in] the instance of the new object
+ * @return the data of the new object, or NULL if the instance is not
+ *  valid, the object exists already, or memory is short
+ */
+void *Object_Store_Create(
+    OBJECT_STORE * store,
+    uint32_t object_instance)
+{
+    void *data = NULL;
+
+    if (object_instance >= BACNET_MAX_INSTANCE) {
+        return NULL;
+    }
+    if (!store->list) {
+        (void) Object_Store_Init(store);
+        if (!store->list) {
+            return NULL;
+        }
+    }
+    if (Keylist_Data(store->list, object_instance)) {
+        return NULL;
+    }
+    data = calloc(1, store->data_size);
+    if (!data) {
+        return NULL;
+    }
+    if (Keylist_Data_Add(store->list, object_instance, data) < 0) {
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+/** Removes an object from the store, and frees its data.  O(n).
+ * @param store [in] the store
+ * @param object_instance [in] the instance of the object
+ * @return true if the object was found and deleted
+ */
+bool Object_Store_Delete(
+    OBJECT_STORE * store,
+    uint32_t object_instance)
+{
+    void *data = NULL;
+
+    if (!store->list) {
+        return false;
+    }
+    data = Keylist_Data_Delete(store->list, object_instance);
+    if (!data) {
+        return false;
+    }
+    if (store->free_function) {
+        store->free_function(object_instance, data);
+    }
+    free(data);
+
+    return true;
+}
+
+/** Removes all of the objects, and the list that held them, so that
+ * Object_Store_Init() sets the store up again.
+ * @param store [in] the store
+ */
+void Object_Store_Cleanup(
+    OBJECT_STORE * store)
+{
+    uint32_t object_instance = 0;
+    void *data = NULL;
+
+    if (!store->list) {
+        return;
+    }
+    /* from the end, so that nothing is moved */
+    while (Keylist_Count(store->list) > 0) {
+        object_instance =
+            Keylist_Key(store->list, Keylist_Count(store->list) - 1);
+        data = Keylist_Data_Pop(store->list);
+        if (store->free_function) {
+            store->free_function(object_instance, data);
+        }
+        free(data);
+    }
+    Keylist_Delete(store->list);
+    store->list = NULL;
+}
+
+/** Finds the data of an object.  O(log n).
+ * @param store [in] the store
+ * @param object_instance [in] the instance of the object
+ * @return the data of the object, or NULL if there is no such object
+ */
+void *Object_Store_Data(
+    OBJECT_STORE * store,
+    uint32_t object_instance)
+{
+    return Keylist_Data(store->list, object_instance);
+}
+
+/** Finds the data of the object at an index.  O(1).
+ * @param store [in] the store
+ * @param index [in] 0..N-1 where N is Object_Store_Count()
+ * @return the data of the object, or NULL if the index is not valid
+ */
+void *Object_Store_Data_Index(
+    OBJECT_STORE * store,
+    unsigned index)
+{
+    return Keylist_Data_Index(store->list, (int) index);
+}
+
+/** Tells whether an object is in the store.  O(log n).
+ * @param store [in] the store
+ * @param object_instance [in] the instance of the object
+ * @return true if the object exists
+ */
+bool Object_Store_Valid_Instance(
+    OBJECT_STORE * store,
+    uint32_t object_instance)
+{
+    return (Keylist_Data(store->list, object_instance) != NULL);
+}
+
+/** Counts the objects in the store.
+ * @param store [in] the store
+ * @return the number of objects
+ */
+unsigned Object_Store_Count(
+    OBJECT_STORE * store)
+{
+    if (!store->list) {
+        return 0;
+    }
+
+    return (unsigned) Keylist_Count(store->list);
+}
+
+/** Finds the instance of the object at an index, in order of instance.
+ * O(1).
+ * @param store [in] the store
+ * @param index [in] 0..N-1 where N is Object_Store_Count()
+ * @return the instance of the object, or 0 if the index is not valid
+ */
+uint32_t Object_Store_Index_To_Instance(
+    OBJECT_STORE * store,
+    unsigned index)
+{
+    return Keylist_Key(store->list, (int) index);
+}
+
+/** Finds the index of an object, in order of instance.  O(log n).
+ * @param store [in] the store
+ * @param object_instance [in] the instance of the object
+ * @return the index, or Object_Store_Count() if there is no such object
+ */
+unsigned Object_Store_Instance_To_Index(
+    OBJECT_STORE * store,
+    uint32_t object_instance)
+{
+    int index = -1;
+
+    if (store->list) {
+        index = Keylist_Index(store->list, object_instance);
+    }
+    if (index < 0) {
+        return Object_Store_Count(store);
+    }
+
+    return (unsigned) index;
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include "ctest.h"
+
+struct test_object {
+    uint32_t instance;
+    uint8_t value;
+};
+
+static unsigned Test_Free_Count;
+
+static void testObjectFree(
+    uint32_t object_instance,
+    void *data)
+{
+    struct test_object *pObject = data;
+
+    if (pObject->instance == object_instance) {
+        Test_Free_Count++;
+    }
+}
+
+void testObjectStore(
+    Test * pTest)
+{
+    OBJECT_STORE store =
+        OBJECT_STORE_INIT(sizeof(struct test_object), testObjectFree);
+    struct test_object *pObject = NULL;
+    const uint32_t instances[] = { 1000, 5, 4194302, 0, 77 };
+    unsigned i = 0;
+    bool status = false;
+
+    ct_test(pTest, Object_Store_Count(&store) == 0);
+    ct_test(pTest, Object_Store_Data(&store, 0) == NULL);
+    ct_test(pTest, Object_Store_Instance_To_Index(&store, 0) == 0);
+    ct_test(pTest, !Object_Store_Delete(&store, 0));
+    status = Object_Store_Init(&store);
+    ct_test(pTest, status);
+    status = Object_Store_Init(&store);
+    ct_test(pTest, !status);
+    /* sparse instances, created in any order */
+    for (i = 0; i < sizeof(instances) / sizeof(instances[0]); i++) {
+        pObject = Object_Store_Create(&store, instances[i]);
+        ct_test(pTest, pObject != NULL);
+        ct_test(pTest, pObject->value == 0);
+        pObject->instance = instances[i];
+        pObject->value = (uint8_t) (i + 1);
+    }
+    ct_test(pTest, Object_Store_Count(&store) == 5);
+    /* no duplicates, and no instances out of range */
+    ct_test(pTest, Object_Store_Create(&store, 77) == NULL);
+    ct_test(pTest, Object_Store_Create(&store, BACNET_MAX_INSTANCE) == NULL);
+    ct_test(pTest, Object_Store_Count(&store) == 5);
+    /* indexed in order of instance */
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 0) == 0);
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 1) == 5);
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 2) == 77);
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 3) == 1000);
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 4) == 4194302);
+    ct_test(pTest, Object_Store_Instance_To_Index(&store, 1000) == 3);
+    ct_test(pTest, Object_Store_Instance_To_Index(&store, 6) == 5);
+    pObject = Object_Store_Data_Index(&store, 2);
+    ct_test(pTest, pObject && (pObject->instance == 77));
+    ct_test(pTest, Object_Store_Data_Index(&store, 5) == NULL);
+    pObject = Object_Store_Data(&store, 4194302);
+    ct_test(pTest, pObject && (pObject->value == 3));
+    ct_test(pTest, Object_Store_Valid_Instance(&store, 5));
+    ct_test(pTest, !Object_Store_Valid_Instance(&store, 6));
+    /* deleting frees through the free function */
+    status = Object_Store_Delete(&store, 5);
+    ct_test(pTest, status);
+    ct_test(pTest, Test_Free_Count == 1);
+    ct_test(pTest, !Object_Store_Valid_Instance(&store, 5));
+    ct_test(pTest, Object_Store_Index_To_Instance(&store, 1) == 77);
+    status = Object_Store_Delete(&store, 5);
+    ct_test(pTest, !status);
+    ct_test(pTest, Test_Free_Count == 1);
+    /* and may be created again */
+    pObject = Object_Store_Create(&store, 5);
+    ct_test(pTest, pObject != NULL);
+    pObject->instance = 5;
+    ct_test(pTest, Object_Store_Count(&store) == 5);
+    /* many more, to grow and shrink the list */
+    for (i = 2000; i < 3000; i++) {
+        pObject = Object_Store_Create(&store, i);
+        ct_test(pTest, pObject != NULL);
+        pObject->instance = i;
+    }
+    ct_test(pTest, Object_Store_Count(&store) == 1005);
+    for (i = 2000; i < 3000; i++) {
+        status = Object_Store_Delete(&store, i);
+        ct_test(pTest, status);
+    }
+    ct_test(pTest, Test_Free_Count == 1001);
+    ct_test(pTest, Object_Store_Count(&store) == 5);
+    Object_Store_Cleanup(&store);
+    ct_test(pTest, Test_Free_Count == 1006);
+    ct_test(pTest, Object_Store_Count(&store) == 0);
+    ct_test(pTest, Object_Store_Data(&store, 0) == NULL);
+    /* and is set up again from the start */
+    status = Object_Store_Init(&store);
+    ct_test(pTest, status);
+    Object_Store_Cleanup(&store);
+}
+
+#ifdef TEST_OBJECT_STORE
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("Object Store", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testObjectStore);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_OBJECT_STORE */
+#endif /* TEST */
@@ -76,7 +76,11 @@ int rr_encode_apdu(
 
     if (apdu) {
         apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
-        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+        /* segmented-response-accepted */
+        apdu[0] |= BIT(1);
+#endif
+        apdu[1] = encode_max_segs_max_apdu(MAX_SEGMENTS_ACCEPTED, MAX_APDU);
         apdu[2] = invoke_id;
         apdu[3] = SERVICE_CONFIRMED_READ_RANGE; /* service choice */
         apdu_len = 4;
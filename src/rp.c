@@ -51,7 +51,11 @@ int rp_encode_apdu(
 
     if (apdu) {
         apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
-        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+        /* segmented-response-accepted */
+        apdu[0] |= BIT(1);
+#endif
+        apdu[1] = encode_max_segs_max_apdu(MAX_SEGMENTS_ACCEPTED, MAX_APDU);
         apdu[2] = invoke_id;
         apdu[3] = SERVICE_CONFIRMED_READ_PROPERTY;      /* service choice */
         apdu_len = 4;
@@ -306,7 +310,7 @@ int rp_decode_apdu(
     if (!apdu)
         return -1;
     /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+    if ((apdu[0] & 0xF0) != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
         return -1;
     /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
     *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
@@ -35,6 +35,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "bits.h"
 #include "apdu.h"
 #include "bacdef.h"
@@ -46,6 +49,9 @@
 #include "handlers.h"
 #include "address.h"
 #include "bacaddr.h"
+#include "abort.h"
+#include "fnv.h"
+#include "minheap.h"
 
 /** @file tsm.c  BACnet Transaction State Machine operations  */
 
@@ -55,88 +61,701 @@
 /* If we are only a server and only initiate broadcasts, */
 /* then we don't need a TSM layer. */
 
-/* FIXME: not coded for segmentation */
+/* FIXME: segmented requests are not received */
 
 /* declare space for the TSM transactions, and set it up in the init. */
 /* table rules: an Invoke ID = 0 is an unused spot in the table */
-static BACNET_TSM_DATA TSM_List[MAX_TSM_TRANSACTIONS];
+/* The table starts out with MAX_TSM_TRANSACTIONS entries and grows
+   up to MAX_TSM_TRANSACTIONS_DYNAMIC, since an invoke ID only needs
+   to be unique for each peer device. */
+static BACNET_TSM_DATA *TSM_List;
+
+/* marks the end of a chain of TSM_List indexes */
+#define TSM_NO_INDEX UINT_MAX
+
+/* bookkeeping for each TSM_List entry */
+struct tsm_link {
+    /* next entry in the same hash bucket, or on the free list */
+    unsigned next;
+    /* entries using the same invoke ID, for replies from an address
+       other than the one the request was sent to */
+    unsigned id_next;
+    unsigned id_prev;
+    /* position in the timer heap, or MIN_HEAP_NO_POSITION */
+    unsigned timer_position;
+    /* true once the peer address is known and the entry is hashed */
+    bool bound;
+    /* size class of the apdu buffer */
+    uint8_t buffer_class;
+    /* TSM_Peer entry of the bound peer, or TSM_NO_INDEX */
+    unsigned peer;
+    /* TSM_Clock when the request was last sent */
+    uint32_t sent_time;
+    /* true for a segmented response to a request from the peer,
+       which uses the invoke ID of the peer */
+    bool server;
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+    /* segmented response: the NPDU header at the front of the copy,
+       the size of each segment, the number of segments, and the
+       first segment of the window that is awaiting a SegmentACK */
+    uint8_t npdu_len;
+    uint16_t segment_size;
+    unsigned segment_count;
+    unsigned segment_first;
+#endif
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+    /* segmented confirmation: the size of the buffer that the
+       segments of the ComplexACK are reassembled in */
+    unsigned reassembly_size;
+#endif
+};
+static struct tsm_link *TSM_Link;
+static unsigned TSM_List_Size;
+static unsigned TSM_Used_Count;
+static unsigned TSM_Free_Head = TSM_NO_INDEX;
+
+/* chains of TSM_List indexes hashed by peer address and invoke ID */
+static unsigned *TSM_Hash;
+/* always a power of two, or zero */
+static unsigned TSM_Hash_Size;
+
+/* head of the chain of entries using each invoke ID */
+static unsigned TSM_ID_Head[256];
+static bool TSM_Initialized;
+
+/* Copies kept for retries come from per size class free lists.
+   The smallest class is TSM_BUFFER_MIN bytes and each class is twice
+   the size of the one before, so a short request doesn't hold on to
+   a MAX_PDU sized buffer. */
+#define TSM_BUFFER_MIN 32
+#define TSM_BUFFER_CLASSES 8
+#if ((TSM_BUFFER_MIN << (TSM_BUFFER_CLASSES - 1)) < MAX_PDU)
+#error "TSM_BUFFER_CLASSES is too small for MAX_PDU"
+#endif
+/* a segmented response larger than the largest class gets a buffer
+   of its own, marked with this class */
+#define TSM_BUFFER_LARGE TSM_BUFFER_CLASSES
+#if (MAX_PDU_SEGMENTED > 65535)
+#error "MAX_SEGMENTS_TRANSMIT is too large for MAX_APDU"
+#endif
+#if (MAX_APDU_REASSEMBLED > 65535)
+#error "MAX_SEGMENTS_ACCEPTED is too large for MAX_APDU"
+#endif
+/* a free buffer holds the pointer to the next free buffer */
+static uint8_t *TSM_Buffer_Free[TSM_BUFFER_CLASSES];
+
+/* TSM_List indexes that are awaiting confirmation, ordered by the
+   TSM_Clock time at which their request timer expires */
+static void tsm_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position);
+static MIN_HEAP TSM_Timer_Heap = { NULL, 0, 0, tsm_timer_moved, NULL };
+/* milliseconds elapsed, as counted by tsm_timer_milliseconds() */
+static uint32_t TSM_Clock;
+/* milliseconds passed to the last tsm_timer_milliseconds() call */
+static uint16_t TSM_Tick;
 
 /* invoke ID for incrementing between subsequent calls. */
 static uint8_t Current_Invoke_ID = 1;
 
 static tsm_timeout_function Timeout_Function;
 
+/* Taken by the server functions that read-only request handlers call,
+   for when several threads serve such requests at once.  Everything
+   else in the TSM is used by one thread at a time. */
+static tsm_lock_function TSM_Lock;
+static tsm_lock_function TSM_Unlock;
+
+/* Round trip time estimates for each peer, from which the request
+   timeouts are derived as described by Jacobson and Karels and
+   in RFC 6298.  The resolution is that of the tsm_timer_milliseconds()
+   calls, so round trips are only measured while it is called at least
+   every TSM_TIMEOUT_MIN milliseconds.  Until a peer has been measured,
+   apdu_timeout() is used.  A retry waits at least apdu_timeout(), or
+   with TSM_RETRY_BACKOFF, twice as long as the previous try. */
+#ifndef TSM_TIMEOUT_MIN
+#define TSM_TIMEOUT_MIN 250
+#endif
+#ifndef TSM_TIMEOUT_MAX
+#define TSM_TIMEOUT_MAX 30000
+#endif
+#ifndef TSM_RETRY_BACKOFF
+#define TSM_RETRY_BACKOFF 0
+#endif
+/* peers beyond this many use apdu_timeout() */
+#ifndef MAX_TSM_PEERS
+#define MAX_TSM_PEERS 4096
+#endif
+struct tsm_peer {
+    BACNET_ADDRESS address;
+    /* next entry in the same hash bucket */
+    unsigned next;
+    /* smoothed round trip time, in milliseconds scaled by 8 */
+    uint32_t srtt;
+    /* round trip time mean deviation, in milliseconds scaled by 4 */
+    uint32_t rttvar;
+    /* current retransmission timeout in milliseconds, 0 if unmeasured */
+    uint16_t rto;
+    /* true once a round trip time has been measured */
+    bool measured;
+};
+static struct tsm_peer *TSM_Peer;
+static unsigned TSM_Peer_Count;
+static unsigned TSM_Peer_Size;
+/* chains of TSM_Peer indexes hashed by address; power of two size */
+static unsigned *TSM_Peer_Hash;
+static unsigned TSM_Peer_Hash_Size;
+
 void tsm_set_timeout_handler(
     tsm_timeout_function pFunction)
 {
     Timeout_Function = pFunction;
 }
 
-/* returns MAX_TSM_TRANSACTIONS if not found */
-static uint8_t tsm_find_invokeID_index(
+/** Sets the functions that lock and unlock the TSM around
+ *  tsm_complex_ack_max() and tsm_send_complex_ack(), so that request
+ *  handlers may call them from several threads at once.
+ *
+ * @param lock [in] function to take the lock, or NULL
+ * @param unlock [in] function to release the lock, or NULL
+ */
+void tsm_set_lock_handlers(
+    tsm_lock_function lock,
+    tsm_lock_function unlock)
+{
+    TSM_Lock = lock;
+    TSM_Unlock = unlock;
+}
+
+static void tsm_init(
+    void)
+{
+    unsigned i = 0;
+
+    if (!TSM_Initialized) {
+        for (i = 0; i < 256; i++) {
+            TSM_ID_Head[i] = TSM_NO_INDEX;
+        }
+        TSM_Initialized = true;
+    }
+}
+
+static void tsm_invoke_id_next(
+    void)
+{
+    Current_Invoke_ID++;
+    /* skip zero - we treat that internally as invalid or no free */
+    if (Current_Invoke_ID == 0) {
+        Current_Invoke_ID = 1;
+    }
+}
+
+/* FNV-1a of the invoke ID and the parts of the address compared
+   by bacnet_address_same() */
+static uint32_t tsm_address_hash(
+    BACNET_ADDRESS * peer,
     uint8_t invokeID)
 {
-    unsigned i = 0;     /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS;       /* return value */
+    return FNV_Hash_Address(peer, FNV_Hash_Octet(invokeID, FNV_HASH_INIT));
+}
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == invokeID) {
-            index = (uint8_t) i;
+static unsigned tsm_hash(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID)
+{
+    return (unsigned) (tsm_address_hash(peer, invokeID) & (TSM_Hash_Size -
+            1));
+}
+
+static void tsm_hash_insert(
+    unsigned index)
+{
+    unsigned bucket = 0;
+
+    bucket = tsm_hash(&TSM_List[index].dest, TSM_List[index].InvokeID);
+    TSM_Link[index].next = TSM_Hash[bucket];
+    TSM_Hash[bucket] = index;
+}
+
+static void tsm_hash_remove(
+    unsigned index)
+{
+    unsigned bucket = 0;
+    unsigned *link = NULL;
+
+    bucket = tsm_hash(&TSM_List[index].dest, TSM_List[index].InvokeID);
+    link = &TSM_Hash[bucket];
+    while (*link != TSM_NO_INDEX) {
+        if (*link == index) {
+            *link = TSM_Link[index].next;
             break;
         }
+        link = &TSM_Link[*link].next;
+    }
+}
+
+/* doubles the table, up to MAX_TSM_TRANSACTIONS_DYNAMIC entries;
+   returns false if the table could not grow */
+static bool tsm_grow(
+    void)
+{
+    unsigned size = 0;
+    unsigned hash_size = 0;
+    unsigned i = 0;
+    BACNET_TSM_DATA *list = NULL;
+    struct tsm_link *links = NULL;
+    unsigned *hash = NULL;
+
+    if (TSM_List_Size) {
+        size = TSM_List_Size * 2;
+    } else {
+        size = MAX_TSM_TRANSACTIONS;
+    }
+    if (size > MAX_TSM_TRANSACTIONS_DYNAMIC) {
+        size = MAX_TSM_TRANSACTIONS_DYNAMIC;
+    }
+    if (size <= TSM_List_Size) {
+        return false;
+    }
+    list = realloc(TSM_List, size * sizeof(BACNET_TSM_DATA));
+    if (!list) {
+        return false;
+    }
+    TSM_List = list;
+    links = realloc(TSM_Link, size * sizeof(struct tsm_link));
+    if (!links) {
+        return false;
+    }
+    TSM_Link = links;
+    /* a timer can then always be started */
+    if (!Min_Heap_Reserve(&TSM_Timer_Heap, size)) {
+        return false;
+    }
+    hash_size = 1;
+    while (hash_size < size) {
+        hash_size *= 2;
+    }
+    if (hash_size != TSM_Hash_Size) {
+        hash = realloc(TSM_Hash, hash_size * sizeof(unsigned));
+        if (!hash) {
+            return false;
+        }
+        TSM_Hash = hash;
+        TSM_Hash_Size = hash_size;
+        for (i = 0; i < TSM_Hash_Size; i++) {
+            TSM_Hash[i] = TSM_NO_INDEX;
+        }
+        for (i = 0; i < TSM_List_Size; i++) {
+            if (TSM_Link[i].bound) {
+                tsm_hash_insert(i);
+            }
+        }
+    }
+    memset(&TSM_List[TSM_List_Size], 0,
+        (size - TSM_List_Size) * sizeof(BACNET_TSM_DATA));
+    /* push in reverse so that the lowest index is handed out first */
+    for (i = size; i > TSM_List_Size; i--) {
+        TSM_Link[i - 1].next = TSM_Free_Head;
+        TSM_Link[i - 1].timer_position = MIN_HEAP_NO_POSITION;
+        TSM_Link[i - 1].bound = false;
+        TSM_Free_Head = i - 1;
+    }
+    TSM_List_Size = size;
+
+    return true;
+}
+
+/* finds our request to the peer, or our response to a request from
+   the peer if server is true.  returns TSM_NO_INDEX if not found */
+static unsigned tsm_find_index(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID,
+    bool server)
+{
+    unsigned index = TSM_NO_INDEX;
+
+    if (peer && TSM_Hash_Size) {
+        index = TSM_Hash[tsm_hash(peer, invokeID)];
+        while (index != TSM_NO_INDEX) {
+            if ((TSM_List[index].InvokeID == invokeID) &&
+                (TSM_Link[index].server == server) &&
+                bacnet_address_same(&TSM_List[index].dest, peer)) {
+                break;
+            }
+            index = TSM_Link[index].next;
+        }
     }
 
     return index;
 }
 
-static uint8_t tsm_find_first_free_index(
-    void)
+/* returns TSM_NO_INDEX if not found */
+static unsigned tsm_find_peer_index(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID)
 {
-    unsigned i = 0;     /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS;       /* return value */
+    if (!invokeID) {
+        return TSM_NO_INDEX;
+    }
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == 0) {
-            index = (uint8_t) i;
-            break;
+    return tsm_find_index(peer, invokeID, false);
+}
+
+/* finds our request that a reply from the peer is for.  A reply may
+   come from an address other than the one we sent to, such as from a
+   device behind a different router port, so it is also accepted if
+   only one peer is using this invoke ID.  returns TSM_NO_INDEX if not
+   found */
+static unsigned tsm_find_reply_index(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    unsigned index = TSM_NO_INDEX;
+
+    index = tsm_find_peer_index(src, invokeID);
+    if ((index == TSM_NO_INDEX) && invokeID) {
+        index = TSM_ID_Head[invokeID];
+        if ((index != TSM_NO_INDEX) &&
+            (TSM_Link[index].id_next != TSM_NO_INDEX)) {
+            index = TSM_NO_INDEX;
         }
     }
 
     return index;
 }
 
-bool tsm_transaction_available(
-    void)
+static void tsm_timer_moved(
+    void *context,
+    unsigned index,
+    unsigned position)
 {
-    bool status = false;        /* return value */
-    unsigned i = 0;     /* counter */
+    (void) context;
+    TSM_Link[index].timer_position = position;
+}
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == 0) {
-            /* one is available! */
-            status = true;
-            break;
+/* removes the transaction request timer, if running */
+static void tsm_timer_stop(
+    unsigned index)
+{
+    (void) Min_Heap_Remove(&TSM_Timer_Heap, TSM_Link[index].timer_position);
+}
+
+/* (re)starts the transaction request timer */
+static void tsm_timer_start(
+    unsigned index,
+    uint16_t milliseconds)
+{
+    tsm_timer_stop(index);
+    TSM_List[index].RequestTimer = milliseconds;
+    /* cannot fail, since the heap has room for every entry */
+    (void) Min_Heap_Insert(&TSM_Timer_Heap, index, TSM_Clock + milliseconds);
+}
+
+/* takes an entry from the free list and reserves the invoke ID;
+   returns TSM_NO_INDEX if the table is full */
+static unsigned tsm_reserve(
+    uint8_t invokeID)
+{
+    unsigned index = TSM_NO_INDEX;
+
+    if (TSM_Free_Head == TSM_NO_INDEX) {
+        (void) tsm_grow();
+    }
+    index = TSM_Free_Head;
+    if (index != TSM_NO_INDEX) {
+        TSM_Free_Head = TSM_Link[index].next;
+        TSM_Used_Count++;
+        TSM_List[index].InvokeID = invokeID;
+        TSM_List[index].state = TSM_STATE_IDLE;
+        TSM_List[index].RetryCount = 0;
+        TSM_List[index].RequestTimer = apdu_timeout();
+        TSM_Link[index].bound = false;
+        TSM_Link[index].server = false;
+        TSM_Link[index].peer = TSM_NO_INDEX;
+        TSM_Link[index].id_prev = TSM_NO_INDEX;
+        TSM_Link[index].id_next = TSM_ID_Head[invokeID];
+        if (TSM_ID_Head[invokeID] != TSM_NO_INDEX) {
+            TSM_Link[TSM_ID_Head[invokeID]].id_prev = index;
         }
+        TSM_ID_Head[invokeID] = index;
     }
 
-    return status;
+    return index;
 }
 
-uint8_t tsm_transaction_idle_count(
-    void)
+/* returns TSM_NO_INDEX if the peer has no round trip time entry */
+static unsigned tsm_peer_find(
+    BACNET_ADDRESS * address)
 {
-    uint8_t count = 0;  /* return value */
-    unsigned i = 0;     /* counter */
+    unsigned peer = TSM_NO_INDEX;
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if ((TSM_List[i].InvokeID == 0) &&
-            (TSM_List[i].state == TSM_STATE_IDLE)) {
-            /* one is available! */
-            count++;
+    if (address && TSM_Peer_Hash_Size) {
+        peer =
+            TSM_Peer_Hash[tsm_address_hash(address,
+                0) & (TSM_Peer_Hash_Size - 1)];
+        while (peer != TSM_NO_INDEX) {
+            if (bacnet_address_same(&TSM_Peer[peer].address, address)) {
+                break;
+            }
+            peer = TSM_Peer[peer].next;
+        }
+    }
+
+    return peer;
+}
+
+/* finds or adds the round trip time entry of a peer;
+   returns TSM_NO_INDEX if the peer table is full */
+static unsigned tsm_peer_add(
+    BACNET_ADDRESS * address)
+{
+    unsigned peer = TSM_NO_INDEX;
+    unsigned size = 0;
+    unsigned i = 0;
+    unsigned bucket = 0;
+    struct tsm_peer *peers = NULL;
+    unsigned *hash = NULL;
+
+    peer = tsm_peer_find(address);
+    if (peer != TSM_NO_INDEX) {
+        return peer;
+    }
+    if (TSM_Peer_Count >= TSM_Peer_Size) {
+        if (TSM_Peer_Size >= MAX_TSM_PEERS) {
+            return TSM_NO_INDEX;
+        }
+        size = TSM_Peer_Size ? (TSM_Peer_Size * 2) : 16;
+        if (size > MAX_TSM_PEERS) {
+            size = MAX_TSM_PEERS;
+        }
+        peers = realloc(TSM_Peer, size * sizeof(struct tsm_peer));
+        if (!peers) {
+            return TSM_NO_INDEX;
+        }
+        TSM_Peer = peers;
+        hash = realloc(TSM_Peer_Hash, size * sizeof(unsigned));
+        if (!hash) {
+            return TSM_NO_INDEX;
+        }
+        TSM_Peer_Hash = hash;
+        TSM_Peer_Size = size;
+        /* the peer table size is a power of two up to MAX_TSM_PEERS */
+        TSM_Peer_Hash_Size = 1;
+        while ((TSM_Peer_Hash_Size * 2) <= size) {
+            TSM_Peer_Hash_Size *= 2;
+        }
+        for (i = 0; i < TSM_Peer_Hash_Size; i++) {
+            TSM_Peer_Hash[i] = TSM_NO_INDEX;
+        }
+        for (i = 0; i < TSM_Peer_Count; i++) {
+            bucket =
+                tsm_address_hash(&TSM_Peer[i].address,
+                0) & (TSM_Peer_Hash_Size - 1);
+            TSM_Peer[i].next = TSM_Peer_Hash[bucket];
+            TSM_Peer_Hash[bucket] = i;
+        }
+    }
+    peer = TSM_Peer_Count;
+    TSM_Peer_Count++;
+    memset(&TSM_Peer[peer], 0, sizeof(struct tsm_peer));
+    bacnet_address_copy(&TSM_Peer[peer].address, address);
+    bucket = tsm_address_hash(address, 0) & (TSM_Peer_Hash_Size - 1);
+    TSM_Peer[peer].next = TSM_Peer_Hash[bucket];
+    TSM_Peer_Hash[bucket] = peer;
+
+    return peer;
+}
+
+static uint16_t tsm_timeout_clamp(
+    uint32_t milliseconds)
+{
+    if (milliseconds < TSM_TIMEOUT_MIN) {
+        milliseconds = TSM_TIMEOUT_MIN;
+    } else if (milliseconds > TSM_TIMEOUT_MAX) {
+        milliseconds = TSM_TIMEOUT_MAX;
+    }
+
+    return (uint16_t) milliseconds;
+}
+
+/* the timeout to use for a new request to the peer */
+static uint16_t tsm_peer_rto(
+    unsigned peer)
+{
+    if ((peer != TSM_NO_INDEX) && TSM_Peer[peer].rto) {
+        return TSM_Peer[peer].rto;
+    }
+
+    return apdu_timeout();
+}
+
+/* updates the estimates with a measured round trip time */
+static void tsm_peer_sample(
+    unsigned peer,
+    uint32_t rtt)
+{
+    int32_t error = 0;
+    struct tsm_peer *pPeer = &TSM_Peer[peer];
+
+    if (!pPeer->measured) {
+        pPeer->srtt = rtt << 3;
+        pPeer->rttvar = rtt << 1;
+        pPeer->measured = true;
+    } else {
+        /* srtt += (rtt - srtt) / 8 */
+        error = (int32_t) rtt - (int32_t) (pPeer->srtt >> 3);
+        pPeer->srtt = (uint32_t) ((int32_t) pPeer->srtt + error);
+        /* rttvar += (|rtt - srtt| - rttvar) / 4 */
+        if (error < 0) {
+            error = -error;
+        }
+        pPeer->rttvar =
+            (uint32_t) ((int32_t) pPeer->rttvar + error -
+            (int32_t) (pPeer->rttvar >> 2));
+    }
+    /* rto = srtt + 4 * rttvar */
+    pPeer->rto = tsm_timeout_clamp((pPeer->srtt >> 3) + pPeer->rttvar);
+}
+
+/* measures the round trip of a request answered without a retry, since
+   a reply to a retried request can't be timed (Karn).  A task that calls
+   tsm_timer_milliseconds() less often than TSM_TIMEOUT_MIN would only
+   measure its own period, so no sample is taken then. */
+static void tsm_rtt_sample(
+    unsigned index)
+{
+    if ((TSM_List[index].RetryCount == 0) &&
+        (TSM_Link[index].peer != TSM_NO_INDEX) && TSM_Tick &&
+        (TSM_Tick <= TSM_TIMEOUT_MIN)) {
+        tsm_peer_sample(TSM_Link[index].peer,
+            TSM_Clock - TSM_Link[index].sent_time);
+    }
+}
+
+/* records the peer of a reserved entry */
+static void tsm_bind(
+    unsigned index,
+    BACNET_ADDRESS * peer)
+{
+    bacnet_address_copy(&TSM_List[index].dest, peer);
+    tsm_hash_insert(index);
+    TSM_Link[index].bound = true;
+    TSM_Link[index].peer = tsm_peer_add(peer);
+}
+
+static void tsm_buffer_free(
+    unsigned index)
+{
+    uint8_t size_class = TSM_Link[index].buffer_class;
+
+    if (TSM_List[index].apdu) {
+        if (size_class == TSM_BUFFER_LARGE) {
+            free(TSM_List[index].apdu);
+        } else {
+            memcpy(TSM_List[index].apdu, &TSM_Buffer_Free[size_class],
+                sizeof(uint8_t *));
+            TSM_Buffer_Free[size_class] = TSM_List[index].apdu;
         }
+        TSM_List[index].apdu = NULL;
     }
+    TSM_List[index].apdu_len = 0;
+}
+
+/* keeps a copy of the PDU in a buffer of the smallest size class
+   that fits it; if no memory is available, nothing is kept and
+   the request will not be retried */
+static void tsm_buffer_store(
+    unsigned index,
+    uint8_t * pdu,
+    uint16_t pdu_len)
+{
+    uint8_t size_class = 0;
+    uint8_t *buffer = NULL;
+
+    if (pdu_len > MAX_PDU_SEGMENTED) {
+        pdu_len = MAX_PDU_SEGMENTED;
+    }
+    while ((size_class < TSM_BUFFER_LARGE) &&
+        ((TSM_BUFFER_MIN << size_class) < pdu_len)) {
+        size_class++;
+    }
+    if (TSM_List[index].apdu && ((TSM_Link[index].buffer_class != size_class)
+            || (size_class == TSM_BUFFER_LARGE))) {
+        tsm_buffer_free(index);
+    }
+    buffer = TSM_List[index].apdu;
+    if (!buffer) {
+        if (size_class == TSM_BUFFER_LARGE) {
+            buffer = malloc(pdu_len);
+        } else if (TSM_Buffer_Free[size_class]) {
+            buffer = TSM_Buffer_Free[size_class];
+            memcpy(&TSM_Buffer_Free[size_class], buffer, sizeof(uint8_t *));
+        } else {
+            buffer = malloc(TSM_BUFFER_MIN << size_class);
+        }
+        TSM_List[index].apdu = buffer;
+        TSM_Link[index].buffer_class = size_class;
+    }
+    if (buffer) {
+        memcpy(buffer, pdu, pdu_len);
+        TSM_List[index].apdu_len = pdu_len;
+    } else {
+        TSM_List[index].apdu_len = 0;
+    }
+}
+
+/* removes the entry from the chain of entries using its invoke ID */
+static void tsm_id_unlink(
+    unsigned index)
+{
+    uint8_t invokeID = TSM_List[index].InvokeID;
+
+    if (TSM_Link[index].id_prev != TSM_NO_INDEX) {
+        TSM_Link[TSM_Link[index].id_prev].id_next = TSM_Link[index].id_next;
+    } else {
+        TSM_ID_Head[invokeID] = TSM_Link[index].id_next;
+    }
+    if (TSM_Link[index].id_next != TSM_NO_INDEX) {
+        TSM_Link[TSM_Link[index].id_next].id_prev = TSM_Link[index].id_prev;
+    }
+    TSM_Link[index].id_prev = TSM_NO_INDEX;
+    TSM_Link[index].id_next = TSM_NO_INDEX;
+}
+
+/* returns the entry to the free list and frees its invoke ID */
+static void tsm_release(
+    unsigned index)
+{
+    tsm_timer_stop(index);
+    tsm_buffer_free(index);
+    if (TSM_Link[index].bound) {
+        tsm_hash_remove(index);
+    }
+    /* a response uses the invoke ID of the peer, not one of ours */
+    if (!TSM_Link[index].server) {
+        tsm_id_unlink(index);
+    }
+    TSM_List[index].state = TSM_STATE_IDLE;
+    TSM_List[index].InvokeID = 0;
+    TSM_Link[index].bound = false;
+    TSM_Link[index].server = false;
+    TSM_Link[index].next = TSM_Free_Head;
+    TSM_Free_Head = index;
+    TSM_Used_Count--;
+}
+
+bool tsm_transaction_available(
+    void)
+{
+    return (TSM_Used_Count < MAX_TSM_TRANSACTIONS_DYNAMIC);
+}
 
-    return count;
+/* number of transactions that could still be started */
+unsigned tsm_transaction_idle_count(
+    void)
+{
+    return (MAX_TSM_TRANSACTIONS_DYNAMIC - TSM_Used_Count);
 }
 
 /* sets the invokeID */
@@ -150,45 +769,31 @@ void tsm_invokeID_set(
     Current_Invoke_ID = invokeID;
 }
 
-/* gets the next free invokeID,
-   and reserves a spot in the table
-   returns 0 if none are available */
-uint8_t tsm_next_free_invokeID(
-    void)
+/** Gets the next invoke ID that is free for the given peer,
+ *  and reserves a spot in the table for the transaction.
+ * @param dest [in] The device address the request will be sent to.
+ * @return invoke ID, or 0 if none are available for this peer.
+ */
+uint8_t tsm_next_free_peer_invokeID(
+    BACNET_ADDRESS * dest)
 {
-    uint8_t index = 0;
+    unsigned index = 0;
+    unsigned tries = 0;
     uint8_t invokeID = 0;
-    bool found = false;
 
-    /* is there even space available? */
-    if (tsm_transaction_available()) {
-        while (!found) {
-            index = tsm_find_invokeID_index(Current_Invoke_ID);
-            if (index == MAX_TSM_TRANSACTIONS) {
-                /* Not found, so this invokeID is not used */
-                found = true;
-                /* set this id into the table */
-                index = tsm_find_first_free_index();
-                if (index != MAX_TSM_TRANSACTIONS) {
-                    TSM_List[index].InvokeID = invokeID = Current_Invoke_ID;
-                    TSM_List[index].state = TSM_STATE_IDLE;
-                    TSM_List[index].RequestTimer = apdu_timeout();
-                    /* update for the next call or check */
-                    Current_Invoke_ID++;
-                    /* skip zero - we treat that internally as invalid or no free */
-                    if (Current_Invoke_ID == 0) {
-                        Current_Invoke_ID = 1;
-                    }
-                }
-            } else {
-                /* found! This invokeID is already used */
-                /* try next one */
-                Current_Invoke_ID++;
-                /* skip zero - we treat that internally as invalid or no free */
-                if (Current_Invoke_ID == 0) {
-                    Current_Invoke_ID = 1;
+    tsm_init();
+    if (dest && tsm_transaction_available()) {
+        for (tries = 0; tries < 255; tries++) {
+            if (tsm_find_peer_index(dest, Current_Invoke_ID) == TSM_NO_INDEX) {
+                index = tsm_reserve(Current_Invoke_ID);
+                if (index != TSM_NO_INDEX) {
+                    invokeID = Current_Invoke_ID;
+                    tsm_bind(index, dest);
+                    tsm_invoke_id_next();
                 }
+                break;
             }
+            tsm_invoke_id_next();
         }
     }
 
@@ -202,22 +807,20 @@ void tsm_set_confirmed_unsegmented_transaction(
     uint8_t * apdu,
     uint16_t apdu_len)
 {
-    uint16_t j = 0;
-    uint8_t index;
+    unsigned index;
 
-    if (invokeID) {
-        index = tsm_find_invokeID_index(invokeID);
-        if (index < MAX_TSM_TRANSACTIONS) {
+    if (invokeID && dest) {
+        tsm_init();
+        index = tsm_find_peer_index(dest, invokeID);
+        if (index != TSM_NO_INDEX) {
             /* SendConfirmedUnsegmented */
             TSM_List[index].state = TSM_STATE_AWAIT_CONFIRMATION;
             TSM_List[index].RetryCount = 0;
             /* start the timer */
-            TSM_List[index].RequestTimer = apdu_timeout();
+            tsm_timer_start(index, tsm_peer_rto(TSM_Link[index].peer));
+            TSM_Link[index].sent_time = TSM_Clock;
             /* copy the data */
-            for (j = 0; j < apdu_len; j++) {
-                TSM_List[index].apdu[j] = apdu[j];
-            }
-            TSM_List[index].apdu_len = apdu_len;
+            tsm_buffer_store(index, apdu, apdu_len);
             npdu_copy_data(&TSM_List[index].npdu_data, ndpu_data);
             bacnet_address_copy(&TSM_List[index].dest, dest);
         }
@@ -226,32 +829,37 @@ void tsm_set_confirmed_unsegmented_transaction(
     return;
 }
 
-/* used to retrieve the transaction payload */
-/* if we wanted to find out what we sent (i.e. when we get an ack) */
-bool tsm_get_transaction_pdu(
+/** Gets a copy of the request that a reply from the peer is for, such
+ *  as to find out what we sent when the ack comes back.
+ * @param src [in] The address of the peer device.
+ * @param invokeID [in] The invokeID of the transaction.
+ * @param ndpu_data [out] The NPDU data of the request.
+ * @param apdu [out] The APDU of the request, MAX_PDU bytes.
+ * @param apdu_len [out] The length of the APDU.
+ * @return True if the transaction was found.
+ */
+bool tsm_get_peer_transaction_pdu(
+    BACNET_ADDRESS * src,
     uint8_t invokeID,
-    BACNET_ADDRESS * dest,
     BACNET_NPDU_DATA * ndpu_data,
     uint8_t * apdu,
     uint16_t * apdu_len)
 {
-    uint16_t j = 0;
-    uint8_t index;
+    unsigned index;
     bool found = false;
 
     if (invokeID) {
-        index = tsm_find_invokeID_index(invokeID);
-        /* how much checking is needed?  state?  dest match? just invokeID? */
-        if (index < MAX_TSM_TRANSACTIONS) {
+        tsm_init();
+        index = tsm_find_reply_index(src, invokeID);
+        if (index != TSM_NO_INDEX) {
             /* FIXME: we may want to free the transaction so it doesn't timeout */
             /* retrieve the transaction */
             /* FIXME: bounds check the pdu_len? */
             *apdu_len = (uint16_t) TSM_List[index].apdu_len;
-            for (j = 0; j < *apdu_len; j++) {
-                apdu[j] = TSM_List[index].apdu[j];
+            if (*apdu_len) {
+                memcpy(apdu, TSM_List[index].apdu, *apdu_len);
             }
             npdu_copy_data(ndpu_data, &TSM_List[index].npdu_data);
-            bacnet_address_copy(dest, &TSM_List[index].dest);
             found = true;
         }
     }
@@ -259,88 +867,680 @@ bool tsm_get_transaction_pdu(
     return found;
 }
 
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+/* sends one segment of a segmented response */
+static int tsm_segment_send(
+    unsigned index,
+    unsigned segment)
+{
+    uint8_t pdu[MAX_PDU] = { 0 };
+    BACNET_TSM_DATA *pTSM = &TSM_List[index];
+    unsigned npdu_len = TSM_Link[index].npdu_len;
+    unsigned data_size = TSM_Link[index].segment_size - 5;
+    unsigned offset = 0;
+    unsigned len = 0;
+
+    /* the service data follows the 3 octet ComplexACK header */
+    offset = npdu_len + 3 + (segment * data_size);
+    len = pTSM->apdu_len - offset;
+    if (len > data_size) {
+        len = data_size;
+    }
+    memcpy(&pdu[0], &pTSM->apdu[0], npdu_len);
+    pdu[npdu_len] = PDU_TYPE_COMPLEX_ACK | BIT(3);
+    if ((segment + 1) < TSM_Link[index].segment_count) {
+        /* more follows */
+        pdu[npdu_len] |= BIT(2);
+    }
+    pdu[npdu_len + 1] = pTSM->InvokeID;
+    pdu[npdu_len + 2] = (uint8_t) segment;
+    pdu[npdu_len + 3] = pTSM->ProposedWindowSize;
+    pdu[npdu_len + 4] = pTSM->apdu[npdu_len + 2];
+    memcpy(&pdu[npdu_len + 5], &pTSM->apdu[offset], len);
+
+    return datalink_send_pdu(&pTSM->dest, &pTSM->npdu_data, &pdu[0],
+        npdu_len + 5 + len);
+}
+
+/* FillWindow: sends the window of segments that starts with
+   the first segment not yet acknowledged */
+static int tsm_segment_window_send(
+    unsigned index)
+{
+    unsigned segment = 0;
+    unsigned last = 0;
+    int bytes_sent = 0;
+
+    last = TSM_Link[index].segment_first + TSM_List[index].ActualWindowSize;
+    if (last > TSM_Link[index].segment_count) {
+        last = TSM_Link[index].segment_count;
+    }
+    for (segment = TSM_Link[index].segment_first; segment < last; segment++) {
+        bytes_sent = tsm_segment_send(index, segment);
+    }
+
+    return bytes_sent;
+}
+#endif
+
+/* note: the invoke id has not been cleared yet
+   and this indicates a failed message:
+   IDLE and a valid invoke id */
+static void tsm_failed(
+    unsigned index)
+{
+    tsm_timer_stop(index);
+    TSM_List[index].RequestTimer = 0;
+    TSM_List[index].state = TSM_STATE_IDLE;
+    if (TSM_List[index].InvokeID != 0) {
+        if (Timeout_Function) {
+            Timeout_Function(&TSM_List[index].dest,
+                TSM_List[index].InvokeID);
+        }
+    }
+}
+
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+/* sends a SegmentACK or an Abort, as the client, to the peer */
+static void tsm_client_send(
+    unsigned index,
+    uint8_t * apdu,
+    unsigned apdu_len)
+{
+    uint8_t pdu[MAX_NPDU + 4] = { 0 };
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    int len = 0;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    len =
+        npdu_encode_pdu(&pdu[0], &TSM_List[index].dest, &my_address,
+        &npdu_data);
+    memcpy(&pdu[len], apdu, apdu_len);
+    (void) datalink_send_pdu(&TSM_List[index].dest, &npdu_data, &pdu[0],
+        len + apdu_len);
+}
+
+/* acknowledges the segments received in order, or asks for
+   the ones after them if nak is true */
+static void tsm_segment_ack_send(
+    unsigned index,
+    bool nak)
+{
+    uint8_t apdu[4] = { 0 };
+
+    apdu[0] = PDU_TYPE_SEGMENT_ACK;
+    if (nak) {
+        apdu[0] |= BIT(1);
+    }
+    apdu[1] = TSM_List[index].InvokeID;
+    apdu[2] = TSM_List[index].LastSequenceNumber;
+    apdu[3] = TSM_List[index].ActualWindowSize;
+    tsm_client_send(index, &apdu[0], sizeof(apdu));
+}
+
+/* aborts the reply to our request, which then fails */
+static void tsm_segment_abort(
+    unsigned index,
+    uint8_t abort_reason)
+{
+    uint8_t apdu[3] = { 0 };
+    int len = 0;
+
+    len =
+        abort_encode_apdu(&apdu[0], TSM_List[index].InvokeID, abort_reason,
+        false);
+    tsm_client_send(index, &apdu[0], (unsigned) len);
+    tsm_buffer_free(index);
+    tsm_failed(index);
+}
+
+/* appends the data of a segment to the reassembly buffer, which
+   doubles as needed up to MAX_APDU_REASSEMBLED octets;
+   returns false if it does not fit */
+static bool tsm_segment_append(
+    unsigned index,
+    uint8_t * data,
+    uint16_t data_len)
+{
+    BACNET_TSM_DATA *pTSM = &TSM_List[index];
+    unsigned len = pTSM->apdu_len + data_len;
+    unsigned size = TSM_Link[index].reassembly_size;
+    uint8_t *buffer = NULL;
+
+    if (len > MAX_APDU_REASSEMBLED) {
+        return false;
+    }
+    if (len > size) {
+        if (!size) {
+            size = MAX_APDU;
+        }
+        while (size < len) {
+            size *= 2;
+        }
+        if (size > MAX_APDU_REASSEMBLED) {
+            size = MAX_APDU_REASSEMBLED;
+        }
+        buffer = realloc(pTSM->apdu, size);
+        if (!buffer) {
+            return false;
+        }
+        pTSM->apdu = buffer;
+        TSM_Link[index].reassembly_size = size;
+    }
+    memcpy(&pTSM->apdu[pTSM->apdu_len], data, data_len);
+    pTSM->apdu_len = len;
+
+    return true;
+}
+
+/* the SegmentTimer of the receiver runs for four times Tseg */
+static uint16_t tsm_segment_receive_timeout(
+    void)
+{
+    uint32_t timeout = (uint32_t) apdu_segment_timeout() * 4;
+
+    if (timeout > UINT16_MAX) {
+        timeout = UINT16_MAX;
+    }
+
+    return (uint16_t) timeout;
+}
+#endif
+
 /* called once a millisecond or slower */
 void tsm_timer_milliseconds(
     uint16_t milliseconds)
 {
-    unsigned i = 0;     /* counter */
-
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].state == TSM_STATE_AWAIT_CONFIRMATION) {
-            if (TSM_List[i].RequestTimer > milliseconds)
-                TSM_List[i].RequestTimer -= milliseconds;
-            else
-                TSM_List[i].RequestTimer = 0;
-            /* AWAIT_CONFIRMATION */
-            if (TSM_List[i].RequestTimer == 0) {
-                if (TSM_List[i].RetryCount < apdu_retries()) {
-                    TSM_List[i].RequestTimer = apdu_timeout();
-                    TSM_List[i].RetryCount++;
-                    datalink_send_pdu(&TSM_List[i].dest,
-                        &TSM_List[i].npdu_data, &TSM_List[i].apdu[0],
-                        TSM_List[i].apdu_len);
-                } else {
-                    /* note: the invoke id has not been cleared yet
-                       and this indicates a failed message:
-                       IDLE and a valid invoke id */
-                    TSM_List[i].state = TSM_STATE_IDLE;
-                    if (TSM_List[i].InvokeID != 0) {
-                        if (Timeout_Function) {
-                            Timeout_Function(TSM_List[i].InvokeID);
-                        }
-                    }
-                }
+    unsigned index = 0;
+    uint32_t deadline = 0;
+    unsigned peer = 0;
+    uint16_t timeout = 0;
+
+    TSM_Clock += milliseconds;
+    if (milliseconds) {
+        TSM_Tick = milliseconds;
+    }
+    /* only the expired timers at the top of the heap are visited */
+    while (Min_Heap_Peek(&TSM_Timer_Heap, &index, &deadline)) {
+        if ((int32_t) (TSM_Clock - deadline) < 0) {
+            break;
+        }
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+        if (TSM_List[index].state == TSM_STATE_SEGMENTED_RESPONSE) {
+            if (TSM_List[index].SegmentRetryCount < apdu_retries()) {
+                /* Timeout - send the window again */
+                TSM_List[index].SegmentRetryCount++;
+                tsm_timer_start(index, apdu_segment_timeout());
+                (void) tsm_segment_window_send(index);
+            } else {
+                /* FinalTimeout */
+                tsm_release(index);
             }
+            continue;
+        }
+#endif
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+        if (TSM_List[index].state == TSM_STATE_SEGMENTED_CONFIRMATION) {
+            /* TimeoutSegmented - the reply is incomplete */
+            tsm_buffer_free(index);
+            tsm_failed(index);
+            continue;
         }
+#endif
+        /* AWAIT_CONFIRMATION */
+        if (TSM_List[index].RetryCount < apdu_retries()) {
+            /* wait at least the APDU timeout, and keep the longer
+               timeout for the peer until a new round trip time is
+               measured */
+            peer = TSM_Link[index].peer;
+#if TSM_RETRY_BACKOFF
+            timeout =
+                tsm_timeout_clamp((uint32_t) TSM_List[index].RequestTimer *
+                2);
+#else
+            timeout = TSM_List[index].RequestTimer;
+            if (timeout < apdu_timeout()) {
+                timeout = apdu_timeout();
+            }
+#endif
+            if ((peer != TSM_NO_INDEX) && (TSM_Peer[peer].rto < timeout)) {
+                TSM_Peer[peer].rto = timeout;
+            }
+            tsm_timer_start(index, timeout);
+            TSM_Link[index].sent_time = TSM_Clock;
+            TSM_List[index].RetryCount++;
+            if (TSM_List[index].apdu_len) {
+                datalink_send_pdu(&TSM_List[index].dest,
+                    &TSM_List[index].npdu_data, &TSM_List[index].apdu[0],
+                    TSM_List[index].apdu_len);
+            }
+        } else {
+            tsm_failed(index);
+        }
+    }
+}
+
+/** Gets the time until the next transaction timer expires, so that a
+ *  task which sleeps knows when to call tsm_timer_milliseconds().
+ *
+ * @param milliseconds [out] time until the timer expires, counted from
+ *  the last tsm_timer_milliseconds() call, or zero if it is overdue
+ * @return true if a transaction timer is running
+ */
+bool tsm_timer_next(
+    uint32_t * milliseconds)
+{
+    int32_t remaining = 0;
+    uint32_t deadline = 0;
+
+    if (!Min_Heap_Peek(&TSM_Timer_Heap, NULL, &deadline)) {
+        return false;
     }
+    remaining = (int32_t) (deadline - TSM_Clock);
+    *milliseconds = (remaining > 0) ? (uint32_t) remaining : 0;
+
+    return true;
 }
 
-/* frees the invokeID and sets its state to IDLE */
-void tsm_free_invoke_id(
+/** Frees the transaction with this peer and invoke ID, such as
+ *  when the reply comes back, and sets its state to IDLE.
+ * @param src [in] The address of the peer device.
+ * @param invokeID [in] The invokeID of the transaction.
+ */
+void tsm_free_peer_invoke_id(
+    BACNET_ADDRESS * src,
     uint8_t invokeID)
 {
-    uint8_t index;
+    unsigned index;
 
-    index = tsm_find_invokeID_index(invokeID);
-    if (index < MAX_TSM_TRANSACTIONS) {
-        TSM_List[index].state = TSM_STATE_IDLE;
-        TSM_List[index].InvokeID = 0;
+    if (!invokeID) {
+        return;
+    }
+    tsm_init();
+    index = tsm_find_reply_index(src, invokeID);
+    if (index != TSM_NO_INDEX) {
+        if (TSM_List[index].state == TSM_STATE_AWAIT_CONFIRMATION) {
+            tsm_rtt_sample(index);
+        }
+        tsm_release(index);
     }
 }
 
-/** Check if the invoke ID has been made free by the Transaction State Machine.
- * @param invokeID [in] The invokeID to be checked, normally of last message sent.
- * @return True if it is free (done with), False if still pending in the TSM.
+/** Gets the round trip time estimates for a peer.
+ * @param dest [in] The address of the peer device.
+ * @param srtt [out] Smoothed round trip time in milliseconds, or NULL.
+ * @param rttvar [out] Round trip time mean deviation in milliseconds,
+ *  or NULL.
+ * @return True if a round trip time has been measured for this peer.
+ */
+bool tsm_peer_rtt(
+    BACNET_ADDRESS * dest,
+    uint32_t * srtt,
+    uint32_t * rttvar)
+{
+    unsigned peer = tsm_peer_find(dest);
+
+    if ((peer == TSM_NO_INDEX) || (!TSM_Peer[peer].measured)) {
+        return false;
+    }
+    if (srtt) {
+        *srtt = TSM_Peer[peer].srtt >> 3;
+    }
+    if (rttvar) {
+        *rttvar = TSM_Peer[peer].rttvar >> 2;
+    }
+
+    return true;
+}
+
+/** Gets the timeout that will be used for the next request to a peer.
+ * @param dest [in] The address of the peer device.
+ * @return timeout in milliseconds; apdu_timeout() for an unknown peer.
+ */
+uint16_t tsm_peer_timeout(
+    BACNET_ADDRESS * dest)
+{
+    return tsm_peer_rto(tsm_peer_find(dest));
+}
+
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+/* the largest ComplexACK for the request, without the lock */
+static unsigned tsm_complex_ack_limit(
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    unsigned max_apdu = MAX_APDU;
+    unsigned segments = MAX_SEGMENTS_TRANSMIT;
+    unsigned max_len = 0;
+
+    if ((unsigned) service_data->max_resp < max_apdu) {
+        max_apdu = service_data->max_resp;
+    }
+    /* zero is unspecified, and any number of segments may be sent */
+    if (service_data->max_segs &&
+        ((unsigned) service_data->max_segs < segments)) {
+        segments = service_data->max_segs;
+    }
+    if ((!service_data->segmented_response_accepted) || (segments < 2) ||
+        (max_apdu <= 5) || (!tsm_transaction_available())) {
+        return max_apdu;
+    }
+    /* each segment has two more header octets than the ComplexACK */
+    max_len = 3 + (segments * (max_apdu - 5));
+    if (max_len > MAX_APDU_SEGMENTED) {
+        max_len = MAX_APDU_SEGMENTED;
+    }
+
+    return max_len;
+}
+
+/** Gets the largest ComplexACK that can be sent in response to
+ *  a confirmed request, segmented if the client accepts it.
+ * @param service_data [in] The header of the confirmed request.
+ * @return length of the unsegmented ComplexACK APDU, in octets.
+ */
+unsigned tsm_complex_ack_max(
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    unsigned max_len = 0;
+
+    if (TSM_Lock) {
+        TSM_Lock();
+    }
+    max_len = tsm_complex_ack_limit(service_data);
+    if (TSM_Unlock) {
+        TSM_Unlock();
+    }
+
+    return max_len;
+}
+
+/* starts a segmented response and sends its first segment */
+static int tsm_segmented_response_start(
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * npdu_data,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data,
+    uint8_t * pdu,
+    unsigned npdu_len,
+    unsigned apdu_len,
+    unsigned max_apdu)
+{
+    unsigned index = 0;
+    unsigned data_size = 0;
+
+    if ((apdu_len > tsm_complex_ack_limit(service_data)) ||
+        (npdu_len > MAX_NPDU)) {
+        return -1;
+    }
+    tsm_init();
+    /* the request was sent again before the response was done */
+    index = tsm_find_index(dest, service_data->invoke_id, true);
+    if (index != TSM_NO_INDEX) {
+        tsm_release(index);
+    }
+    index = tsm_reserve(service_data->invoke_id);
+    if (index == TSM_NO_INDEX) {
+        return -1;
+    }
+    tsm_id_unlink(index);
+    TSM_Link[index].server = true;
+    bacnet_address_copy(&TSM_List[index].dest, dest);
+    tsm_hash_insert(index);
+    TSM_Link[index].bound = true;
+    tsm_buffer_store(index, pdu, (uint16_t) (npdu_len + apdu_len));
+    if (TSM_List[index].apdu_len == 0) {
+        tsm_release(index);
+        return -1;
+    }
+    npdu_copy_data(&TSM_List[index].npdu_data, npdu_data);
+    data_size = max_apdu - 5;
+    TSM_Link[index].npdu_len = (uint8_t) npdu_len;
+    TSM_Link[index].segment_size = (uint16_t) max_apdu;
+    TSM_Link[index].segment_count = (apdu_len - 3 + data_size - 1) / data_size;
+    TSM_Link[index].segment_first = 0;
+    TSM_List[index].state = TSM_STATE_SEGMENTED_RESPONSE;
+    TSM_List[index].SegmentRetryCount = 0;
+    TSM_List[index].ProposedWindowSize = MAX_SEGMENT_WINDOW;
+    /* the first segment is sent alone, and the SegmentACK
+       tells us the window size of the client */
+    TSM_List[index].ActualWindowSize = 1;
+    tsm_timer_start(index, apdu_segment_timeout());
+
+    return tsm_segment_window_send(index);
+}
+
+/** Sends a ComplexACK in response to a confirmed request.  If it does
+ *  not fit in one APDU, it is sent as a segmented response, a window
+ *  at a time as SegmentACKs are received (Clause 5.4.5).
+ * @param dest [in] The address of the client.
+ * @param npdu_data [in] The network layer info of the response.
+ * @param service_data [in] The header of the confirmed request.
+ * @param pdu [in] The encoded NPDU followed by the ComplexACK APDU,
+ *  which should be no longer than tsm_complex_ack_max().
+ * @param npdu_len [in] The length of the NPDU header.
+ * @param apdu_len [in] The length of the unsegmented ComplexACK APDU.
+ * @return bytes sent of the response or its first segment,
+ *  or -1 on failure.
  */
-bool tsm_invoke_id_free(
+int tsm_send_complex_ack(
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * npdu_data,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data,
+    uint8_t * pdu,
+    unsigned npdu_len,
+    unsigned apdu_len)
+{
+    unsigned max_apdu = MAX_APDU;
+    int bytes_sent = 0;
+
+    if ((unsigned) service_data->max_resp < max_apdu) {
+        max_apdu = service_data->max_resp;
+    }
+    if (apdu_len <= max_apdu) {
+        return datalink_send_pdu(dest, npdu_data, pdu, npdu_len + apdu_len);
+    }
+    if (TSM_Lock) {
+        TSM_Lock();
+    }
+    bytes_sent =
+        tsm_segmented_response_start(dest, npdu_data, service_data, pdu,
+        npdu_len, apdu_len, max_apdu);
+    if (TSM_Unlock) {
+        TSM_Unlock();
+    }
+
+    return bytes_sent;
+}
+
+/** Handles a SegmentACK from a client for a segmented response.
+ * @param src [in] The address of the client.
+ * @param invokeID [in] The invoke ID of the request of the client.
+ * @param sequence_number [in] The last segment received in order.
+ * @param actual_window_size [in] The window size of the client.
+ */
+void tsm_segment_ack_received(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID,
+    uint8_t sequence_number,
+    uint8_t actual_window_size)
+{
+    unsigned index = 0;
+    uint8_t offset = 0;
+
+    tsm_init();
+    index = tsm_find_index(src, invokeID, true);
+    if ((index == TSM_NO_INDEX) ||
+        (TSM_List[index].state != TSM_STATE_SEGMENTED_RESPONSE)) {
+        return;
+    }
+    offset =
+        (uint8_t) (sequence_number -
+        (uint8_t) TSM_Link[index].segment_first);
+    if (offset >= TSM_List[index].ActualWindowSize) {
+        /* DuplicateACK_Received */
+        tsm_timer_start(index, apdu_segment_timeout());
+        return;
+    }
+    TSM_Link[index].segment_first += offset + 1;
+    if (TSM_Link[index].segment_first >= TSM_Link[index].segment_count) {
+        /* FinalACK_Received */
+        tsm_release(index);
+        return;
+    }
+    /* NewACK_Received */
+    if (actual_window_size < 1) {
+        actual_window_size = 1;
+    } else if (actual_window_size > TSM_List[index].ProposedWindowSize) {
+        actual_window_size = TSM_List[index].ProposedWindowSize;
+    }
+    TSM_List[index].ActualWindowSize = actual_window_size;
+    TSM_List[index].SegmentRetryCount = 0;
+    tsm_timer_start(index, apdu_segment_timeout());
+    (void) tsm_segment_window_send(index);
+}
+
+/** Frees a segmented response to the client, such as when the
+ *  client aborts the transaction.
+ * @param src [in] The address of the client.
+ * @param invokeID [in] The invoke ID of the request of the client.
+ */
+void tsm_free_peer_response(
+    BACNET_ADDRESS * src,
     uint8_t invokeID)
 {
-    bool status = true;
-    uint8_t index;
+    unsigned index = 0;
 
-    index = tsm_find_invokeID_index(invokeID);
-    if (index < MAX_TSM_TRANSACTIONS)
-        status = false;
+    tsm_init();
+    index = tsm_find_index(src, invokeID, true);
+    if (index != TSM_NO_INDEX) {
+        tsm_release(index);
+    }
+}
+#endif
 
-    return status;
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+/** Reassembles a segmented ComplexACK to one of our requests,
+ *  acknowledging its segments a window at a time (Clause 5.4.4).
+ * @param src [in] The address of the server.
+ * @param service_data [in,out] The header of the segment; once the
+ *  ComplexACK is complete, it is changed to that of an unsegmented one.
+ * @param service_request [in] The service data of the segment.
+ * @param service_request_len [in,out] The length of the service data
+ *  of the segment, and then of the whole ComplexACK.
+ * @return the service data of the whole ComplexACK once the last
+ *  segment is received, or NULL.  It is kept until the transaction
+ *  is freed with tsm_free_peer_invoke_id().
+ */
+uint8_t *tsm_segmented_ack_received(
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data,
+    uint8_t * service_request,
+    uint16_t * service_request_len)
+{
+    unsigned index = 0;
+    BACNET_TSM_DATA *pTSM = NULL;
+    uint8_t sequence_number = service_data->sequence_number;
+
+    tsm_init();
+    index = tsm_find_peer_index(src, service_data->invoke_id);
+    if (index == TSM_NO_INDEX) {
+        return NULL;
+    }
+    pTSM = &TSM_List[index];
+    if (pTSM->state == TSM_STATE_AWAIT_CONFIRMATION) {
+        if (sequence_number != 0) {
+            /* UnexpectedPDU_Received */
+            tsm_segment_abort(index, ABORT_REASON_INVALID_APDU_IN_THIS_STATE);
+            return NULL;
+        }
+        /* SegmentedComplexACK_Received - the request is not
+           sent again, so its copy makes way for the reply */
+        tsm_rtt_sample(index);
+        tsm_buffer_free(index);
+        TSM_Link[index].buffer_class = TSM_BUFFER_LARGE;
+        TSM_Link[index].reassembly_size = 0;
+        pTSM->state = TSM_STATE_SEGMENTED_CONFIRMATION;
+        pTSM->ProposedWindowSize = service_data->proposed_window_number;
+        pTSM->ActualWindowSize = pTSM->ProposedWindowSize;
+        if (pTSM->ActualWindowSize < 1) {
+            pTSM->ActualWindowSize = 1;
+        } else if (pTSM->ActualWindowSize > MAX_SEGMENT_WINDOW) {
+            pTSM->ActualWindowSize = MAX_SEGMENT_WINDOW;
+        }
+        pTSM->InitialSequenceNumber = 0;
+    } else if (pTSM->state == TSM_STATE_SEGMENTED_CONFIRMATION) {
+        if (sequence_number != (uint8_t) (pTSM->LastSequenceNumber + 1)) {
+            /* SegmentReceivedOutOfOrder, or a duplicate */
+            pTSM->InitialSequenceNumber = pTSM->LastSequenceNumber;
+            tsm_segment_ack_send(index, true);
+            tsm_timer_start(index, tsm_segment_receive_timeout());
+            return NULL;
+        }
+    } else {
+        return NULL;
+    }
+    if (!tsm_segment_append(index, service_request, *service_request_len)) {
+        tsm_segment_abort(index, ABORT_REASON_BUFFER_OVERFLOW);
+        return NULL;
+    }
+    pTSM->LastSequenceNumber = sequence_number;
+    if (service_data->more_follows) {
+        if ((sequence_number == 0) ||
+            (sequence_number ==
+                (uint8_t) (pTSM->InitialSequenceNumber +
+                    pTSM->ActualWindowSize))) {
+            /* LastSegmentOfGroupReceived */
+            pTSM->InitialSequenceNumber = sequence_number;
+            tsm_segment_ack_send(index, false);
+        }
+        tsm_timer_start(index, tsm_segment_receive_timeout());
+        return NULL;
+    }
+    /* LastSegmentOfComplexACK_Received */
+    tsm_segment_ack_send(index, false);
+    tsm_timer_stop(index);
+    service_data->segmented_message = false;
+    service_data->more_follows = false;
+    service_data->sequence_number = 0;
+    *service_request_len = (uint16_t) pTSM->apdu_len;
+
+    return pTSM->apdu;
+}
+#endif
+
+/** Check if the invoke ID used with this peer has been made free
+ *  by the Transaction State Machine.
+ * @param dest [in] The address of the peer device.
+ * @param invokeID [in] The invokeID to be checked.
+ * @return True if it is free (done with), False if still pending in the TSM.
+ */
+bool tsm_peer_invoke_id_free(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID)
+{
+    tsm_init();
+
+    return (tsm_find_peer_index(dest, invokeID) == TSM_NO_INDEX);
 }
 
-/** See if we failed get a confirmation for the message associated
- *  with this invoke ID.
- * @param invokeID [in] The invokeID to be checked, normally of last message sent.
+/** See if we failed get a confirmation for the message sent to this
+ *  peer with this invoke ID.
+ * @param dest [in] The address of the peer device.
+ * @param invokeID [in] The invokeID to be checked.
  * @return True if already failed, False if done or segmented or still waiting
  *         for a confirmation.
  */
-bool tsm_invoke_id_failed(
+bool tsm_peer_invoke_id_failed(
+    BACNET_ADDRESS * dest,
     uint8_t invokeID)
 {
     bool status = false;
-    uint8_t index;
+    unsigned index;
 
-    index = tsm_find_invokeID_index(invokeID);
-    if (index < MAX_TSM_TRANSACTIONS) {
-        /* a valid invoke ID and the state is IDLE is a
-           message that failed to confirm */
+    tsm_init();
+    index = tsm_find_peer_index(dest, invokeID);
+    if (index != TSM_NO_INDEX) {
         if (TSM_List[index].state == TSM_STATE_IDLE)
             status = true;
     }
@@ -357,6 +1557,13 @@ bool tsm_invoke_id_failed(
 /* flag to send an I-Am */
 bool I_Am_Request = true;
 
+static unsigned Sent_Count;
+static unsigned Sent_Len;
+static uint8_t Sent_PDU[MAX_PDU];
+static unsigned Timeout_Count;
+static uint8_t Timeout_Invoke_ID;
+static BACNET_ADDRESS Timeout_Dest;
+
 /* dummy function stubs */
 int datalink_send_pdu(
     BACNET_ADDRESS * dest,
@@ -366,8 +1573,12 @@ int datalink_send_pdu(
 {
     (void) dest;
     (void) npdu_data;
-    (void) pdu;
     (void) pdu_len;
+    Sent_Count++;
+    Sent_Len = pdu_len;
+    if (pdu_len <= sizeof(Sent_PDU)) {
+        memcpy(Sent_PDU, pdu, pdu_len);
+    }
 
     return 0;
 }
@@ -379,13 +1590,628 @@ void datalink_get_broadcast_address(
     (void) dest;
 }
 
+void datalink_get_my_address(
+    BACNET_ADDRESS * my_address)
+{
+    memset(my_address, 0, sizeof(BACNET_ADDRESS));
+}
+
+uint16_t apdu_timeout(
+    void)
+{
+    return 3000;
+}
+
+uint8_t apdu_retries(
+    void)
+{
+    return 3;
+}
+
+uint16_t apdu_segment_timeout(
+    void)
+{
+    return 2000;
+}
+
+/* the retries take 3 seconds each, or with TSM_RETRY_BACKOFF,
+   6, 12 and then 24 seconds */
+#if TSM_RETRY_BACKOFF
+#define TEST_BACKOFF_TIME (3000 * 11)
+#else
+#define TEST_BACKOFF_TIME 0
+#endif
+
+static void testTimeoutHandler(
+    BACNET_ADDRESS * dest,
+    uint8_t invoke_id)
+{
+    Timeout_Count++;
+    Timeout_Invoke_ID = invoke_id;
+    bacnet_address_copy(&Timeout_Dest, dest);
+}
+
+static void testPeerAddress(
+    BACNET_ADDRESS * dest,
+    unsigned peer)
+{
+    memset(dest, 0, sizeof(BACNET_ADDRESS));
+    dest->mac_len = 2;
+    dest->mac[0] = (uint8_t) (peer >> 8);
+    dest->mac[1] = (uint8_t) peer;
+}
+
 void testTSM(
     Test * pTest)
 {
-    /* FIXME: add some unit testing... */
-    return;
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t apdu[MAX_PDU] = { 0 };
+    uint16_t apdu_len = 0;
+    uint8_t invoke_id[255] = { 0 };
+    unsigned i = 0;
+    bool status = false;
+    uint32_t milliseconds = 0;
+
+    tsm_set_timeout_handler(testTimeoutHandler);
+    testPeerAddress(&dest, 1000);
+    ct_test(pTest, !tsm_timer_next(&milliseconds));
+    ct_test(pTest, tsm_transaction_available());
+    ct_test(pTest, tsm_transaction_idle_count() ==
+        MAX_TSM_TRANSACTIONS_DYNAMIC);
+    /* use up every invoke ID */
+    tsm_invokeID_set(1);
+    for (i = 0; i < 255; i++) {
+        invoke_id[i] = tsm_next_free_peer_invokeID(&dest);
+        ct_test(pTest, invoke_id[i] != 0);
+        ct_test(pTest, !tsm_peer_invoke_id_free(&dest, invoke_id[i]));
+    }
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest) == 0);
+    /* free one and get it back */
+    tsm_free_peer_invoke_id(&dest, invoke_id[10]);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, invoke_id[10]));
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest) == invoke_id[10]);
+    for (i = 0; i < 255; i++) {
+        tsm_free_peer_invoke_id(&dest, invoke_id[i]);
+    }
+    /* the invoke ID keeps counting, skipping zero */
+    tsm_invokeID_set(255);
+    invoke_id[0] = tsm_next_free_peer_invokeID(&dest);
+    ct_test(pTest, invoke_id[0] == 255);
+    invoke_id[1] = tsm_next_free_peer_invokeID(&dest);
+    ct_test(pTest, invoke_id[1] == 1);
+    /* timers with staggered start times */
+    apdu[0] = 0x55;
+    tsm_set_confirmed_unsegmented_transaction(invoke_id[0], &dest,
+        &npdu_data, apdu, 1);
+    tsm_timer_milliseconds(1000);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id[1], &dest,
+        &npdu_data, apdu, 1);
+    apdu[0] = 0;
+    status = tsm_get_peer_transaction_pdu(&dest, invoke_id[0], &npdu_data,
+        apdu, &apdu_len);
+    ct_test(pTest, status);
+    ct_test(pTest, apdu_len == 1);
+    ct_test(pTest, apdu[0] == 0x55);
+    Sent_Count = 0;
+    ct_test(pTest, tsm_timer_next(&milliseconds));
+    ct_test(pTest, milliseconds == 2000);
+    tsm_timer_milliseconds(1999);
+    ct_test(pTest, Sent_Count == 0);
+    ct_test(pTest, tsm_timer_next(&milliseconds));
+    ct_test(pTest, milliseconds == 1);
+    tsm_timer_milliseconds(1);
+    ct_test(pTest, Sent_Count == 1);
+    tsm_timer_milliseconds(1000);
+    ct_test(pTest, Sent_Count == 2);
+    /* a confirmed transaction no longer times out */
+    tsm_free_peer_invoke_id(&dest, invoke_id[1]);
+    for (i = 0; i < ((3000 * 3) + TEST_BACKOFF_TIME); i += 100) {
+        tsm_timer_milliseconds(100);
+    }
+    ct_test(pTest, Sent_Count == 4);
+    ct_test(pTest, Timeout_Count == 1);
+    ct_test(pTest, Timeout_Invoke_ID == invoke_id[0]);
+    ct_test(pTest, bacnet_address_same(&Timeout_Dest, &dest));
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest, invoke_id[0]));
+    ct_test(pTest, !tsm_peer_invoke_id_free(&dest, invoke_id[0]));
+    tsm_free_peer_invoke_id(&dest, invoke_id[0]);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, invoke_id[0]));
+    /* many timers expiring in order */
+    testPeerAddress(&dest, 1001);
+    Sent_Count = 0;
+    Timeout_Count = 0;
+    for (i = 0; i < 100; i++) {
+        invoke_id[i] = tsm_next_free_peer_invokeID(&dest);
+        tsm_set_confirmed_unsegmented_transaction(invoke_id[i], &dest,
+            &npdu_data, apdu, 1);
+        tsm_timer_milliseconds(10);
+    }
+    for (i = 0; i < 100; i += 2) {
+        tsm_free_peer_invoke_id(&dest, invoke_id[i]);
+    }
+    tsm_timer_milliseconds(3000 - 1000);
+    ct_test(pTest, Sent_Count == 0);
+    tsm_timer_milliseconds(1000 - 10);
+    ct_test(pTest, Sent_Count == 50);
+    for (i = 0; i < ((3000 * 4) + TEST_BACKOFF_TIME); i += 100) {
+        tsm_timer_milliseconds(100);
+    }
+    ct_test(pTest, Timeout_Count == 50);
+    for (i = 1; i < 100; i += 2) {
+        ct_test(pTest, tsm_peer_invoke_id_failed(&dest, invoke_id[i]));
+        tsm_free_peer_invoke_id(&dest, invoke_id[i]);
+    }
+    ct_test(pTest, tsm_transaction_idle_count() ==
+        MAX_TSM_TRANSACTIONS_DYNAMIC);
 }
 
+void testTSMPeer(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS src = { 0 };
+    BACNET_ADDRESS other = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t apdu[MAX_PDU] = { 0 };
+    uint16_t apdu_len = 0;
+    uint8_t invoke_id = 0;
+    unsigned peer = 0;
+    unsigned i = 0;
+    unsigned count = 0;
+
+    /* each peer has its own invoke ID space */
+    for (peer = 0; peer < 8; peer++) {
+        testPeerAddress(&dest, peer);
+        tsm_invokeID_set(1);
+        for (i = 1; i < 256; i++) {
+            invoke_id = tsm_next_free_peer_invokeID(&dest);
+            ct_test(pTest, invoke_id == i);
+        }
+        ct_test(pTest, tsm_next_free_peer_invokeID(&dest) == 0);
+    }
+    ct_test(pTest, tsm_transaction_available());
+    testPeerAddress(&dest, 3);
+    tsm_free_peer_invoke_id(&dest, 7);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, 7));
+    testPeerAddress(&src, 2);
+    ct_test(pTest, !tsm_peer_invoke_id_free(&src, 7));
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest) == 7);
+    /* a reply from an unknown address is ignored when ambiguous */
+    testPeerAddress(&src, 100);
+    tsm_free_peer_invoke_id(&src, 7);
+    ct_test(pTest, !tsm_peer_invoke_id_free(&dest, 7));
+    for (peer = 0; peer < 8; peer++) {
+        testPeerAddress(&dest, peer);
+        for (i = 1; i < 256; i++) {
+            tsm_free_peer_invoke_id(&dest, (uint8_t) i);
+        }
+    }
+    ct_test(pTest, tsm_transaction_idle_count() ==
+        MAX_TSM_TRANSACTIONS_DYNAMIC);
+    /* ... but accepted when only one peer uses the invoke ID */
+    testPeerAddress(&dest, 1);
+    tsm_invokeID_set(42);
+    invoke_id = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        apdu, 1);
+    tsm_free_peer_invoke_id(&src, invoke_id);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, invoke_id));
+    /* timeouts are per peer */
+    Timeout_Count = 0;
+    testPeerAddress(&dest, 1);
+    testPeerAddress(&src, 2);
+    tsm_invokeID_set(9);
+    invoke_id = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        apdu, 1);
+    tsm_invokeID_set(9);
+    ct_test(pTest, tsm_next_free_peer_invokeID(&src) == invoke_id);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &src, &npdu_data,
+        apdu, 1);
+    /* ... and the request is only found for its own peer */
+    ct_test(pTest, tsm_get_peer_transaction_pdu(&src, invoke_id, &npdu_data,
+            apdu, &apdu_len));
+    testPeerAddress(&other, 100);
+    ct_test(pTest, !tsm_get_peer_transaction_pdu(&other, invoke_id,
+            &npdu_data, apdu, &apdu_len));
+    tsm_free_peer_invoke_id(&src, invoke_id);
+    for (i = 0; i < ((3000 * 5) + TEST_BACKOFF_TIME); i += 100) {
+        tsm_timer_milliseconds(100);
+    }
+    ct_test(pTest, Timeout_Count == 1);
+    ct_test(pTest, bacnet_address_same(&Timeout_Dest, &dest));
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest, invoke_id));
+    ct_test(pTest, !tsm_peer_invoke_id_failed(&src, invoke_id));
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    /* the table stops growing at the configured limit */
+    for (peer = 0; peer < 1000; peer++) {
+        testPeerAddress(&dest, peer);
+        for (i = 1; i < 256; i++) {
+            if (tsm_next_free_peer_invokeID(&dest) == 0) {
+                break;
+            }
+            count++;
+        }
+        if (i < 256) {
+            break;
+        }
+    }
+    ct_test(pTest, count == MAX_TSM_TRANSACTIONS_DYNAMIC);
+    ct_test(pTest, !tsm_transaction_available());
+    ct_test(pTest, tsm_transaction_idle_count() == 0);
+    count = peer;
+    for (peer = 0; peer <= count; peer++) {
+        testPeerAddress(&dest, peer);
+        for (i = 1; i < 256; i++) {
+            tsm_free_peer_invoke_id(&dest, (uint8_t) i);
+        }
+    }
+    ct_test(pTest, tsm_transaction_idle_count() ==
+        MAX_TSM_TRANSACTIONS_DYNAMIC);
+}
+
+void testTSMBuffer(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t pdu[MAX_PDU] = { 0 };
+    uint8_t test_pdu[MAX_PDU] = { 0 };
+    uint16_t test_pdu_len = 0;
+    uint8_t invoke_id[3] = { 0 };
+    uint16_t pdu_len[3] = { 20, 600, MAX_PDU };
+    unsigned i = 0;
+
+    for (i = 0; i < sizeof(pdu); i++) {
+        pdu[i] = (uint8_t) i;
+    }
+    testPeerAddress(&dest, 2000);
+    for (i = 0; i < 3; i++) {
+        invoke_id[i] = tsm_next_free_peer_invokeID(&dest);
+        tsm_set_confirmed_unsegmented_transaction(invoke_id[i], &dest,
+            &npdu_data, pdu, pdu_len[i]);
+        ct_test(pTest, tsm_get_peer_transaction_pdu(&dest, invoke_id[i],
+                &npdu_data, test_pdu, &test_pdu_len));
+        ct_test(pTest, test_pdu_len == pdu_len[i]);
+        ct_test(pTest, memcmp(pdu, test_pdu, test_pdu_len) == 0);
+    }
+    /* the same transaction may be sent again with a different size */
+    tsm_set_confirmed_unsegmented_transaction(invoke_id[0], &dest,
+        &npdu_data, &pdu[1], 1000);
+    ct_test(pTest, tsm_get_peer_transaction_pdu(&dest, invoke_id[0],
+            &npdu_data, test_pdu, &test_pdu_len));
+    ct_test(pTest, test_pdu_len == 1000);
+    ct_test(pTest, memcmp(&pdu[1], test_pdu, test_pdu_len) == 0);
+    /* retries send the stored copy */
+    Sent_Count = 0;
+    tsm_free_peer_invoke_id(&dest, invoke_id[1]);
+    tsm_free_peer_invoke_id(&dest, invoke_id[2]);
+    tsm_timer_milliseconds(3000);
+    ct_test(pTest, Sent_Count == 1);
+    ct_test(pTest, Sent_Len == 1000);
+    tsm_free_peer_invoke_id(&dest, invoke_id[0]);
+    /* freed buffers are handed out again */
+    invoke_id[0] = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id[0], &dest,
+        &npdu_data, pdu, 10);
+    ct_test(pTest, tsm_get_peer_transaction_pdu(&dest, invoke_id[0],
+            &npdu_data, test_pdu, &test_pdu_len));
+    ct_test(pTest, test_pdu_len == 10);
+    ct_test(pTest, memcmp(pdu, test_pdu, test_pdu_len) == 0);
+    tsm_free_peer_invoke_id(&dest, invoke_id[0]);
+}
+
+void testTSMRtt(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t apdu[1] = { 0 };
+    uint8_t invoke_id = 0;
+    uint32_t srtt = 0;
+    uint32_t rttvar = 0;
+    unsigned i = 0;
+
+    /* unmeasured peers use the APDU timeout */
+    testPeerAddress(&dest, 3000);
+    ct_test(pTest, !tsm_peer_rtt(&dest, &srtt, &rttvar));
+    ct_test(pTest, tsm_peer_timeout(&dest) == apdu_timeout());
+    /* a fast peer */
+    for (i = 0; i < 20; i++) {
+        invoke_id = tsm_next_free_peer_invokeID(&dest);
+        tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest,
+            &npdu_data, apdu, 1);
+        tsm_timer_milliseconds(100);
+        tsm_free_peer_invoke_id(&dest, invoke_id);
+        if (i == 0) {
+            ct_test(pTest, tsm_peer_rtt(&dest, &srtt, &rttvar));
+            ct_test(pTest, srtt == 100);
+            ct_test(pTest, rttvar == 50);
+            ct_test(pTest, tsm_peer_timeout(&dest) == 300);
+        }
+    }
+    ct_test(pTest, tsm_peer_rtt(&dest, &srtt, &rttvar));
+    ct_test(pTest, srtt == 100);
+    ct_test(pTest, rttvar < 5);
+    ct_test(pTest, tsm_peer_timeout(&dest) == TSM_TIMEOUT_MIN);
+    /* a slow peer: the first reply comes after a retry and is not timed */
+    testPeerAddress(&dest, 3001);
+    invoke_id = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        apdu, 1);
+    for (i = 0; i < 50; i++) {
+        tsm_timer_milliseconds(100);
+    }
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    ct_test(pTest, !tsm_peer_rtt(&dest, &srtt, &rttvar));
+#if TSM_RETRY_BACKOFF
+    ct_test(pTest, tsm_peer_timeout(&dest) == (apdu_timeout() * 2));
+    /* ...the longer timeout lets the next reply be timed */
+    Sent_Count = 0;
+    invoke_id = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        apdu, 1);
+    for (i = 0; i < 50; i++) {
+        tsm_timer_milliseconds(100);
+    }
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    ct_test(pTest, Sent_Count == 0);
+    ct_test(pTest, tsm_peer_rtt(&dest, &srtt, &rttvar));
+    ct_test(pTest, srtt == 5000);
+    ct_test(pTest, rttvar == 2500);
+    ct_test(pTest, tsm_peer_timeout(&dest) == 15000);
+#else
+    ct_test(pTest, tsm_peer_timeout(&dest) == apdu_timeout());
+#endif
+    /* a task ticking once a second can't time the replies */
+    testPeerAddress(&dest, 3002);
+    invoke_id = tsm_next_free_peer_invokeID(&dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        apdu, 1);
+    tsm_timer_milliseconds(1000);
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    ct_test(pTest, !tsm_peer_rtt(&dest, &srtt, &rttvar));
+    ct_test(pTest, tsm_peer_timeout(&dest) == apdu_timeout());
+}
+
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+void testTSMSegmentedResponse(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_CONFIRMED_SERVICE_DATA service_data = { 0 };
+    uint8_t pdu[MAX_PDU] = { 0 };
+    unsigned idle_count = 0;
+    unsigned i = 0;
+    int len = 0;
+
+    testPeerAddress(&dest, 3000);
+    service_data.invoke_id = 7;
+    service_data.max_resp = 50;
+    service_data.max_segs = 0;
+    /* without segmentation, the reply is limited to one APDU */
+    ct_test(pTest, tsm_complex_ack_max(&service_data) == 50);
+    service_data.segmented_response_accepted = true;
+    ct_test(pTest,
+        tsm_complex_ack_max(&service_data) ==
+        3 + MAX_SEGMENTS_TRANSMIT * 45);
+    service_data.max_segs = 2;
+    ct_test(pTest, tsm_complex_ack_max(&service_data) == 3 + 2 * 45);
+    service_data.max_segs = 0;
+    /* NPDU, then a ComplexACK of 100 octets of data in 3 segments */
+    pdu[0] = 1;
+    pdu[1] = 0;
+    pdu[2] = PDU_TYPE_COMPLEX_ACK;
+    pdu[3] = service_data.invoke_id;
+    pdu[4] = SERVICE_CONFIRMED_READ_PROP_MULTIPLE;
+    for (i = 0; i < 100; i++) {
+        pdu[5 + i] = (uint8_t) i;
+    }
+    /* a reply that fits is sent as is */
+    idle_count = tsm_transaction_idle_count();
+    Sent_Count = 0;
+    len =
+        tsm_send_complex_ack(&dest, &npdu_data, &service_data, pdu, 2, 50);
+    ct_test(pTest, Sent_Count == 1);
+    ct_test(pTest, Sent_Len == 52);
+    ct_test(pTest, tsm_transaction_idle_count() == idle_count);
+    /* the first segment is sent alone */
+    Sent_Count = 0;
+    len =
+        tsm_send_complex_ack(&dest, &npdu_data, &service_data, pdu, 2, 103);
+    ct_test(pTest, len == 0);
+    ct_test(pTest, Sent_Count == 1);
+    ct_test(pTest, Sent_Len == 2 + 5 + 45);
+    ct_test(pTest, Sent_PDU[2] == (PDU_TYPE_COMPLEX_ACK | BIT(3) | BIT(2)));
+    ct_test(pTest, Sent_PDU[3] == service_data.invoke_id);
+    ct_test(pTest, Sent_PDU[4] == 0);
+    ct_test(pTest, Sent_PDU[5] == MAX_SEGMENT_WINDOW);
+    ct_test(pTest, Sent_PDU[6] == SERVICE_CONFIRMED_READ_PROP_MULTIPLE);
+    ct_test(pTest, Sent_PDU[7] == 0);
+    /* the request is not found as one of our own */
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, service_data.invoke_id));
+    /* an ACK from another client is ignored */
+    testPeerAddress(&dest, 3001);
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 1);
+    testPeerAddress(&dest, 3000);
+    /* NewACK fills the window of the client */
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 3);
+    ct_test(pTest, Sent_Len == 2 + 5 + 10);
+    ct_test(pTest, Sent_PDU[2] == (PDU_TYPE_COMPLEX_ACK | BIT(3)));
+    ct_test(pTest, Sent_PDU[4] == 2);
+    ct_test(pTest, Sent_PDU[7] == 90);
+    /* DuplicateACK sends nothing */
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 3);
+    /* Timeout sends the window again */
+    tsm_timer_milliseconds(2000);
+    ct_test(pTest, Sent_Count == 5);
+    /* FinalACK frees the transaction */
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 2, 2);
+    ct_test(pTest, Sent_Count == 5);
+    ct_test(pTest, tsm_transaction_idle_count() == idle_count);
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 5);
+    /* FinalTimeout frees the transaction after the retries */
+    Sent_Count = 0;
+    (void) tsm_send_complex_ack(&dest, &npdu_data, &service_data, pdu, 2,
+        103);
+    for (i = 0; i < apdu_retries(); i++) {
+        tsm_timer_milliseconds(2000);
+    }
+    ct_test(pTest, Sent_Count == 1 + apdu_retries());
+    tsm_timer_milliseconds(2000);
+    ct_test(pTest, Sent_Count == 1 + apdu_retries());
+    ct_test(pTest, tsm_transaction_idle_count() == idle_count);
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 1 + apdu_retries());
+    /* an Abort from the client frees the transaction */
+    (void) tsm_send_complex_ack(&dest, &npdu_data, &service_data, pdu, 2,
+        103);
+    tsm_free_peer_response(&dest, service_data.invoke_id);
+    ct_test(pTest, tsm_transaction_idle_count() == idle_count);
+    tsm_timer_milliseconds(2000);
+    tsm_segment_ack_received(&dest, service_data.invoke_id, 0, 2);
+    ct_test(pTest, Sent_Count == 2 + apdu_retries());
+}
+#endif
+
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+/* starts a request to the peer, and the header of its segmented reply */
+static uint8_t testSegmentedRequest(
+    BACNET_ADDRESS * dest,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * ack_data)
+{
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    uint8_t apdu[4] = { 0 };
+    uint8_t invoke_id = 0;
+
+    invoke_id = tsm_next_free_peer_invokeID(dest);
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, dest, &npdu_data,
+        apdu, sizeof(apdu));
+    memset(ack_data, 0, sizeof(BACNET_CONFIRMED_SERVICE_ACK_DATA));
+    ack_data->segmented_message = true;
+    ack_data->more_follows = true;
+    ack_data->invoke_id = invoke_id;
+    ack_data->proposed_window_number = 2;
+
+    return invoke_id;
+}
+
+void testTSMSegmentedConfirmation(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_CONFIRMED_SERVICE_ACK_DATA ack_data;
+    static uint8_t data[MAX_APDU];
+    uint8_t *reply = NULL;
+    uint16_t len = 0;
+    uint8_t invoke_id = 0;
+    unsigned i = 0;
+
+    tsm_set_timeout_handler(testTimeoutHandler);
+    testPeerAddress(&dest, 4000);
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) i;
+    }
+    /* the first segment is acknowledged with our window size */
+    invoke_id = testSegmentedRequest(&dest, &ack_data);
+    Sent_Count = 0;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[0], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_Count == 1);
+    ct_test(pTest, Sent_PDU[2] == PDU_TYPE_SEGMENT_ACK);
+    ct_test(pTest, Sent_PDU[3] == invoke_id);
+    ct_test(pTest, Sent_PDU[4] == 0);
+    ct_test(pTest, Sent_PDU[5] == 2);
+    ct_test(pTest, !tsm_peer_invoke_id_free(&dest, invoke_id));
+    /* the rest of the window is acknowledged at its end */
+    ack_data.sequence_number = 1;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[10], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_Count == 1);
+    /* a segment out of order asks for the ones after the last in order */
+    ack_data.sequence_number = 3;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[30], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_Count == 2);
+    ct_test(pTest, Sent_PDU[2] == (PDU_TYPE_SEGMENT_ACK | BIT(1)));
+    ct_test(pTest, Sent_PDU[4] == 1);
+    ack_data.sequence_number = 2;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[20], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_Count == 2);
+    ack_data.sequence_number = 3;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[30], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_Count == 3);
+    ct_test(pTest, Sent_PDU[2] == PDU_TYPE_SEGMENT_ACK);
+    ct_test(pTest, Sent_PDU[4] == 3);
+    /* the last segment completes the reply */
+    ack_data.sequence_number = 4;
+    ack_data.more_follows = false;
+    len = 5;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[40], &len);
+    ct_test(pTest, reply != NULL);
+    ct_test(pTest, Sent_Count == 4);
+    ct_test(pTest, Sent_PDU[4] == 4);
+    ct_test(pTest, len == 45);
+    ct_test(pTest, !ack_data.segmented_message);
+    if (reply) {
+        ct_test(pTest, memcmp(reply, data, len) == 0);
+    }
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest, invoke_id));
+    /* a reply larger than we accept is aborted */
+    Timeout_Count = 0;
+    invoke_id = testSegmentedRequest(&dest, &ack_data);
+    for (i = 0; i <= MAX_SEGMENTS_ACCEPTED; i++) {
+        ack_data.sequence_number = (uint8_t) i;
+        len = MAX_APDU;
+        reply = tsm_segmented_ack_received(&dest, &ack_data, &data[0], &len);
+        ct_test(pTest, reply == NULL);
+    }
+    ct_test(pTest, Sent_PDU[2] == PDU_TYPE_ABORT);
+    ct_test(pTest, Sent_PDU[3] == invoke_id);
+    ct_test(pTest, Sent_PDU[4] == ABORT_REASON_BUFFER_OVERFLOW);
+    ct_test(pTest, Timeout_Count == 1);
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest, invoke_id));
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    /* a reply that does not start with the first segment is aborted */
+    invoke_id = testSegmentedRequest(&dest, &ack_data);
+    ack_data.sequence_number = 1;
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[0], &len);
+    ct_test(pTest, reply == NULL);
+    ct_test(pTest, Sent_PDU[2] == PDU_TYPE_ABORT);
+    ct_test(pTest, Sent_PDU[4] == ABORT_REASON_INVALID_APDU_IN_THIS_STATE);
+    ct_test(pTest, Timeout_Count == 2);
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    /* a reply that stops coming fails */
+    invoke_id = testSegmentedRequest(&dest, &ack_data);
+    len = 10;
+    reply = tsm_segmented_ack_received(&dest, &ack_data, &data[0], &len);
+    Sent_Count = 0;
+    tsm_timer_milliseconds((4 * apdu_segment_timeout()) - 1);
+    ct_test(pTest, Timeout_Count == 2);
+    tsm_timer_milliseconds(1);
+    ct_test(pTest, Timeout_Count == 3);
+    ct_test(pTest, Timeout_Invoke_ID == invoke_id);
+    ct_test(pTest, Sent_Count == 0);
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest, invoke_id));
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+}
+#endif
+
 #ifdef TEST_TSM
 int main(
     void)
@@ -397,6 +2223,20 @@ int main(
     /* individual tests */
     rc = ct_addTestFunction(pTest, testTSM);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testTSMPeer);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTSMBuffer);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTSMRtt);
+    assert(rc);
+#if (MAX_SEGMENTS_TRANSMIT > 1)
+    rc = ct_addTestFunction(pTest, testTSMSegmentedResponse);
+    assert(rc);
+#endif
+#if (MAX_SEGMENTS_ACCEPTED > 1)
+    rc = ct_addTestFunction(pTest, testTSMSegmentedConfirmation);
+    assert(rc);
+#endif
 
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -10,9 +10,9 @@
 LOGFILE = test.log
 
 all: abort address arf awf bvlc6 bacapp bacdcode bacerror bacint bacstr \
-	cov crc datetime dcc event filename fifo getevent iam ihave \
-	indtext keylist key memcopy npdu proplist ptransfer \
-	rd reject ringbuf rp rpm sbuf timesync vmac \
+	cov cov_client crc datetime dcc event filename fifo fnv getevent iam \
+	ihave indtext keylist key memcopy minheap npdu objstore proplist \
+	ptransfer rd reject ringbuf rp rpm sbuf timesync tsm vmac \
 	whohas whois wp objects lighting
 
 clean: logfile
@@ -76,6 +76,11 @@ cov: logfile test/cov.mak
 	( ./test/cov >> ${LOGFILE} )
 	$(MAKE) -s -C test -f cov.mak clean
 
+cov_client: logfile demo/handler/cov_client.mak
+	$(MAKE) -s -C demo/handler -f cov_client.mak clean all
+	( ./demo/handler/cov_client >> ${LOGFILE} )
+	$(MAKE) -s -C demo/handler -f cov_client.mak clean
+
 crc: logfile test/crc.mak
 	$(MAKE) -s -C test -f crc.mak clean all
 	( ./test/crc >> ${LOGFILE} )
@@ -106,6 +111,11 @@ fifo: logfile test/fifo.mak
 	( ./test/fifo >> ${LOGFILE} )
 	$(MAKE) -s -C test -f fifo.mak clean
 
+fnv: logfile test/fnv.mak
+	$(MAKE) -s -C test -f fnv.mak clean all
+	( ./test/fnv >> ${LOGFILE} )
+	$(MAKE) -s -C test -f fnv.mak clean
+
 getevent: logfile test/getevent.mak
 	$(MAKE) -s -C test -f getevent.mak clean all
 	( ./test/getevent >> ${LOGFILE} )
@@ -146,11 +156,21 @@ memcopy: logfile test/memcopy.mak
 	( ./test/memcopy >> ${LOGFILE} )
 	$(MAKE) -s -C test -f memcopy.mak clean
 
+minheap: logfile test/minheap.mak
+	$(MAKE) -s -C test -f minheap.mak clean all
+	( ./test/minheap >> ${LOGFILE} )
+	$(MAKE) -s -C test -f minheap.mak clean
+
 npdu: logfile test/npdu.mak
 	$(MAKE) -s -C test -f npdu.mak clean all
 	( ./test/npdu >> ${LOGFILE} )
 	$(MAKE) -s -C test -f npdu.mak clean
 
+objstore: logfile test/objstore.mak
+	$(MAKE) -s -C test -f objstore.mak clean all
+	( ./test/objstore >> ${LOGFILE} )
+	$(MAKE) -s -C test -f objstore.mak clean
+
 proplist: logfile test/proplist.mak
 	$(MAKE) -s -C test -f proplist.mak clean all
 	( ./test/proplist >> ${LOGFILE} )
@@ -196,6 +216,11 @@ timesync: logfile test/timesync.mak
 	( ./test/timesync >> ${LOGFILE} )
 	$(MAKE) -s -C test -f timesync.mak clean
 
+tsm: logfile test/tsm.mak
+	$(MAKE) -s -C test -f tsm.mak clean all
+	( ./test/tsm >> ${LOGFILE} )
+	$(MAKE) -s -C test -f tsm.mak clean
+
 vmac: logfile test/vmac.mak
 	$(MAKE) -s -C test -f vmac.mak clean all
 	( ./test/vmac >> ${LOGFILE} )
@@ -273,6 +298,7 @@ av: logfile demo/object/av.mak
 
 bi: logfile demo/object/bi.mak
 	$(MAKE) -s -C demo/object -f bi.mak clean all
+	( ./demo/object/binary_input >> ${LOGFILE} )
 	$(MAKE) -s -C demo/object -f bi.mak clean
 
 bo: logfile demo/object/bo.mak
@@ -2,11 +2,13 @@
 CC      = gcc
 SRC_DIR = ../src
 INCLUDES = -I../include -I.
-DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_ADDRESS -DBACNET_ADDRESS_CACHE_FILE
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_ADDRESS -DBACNET_ADDRESS_CACHE_FILE \
+	-DBACNET_ADDRESS_CACHE_SNAPSHOT
 
 CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
 
 SRCS = $(SRC_DIR)/address.c \
+	$(SRC_DIR)/fnv.c \
 	$(SRC_DIR)/bacaddr.c \
 	$(SRC_DIR)/bacdcode.c \
 	$(SRC_DIR)/bacint.c \
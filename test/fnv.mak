@@ -0,0 +1,32 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_FNV
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = $(SRC_DIR)/fnv.c \
+	ctest.c
+
+TARGET = fnv
+
+all: ${TARGET}
+ 
+OBJS = ${SRCS:.c=.o}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS} 
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+	
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+	
+clean:
+	rm -rf core ${TARGET} $(OBJS) *.bak *.1 *.ini
+
+include: .depend
+
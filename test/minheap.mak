@@ -0,0 +1,32 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_MIN_HEAP
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = $(SRC_DIR)/minheap.c \
+	ctest.c
+
+TARGET = minheap
+
+all: ${TARGET}
+ 
+OBJS = ${SRCS:.c=.o}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS} 
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+	
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+	
+clean:
+	rm -rf core ${TARGET} $(OBJS) *.bak *.1 *.ini
+
+include: .depend
+